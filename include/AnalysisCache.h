@@ -0,0 +1,87 @@
+#pragma once
+
+#include "TrackAnalyzer.h"
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief On-disk cache of TrackAnalyzer results
+ *
+ * Entries are keyed by a hash of the track content the analyzer reads
+ * (elevation, distance and gradient of every point) and a hash of the
+ * analyzer parameters, so an edited file, a different trim or reverse
+ * view, or changed thresholds all miss the cache, while reopening the same
+ * track loads its segments and climbs without re-running the pipeline.
+ *
+ * Each entry is a small binary file named after both keys, written
+ * atomically, so several threads or processes can share one directory.
+ * Every store prunes the least recently used entries beyond the size
+ * limit; a hit refreshes the entry's modification time.
+ */
+class AnalysisCache {
+public:
+    static const qint64 DEFAULT_SIZE_LIMIT = 32 * 1024 * 1024;
+
+    /**
+     * @param directory Where entries are stored, defaultDirectory() if empty
+     * @param sizeLimit Total size of the entries kept in bytes
+     */
+    explicit AnalysisCache(const QString& directory = QString(), qint64 sizeLimit = DEFAULT_SIZE_LIMIT);
+
+    /**
+     * @brief Per-user cache location of the application
+     */
+    static QString defaultDirectory();
+
+    const QString& directory() const { return m_directory; }
+
+    /**
+     * @brief 64-bit hash of the analyzed channels of a track
+     */
+    static quint64 contentHash(const std::vector<TrackPoint>& points);
+
+    /**
+     * @brief 64-bit hash of every analyzer setting that affects the result
+     */
+    static quint64 paramsHash(const TrackAnalyzer& analyzer);
+
+    /**
+     * @brief Read a cached result
+     * @return False if there is no usable entry for the keys
+     */
+    bool load(quint64 contentHash, quint64 paramsHash, TrackAnalysisResult& result) const;
+
+    /**
+     * @brief Write a result for the keys, replacing any previous entry
+     */
+    bool store(quint64 contentHash, quint64 paramsHash, const TrackAnalysisResult& result) const;
+
+    /**
+     * @brief Cached result for the track, running and storing the analysis on a miss
+     */
+    TrackAnalysisResult analyze(const TrackAnalyzer& analyzer, const std::vector<TrackPoint>& points) const;
+
+    /**
+     * @brief Cached result for a track already prepared by the analyzer, segmenting the profile on a miss
+     * @param profile Result of analyzer.prepare() for the same points
+     */
+    TrackAnalysisResult analyze(const TrackAnalyzer& analyzer, const std::vector<TrackPoint>& points,
+                                const GradientProfile& profile) const;
+
+    /**
+     * @brief File holding the entry for the keys
+     */
+    QString entryPath(quint64 contentHash, quint64 paramsHash) const;
+
+    /**
+     * @brief Remove the least recently used entries until the rest fit the size limit
+     *
+     * Entries of an older cache version are never hit again, so they age out the same way.
+     */
+    void prune() const;
+
+private:
+    QString m_directory;
+    qint64 m_sizeLimit;
+};
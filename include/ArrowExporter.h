@@ -0,0 +1,36 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <QString>
+
+/**
+ * @brief Writes track columns as an Arrow IPC file (Feather v2)
+ *
+ * The file holds a single record batch with one column per channel:
+ * time (timestamp[ms, UTC], when present), latitude, longitude, elevation,
+ * distance, gradient and any recorded sensor channels (heart_rate, cadence,
+ * power, temperature) as float64. Column buffers are written directly from
+ * the TrackColumns arrays; only the small flatbuffer metadata is encoded.
+ * Building the TrackColumns from TrackPoints is a separate row-by-row pass,
+ * done once per displayed track and shared with the stats widget.
+ */
+class ArrowExporter {
+public:
+    ArrowExporter() = default;
+
+    /**
+     * @brief Write the columns to an Arrow IPC file
+     * @param columns Column store to export
+     * @param filename Destination path (conventionally *.arrow or *.feather)
+     * @return True on success, false otherwise (see errorString())
+     */
+    bool exportColumns(const TrackColumns& columns, const QString& filename);
+
+    /**
+     * @brief Description of the last error
+     */
+    QString errorString() const { return m_errorString; }
+
+private:
+    QString m_errorString;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "GpxParser.h"
+#include "ClimbDetector.h"
+#include "ElevationGain.h"
+#include "ZoneHistogram.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * @brief Headline statistics of one analyzed file
+ */
+struct TrackSummary {
+    QString file;
+    QString error;                  // Empty if the file was analyzed
+
+    size_t pointCount = 0;
+    double distance = 0.0;          // in meters
+    double elevationGain = 0.0;     // Parser gain, as shown in the viewer (m)
+    double maxElevation = 0.0;
+    double minElevation = 0.0;
+    ElevationGainReport gains;      // Without the DEM estimate
+
+    // Zero for untimed tracks
+    double elapsedTime = 0.0;       // in seconds
+    double movingTime = 0.0;        // in seconds
+    double averageMovingSpeed = 0.0; // in m/s
+    double maxSpeed = 0.0;          // in m/s
+
+    size_t segmentCount = 0;        // Most detailed level
+    double uphillPercent = 0.0;
+    double downhillPercent = 0.0;
+    double flatPercent = 0.0;
+    double steepestUphill = 0.0;
+    double steepestDownhill = 0.0;
+
+    std::vector<Climb> climbs;
+    std::vector<double> climbStarts; // Distance from the start to each climb (m)
+    ZoneReport zones;
+
+    bool ok() const { return error.isEmpty(); }
+};
+
+/**
+ * @brief Analyzes many GPX files without any widget dependencies
+ *
+ * Files are the unit of parallelism: each one is parsed and run through
+ * the segmentation, climb, motion, gain and zone analyzers on a worker of
+ * the global thread pool, with the per-track analyzers kept sequential so
+ * a batch never oversubscribes the cores. Only the small summaries are
+ * kept, so memory stays bounded by the largest files in flight.
+ */
+class BatchAnalyzer {
+public:
+    explicit BatchAnalyzer(const ZoneSettings& zones = ZoneSettings()) : m_zoneSettings(zones) {}
+
+    /**
+     * @brief Load and store segmentations through AnalysisCache
+     */
+    void setUseCache(bool useCache) { m_useCache = useCache; }
+    bool useCache() const { return m_useCache; }
+
+    /**
+     * @brief Expand files and directories into a sorted list of GPX files
+     *
+     * Directories are searched recursively for *.gpx (any case); files are
+     * taken as given. Missing paths are kept so they are reported as errors.
+     */
+    static QStringList collectFiles(const QStringList& paths);
+
+    /**
+     * @brief Summaries of the files in input order, analyzed in parallel
+     */
+    std::vector<TrackSummary> analyzeFiles(const QStringList& files) const;
+
+    /**
+     * @brief Parse and summarize one file
+     */
+    TrackSummary analyzeFile(const QString& file) const;
+
+    /**
+     * @brief Summarize already parsed points
+     */
+    TrackSummary summarize(const QString& file, const GPXParser& parser) const;
+
+    // Output formats: one JSON object per file, or one CSV row per file with
+    // zone times joined by ';'. Distances in meters, times in seconds.
+    static QJsonObject toJson(const TrackSummary& summary);
+    static QByteArray csvHeader();
+    static QByteArray toCsv(const TrackSummary& summary);
+
+private:
+    ZoneSettings m_zoneSettings;
+    bool m_useCache = false;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <vector>
+
+/**
+ * @brief Best performance of a track over one window size
+ */
+struct BestEffort {
+    enum Kind { FASTEST_DISTANCE, MAX_CLIMB_RATE };
+    Kind kind;
+    double window;          // Meters for FASTEST_DISTANCE, seconds for MAX_CLIMB_RATE
+    bool found = false;     // False if the track is untimed or shorter than the window
+    size_t startIndex = 0;  // Point indices into the track
+    size_t endIndex = 0;
+    double distance = 0.0;  // in meters
+    double duration = 0.0;  // in seconds
+    double climb = 0.0;     // Net elevation change in meters
+
+    // Average speed in m/s
+    double speed() const { return duration > 0.0 ? distance / duration : 0.0; }
+    // Vertical ascent rate (VAM) in meters per hour
+    double climbRate() const { return duration > 0.0 ? climb / duration * 3600.0 : 0.0; }
+};
+
+/**
+ * @brief Finds best efforts: fastest distances and highest climbing rates
+ *
+ * Every window size is a two-pointer sweep over the timed points, O(n) per
+ * window. The sweeps are independent and run in parallel on the global
+ * thread pool, so a whole table costs about one scan of the track.
+ *
+ * Climbing rates are taken over the shortest stretch ending at each point
+ * that lasts at least the window, so they describe that duration rather
+ * than any longer effort containing it.
+ */
+class BestEffortFinder {
+public:
+    BestEffortFinder();
+
+    /**
+     * @brief Distances in meters for fastest-effort windows (default 1 km, 5 km, 10 km, half marathon)
+     */
+    void setDistances(const std::vector<double>& meters) { m_distances = meters; }
+    const std::vector<double>& distances() const { return m_distances; }
+
+    /**
+     * @brief Durations in seconds for climbing-rate windows (default 5, 10 and 20 minutes)
+     */
+    void setDurations(const std::vector<double>& seconds) { m_durations = seconds; }
+    const std::vector<double>& durations() const { return m_durations; }
+
+    /**
+     * @brief Best efforts for all configured windows, distances first
+     */
+    std::vector<BestEffort> find(const TrackColumns& columns) const;
+
+private:
+    std::vector<double> m_distances;
+    std::vector<double> m_durations;
+};
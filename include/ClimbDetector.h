@@ -0,0 +1,63 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QString>
+#include <vector>
+
+// A significant climb, scored on the usual Cat 4 to HC scale
+struct Climb {
+    enum Category { CATEGORY_4, CATEGORY_3, CATEGORY_2, CATEGORY_1, HORS_CATEGORIE };
+    Category category;
+    size_t startIndex;      // Lowest point
+    size_t endIndex;        // Summit
+    double distance;        // in meters
+    double elevationGain;   // in meters, summit minus start
+    double avgGradient;     // in percent
+    double maxGradient;     // in percent
+    double score;           // distance in meters times average gradient in percent
+};
+
+/**
+ * @brief Tunables for ClimbDetector
+ */
+struct ClimbParams {
+    double minDistance = 500.0;     // Shortest climb in meters
+    double minAvgGradient = 3.0;    // Flattest climb in percent
+    double minScore = 8000.0;       // Lowest score kept (the Cat 4 threshold)
+    double maxDip = 10.0;           // Descent tolerated inside a climb in meters...
+    double maxDipFraction = 0.1;    // ...or this fraction of the gain so far, if larger
+    double rampTolerance = 0.2;     // Elevation noise ignored at the foot and summit in meters
+};
+
+/**
+ * @brief Finds and categorizes every significant climb of a track
+ *
+ * A single scan splits the elevation series into valley-to-summit
+ * candidates, ending a candidate once the descent from its summit exceeds
+ * the dip tolerance. Candidates are trimmed and merged with range
+ * minimum/maximum queries (RangeQuery.h), so detection is linear in the
+ * number of points plus O(log n) per climb.
+ */
+class ClimbDetector {
+public:
+    ClimbDetector() = default;
+    explicit ClimbDetector(const ClimbParams& params) : m_params(params) {}
+
+    const ClimbParams& params() const { return m_params; }
+
+    /**
+     * @brief Detect climbs in start order
+     * @param points Track points with cumulative distances and parser gradients
+     */
+    std::vector<Climb> detect(const std::vector<TrackPoint>& points) const;
+
+    // Category for a climb score, and the lowest score of each category
+    static Climb::Category categorize(double score);
+    static double categoryThreshold(Climb::Category category);
+    static QString categoryName(Climb::Category category);
+
+private:
+    ClimbParams m_params;
+
+    double dipTolerance(double gain) const;
+};
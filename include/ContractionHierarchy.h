@@ -0,0 +1,102 @@
+#pragma once
+
+#include "RoadGraph.h"
+#include <QGeoCoordinate>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief Road route between two positions on the road graph
+ */
+struct RouteLeg {
+    bool found = false;
+    double length = 0.0;                    // m
+    std::vector<QGeoCoordinate> points;     // Start position, road nodes, end position
+};
+
+/**
+ * @brief Contraction hierarchy over a RoadGraph for fast shortest routes
+ *
+ * Preprocessing contracts the nodes one by one, least important first
+ * (lazy updated edge difference plus contracted neighbors). Contracting a
+ * node adds a shortcut between two of its neighbors unless a bounded
+ * witness search finds a path at least as short without it. A query is
+ * then a bidirectional Dijkstra that only moves up the order, which
+ * settles a few hundred nodes instead of a whole city; shortcuts are
+ * unpacked into road nodes afterwards.
+ *
+ * One-way rules carry over: the graph is directed throughout. The graph
+ * must outlive the hierarchy. Queries reuse scratch arrays, so a
+ * hierarchy must not be queried from several threads at once.
+ * Contraction takes seconds for a city, so the result can be saved and
+ * loaded again for the same extract.
+ */
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() = default;
+    explicit ContractionHierarchy(const RoadGraph& graph);
+
+    bool isEmpty() const { return m_rank.empty(); }
+    size_t shortcutCount() const { return m_shortcutCount; }
+
+    /**
+     * @brief Shortest route between two road positions, e.g. snapped clicks
+     */
+    RouteLeg route(const RoadCandidate& from, const RoadCandidate& to);
+
+    /**
+     * @brief Shortest route length between two nodes, infinity when unreachable
+     */
+    double distance(qint32 source, qint32 target);
+
+    /**
+     * @brief Write the preprocessed hierarchy, so it is built once per extract
+     */
+    bool save(const QString& filename) const;
+
+    /**
+     * @brief Read a hierarchy written by save() for this graph
+     * @return False if the file is missing, damaged or made for another graph
+     */
+    bool load(const QString& filename, const RoadGraph& graph);
+
+    /**
+     * @brief Cache file for the hierarchy of an extract, keyed by its path, size and date
+     */
+    static QString cachePath(const QString& extractFile);
+
+private:
+    struct Edge {
+        qint32 from;
+        qint32 to;
+        float weight;
+        qint32 first;       // Shortcuts: the two edges they replace, -1 for road arcs
+        qint32 second;
+    };
+    struct Seed {
+        qint32 node;
+        double distance;
+    };
+
+    void contract();
+    void buildSearchGraphs();
+    double query(const std::vector<Seed>& sources, const std::vector<Seed>& targets, std::vector<qint32>* nodes);
+    void unpack(qint32 edge, std::vector<qint32>& nodes) const;
+
+    const RoadGraph* m_graph = nullptr;
+    std::vector<Edge> m_edges;
+    std::vector<qint32> m_rank;             // Contraction order of each node
+    size_t m_shortcutCount = 0;
+
+    // Search graphs, CSR over edge ids: upward out-edges and upward reversed in-edges
+    std::vector<quint32> m_upOffsets;
+    std::vector<qint32> m_upEdges;
+    std::vector<quint32> m_downOffsets;
+    std::vector<qint32> m_downEdges;
+
+    // Query scratch, infinite between queries
+    std::vector<double> m_forwardDistance;
+    std::vector<double> m_backwardDistance;
+    std::vector<qint32> m_forwardEdge;
+    std::vector<qint32> m_backwardEdge;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <QGeoCoordinate>
+#include <vector>
+
+/**
+ * @brief Tuning of the elevation gain estimators
+ */
+struct GainParams {
+    double threshold = 0.6;          // Steps at or below this are ignored (m), as GPXParser
+    double hysteresisBand = 3.0;     // Elevation must move this far from the last turning point (m)
+    double smoothingWindow = 100.0;  // Width of the centered moving average (m of distance)
+};
+
+/**
+ * @brief Total elevation gain of one track under each estimator, in meters
+ *
+ * The estimators disagree by design: raw sums every rise including GPS
+ * noise, threshold is what the rest of the app reports, hysteresis is
+ * close to what barometric devices do, smoothed sums a distance-averaged
+ * profile and DEM sums the threshold gain of terrain model elevations.
+ */
+struct ElevationGainReport {
+    double raw = 0.0;
+    double threshold = 0.0;
+    double hysteresis = 0.0;
+    double smoothed = 0.0;
+    double dem = 0.0;           // NaN without DEM elevations for every point
+};
+
+/**
+ * @brief Computes all elevation gain estimators in one fused pass
+ *
+ * A single loop walks the elevation and distance columns once: the raw,
+ * threshold and hysteresis sums update from the current step, while a
+ * pair of pointers keeps the running sum of the smoothing window centered
+ * on the current point, so the smoothed profile is never materialized.
+ * The DEM series, when given, is read in the same loop.
+ */
+class ElevationGainEstimator {
+public:
+    explicit ElevationGainEstimator(const GainParams& params = GainParams()) : m_params(params) {}
+
+    const GainParams& params() const { return m_params; }
+
+    /**
+     * @brief Gain of a track under every estimator
+     * @param demElevation Terrain model elevation per row (see sampleDem); empty or
+     *        containing NaN leaves the DEM estimate NaN
+     */
+    ElevationGainReport estimate(const TrackColumns& columns,
+                                 const std::vector<double>& demElevation = std::vector<double>()) const;
+
+    /**
+     * @brief Bilinear lookup of every track point in an elevation grid
+     *
+     * The grid layout is TerrainService's: rows run from south to north and
+     * columns from west to east, spanning the bounding box corners evenly.
+     * Points outside the grid get NaN.
+     */
+    static std::vector<double> sampleDem(const std::vector<std::vector<float>>& grid,
+                                         const QGeoCoordinate& topLeft, const QGeoCoordinate& bottomRight,
+                                         const TrackColumns& columns);
+
+private:
+    GainParams m_params;
+};
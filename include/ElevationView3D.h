@@ -3,6 +3,7 @@
 #include <QWidget>
 #include <vector>
 #include "GpxParser.h"
+#include "TrackView.h"
 #include "TerrainService.h"
 #include <QPushButton>
 #include <QSlider>
@@ -26,12 +27,18 @@ public:
 
     // Public API used by MainWindow
     void setTrackData(const std::vector<TrackPoint>& points);
+    void setTrackData(const TrackView& track);
     void updatePosition(size_t pointIndex);
     void setElevationScale(float scale);
+    
+    // Second marker for a ghost rider; hidden when coord is invalid
+    void updateGhostPosition(const QGeoCoordinate& coord, double elevation);
 
 signals:
     // Public signal used by MainWindow
     void positionChanged(int pointIndex);
+    // Emitted with every terrain grid fetched for the current track
+    void terrainLoaded(const TerrainData& data);
 
 private slots:
     void onPlayPause(bool checked);
@@ -50,6 +57,7 @@ private:
     RouteRenderer* m_routeRenderer;
     FlythroughController* m_flythroughController;
     Qt3DCore::QEntity* m_markerEntity;
+    Qt3DCore::QEntity* m_ghostEntity;
     Qt3DExtras::QOrbitCameraController* m_orbitController;
     Qt3DCore::QEntity* m_terrainEntity;
 
@@ -57,7 +65,7 @@ private:
     TerrainService* m_terrainService;
 
     // Data
-    std::vector<TrackPoint> m_trackPoints;
+    TrackView m_track;
     float m_elevationScale;
 
     // UI Elements
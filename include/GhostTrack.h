@@ -0,0 +1,75 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QGeoCoordinate>
+#include <vector>
+
+/**
+ * @brief Where the ghost is at one moment of the replay
+ */
+struct GhostPosition {
+    bool valid = false;
+    size_t index = 0;               // Ghost point at or before the moment
+    QGeoCoordinate coord;           // Interpolated between ghost points
+    double elevation = 0.0;         // m
+    double distance = 0.0;          // Along the reference track, for the profile (m)
+    bool finished = false;          // The ghost's ride is over; it waits at its last point
+};
+
+/**
+ * @brief A second effort replayed against the displayed track
+ *
+ * The ghost is placed where it was at the same elapsed time as the rider.
+ * A table of the last ghost point at or before every whole second is
+ * built once, so a lookup is a table read plus a few steps forward; the
+ * cursor of the previous lookup makes the steady advance of playback
+ * amortized O(1) without touching the table at all.
+ *
+ * The time gap at each reference point is precomputed from a DTW alignment
+ * of the two rides (TrackAligner), so it compares the two efforts at the
+ * same place on the road rather than at the same, drifting distance count.
+ */
+class GhostTrack {
+public:
+    GhostTrack() = default;
+
+    /**
+     * @brief Prepare a ghost for a reference track
+     *
+     * Both tracks need timestamps; otherwise the ghost stays empty.
+     */
+    GhostTrack(const std::vector<TrackPoint>& ghost, const std::vector<TrackPoint>& reference);
+
+    bool isEmpty() const { return m_elapsedMs.empty(); }
+    size_t size() const { return m_elapsedMs.size(); }
+    double duration() const { return isEmpty() ? 0.0 : m_elapsedMs.back() / 1000.0; }
+
+    /**
+     * @brief Ghost point at or before an elapsed time in seconds
+     */
+    size_t indexAtTime(double elapsed);
+
+    /**
+     * @brief Ghost position at an elapsed time in seconds
+     */
+    GhostPosition positionAt(double elapsed);
+
+    /**
+     * @brief Elapsed seconds of a reference point, NaN out of range
+     */
+    double referenceElapsed(size_t referenceIndex) const;
+
+    /**
+     * @brief Seconds the rider is behind the ghost at a reference point (negative when ahead)
+     */
+    double timeGapAt(size_t referenceIndex) const;
+
+private:
+    std::vector<TrackPoint> m_points;
+    std::vector<qint64> m_elapsedMs;            // Ghost time since its first point
+    std::vector<size_t> m_indexAtSecond;        // Last ghost point at or before each whole second
+    std::vector<double> m_referenceDistance;    // Reference distance of each ghost point
+    std::vector<qint64> m_referenceElapsedMs;   // Rider time since the first reference point
+    std::vector<double> m_timeGap;              // Per reference point, seconds
+    size_t m_cursor = 0;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QString>
+#include <QDateTime>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Byte range of a GPX file holding a contiguous run of track points
+ *
+ * Produced by GpxIndex and consumed by GPXParser::parseWindow().
+ */
+struct GpxWindow {
+    qint64 beginOffset = 0;      ///< Byte offset of the first <trkpt> in the window
+    qint64 endOffset = 0;        ///< Byte offset just past the window
+    size_t firstPointIndex = 0;  ///< Index of the first window point in the whole track
+    double startDistance = 0.0;  ///< Cumulative distance of the first window point in meters
+
+    bool isValid() const { return endOffset > beginOffset; }
+};
+
+/**
+ * @brief Sparse byte-offset index of a GPX file for random-access loading
+ *
+ * Every N-th track point the index records the byte offset of its <trkpt>
+ * element together with its cumulative distance, timestamp and position.
+ * The index is built with a single byte scan (no XML parsing) and stored in
+ * a small sidecar file next to the GPX, so large recordings can be shown as
+ * a coarse overview and loaded at full resolution one window at a time.
+ */
+class GpxIndex {
+public:
+    struct Entry {
+        qint64 pointIndex = 0;   ///< Index of the point in the whole track
+        qint64 byteOffset = 0;   ///< Offset of the "<trkpt" tag
+        double distance = 0.0;   ///< Cumulative distance in meters
+        qint64 timeMs = -1;      ///< Milliseconds since epoch, -1 if the point has no time
+        double latitude = 0.0;
+        double longitude = 0.0;
+        double elevation = 0.0;
+    };
+
+    static const int DEFAULT_STRIDE = 500;
+
+    GpxIndex() = default;
+
+    /**
+     * @brief Scan a GPX file and build its index
+     *
+     * Entries are recorded for every stride-th point plus the last point.
+     * @param filename Path to the GPX file
+     * @param stride Number of points between index entries
+     * @return True if at least one track point was found
+     */
+    bool build(const QString& filename, int stride = DEFAULT_STRIDE);
+
+    /**
+     * @brief Load the sidecar index if it matches the file, otherwise build and save it
+     * @param filename Path to the GPX file
+     * @param stride Number of points between index entries when rebuilding
+     * @return True if a usable index is available
+     */
+    bool loadOrBuild(const QString& filename, int stride = DEFAULT_STRIDE);
+
+    /**
+     * @brief Write the index to a sidecar file
+     * @param path Destination, defaults to sidecarPath(sourceFile())
+     */
+    bool save(const QString& path = QString()) const;
+
+    /**
+     * @brief Read an index from a sidecar file, checking it against the GPX file
+     * @param filename Path to the GPX file the index belongs to
+     */
+    bool load(const QString& filename);
+
+    /**
+     * @brief Sidecar location for a GPX file (<file>.idx)
+     */
+    static QString sidecarPath(const QString& filename);
+
+    /**
+     * @brief Window covering all points between two cumulative distances
+     */
+    GpxWindow windowForDistance(double startDistance, double endDistance) const;
+
+    /**
+     * @brief Window covering all points between two timestamps
+     * @return Invalid window if the track has no timestamps
+     */
+    GpxWindow windowForTime(const QDateTime& start, const QDateTime& end) const;
+
+    /**
+     * @brief One track point per index entry, for drawing a coarse overview
+     */
+    std::vector<TrackPoint> overviewPoints() const;
+
+    bool isEmpty() const { return m_entries.empty(); }
+    const QString& sourceFile() const { return m_sourceFile; }
+    const std::vector<Entry>& entries() const { return m_entries; }
+    int stride() const { return m_stride; }
+    qint64 pointCount() const { return m_pointCount; }
+    double totalDistance() const { return m_totalDistance; }
+
+    /// Bytes before the first track point (XML declaration, <gpx>, <trk>, <trkseg>)
+    qint64 prefixLength() const { return m_prefixLength; }
+    /// Offset of the bytes after the last track point (closing tags)
+    qint64 suffixOffset() const { return m_suffixOffset; }
+
+private:
+    QString m_sourceFile;
+    qint64 m_sourceSize = 0;
+    qint64 m_sourceModified = 0;
+    int m_stride = DEFAULT_STRIDE;
+    qint64 m_pointCount = 0;
+    double m_totalDistance = 0.0;
+    qint64 m_prefixLength = 0;
+    qint64 m_suffixOffset = 0;
+    std::vector<Entry> m_entries;
+
+    void clear();
+    GpxWindow windowForEntries(size_t first, size_t last) const;
+};
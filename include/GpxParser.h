@@ -5,6 +5,10 @@
 #include <QDateTime>
 #include <vector>
 #include <memory>
+#include <limits>
+
+struct GpxWindow;
+class GpxIndex;
 
 /**
  * @brief Structure to hold track point data with geographical and metric information
@@ -15,6 +19,10 @@ struct TrackPoint {
     double distance = 0.0;    ///< Cumulative distance in meters from start
     double gradient = 0.0;    ///< Gradient (slope) in percent at this point
     QDateTime timestamp;      ///< Timestamp of the track point
+    double heartRate = std::numeric_limits<double>::quiet_NaN();   ///< Heart rate in bpm (NaN if not recorded)
+    double cadence = std::numeric_limits<double>::quiet_NaN();     ///< Cadence in rpm (NaN if not recorded)
+    double power = std::numeric_limits<double>::quiet_NaN();       ///< Power in watts (NaN if not recorded)
+    double temperature = std::numeric_limits<double>::quiet_NaN(); ///< Air temperature in Celsius (NaN if not recorded)
     
     // Default constructor
     TrackPoint() = default;
@@ -51,11 +59,46 @@ public:
      */
     bool parseData(const QString& data);
 
+    /**
+     * @brief Parse only a window of an indexed GPX file
+     *
+     * Reads the file header, the window's bytes and the closing tags, so the
+     * cost depends on the window size rather than the file size. Point
+     * distances stay cumulative from the start of the whole track.
+     * @param index Index built for the file (see GpxIndex)
+     * @param window Byte range from GpxIndex::windowForDistance() or windowForTime()
+     * @return True if parsing successful, false otherwise
+     */
+    bool parseWindow(const GpxIndex& index, const GpxWindow& window);
+
+    /**
+     * @brief Replace the track with already-built points
+     *
+     * Distances are kept as given; gradients and elevation range are recomputed.
+     * @param points Track points with cumulative distances
+     */
+    void setPoints(std::vector<TrackPoint> points);
+
+    /**
+     * @brief Index of the first parsed point within the whole track
+     * @return 0 unless the points came from parseWindow()
+     */
+    size_t getFirstPointIndex() const { return m_firstPointIndex; }
+
     /**
      * @brief Get all parsed track points
      * @return Vector of track points
      */
-    const std::vector<TrackPoint>& getPoints() const { return m_points; }
+    const std::vector<TrackPoint>& getPoints() const { return *m_points; }
+
+    /**
+     * @brief Get the parsed points as a shared, immutable store
+     *
+     * The store stays valid after the parser is cleared or re-used, so
+     * TrackView objects can reference it without copying.
+     * @return Shared pointer to the track points
+     */
+    std::shared_ptr<const std::vector<TrackPoint>> sharedPoints() const { return m_points; }
 
     /**
      * @brief Calculate cumulative elevation gain up to specific point
@@ -101,9 +144,10 @@ public:
     void clear();
 
 private:
-    std::vector<TrackPoint> m_points;  ///< Storage for parsed track points
+    std::shared_ptr<std::vector<TrackPoint>> m_points = std::make_shared<std::vector<TrackPoint>>();  ///< Storage for parsed track points, shared with views
     double m_minElevation = 0.0;
     double m_maxElevation = 0.0;
+    size_t m_firstPointIndex = 0;
     
     /**
      * @brief Process a track point from XML
@@ -112,6 +156,13 @@ private:
      */
     bool processTrackPoint(QXmlStreamReader& xml);
 
+    /**
+     * @brief Read a numeric sensor extension element (hr, cad, power, atemp)
+     * @param xml XML stream reader positioned at the element
+     * @return Parsed value, or NaN if the text is not a number
+     */
+    double parseSensorValue(QXmlStreamReader& xml);
+
     /**
      * @brief Main parsing logic for different sources
      * @param xml XML stream reader to parse from
@@ -13,9 +13,11 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QStatusBar>
+#include <QFutureWatcher>
 #include <functional>
 #include <vector>
 #include <memory>
+#include "RouteSimilarity.h"
 
 /**
  * @brief A landing page widget shown when the application starts
@@ -70,6 +72,10 @@ private slots:
     void handleHelpClicked();
     void handleSettingsClicked();
     void handleShow3DViewClicked();
+    void handleChooseLibraryClicked();
+    void handleFindSimilarClicked();
+    void handleSimilarityFinished();
+    void handleSimilarRouteClicked(QListWidgetItem* item);
     
 private:
     static const int MAX_RECENT_FILES = 10;
@@ -80,6 +86,11 @@ private:
     QLabel* m_subtitleLabel;
     QListWidget* m_recentFilesListWidget;
     QListWidget* m_samplesListWidget;
+    QListWidget* m_similarListWidget;
+    QLabel* m_similarStatusLabel;
+    QPushButton* m_findSimilarButton;
+    QFutureWatcher<std::vector<RouteMatch>>* m_similarityWatcher;
+    QString m_similarQuery;          // Track the current matches are for
     QLabel* m_tipLabel;
     QPushButton* m_newTipButton;
     QStatusBar* m_statusBar = nullptr;
@@ -91,6 +102,8 @@ private:
     void setupStyles();
     QString truncateFilePath(const QString& path, int maxLength = 50);
     void loadSampleRoutes();
+    QString libraryDirectory() const;
+    void findSimilarRoutes(const QString& filePath);
     void loadTips();
     void showNextTip();
     QStatusBar* statusBar();
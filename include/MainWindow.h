@@ -5,12 +5,22 @@
 #include <QTimer>
 #include <QTabWidget>
 #include <QStackedWidget>
+#include <QFutureWatcher>
+#include <memory>
 #include "../third_party/qcustomplot.h"
 #include "GpxParser.h"
+#include "TrackView.h"
+#include "TrackRangeStats.h"
+#include "GpxIndex.h"
 #include "MapWidget.h"
 #include "TrackStatsWidget.h"
 #include "ElevationView3D.h"
 #include "LandingPage.h"
+#include "SegmentMatcher.h"
+#include "TrackAligner.h"
+#include "GhostTrack.h"
+#include "MapMatcher.h"
+#include "ContractionHierarchy.h"
 
 class MainWindow : public QMainWindow
 {
@@ -32,12 +42,48 @@ private slots:
     void createNewRoute();
     void showSettings();
     void show3DView();
+    void exportTrackData();
+    void trimStartAtMarker();
+    void trimEndAtMarker();
+    void reverseTrack();
+    void appendTrack();
+    void resetTrack();
+    void snapToRoads();
+    void handleSnapFinished();
+    void handleMetricsChanged();
+    void handleRoutingReady();
+    void addRouteWaypoint(const QGeoCoordinate& coordinate);
+    void undoRouteWaypoint();
+    void finishRoute();
+    void handleProfileRangeChanged(const QCPRange& range);
+    void handleMapViewportChanged(const QGeoCoordinate& topLeft, const QGeoCoordinate& bottomRight);
+    void loadDetailWindow();
+    void handleLazyLoadFinished();
+    void setRangeSelectionEnabled(bool enabled);
+    void handleRangeSelected(const QRect& rect, QMouseEvent* event);
+    void findSegmentEfforts();
+    void handleSegmentEffortsFound();
+    void compareWithRide();
+    void handleComparisonFinished();
+    void loadGhost();
+    void handleGhostLoaded();
+    void removeGhost();
 
 private:
     void setupUi();
+    void openIndexedFile(const QString& filePath);
+    void showIndexedFile(const QString& filePath, const GpxIndex& index);
+    void displayTrack();
     void plotElevationProfile();
+    void plotMotionOverlays(const QVector<double>& distances);
     void updatePlotPosition(const TrackPoint& point);
+    void clearRangeSelection();
+    void updateGhost();
+    void applyZoneSettings();
     size_t findClosestPointByDistance(double targetDistance);
+    QString roadExtractFile();
+    void useRoadExtract(const QString& extract);
+    void updatePlannedRoute();
     void addToRecentFiles(const QString& filePath);
 
     // UI Elements
@@ -48,14 +94,84 @@ private:
     MapWidget *m_mapView;
     QCustomPlot *m_elevationPlot;
     QSlider *m_positionSlider;
+    QPushButton *m_rangeSelectButton;
+    QLabel *m_rangeStatsLabel;
+    QLabel *m_ghostLabel;
+    QCPItemRect *m_rangeHighlight;
+    QAction *m_segmentEffortsAction;
     TrackStatsWidget *m_statsWidget;
     ElevationView3D *m_elevation3DView;
 
     // Data
     GPXParser m_gpxParser;
+    TrackView m_track;  // Displayed view (trimmed, reversed, ...) of the parsed points
     size_t m_currentPointIndex;
+    size_t m_selectionStart;       // Point range of the current brush selection
+    size_t m_selectionEnd;
+    
+    // Segment search over the library, with the index it used and the library state it was built from
+    struct SegmentSearch {
+        std::shared_ptr<SegmentIndex> index;
+        QByteArray libraryState;
+        std::vector<SegmentEffort> efforts;
+    };
+    
+    // Spatial index of the library, built on the first segment search and kept for later ones
+    // until the folder or any file in it changes
+    std::shared_ptr<SegmentIndex> m_segmentIndex;
+    QString m_segmentIndexDirectory;
+    QByteArray m_segmentIndexState;
+    QFutureWatcher<SegmentSearch>* m_segmentWatcher;
+    
+    // Ride compared against the displayed track
+    QString m_comparedFile;
+    QFutureWatcher<TrackAlignment>* m_comparisonWatcher;
+    
+    // Road network of the OpenStreetMap extract used to snap tracks
+    std::shared_ptr<RoadGraph> m_roadGraph;
+    QString m_roadGraphFile;
+    QFutureWatcher<MapMatchResult>* m_snapWatcher;
+    TrackView m_snapTrack;  // View being snapped; the result is dropped once m_track moves on
+    
+    // Route planning on the same extract: hierarchy over m_roadGraph, clicked waypoints
+    // snapped to roads, and the planned points with the point count after each waypoint
+    std::shared_ptr<ContractionHierarchy> m_routing;
+    QFutureWatcher<bool>* m_routingWatcher;
+    bool m_planning;
+    std::vector<RoadCandidate> m_waypointRoads;
+    std::vector<QGeoCoordinate> m_waypoints;
+    std::vector<TrackPoint> m_plannedPoints;
+    std::vector<size_t> m_waypointEnds;
+    QAction* m_undoWaypointAction;
+    QAction* m_finishRouteAction;
+    
+    // Ghost rider replayed at the same elapsed time as the current position
+    GhostTrack m_ghost;
+    QString m_ghostFile;
+    QFutureWatcher<GhostTrack>* m_ghostWatcher;
     
     // Flag to prevent feedback loops when updating slider programmatically
     bool m_updatingFromHover;
     bool m_updatingFrom3D;
+    
+    // Background work for large files: building the index of a newly opened file,
+    // or parsing one detail window from the current index
+    struct LazyLoad {
+        QString indexedFile;                                  // Set when the task built an index
+        GpxIndex index;
+        bool indexed = false;
+        std::shared_ptr<const std::vector<TrackPoint>> points; // Window points, null if parsing failed
+    };
+    
+    // Large files: sparse index, overview in m_gpxParser and one full-resolution window, plus
+    // the file being indexed or the window being parsed (cleared once they no longer apply)
+    GpxIndex m_gpxIndex;
+    GpxWindow m_detailWindow;
+    QString m_pendingIndexFile;
+    GpxWindow m_pendingWindow;
+    QFutureWatcher<LazyLoad>* m_detailWatcher;
+    QTimer* m_detailTimer;
+    bool m_lazyLoaded;
+    double m_detailStart;
+    double m_detailEnd;
 };
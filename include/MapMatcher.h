@@ -0,0 +1,94 @@
+#pragma once
+
+#include "GpxParser.h"
+#include "RoadGraph.h"
+#include <QGeoCoordinate>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Tuning of the road snapping
+ */
+struct MapMatchParams {
+    double sigma = 8.0;             // GPS noise, standard deviation (m)
+    double searchRadius = 50.0;     // Roads farther than this from a point are not candidates (m)
+    int maxCandidates = 8;          // Nearest roads kept per point
+    double beta = 10.0;             // Tolerated route minus straight-line difference (m)
+    double minSpacing = 15.0;       // Points closer than this to the last used point are not scored (m)
+    double routeFactor = 4.0;       // Route search bound, as a multiple of the straight-line distance
+    double routeSlack = 200.0;      // Route search bound, added (m)
+};
+
+/**
+ * @brief Road position of one track point
+ */
+struct MatchedPoint {
+    bool matched = false;
+    QGeoCoordinate coord;           // On the road; invalid when not matched
+    qint32 segment = -1;            // RoadGraph segment
+    double offset = 0.0;            // Distance from the recorded position (m)
+};
+
+/**
+ * @brief Track snapped onto the road graph
+ */
+struct MapMatchResult {
+    std::vector<MatchedPoint> points;       // One per input point
+    std::vector<QGeoCoordinate> path;       // Road geometry ridden, start to end
+    int breaks = 0;                         // Places where no road route joined two points
+    size_t usedPoints = 0;                  // Points scored by the HMM after spacing
+
+    size_t matchedCount() const;
+};
+
+/**
+ * @brief Hidden Markov model map matching (Newson and Krumm)
+ *
+ * The hidden states of a point are the nearest road positions within
+ * searchRadius. A state scores its Gaussian distance from the recorded
+ * position; a move between the states of consecutive points scores how
+ * much the road route between them is longer than the straight line, so
+ * the Viterbi path follows roads the rider could actually have taken,
+ * one-way rules included. When no route joins two points the chain is
+ * restarted and a break is counted.
+ *
+ * Points within minSpacing of the last used point carry little extra
+ * information and are only projected onto the route chosen around them,
+ * which keeps dense 1 Hz recordings cheap. Route distances come from
+ * Dijkstra searches bounded by the straight-line distance; each search
+ * tree is cached per start node, since consecutive points share most of
+ * their candidates.
+ */
+class MapMatcher {
+public:
+    explicit MapMatcher(const RoadGraph& graph, const MapMatchParams& params = MapMatchParams());
+
+    /**
+     * @brief Snap a track onto the roads
+     */
+    MapMatchResult match(const std::vector<TrackPoint>& points);
+
+private:
+    struct Settled {
+        qint32 node;
+        float distance;
+        qint32 previous;                    // -1 at the start node
+    };
+    struct Tree {
+        double bound = 0.0;
+        std::vector<Settled> settled;       // Sorted by node
+    };
+
+    const Tree& treeFrom(qint32 node, double bound);
+    const Settled* find(const Tree& tree, qint32 node) const;
+    double routeDistance(const RoadCandidate& a, const RoadCandidate& b, double bound,
+                         std::vector<qint32>* nodes = nullptr);
+    qint32 segmentBetween(qint32 from, qint32 to) const;
+    RoadCandidate projectOnto(qint32 segment, double x, double y) const;
+
+    const RoadGraph& m_graph;
+    MapMatchParams m_params;
+    std::unordered_map<qint32, Tree> m_trees;
+    std::vector<float> m_distance;          // Dijkstra scratch, infinite between searches
+    std::vector<qint32> m_previous;
+};
@@ -9,7 +9,10 @@
 #include <QDir>
 #include <vector>
 #include <QToolTip>
-#include "TrackStatsWidget.h" // Include to use TrackSegment
+#include <QColor>
+#include <QPixmap>
+#include "TrackAnalyzer.h"
+#include "TrackView.h"
 
 /**
  * @brief Widget that displays an interactive map with routes and markers
@@ -28,18 +31,46 @@ public:
     void setRoute(const std::vector<QGeoCoordinate>& coordinates);
     void updateMarker(const QGeoCoordinate& coordinate);
     
+    // Ghost rider marker; an invalid coordinate hides it
+    void updateGhostMarker(const QGeoCoordinate& coordinate);
+    
     // New method to set route with segment information
     void setRouteWithSegments(const std::vector<QGeoCoordinate>& coordinates, 
                              const std::vector<TrackSegment>& segments,
                              const std::vector<TrackPoint>& points);
+    
+    // Set route from a track view, colored by the segment level matching the zoom
+    void setRouteWithSegments(const TrackView& track, const TrackAnalysisResult& analysis);
+    
+    // Recolor the current route, keeping the map position (e.g. when analysis finishes)
+    void setAnalysis(const TrackAnalysisResult& analysis);
                              
     // Get the raw track points for hover information
     void setTrackPoints(const std::vector<TrackPoint>& points);
+    void setTrackView(const TrackView& track);
+    
+    // Full-resolution part of a lazily loaded route, drawn over the overview
+    void setDetailRoute(const std::vector<QGeoCoordinate>& coordinates);
+    
+    // Route planning: new routes keep the map position instead of zooming to fit
+    void setPlanningMode(bool planning);
+    
+    // Move the view without changing the route
+    void centerOn(const QGeoCoordinate& coordinate, int zoom);
+    
+    // Numbered markers for the clicked waypoints of a planned route
+    void setWaypoints(const std::vector<QGeoCoordinate>& waypoints);
     
 signals:
     // Signal to notify about hover position change
     void routeHovered(int pointIndex);
     
+    // Emitted after the user zooms or pans the map
+    void viewportChanged(const QGeoCoordinate& topLeft, const QGeoCoordinate& bottomRight);
+    
+    // Emitted when the map is clicked without dragging it
+    void mapClicked(const QGeoCoordinate& coordinate);
+    
 protected:
     // Event handlers
     void paintEvent(QPaintEvent* event) override;
@@ -54,11 +85,16 @@ private:
     QGeoCoordinate mCenterCoordinate;
     bool mIsPanning;
     QPoint mLastMousePos;
+    QPoint mPressMousePos;
+    bool mPlanningMode;
     
     // Route and marker
     QList<QGeoCoordinate> mRouteCoordinates;
+    QList<QGeoCoordinate> mDetailCoordinates;
     QGeoCoordinate mCurrentMarkerCoordinate;
-    std::vector<TrackPoint> mTrackPoints;
+    QGeoCoordinate mGhostMarkerCoordinate;
+    QList<QGeoCoordinate> mWaypoints;
+    TrackView mTrack;
     
     // Hover detection
     int mHoverPointIndex;
@@ -72,6 +108,8 @@ private:
     };
     QList<RouteSegment> mRouteSegments;
     bool mHasSegments;
+    TrackAnalysisResult mAnalysis;   // Segment hierarchy the route colors are taken from
+    int mSegmentLevel;               // Hierarchy level currently drawn, -1 if none
     
     // Tile management
     QNetworkAccessManager* mNetworkManager;
@@ -83,6 +121,11 @@ private:
     QGeoCoordinate pixelToGeo(const QPoint& pixel, const QGeoCoordinate& center, int zoom, const QSize& size);
     QColor getSegmentColor(const TrackSegment& segment) const;
     QColor enhanceColor(const QColor& color) const; // Helper method to improve color visibility
+    void emitViewportChanged();
+    void buildSegmentedRoute(const std::vector<QGeoCoordinate>& coordinates,
+                             const std::vector<TrackSegment>& segments);
+    void buildRouteSegments(const std::vector<TrackSegment>& segments);
+    void updateSegmentLevel();
     
     // Route hover detection
     int findClosestRoutePoint(const QPoint& mousePos);
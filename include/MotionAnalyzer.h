@@ -0,0 +1,61 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Thresholds for moving-time detection and pace smoothing
+ */
+struct MotionParams {
+    double stopSpeed = 0.5;         // Slower than this counts as stopped (m/s)
+    double maxGap = 120.0;          // Longer gaps between points count as paused recording (s)
+    double smoothingWindow = 30.0;  // Trailing window of the smoothed speed and pace (s)
+};
+
+/**
+ * @brief Per-point speed series and time totals of a track
+ *
+ * Series have one entry per point; entry i describes the interval from
+ * point i-1 to point i (entry 0 and untimed intervals are NaN).
+ */
+struct MotionProfile {
+    std::vector<double> speed;          // Instantaneous speed in m/s
+    std::vector<double> smoothedSpeed;  // Trailing-window speed in m/s
+    std::vector<double> pace;           // Smoothed pace in s/km, NaN while stopped
+    std::vector<uint8_t> moving;        // 1 if the interval counts as moving time
+
+    double elapsedTime = 0.0;           // First to last timestamp in seconds
+    double movingTime = 0.0;            // in seconds
+    double movingDistance = 0.0;        // in meters
+    double maxSpeed = 0.0;              // Highest smoothed speed in m/s
+
+    bool hasTime() const { return elapsedTime > 0.0; }
+    double stoppedTime() const { return elapsedTime - movingTime; }
+    double averageMovingSpeed() const { return movingTime > 0.0 ? movingDistance / movingTime : 0.0; }
+};
+
+/**
+ * @brief Time, speed and pace kernels over the columnar track data
+ *
+ * All series and totals come out of one fused pass over the timestamp and
+ * distance columns. The smoothed speed is a trailing time window over the
+ * cumulative distance, maintained with a second index into the same
+ * arrays, so the pass stays O(n) for any window length.
+ */
+class MotionAnalyzer {
+public:
+    MotionAnalyzer() = default;
+    explicit MotionAnalyzer(const MotionParams& params) : m_params(params) {}
+
+    const MotionParams& params() const { return m_params; }
+
+    /**
+     * @brief Compute speed series and moving time
+     * @param columns Track columns; an untimed track gives NaN series and zero totals
+     */
+    MotionProfile analyze(const TrackColumns& columns) const;
+
+private:
+    MotionParams m_params;
+};
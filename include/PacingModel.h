@@ -0,0 +1,73 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <vector>
+
+/**
+ * @brief Rider or hiker parameters of the pacing model
+ */
+struct RiderParams {
+    enum Mode { CYCLING, HIKING };
+    Mode mode = CYCLING;
+    
+    // Cycling: steady power against gravity, rolling resistance and drag
+    double power = 200.0;           // Watts at the pedals
+    double mass = 85.0;             // Rider and bike in kg
+    double dragArea = 0.32;         // CdA in m^2
+    double rollingResistance = 0.005;
+    double airDensity = 1.225;      // kg/m^3
+    double maxSpeed = 15.0;         // Braking limit on descents in m/s
+    double minSpeed = 1.0;          // Walking pace on very steep ramps in m/s
+    
+    // Hiking: Tobler's hiking function scaled by this factor
+    double hikingFactor = 1.0;
+};
+
+/**
+ * @brief Projected speed and elapsed time at every point of a route
+ */
+struct PacingEstimate {
+    std::vector<double> speed;      // m/s over the interval ending at each point
+    std::vector<double> elapsed;    // Seconds from the start to each point
+    
+    double totalTime() const { return elapsed.empty() ? 0.0 : elapsed.back(); }
+};
+
+/**
+ * @brief Estimates riding or hiking time of a route from its gradients
+ *
+ * Cycling speed solves the steady-state power balance
+ *   P = v * m * g * (sin(a) + Crr * cos(a)) + 0.5 * rho * CdA * v^3
+ * for v at every point. Newton's method starts to the right of the root,
+ * where the cubic is convex, so it converges without safeguards; every
+ * point runs the same fixed number of iterations over plain arrays, which
+ * keeps the loop branch-free and lets the compiler vectorize it.
+ */
+class PacingModel {
+public:
+    PacingModel() = default;
+    explicit PacingModel(const RiderParams& params) : m_params(params) {}
+    
+    const RiderParams& params() const { return m_params; }
+    
+    /**
+     * @brief Projected speed and elapsed time along a route
+     * @param columns Route columns; only distance and gradient are used
+     */
+    PacingEstimate estimate(const TrackColumns& columns) const;
+    
+    /**
+     * @brief Speed in m/s on a constant gradient (percent)
+     */
+    double speedAt(double gradient) const;
+    
+    /**
+     * @brief Total projected time for each parameter set, evaluated in parallel
+     */
+    static std::vector<double> sweep(const TrackColumns& columns, const std::vector<RiderParams>& grid);
+    
+private:
+    RiderParams m_params;
+    
+    void solveSpeeds(const std::vector<double>& gradients, std::vector<double>& speeds) const;
+};
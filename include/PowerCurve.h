@@ -0,0 +1,72 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <vector>
+
+/**
+ * @brief Best average power over one duration
+ */
+struct PowerCurvePoint {
+    int duration;       // in seconds
+    double power;       // Mean-maximal power in watts
+    int startSecond;    // Start of the best effort, in seconds from the first power sample
+};
+
+/**
+ * @brief Mean-maximal power curve of a ride, with power-duration estimates
+ *
+ * The power channel is resampled to 1 Hz (samples are held for up to
+ * MAX_HOLD_SECONDS, longer gaps count as zero power) and turned into a
+ * prefix sum, so the mean power of any window is one subtraction. Each
+ * sampled duration is then a single linear scan for the largest window
+ * sum. Durations are every second up to two minutes and logarithmically
+ * spaced after that, and the scans run in parallel across durations, so
+ * a 10 hour ride needs a few hundred O(n) scans instead of O(n^2) work.
+ */
+class PowerCurve {
+public:
+    static const int MAX_HOLD_SECONDS = 30;
+
+    PowerCurve() = default;
+
+    /**
+     * @brief Compute the curve from the power and timestamp columns
+     * @return Empty curve if the track has no timed power samples
+     */
+    static PowerCurve compute(const TrackColumns& columns);
+
+    /**
+     * @brief Compute the curve from a 1 Hz power series
+     */
+    static PowerCurve fromSeries(const std::vector<double>& watts);
+
+    bool isEmpty() const { return m_points.empty(); }
+    const std::vector<PowerCurvePoint>& points() const { return m_points; }
+
+    /**
+     * @brief Mean-maximal power for a duration in seconds
+     *
+     * Durations between sampled points return the value of the next longer
+     * sampled duration, a lower bound of the exact value.
+     */
+    double powerAt(int seconds) const;
+
+    /**
+     * @brief Critical power and W' of the two-parameter model P(t) = W'/t + CP
+     *
+     * Least-squares fit of work against duration over 3 to 20 minute efforts.
+     * Both are zero if the ride is too short.
+     */
+    double criticalPower() const { return m_criticalPower; }
+    double anaerobicCapacity() const { return m_anaerobicCapacity; }  // W' in joules
+
+    // Durations evaluated for a series of the given length in seconds
+    static std::vector<int> sampleDurations(int seriesLength);
+
+private:
+    std::vector<PowerCurvePoint> m_points;
+    double m_criticalPower = 0.0;
+    double m_anaerobicCapacity = 0.0;
+
+    void fitCriticalPower();
+};
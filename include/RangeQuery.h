@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Constant-time range minimum/maximum queries over a fixed series
+ *
+ * Block-decomposed sparse table: the series is cut into blocks of
+ * BLOCK_SIZE values, and a sparse table over the per-block extremes
+ * answers whole-block spans with two lookups. Partial blocks at the ends
+ * of a range are scanned directly, so memory stays O(n) instead of the
+ * O(n log n) of a plain sparse table while queries stay O(BLOCK_SIZE).
+ *
+ * Queries return the index of the extreme value; on ties the leftmost
+ * index wins. Compare is std::less for minima, std::greater for maxima.
+ */
+template <typename T, typename Compare>
+class RangeExtremum {
+public:
+    static const size_t BLOCK_SIZE = 32;
+
+    RangeExtremum() = default;
+
+    explicit RangeExtremum(std::vector<T> values)
+        : m_values(std::move(values))
+    {
+        const size_t blockCount = (m_values.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blockCount == 0) {
+            return;
+        }
+
+        // Level 0: extreme of every block
+        m_table.emplace_back(blockCount);
+        for (size_t block = 0; block < blockCount; ++block) {
+            size_t begin = block * BLOCK_SIZE;
+            m_table[0][block] = scan(begin, std::min(begin + BLOCK_SIZE, m_values.size()) - 1);
+        }
+
+        // Level k: extreme of 2^k consecutive blocks
+        for (size_t width = 2; width <= blockCount; width *= 2) {
+            const std::vector<size_t>& previous = m_table.back();
+            std::vector<size_t> level(blockCount - width + 1);
+            for (size_t block = 0; block < level.size(); ++block) {
+                level[block] = better(previous[block], previous[block + width / 2]);
+            }
+            m_table.push_back(std::move(level));
+        }
+    }
+
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+    const T& value(size_t index) const { return m_values[index]; }
+    const std::vector<T>& values() const { return m_values; }
+
+    /**
+     * @brief Index of the extreme value in the inclusive range [first, last]
+     */
+    size_t query(size_t first, size_t last) const {
+        if (first > last) {
+            std::swap(first, last);
+        }
+
+        size_t firstBlock = first / BLOCK_SIZE;
+        size_t lastBlock = last / BLOCK_SIZE;
+        if (lastBlock - firstBlock < 2) {
+            return scan(first, last);
+        }
+
+        size_t result = scan(first, (firstBlock + 1) * BLOCK_SIZE - 1);
+        result = better(result, blockQuery(firstBlock + 1, lastBlock - 1));
+        return better(result, scan(lastBlock * BLOCK_SIZE, last));
+    }
+
+    // Extreme value in the inclusive range [first, last]
+    const T& extreme(size_t first, size_t last) const { return m_values[query(first, last)]; }
+
+private:
+    std::vector<T> m_values;
+    std::vector<std::vector<size_t>> m_table;
+    Compare m_compare;
+
+    size_t better(size_t a, size_t b) const {
+        if (m_compare(m_values[b], m_values[a]) || (!m_compare(m_values[a], m_values[b]) && b < a)) {
+            return b;
+        }
+        return a;
+    }
+
+    size_t scan(size_t first, size_t last) const {
+        size_t result = first;
+        for (size_t i = first + 1; i <= last; ++i) {
+            if (m_compare(m_values[i], m_values[result])) {
+                result = i;
+            }
+        }
+        return result;
+    }
+
+    size_t blockQuery(size_t firstBlock, size_t lastBlock) const {
+        size_t count = lastBlock - firstBlock + 1;
+        size_t level = 0;
+        while ((size_t(2) << level) <= count) {
+            ++level;
+        }
+        return better(m_table[level][firstBlock], m_table[level][lastBlock + 1 - (size_t(1) << level)]);
+    }
+};
+
+template <typename T, typename Compare>
+const size_t RangeExtremum<T, Compare>::BLOCK_SIZE;
+
+using RangeMinimum = RangeExtremum<double, std::less<double>>;
+using RangeMaximum = RangeExtremum<double, std::greater<double>>;
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Straight piece of road between two consecutive way nodes
+ */
+struct RoadSegment {
+    qint32 from = 0;
+    qint32 to = 0;
+    bool forward = true;        // Travel from -> to allowed
+    bool backward = true;       // Travel to -> from allowed
+    float length = 0.0f;        // m
+};
+
+/**
+ * @brief A point of a road segment close to a query position
+ */
+struct RoadCandidate {
+    qint32 segment = -1;
+    double fraction = 0.0;      // Position along the segment, 0 at from, 1 at to
+    double distance = 0.0;      // From the query position (m)
+    double x = 0.0;             // Projected position on the segment (m)
+    double y = 0.0;
+};
+
+/**
+ * @brief Routable road network read from an OpenStreetMap extract
+ *
+ * loadPbf() reads the standard .osm.pbf format directly: blobs are
+ * inflated with Qt's zlib and the protobuf messages are decoded by hand,
+ * so no OSM library or network service is needed. The first pass keeps
+ * the ways tagged as roads, the second only the nodes they reference.
+ * Blocks of each pass are inflated and decoded in parallel.
+ *
+ * Every way node becomes a graph node and every pair of consecutive nodes
+ * a segment, with one-way rules applied. Positions are projected onto a
+ * plane around the extract's mean latitude. Segments are bucketed into
+ * grid cells along the cells they cross and stored sorted by cell, so
+ * candidate lookup is a few binary searches.
+ */
+class RoadGraph {
+public:
+    explicit RoadGraph(double cellSize = 100.0);
+
+    /**
+     * @brief Replace the graph with the roads of a .osm.pbf file
+     */
+    bool loadPbf(const QString& filename);
+    QString errorString() const { return m_errorString; }
+
+    // Building by hand (tests, other sources); call build() afterwards
+    qint32 addNode(double latitude, double longitude);
+    void addWay(const std::vector<qint32>& nodes, bool oneway = false);
+    void build();
+
+    bool isEmpty() const { return m_segments.empty(); }
+    size_t nodeCount() const { return m_latitude.size(); }
+    size_t segmentCount() const { return m_segments.size(); }
+    const RoadSegment& segment(qint32 id) const { return m_segments[id]; }
+    QGeoCoordinate nodeCoordinate(qint32 node) const { return QGeoCoordinate(m_latitude[node], m_longitude[node]); }
+
+    // Plane coordinates in meters
+    double nodeX(qint32 node) const { return m_x[node]; }
+    double nodeY(qint32 node) const { return m_y[node]; }
+    void project(double latitude, double longitude, double& x, double& y) const;
+    QGeoCoordinate unproject(double x, double y) const;
+
+    /**
+     * @brief Closest point of every segment within a radius, nearest first
+     * @param maxCount Longest list returned
+     */
+    std::vector<RoadCandidate> candidates(double x, double y, double radius, int maxCount) const;
+
+    /**
+     * @brief Outgoing arcs of a node
+     */
+    struct Arc {
+        qint32 target;
+        qint32 segment;
+        float length;
+    };
+    const Arc* arcsBegin(qint32 node) const { return m_arcs.data() + m_arcOffsets[node]; }
+    const Arc* arcsEnd(qint32 node) const { return m_arcs.data() + m_arcOffsets[node + 1]; }
+
+private:
+    struct CellEntry {
+        quint64 cell;
+        qint32 segment;
+    };
+
+    quint64 cellKey(qint64 row, qint64 column) const;
+    void addSegmentCells(qint32 segment);
+
+    double m_cellSize;
+    double m_lonScale = 111320.0;        // Meters per degree of longitude on the plane
+    std::vector<double> m_latitude;
+    std::vector<double> m_longitude;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<RoadSegment> m_segments;
+    std::vector<quint32> m_arcOffsets;   // CSR adjacency, nodeCount + 1 entries
+    std::vector<Arc> m_arcs;
+    std::vector<CellEntry> m_cells;      // Sorted by cell
+    QString m_errorString;
+};
@@ -18,6 +18,9 @@ public:
     const std::vector<QVector3D>& getPositions() const { return m_positions; }
     RoutePoint getPointAtProgress(float progress) const;
     size_t getIndexAtProgress(float progress) const;
+    
+    // Scene position of any coordinate, in the same frame as the route (e.g. a ghost rider)
+    QVector3D positionOf(const QGeoCoordinate& coord, double elevation) const;
 
 private:
     void processPoints(const std::vector<TrackPoint>& trackPoints, float elevationScale);
@@ -25,4 +28,7 @@ private:
     std::vector<QVector3D> m_positions; // Raw positions, for renderer
     std::vector<RoutePoint> m_routePoints; // Enriched points for controller
     float m_totalDistance = 0.0f;
+    double m_originLon = 0.0;
+    double m_originLat = 0.0;
+    float m_elevationScale = 1.0f;
 };
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Tuning of the route similarity index
+ *
+ * With b bands of r rows, two routes with cell-set Jaccard similarity s
+ * share at least one band bucket with probability 1 - (1 - s^r)^b; the
+ * defaults make that about 55% at s = 0.4 and 99% at s = 0.6.
+ */
+struct SimilarityParams {
+    double cellSize = 100.0;    // Grid cell edge in meters
+    int bands = 32;             // LSH bands
+    int rowsPerBand = 4;        // MinHash values per band
+
+    int signatureSize() const { return bands * rowsPerBand; }
+};
+
+/**
+ * @brief Grid cells a route passes through and their MinHash signature
+ */
+struct RouteSketch {
+    std::vector<quint64> cells;         // Sorted and unique
+    std::vector<quint64> signature;     // Minimum hash per MinHash function
+
+    bool isEmpty() const { return cells.empty(); }
+};
+
+/**
+ * @brief A library route similar to the query
+ */
+struct RouteMatch {
+    QString file;
+    double similarity = 0.0;    // Exact Jaccard similarity of the cell sets
+    double coverage = 0.0;      // Share of the query's cells the route also passes
+};
+
+/**
+ * @brief "Find rides like this one" over a library of GPX files
+ *
+ * Every route is reduced to the set of grid cells it passes through and a
+ * MinHash signature of that set. Signatures are split into bands, and each
+ * band is hashed into a bucket table (locality-sensitive hashing), so a
+ * query only looks at routes sharing at least one bucket instead of the
+ * whole library. The exact Jaccard similarity of the cell sets is then
+ * computed for that shortlist only.
+ *
+ * The index can be saved and refreshed: update() re-reads only files that
+ * are new or changed since they were sketched.
+ */
+class RouteSimilarityIndex {
+public:
+    explicit RouteSimilarityIndex(const SimilarityParams& params = SimilarityParams());
+
+    const SimilarityParams& params() const { return m_params; }
+    size_t size() const { return m_entries.size(); }
+
+    /**
+     * @brief Cells and signature of a track
+     *
+     * Long gaps between points are interpolated, so sparse and dense
+     * recordings of the same road cover the same cells.
+     */
+    RouteSketch sketch(const std::vector<TrackPoint>& points) const;
+
+    /**
+     * @brief Add or replace the route of a file
+     */
+    void add(const QString& file, RouteSketch sketch, qint64 fileSize = 0, qint64 modified = 0);
+
+    /**
+     * @brief Make the index match a list of files
+     *
+     * Drops routes no longer listed and sketches new or modified files in
+     * parallel; unchanged files are not read. Files that fail to parse are
+     * left out.
+     * @return Number of files that were (re)sketched
+     */
+    int update(const QStringList& files);
+
+    /**
+     * @brief Routes most similar to a sketch, best first
+     * @param maxResults Longest list returned
+     * @param minSimilarity Lowest exact similarity kept
+     */
+    std::vector<RouteMatch> query(const RouteSketch& sketch, int maxResults = 20, double minSimilarity = 0.2) const;
+
+    /**
+     * @brief Number of routes a query would score exactly (for tests and tuning)
+     */
+    size_t candidateCount(const RouteSketch& sketch) const;
+
+    // Binary index file; load() fails on other parameters or a damaged file
+    bool save(const QString& filename) const;
+    bool load(const QString& filename);
+
+    /**
+     * @brief Per-user location of the library index
+     */
+    static QString defaultIndexPath();
+
+    /**
+     * @brief Jaccard similarity of two sorted cell sets
+     */
+    static double jaccard(const std::vector<quint64>& a, const std::vector<quint64>& b);
+
+private:
+    struct Entry {
+        QString file;
+        qint64 fileSize = 0;
+        qint64 modified = 0;    // ms since epoch
+        RouteSketch sketch;
+    };
+
+    std::vector<int> candidates(const RouteSketch& sketch) const;
+    quint64 bandKey(const std::vector<quint64>& signature, int band) const;
+    void rebuildBuckets();
+
+    SimilarityParams m_params;
+    std::vector<Entry> m_entries;
+    std::vector<std::unordered_map<quint64, std::vector<int>>> m_buckets; // Per band: key -> entries
+};
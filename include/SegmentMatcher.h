@@ -0,0 +1,118 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QGeoCoordinate>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Tolerances for matching a segment against a track
+ */
+struct SegmentMatchParams {
+    double passRadius = 30.0;       // A track passes the start or end within this distance (m)
+    double pathTolerance = 40.0;    // Every path sample must be passed within this distance (m)
+    double minPathFidelity = 0.9;   // Share of path samples that must be passed, in order
+    double maxLengthRatio = 1.5;    // Longest accepted traversal relative to the segment length
+};
+
+/**
+ * @brief A stretch of road defined by the points of one track
+ */
+struct SegmentDefinition {
+    std::vector<QGeoCoordinate> path;   // Resampled every few meters, start to end
+    double length = 0.0;                // Along the source track (m)
+
+    bool isEmpty() const { return path.size() < 2; }
+
+    /**
+     * @brief Segment between two points of a track (inclusive)
+     */
+    static SegmentDefinition fromTrack(const std::vector<TrackPoint>& points, size_t startIndex, size_t endIndex);
+};
+
+/**
+ * @brief One traversal of a segment
+ */
+struct SegmentEffort {
+    int track = -1;                 // Index in the SegmentIndex
+    QString file;
+    size_t startIndex = 0;          // Track points closest to the segment start and end
+    size_t endIndex = 0;
+    double distance = 0.0;          // Track distance between them (m)
+    double elapsedTime = 0.0;       // Seconds, NaN for untimed tracks
+    QDateTime startTime;
+    double pathFidelity = 0.0;      // Share of the segment path followed
+};
+
+/**
+ * @brief Spatial hash over every point of a library of tracks
+ *
+ * Points are bucketed into square grid cells of about the pass radius and
+ * stored sorted by cell, so all points near a coordinate - across every
+ * track - are a few contiguous runs found by binary search. A segment
+ * search looks up the passes near its start and its end, pairs each start
+ * pass with the next end pass of the same track, and only then walks the
+ * track between them to check that it follows the segment path in order.
+ * The cost grows with the number of passes near the segment, not with the
+ * size of the library.
+ */
+class SegmentIndex {
+public:
+    explicit SegmentIndex(double cellSize = 50.0);
+
+    size_t trackCount() const { return m_tracks.size(); }
+    size_t pointCount() const { return m_cells.size(); }
+    const QString& file(int track) const { return m_tracks[track].file; }
+
+    /**
+     * @brief Add a track; call build() before searching
+     * @return Index of the track
+     */
+    int addTrack(const QString& file, const std::vector<TrackPoint>& points);
+
+    /**
+     * @brief Parse files in parallel and add every track that loads
+     * @return Number of tracks added
+     */
+    int addFiles(const QStringList& files);
+
+    /**
+     * @brief Sort the point cells after tracks were added
+     */
+    void build();
+
+    /**
+     * @brief Every traversal of the segment in the library, fastest first
+     *
+     * Untimed efforts are listed after the timed ones.
+     */
+    std::vector<SegmentEffort> find(const SegmentDefinition& segment,
+                                    const SegmentMatchParams& params = SegmentMatchParams()) const;
+
+private:
+    struct Track {
+        QString file;
+        std::vector<double> latitude;
+        std::vector<double> longitude;
+        std::vector<double> distance;
+        std::vector<qint64> timestampMs;    // 0 where missing
+    };
+
+    struct PointRef {
+        quint64 cell;
+        qint32 track;
+        qint32 index;
+    };
+
+    quint64 cellOf(double latitude, double longitude) const;
+    std::vector<PointRef> pointsNear(const QGeoCoordinate& coord, double radius) const;
+    bool matchEffort(const Track& track, size_t start, size_t end, const SegmentDefinition& segment,
+                     const SegmentMatchParams& params, SegmentEffort& effort) const;
+
+    double m_cellSize;
+    std::vector<Track> m_tracks;
+    std::vector<PointRef> m_cells;      // Sorted by cell after build()
+    bool m_built = true;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Cell keys and hashing shared by the spatial indexes and caches
+ */
+namespace SpatialHash {
+    // Meters per degree of latitude, and of longitude at the equator
+    const double METERS_PER_DEGREE = 111320.0;
+
+    // 64-bit finalizer from MurmurHash3, spreads the bits of a word
+    inline quint64 mix(quint64 x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Square cells: rows are cellSize tall, and each row is cellSize wide at its center
+    // latitude, so a key depends only on the position, never on the rest of the track
+    inline quint64 cellKey(double latitude, double longitude, double cellSize) {
+        const double rowHeight = cellSize / METERS_PER_DEGREE;
+        const qint64 row = static_cast<qint64>(std::floor(latitude / rowHeight));
+        const double rowLatitude = (row + 0.5) * rowHeight;
+        const double columnWidth = rowHeight / std::max(std::cos(rowLatitude * M_PI / 180.0), 1e-6);
+        const qint64 column = static_cast<qint64>(std::floor(longitude / columnWidth));
+        return (static_cast<quint64>(static_cast<quint32>(row)) << 32) | static_cast<quint32>(column);
+    }
+}
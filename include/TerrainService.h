@@ -61,6 +61,7 @@ private:
     TerrainData m_terrainData;
     int m_gridWidth;
     int m_gridHeight;
+    int m_generation;    // Incremented per fetch; replies of earlier fetches are dropped
 
     void fetchElevationData(double northLat, double southLat, double westLon, double eastLon, int width, int height);
     void fetchSatelliteImage(double northLat, double southLat, double westLon, double eastLon, int width, int height);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Tuning of the effort alignment
+ */
+struct AlignmentParams {
+    int bandRadius = 150;   // Points of the other track considered on each side of the expected match
+    bool useSimd = true;    // Vectorized local costs where the CPU supports them (same result)
+};
+
+/**
+ * @brief A reference point and the point of the other effort aligned with it
+ */
+struct AlignedPoint {
+    size_t index = 0;               // Reference point
+    size_t otherIndex = 0;          // Matched point of the other effort
+    double distance = 0.0;          // Reference distance from the start (m)
+    double timeGap = 0.0;           // Seconds the other effort is behind, NaN when either is untimed
+    double elevationDelta = 0.0;    // Other minus reference elevation (m)
+    double offset = 0.0;            // Distance between the matched positions (m)
+};
+
+/**
+ * @brief Point alignment of two efforts over the same route
+ */
+struct TrackAlignment {
+    std::vector<AlignedPoint> points;                   // One per reference point
+    std::vector<std::pair<size_t, size_t>> path;        // Warping path, start to end
+    double cost = 0.0;                                  // Sum of matched position offsets (m)
+    size_t cellCount = 0;                               // Cells of the band that were evaluated
+
+    bool isEmpty() const { return points.empty(); }
+};
+
+/**
+ * @brief Dynamic time warping of two efforts restricted to a Sakoe-Chiba band
+ *
+ * Index or distance alignment drifts as soon as the two recordings differ
+ * in sampling, GPS noise or stops. DTW instead finds the monotone matching
+ * of the two point sequences that minimizes the summed distance between
+ * matched positions. Only cells within bandRadius of the distance-
+ * proportional diagonal are evaluated, so time and memory are O(n·w)
+ * instead of O(n·m): two cost rows plus one step byte per band cell.
+ *
+ * The local costs of a row are independent of each other and are computed
+ * two at a time with SSE2 where available; only the cheap left-neighbor
+ * minimum runs serially.
+ */
+class TrackAligner {
+public:
+    explicit TrackAligner(const AlignmentParams& params = AlignmentParams());
+
+    /**
+     * @brief Align another effort to a reference effort
+     * @return Empty when either track has fewer than two points
+     */
+    TrackAlignment align(const std::vector<TrackPoint>& reference, const std::vector<TrackPoint>& other) const;
+
+    /**
+     * @brief Whether this build has the vectorized inner loop
+     */
+    static bool simdAvailable();
+
+private:
+    AlignmentParams m_params;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "ClimbDetector.h"
+#include "GpxParser.h"
+#include <vector>
+
+// Define a segment struct for track analysis
+struct TrackSegment {
+    enum Type { FLAT, CLIMB, DESCENT };
+    Type type;
+    size_t startIndex;
+    size_t endIndex;
+    double distance;       // in meters
+    double elevationChange; // in meters
+    double avgGradient;    // in percent
+    double maxGradient;    // in percent
+    double minGradient;    // in percent
+};
+
+/**
+ * @brief Merge thresholds that set the granularity of a segmentation level
+ */
+struct SegmentationParams {
+    // Boundary detection on the smoothed gradients, used by the most detailed level only
+    double flatThreshold = 1.5;             // Gradients within +/- this count as flat (percent)
+    double changeThreshold = 2.5;           // Smallest change of average gradient that starts a segment (percent)
+    double minBoundaryDistance = 300.0;     // Shortest distance between two boundaries (meters)
+    
+    // Merging, applied at every level
+    double similarGradientThreshold = 3.0;  // Merge same-type neighbours closer than this (percent)
+    double tinySegmentThreshold = 300.0;    // Always merge segments shorter than this (meters)
+    double smallSegmentThreshold = 500.0;   // Merge into a next segment more than twice as long (meters)
+    double mergedFlatThreshold = 1.5;       // Merged segments within +/- this are typed flat (percent)
+
+    // Thresholds for the next coarser level of the segment hierarchy
+    SegmentationParams coarser() const;
+};
+
+/**
+ * @brief Immutable outcome of a TrackAnalyzer run
+ *
+ * Holds the climb/descent/flat segments of a track together with the
+ * summary figures derived from them. Cheap to copy between threads.
+ *
+ * Segments form a hierarchy: level 0 is the detailed segmentation and
+ * every further level merges neighbouring segments of the level below,
+ * so each coarse segment covers a run of finer ones.
+ *
+ * Categorized climbs are detected independently of the segmentation and
+ * may span several climb segments separated by short dips.
+ */
+class TrackAnalysisResult {
+public:
+    TrackAnalysisResult() = default;
+    TrackAnalysisResult(size_t pointCount, std::vector<TrackSegment> segments);
+    TrackAnalysisResult(size_t pointCount, std::vector<std::vector<TrackSegment>> levels,
+                        std::vector<double> levelResolutions, std::vector<Climb> climbs = {});
+
+    size_t pointCount() const { return m_pointCount; }
+    const std::vector<TrackSegment>& segments() const { return segmentsAtLevel(0); }
+    bool isEmpty() const { return segments().empty(); }
+
+    // Segment hierarchy, level 0 being the most detailed
+    int levelCount() const { return static_cast<int>(m_levels.size()); }
+    const std::vector<TrackSegment>& segmentsAtLevel(int level) const;
+    // Length in meters below which a level no longer keeps segments apart
+    double levelResolution(int level) const;
+    // Most detailed level whose segments are still at least the given length apart
+    int levelForResolution(double meters) const;
+
+    // Distance covered by each segment type in meters
+    double uphillDistance() const { return m_uphillDistance; }
+    double downhillDistance() const { return m_downhillDistance; }
+    double flatDistance() const { return m_flatDistance; }
+
+    // Share of the segmented distance per type in percent
+    double uphillPercent() const;
+    double downhillPercent() const;
+    double flatPercent() const;
+
+    // Steepest climb (positive) and descent (negative) gradient in percent
+    double steepestUphill() const { return m_steepestUphill; }
+    double steepestDownhill() const { return m_steepestDownhill; }
+
+    // Categorized climbs in track order
+    const std::vector<Climb>& climbs() const { return m_climbs; }
+
+private:
+    size_t m_pointCount = 0;
+    std::vector<std::vector<TrackSegment>> m_levels;
+    std::vector<double> m_levelResolutions;
+    std::vector<Climb> m_climbs;
+    double m_uphillDistance = 0.0;
+    double m_downhillDistance = 0.0;
+    double m_flatDistance = 0.0;
+    double m_steepestUphill = 0.0;
+    double m_steepestDownhill = 0.0;
+
+    double percentOf(double distance) const;
+};
+
+/**
+ * @brief Threshold-independent intermediate results of an analysis
+ *
+ * Smoothing the gradients and detecting climbs dominate the cost of a
+ * run and do not depend on SegmentationParams, so a profile prepared once
+ * per track lets TrackAnalyzer::segment() redo only boundary detection
+ * and merging when the thresholds change. Raw segment averages are still
+ * summed directly over each segment, one pass over the track in total, so
+ * they are bit-identical to a full analysis.
+ */
+struct GradientProfile {
+    std::vector<double> smoothGradients;
+    std::vector<Climb> climbs;            // Detected with the preparing analyzer's climb parameters
+    
+    bool isEmpty() const { return smoothGradients.empty(); }
+};
+
+/**
+ * @brief Splits a track into climb, descent and flat segments
+ *
+ * Has no widget or event loop dependencies and keeps no state between
+ * calls, so one analyzer can be used concurrently from several threads
+ * (e.g. a QtConcurrent worker, tests, or a command line tool).
+ *
+ * Tracks longer than two chunks are processed in parallel on the global
+ * thread pool. Boundary detection scans chunks speculatively and stitches
+ * them at the seams, so the result is identical to a sequential run.
+ */
+class TrackAnalyzer {
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 65536;
+    static const int MAX_LEVELS = 4;
+
+    TrackAnalyzer() = default;
+
+    /**
+     * @brief Thresholds of the most detailed hierarchy level
+     */
+    void setParams(const SegmentationParams& params) { m_params = params; }
+    const SegmentationParams& params() const { return m_params; }
+
+    /**
+     * @brief Thresholds for categorized climb detection
+     */
+    void setClimbParams(const ClimbParams& params) { m_climbParams = params; }
+    const ClimbParams& climbParams() const { return m_climbParams; }
+
+    /**
+     * @brief Points per parallel work item, 0 to always run sequentially
+     */
+    void setChunkSize(size_t chunkSize) { m_chunkSize = chunkSize; }
+    size_t chunkSize() const { return m_chunkSize; }
+
+    /**
+     * @brief Run the full segmentation pipeline
+     *
+     * Builds up to MAX_LEVELS hierarchy levels, each by merging the level
+     * below with coarser() thresholds, and detects categorized climbs.
+     * @param points Track points with cumulative distances and parser gradients
+     * @return Segments and summary statistics; empty for fewer than two points
+     */
+    TrackAnalysisResult analyze(const std::vector<TrackPoint>& points) const;
+    
+    /**
+     * @brief Run the threshold-independent stages once for a track
+     */
+    GradientProfile prepare(const std::vector<TrackPoint>& points) const;
+    
+    /**
+     * @brief Segment a track from a prepared profile with the current parameters
+     *
+     * Gives the same segments as analyze() at a fraction of the cost, so
+     * thresholds can be adjusted interactively.
+     * @param profile Result of prepare() for the same points
+     */
+    TrackAnalysisResult segment(const std::vector<TrackPoint>& points, const GradientProfile& profile) const;
+
+    // Individual pipeline stages, exposed for tests and benchmarks
+    std::vector<double> calculateSmoothedGradients(const std::vector<TrackPoint>& points) const;
+    std::vector<size_t> identifySegmentBoundaries(const std::vector<TrackPoint>& points,
+                                                  const std::vector<double>& smoothGradients) const;
+    std::vector<TrackSegment> createRawSegments(const std::vector<TrackPoint>& points,
+                                                const std::vector<double>& smoothGradients,
+                                                const std::vector<size_t>& boundaries) const;
+    std::vector<TrackSegment> optimizeSegments(const std::vector<TrackSegment>& rawSegments,
+                                               const std::vector<TrackPoint>& points) const;
+    std::vector<TrackSegment> optimizeSegments(const std::vector<TrackSegment>& rawSegments,
+                                               const std::vector<TrackPoint>& points,
+                                               const SegmentationParams& params) const;
+
+private:
+    size_t m_chunkSize = DEFAULT_CHUNK_SIZE;
+    SegmentationParams m_params;
+    ClimbParams m_climbParams;
+};
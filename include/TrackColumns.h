@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QtGlobal>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Column-oriented copy of a track and its derived series
+ *
+ * Every channel is held in its own contiguous array so analysis kernels and
+ * exporters can work on whole columns instead of walking TrackPoint structs.
+ * Sensor columns are left empty when no point in the track carries the channel.
+ */
+struct TrackColumns {
+    std::vector<double> latitude;     ///< Degrees
+    std::vector<double> longitude;    ///< Degrees
+    std::vector<double> elevation;    ///< Meters
+    std::vector<double> distance;     ///< Cumulative meters from start
+    std::vector<double> gradient;     ///< Percent
+
+    std::vector<qint64> timestampMs;         ///< Milliseconds since epoch, 0 where missing
+    std::vector<uint8_t> timestampValidity;  ///< LSB-first validity bitmap, empty if every timestamp is valid
+    size_t timestampNullCount = 0;           ///< Number of points without a timestamp
+
+    std::vector<double> heartRate;    ///< bpm, NaN where missing
+    std::vector<double> cadence;      ///< rpm, NaN where missing
+    std::vector<double> power;        ///< Watts, NaN where missing
+    std::vector<double> temperature;  ///< Celsius, NaN where missing
+
+    /**
+     * @brief Number of rows (track points)
+     */
+    size_t size() const { return distance.size(); }
+
+    /**
+     * @brief Whether at least one point has a timestamp
+     */
+    bool hasTimestamps() const { return !timestampMs.empty(); }
+
+    /**
+     * @brief Whether a row has a timestamp
+     */
+    bool timestampValid(size_t row) const {
+        return hasTimestamps() && (timestampValidity.empty() || ((timestampValidity[row / 8] >> (row % 8)) & 1));
+    }
+
+    /**
+     * @brief Build the columns from parsed track points
+     * @param points Track points as produced by GPXParser
+     * @return Column store with one row per point
+     */
+    static TrackColumns fromPoints(const std::vector<TrackPoint>& points);
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "GpxParser.h"
+#include "RangeQuery.h"
+#include <vector>
+
+/**
+ * @brief Statistics of one stretch of a track
+ */
+struct RangeStats {
+    size_t startIndex = 0;
+    size_t endIndex = 0;
+    double distance = 0.0;       // in meters
+    double elevationGain = 0.0;  // in meters, same 0.6 m step threshold as GPXParser
+    double elevationLoss = 0.0;  // in meters, positive
+    double minElevation = 0.0;   // in meters
+    double maxElevation = 0.0;   // in meters
+    double avgGradient = 0.0;    // net elevation change over distance, in percent
+    double maxGradient = 0.0;    // in percent
+    double minGradient = 0.0;    // in percent
+    double duration = 0.0;       // in seconds, NaN without timestamps
+    double avgSpeed = 0.0;       // in m/s, NaN without timestamps
+};
+
+/**
+ * @brief Fast statistics for arbitrary index or distance ranges
+ *
+ * Built once per track in O(n): prefix sums of elevation gain and loss
+ * plus range minimum/maximum tables (RangeQuery.h) over elevation and
+ * gradient. Index range queries then cost O(block), at most two partial
+ * blocks of RangeExtremum::BLOCK_SIZE points scanned, and distance range
+ * queries add a binary search, independent of the stretch length.
+ */
+class TrackRangeStats {
+public:
+    TrackRangeStats() = default;
+
+    /**
+     * @brief Build the tables for a track
+     * @param points Track points with cumulative distances and parser gradients
+     */
+    explicit TrackRangeStats(const std::vector<TrackPoint>& points);
+
+    size_t size() const { return m_distances.size(); }
+    bool empty() const { return m_distances.empty(); }
+
+    /**
+     * @brief Statistics between two points (inclusive, in either order)
+     */
+    RangeStats stats(size_t first, size_t last) const;
+
+    /**
+     * @brief Statistics between two distances from the start in meters
+     *
+     * Each distance is snapped to the nearest point; the range is clamped
+     * to the track.
+     */
+    RangeStats statsForDistance(double from, double to) const;
+
+    /**
+     * @brief Index of the point closest to a distance from the start
+     */
+    size_t indexAtDistance(double meters) const;
+
+    /**
+     * @brief Consecutive splits every interval meters, e.g. 1000 for km splits
+     *
+     * Each boundary is found by binary search and snapped to the nearest
+     * point; boundaries that snap to the same point as the previous one
+     * are skipped. The last split holds the remainder and may be shorter.
+     */
+    std::vector<RangeStats> splitsByDistance(double interval) const;
+
+    /**
+     * @brief Consecutive splits every interval seconds of elapsed time
+     *
+     * Points without a timestamp belong to the split of the timed point
+     * before them. Empty when the track has no timestamps.
+     */
+    std::vector<RangeStats> splitsByTime(double interval) const;
+
+private:
+    std::vector<RangeStats> splits(const std::vector<double>& axis, double interval) const;
+
+    std::vector<double> m_distances;
+    std::vector<double> m_gainPrefix;    // Gain from the first point up to each point
+    std::vector<double> m_lossPrefix;    // Loss from the first point up to each point
+    std::vector<double> m_seconds;       // Seconds since the first timestamp, NaN if missing
+    std::vector<double> m_clock;         // Non-decreasing elapsed seconds, empty without timestamps
+    RangeMinimum m_lowestElevation;
+    RangeMaximum m_highestElevation;
+    RangeMinimum m_minGradient;
+    RangeMaximum m_maxGradient;
+};
@@ -7,23 +7,25 @@
 #include <QtMath>
 #include <QDateTime>
 #include <QPushButton>
+#include <QFutureWatcher>
+#include <QComboBox>
+#include <QTableWidget>
+#include <QSlider>
+#include <memory>
 #include <vector>
 #include <utility>
 #include "qcustomplot.h"
 #include "GpxParser.h"
-
-// Define a segment struct for track analysis
-struct TrackSegment {
-    enum Type { FLAT, CLIMB, DESCENT };
-    Type type;
-    size_t startIndex;
-    size_t endIndex;
-    double distance;       // in meters
-    double elevationChange; // in meters
-    double avgGradient;    // in percent
-    double maxGradient;    // in percent
-    double minGradient;    // in percent
-};
+#include "TrackView.h"
+#include "TrackAnalyzer.h"
+#include "MotionAnalyzer.h"
+#include "BestEfforts.h"
+#include "PacingModel.h"
+#include "PowerCurve.h"
+#include "ZoneHistogram.h"
+#include "TrackRangeStats.h"
+#include "ElevationGain.h"
+#include "TerrainService.h"
 
 class TrackStatsWidget : public QWidget
 {
@@ -34,23 +36,83 @@ public:
 
     // Update all stats at once with a track point
     void updateStats(const TrackPoint& point, int pointIndex, const GPXParser& parser);
+    void updateStats(const TrackPoint& point, int pointIndex, const TrackView& track);
     
     // Update only the position (when slider moves)
     void updatePosition(const TrackPoint& point, int pointIndex, const GPXParser& parser);
+    void updatePosition(const TrackPoint& point, int pointIndex, const TrackView& track);
     
-    // Set track info when a new track is loaded
+    // Set track info when a new track (or a trimmed/reversed view of one) is loaded
     void setTrackInfo(const GPXParser& parser);
+    void setTrackInfo(const TrackView& track);
     
     // Get analyzed segments for external use
-    const std::vector<TrackSegment>& getSegments() const { return m_segments; }
+    const std::vector<TrackSegment>& getSegments() const { return m_analysis.segments(); }
+    const TrackAnalysisResult& getAnalysis() const { return m_analysis; }
+    
+    // Speed, pace and moving time of the current track (empty series without timestamps)
+    const MotionProfile& getMotion() const { return m_motion; }
+    
+    // Projected riding time of the current track from the pacing model
+    const PacingEstimate& getPacing() const { return m_pacing; }
+    
+    // Time-in-zone histograms of the current track
+    const ZoneReport& getZones() const { return m_zones; }
+    
+    // Range tables of the current track, shared with the profile's brush selection
+    const TrackRangeStats& getRangeStats() const { return m_rangeStats; }
+    
+    // Automatic splits of the current track at the interval picked in the splits section
+    const std::vector<RangeStats>& getSplits() const { return m_splits; }
+    
+    // Change the heart rate, power and gradient zone bounds and rebuild the histograms
+    void setZoneSettings(const ZoneSettings& settings);
+    
+    // Total gain of the current track under each estimator
+    const ElevationGainReport& getElevationGains() const { return m_gains; }
+    
+    // Terrain model covering the current track, used for the DEM gain estimate
+    void setTerrain(const TerrainData& terrain);
     
     // Make toggleUnits public so tests can access it
     void toggleUnits();
 
+    // Column copy of the current track, null until the background metrics have finished
+    std::shared_ptr<const TrackColumns> getColumns() const { return m_columns; }
+
+signals:
+    // Emitted when background segment analysis of the current track has finished
+    void analysisChanged(const TrackAnalysisResult& analysis);
+    
+    // Emitted when motion, best efforts, power curve, pacing and range tables are ready
+    void metricsChanged();
+
 private slots:
     void showSegmentDetails(int segmentIndex);
+    void handleAnalysisFinished();
+    void handleMetricsFinished();
+    void handleThresholdChanged();
 
 private:
+    // Segmentation run on the thread pool, with the prepared profile that threshold changes re-segment
+    struct TrackSegmentation {
+        std::vector<TrackPoint> points;
+        GradientProfile profile;
+        TrackAnalysisResult analysis;
+    };
+    
+    // Whole-track metrics computed together on the thread pool from one column copy
+    struct TrackMetrics {
+        std::shared_ptr<const TrackColumns> columns;
+        MotionProfile motion;
+        std::vector<BestEffort> bestEfforts;
+        PowerCurve powerCurve;
+        PacingEstimate pacing;
+        double projectedFastest = 0.0;
+        double projectedSlowest = 0.0;
+        TrackRangeStats rangeStats;
+    };
+    
     // UI Elements
     QLabel* m_titleLabel;
     
@@ -62,6 +124,9 @@ private:
     QLabel* m_latitudeLabel;
     QLabel* m_longitudeLabel;
     QLabel* m_gradientLabel; // New: Current gradient
+    QLabel* m_speedLabel;
+    QLabel* m_paceLabel;
+    QLabel* m_etaLabel;
     
     // Overall track information
     QLabel* m_trackTitle;
@@ -74,18 +139,76 @@ private:
     QLabel* m_flatPercentLabel;
     QLabel* m_steepestUphillLabel;   // New: Steepest uphill
     QLabel* m_steepestDownhillLabel; // New: Steepest downhill
+    QLabel* m_elapsedTimeLabel;
+    QLabel* m_movingTimeLabel;
+    QLabel* m_avgMovingSpeedLabel;
+    QLabel* m_maxSpeedLabel;
+    QLabel* m_projectedTimeLabel;
+    
+    // Elevation gain estimators side by side
+    QLabel* m_gainsTitle;
+    QLabel* m_gainsLabel;
     
     // Segment analysis section
     QLabel* m_segmentTitle;
     QCustomPlot* m_miniProfile;      // Mini elevation profile
     QWidget* m_segmentListWidget;    // Container for segment buttons
     
+    // Live segmentation thresholds
+    QSlider* m_flatThresholdSlider;      // Tenths of a percent
+    QSlider* m_changeThresholdSlider;    // Tenths of a percent
+    QSlider* m_minSegmentSlider;         // Meters
+    QSlider* m_mergeThresholdSlider;     // Tenths of a percent
+    QLabel* m_flatThresholdValue;
+    QLabel* m_changeThresholdValue;
+    QLabel* m_minSegmentValue;
+    QLabel* m_mergeThresholdValue;
+    
+    // Automatic splits table
+    QComboBox* m_splitIntervalCombo;
+    QTableWidget* m_splitsTable;
+    
+    // Categorized climbs section
+    QLabel* m_climbsTitle;
+    QLabel* m_climbsLabel;
+    
+    // Best efforts section (timed tracks only)
+    QLabel* m_bestEffortsTitle;
+    QLabel* m_bestEffortsLabel;
+    
+    // Power curve section (tracks with power only)
+    QLabel* m_powerCurveTitle;
+    QLabel* m_powerCurveLabel;
+    
+    // Time-in-zone section
+    QLabel* m_zonesTitle;
+    QLabel* m_zonesLabel;
+    
     // Units toggle
     QPushButton* m_unitsToggleButton;
     bool m_useMetricUnits;
     
     // Segment analysis data
-    std::vector<TrackSegment> m_segments;
+    TrackView m_track;               // Track the segments are computed for
+    TrackAnalysisResult m_analysis;
+    QFutureWatcher<TrackSegmentation>* m_analysisWatcher;
+    SegmentationParams m_segmentationParams;
+    GradientProfile m_gradientProfile;       // Prepared with the background analysis of the track
+    std::vector<TrackPoint> m_analysisPoints; // Points the profile was prepared for
+    QFutureWatcher<TrackMetrics>* m_metricsWatcher;
+    std::shared_ptr<const TrackColumns> m_columns;
+    MotionProfile m_motion;
+    std::vector<BestEffort> m_bestEfforts;
+    PacingEstimate m_pacing;
+    PowerCurve m_powerCurve;
+    ZoneSettings m_zoneSettings;
+    ZoneReport m_zones;
+    TrackRangeStats m_rangeStats;    // Prefix sums and range tables the splits are cut from
+    std::vector<RangeStats> m_splits;
+    ElevationGainReport m_gains;
+    TerrainData m_terrain;
+    double m_projectedFastest;       // Projected time range over the rider parameter sweep
+    double m_projectedSlowest;
     QWidget* m_segmentDetailsWidget;
     QLabel* m_segmentDetailsTitle;
     QLabel* m_segmentTypeLabel;
@@ -96,23 +219,24 @@ private:
     // Helper functions
     QWidget* createStatsSection(const QString& title, QLabel** labelArray, const QStringList& labelTexts);
     void createMiniProfile();
-    void updateMiniProfile(const GPXParser& parser);
-    void analyzeSegments(const GPXParser& parser);
+    void updateMiniProfile(const TrackView& track);
+    void startAnalysis(const TrackView& track);
+    void startMetrics(const TrackView& track);
+    void updateSegmentSummary();
+    void updateMotionSummary();
+    void updateBestEffortsList();
+    void updatePowerCurveList();
+    void updateZonesList();
+    void updateSplitsTable();
+    void updateElevationGains(const TrackColumns& columns);
+    void updateGainsList();
     void createSegmentsList();
     void updateSegmentsList();
+    void updateThresholdLabels();
+    void updateClimbsList();
     QString getGradientColorStyle(double gradient) const;
     QString getDifficultyLabel(double gradient) const;
     
-    // Segment analysis helper functions
-    std::vector<double> calculateSmoothedGradients(const std::vector<TrackPoint>& points);
-    std::vector<size_t> identifySegmentBoundaries(const std::vector<TrackPoint>& points, 
-                                                 const std::vector<double>& smoothGradients);
-    std::vector<TrackSegment> createRawSegments(const std::vector<TrackPoint>& points, 
-                                              const std::vector<double>& smoothGradients,
-                                              const std::vector<size_t>& boundaries);
-    std::vector<TrackSegment> optimizeSegments(const std::vector<TrackSegment>& rawSegments,
-                                             const std::vector<TrackPoint>& points);
-    
     // Conversion functions
     double metersToMiles(double meters) const { return meters * 0.000621371; }
     double metersToFeet(double meters) const { return meters * 3.28084; }
@@ -120,6 +244,9 @@ private:
     QString formatDistance(double meters) const;
     QString formatElevation(double meters) const;
     QString formatGradient(double gradient) const;
+    QString formatDuration(double seconds) const;
+    QString formatSpeed(double metersPerSecond) const;
+    QString formatPace(double secondsPerKilometer) const;
 
     // Modern UI styling helpers 
     QString getModernCardStyle() const {
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <QVarLengthArray>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Lightweight view over one or more ranges of shared track point stores
+ *
+ * A view references index ranges of immutable point stores (optionally reversed)
+ * instead of copying points, so trimming, splitting, reversing and concatenating
+ * tracks is O(1) in the number of points. Distance and gradient are derived
+ * per view on access: distances restart at zero at the start of the view and
+ * gradients flip sign on reversed ranges.
+ */
+class TrackView {
+public:
+    using PointStore = std::shared_ptr<const std::vector<TrackPoint>>;
+
+    /**
+     * @brief Create an empty view
+     */
+    TrackView() = default;
+
+    /**
+     * @brief Create a view covering a whole point store
+     * @param store Shared track points (e.g. GPXParser::sharedPoints())
+     */
+    explicit TrackView(PointStore store);
+
+    /**
+     * @brief Create a view owning a copy of the given points
+     * @param points Track points to move into a new store
+     */
+    static TrackView fromPoints(std::vector<TrackPoint> points);
+
+    /**
+     * @brief Number of points in the view
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief Whether the view contains no points
+     */
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief Get a point with view-relative distance and gradient
+     * @param index Index within the view
+     * @return Copy of the stored point with derived distance and gradient
+     */
+    TrackPoint at(size_t index) const;
+    TrackPoint operator[](size_t index) const { return at(index); }
+    TrackPoint front() const { return at(0); }
+    TrackPoint back() const { return at(m_size - 1); }
+
+    /**
+     * @brief Get the underlying stored point without derived values
+     * @param index Index within the view
+     */
+    const TrackPoint& sourcePoint(size_t index) const;
+
+    /**
+     * @brief Distance from the start of the view in meters
+     */
+    double distanceAt(size_t index) const;
+
+    /**
+     * @brief Gradient in percent, negated on reversed ranges
+     */
+    double gradientAt(size_t index) const;
+
+    /**
+     * @brief Total distance covered by the view in meters
+     */
+    double totalDistance() const;
+
+    /**
+     * @brief Elevation gain from the start of the view up to a point (0.6 m threshold, as GPXParser)
+     * @param upToIndex Index of the last point to include
+     */
+    double cumulativeElevationGain(size_t upToIndex) const;
+    double totalElevationGain() const;
+    double minElevation() const;
+    double maxElevation() const;
+
+    /**
+     * @brief View of the points between two indices
+     * @param startIndex First point to keep
+     * @param endIndex Last point to keep (inclusive)
+     */
+    TrackView trimmed(size_t startIndex, size_t endIndex) const;
+
+    /**
+     * @brief Split the view in two at a point
+     * @param index First point of the second half
+     * @return Points [0, index) and [index, size())
+     */
+    std::pair<TrackView, TrackView> splitAt(size_t index) const;
+
+    /**
+     * @brief View of the same points in reverse order
+     */
+    TrackView reversed() const;
+
+    /**
+     * @brief View of this track followed by another one
+     *
+     * The distance across the join is the straight-line distance between the
+     * last point of this view and the first point of the other.
+     */
+    TrackView concatenated(const TrackView& other) const;
+
+    /**
+     * @brief Copy the view into a point vector with derived distance and gradient
+     */
+    std::vector<TrackPoint> toPoints() const;
+
+    /**
+     * @brief Whether two views reference the same ranges of the same stores
+     */
+    bool operator==(const TrackView& other) const;
+    bool operator!=(const TrackView& other) const { return !(*this == other); }
+
+private:
+    struct Range {
+        PointStore store;
+        size_t begin = 0;            ///< First stored index
+        size_t end = 0;              ///< One past the last stored index
+        bool reversed = false;
+        size_t viewStart = 0;        ///< Index of the first point within the view
+        double distanceStart = 0.0;  ///< View distance at the first point
+
+        size_t size() const { return end - begin; }
+        size_t sourceIndex(size_t offset) const { return reversed ? end - 1 - offset : begin + offset; }
+        const TrackPoint& first() const { return (*store)[sourceIndex(0)]; }
+        const TrackPoint& last() const { return (*store)[sourceIndex(size() - 1)]; }
+        double length() const;
+        double gradient(size_t offset) const;
+    };
+
+    // Inline storage for two ranges keeps trims and single joins allocation-free
+    QVarLengthArray<Range, 2> m_ranges;
+    size_t m_size = 0;
+
+    const Range& rangeFor(size_t index) const;
+    void appendRange(const Range& range);
+    void updateOffsets();
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "TrackColumns.h"
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * @brief Time and distance spent in each zone of one channel
+ *
+ * Zone 0 covers values below bounds[0], zone i values in
+ * [bounds[i-1], bounds[i]), and the last zone everything above.
+ */
+struct ZoneHistogram {
+    std::vector<double> bounds;     // Ascending lower bounds of zones 1..N-1
+    std::vector<double> time;       // Seconds per zone
+    std::vector<double> distance;   // Meters per zone
+    
+    size_t zoneCount() const { return time.size(); }
+    bool isEmpty() const;
+    double totalTime() const;
+    double totalDistance() const;
+};
+
+/**
+ * @brief Zone bounds for heart rate, power and gradient
+ */
+struct ZoneSettings {
+    std::vector<double> heartRateBounds;    // bpm
+    std::vector<double> powerBounds;        // Watts
+    std::vector<double> gradientBounds;     // Percent
+    double maxGap = 120.0;                  // Longer intervals count as paused recording (s)
+    
+    /**
+     * @brief Five heart rate zones at 60/70/80/90% of max HR, the seven Coggan
+     *        power zones at 55/75/90/105/120/150% of FTP and seven gradient zones
+     */
+    explicit ZoneSettings(double maxHeartRate = 190.0, double functionalThresholdPower = 250.0);
+    
+    // Comma separated bounds, e.g. "-8,-4,-1,1,4,8"; invalid entries are skipped
+    static std::vector<double> parseBounds(const QString& text);
+};
+
+/**
+ * @brief Time-in-zone histograms of one track
+ */
+struct ZoneReport {
+    ZoneHistogram heartRate;
+    ZoneHistogram power;
+    ZoneHistogram gradient;
+};
+
+/**
+ * @brief Builds zone histograms from the columnar sensor and gradient arrays
+ *
+ * Each channel is one pass in two steps: a branch-free loop computing the
+ * zone index (a sum of comparisons against the bounds) and interval
+ * weights (missing samples and gaps multiply to zero) into flat arrays,
+ * followed by an accumulation into the zone bins. Batches of tracks are
+ * processed in parallel on the global thread pool.
+ */
+class ZoneAnalyzer {
+public:
+    ZoneAnalyzer() = default;
+    explicit ZoneAnalyzer(const ZoneSettings& settings) : m_settings(settings) {}
+    
+    const ZoneSettings& settings() const { return m_settings; }
+    
+    ZoneReport analyze(const TrackColumns& columns) const;
+    std::vector<ZoneReport> analyzeBatch(const std::vector<TrackColumns>& tracks) const;
+    
+    /**
+     * @brief Histogram of one channel; interval i-1..i is counted in the zone of values[i]
+     * @param values One value per row, NaN where missing; empty gives an empty histogram
+     */
+    ZoneHistogram histogram(const TrackColumns& columns, const std::vector<double>& values,
+                            const std::vector<double>& bounds) const;
+    
+private:
+    ZoneSettings m_settings;
+};
@@ -0,0 +1,243 @@
+#include "AnalysisCache.h"
+#include "SpatialHash.h"
+#include "logging.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+namespace {
+    const quint32 CACHE_MAGIC = 0x47504143; // "GPAC"
+    const quint32 CACHE_VERSION = 2;        // Bump when the analyzer output changes for the same input
+
+    using SpatialHash::mix;
+
+    quint64 combine(quint64 hash, double value) {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return mix(hash ^ bits) + 0x9e3779b97f4a7c15ULL;
+    }
+
+    QDataStream& operator<<(QDataStream& out, const TrackSegment& segment) {
+        return out << qint32(segment.type) << quint64(segment.startIndex) << quint64(segment.endIndex)
+                   << segment.distance << segment.elevationChange
+                   << segment.avgGradient << segment.maxGradient << segment.minGradient;
+    }
+
+    QDataStream& operator>>(QDataStream& in, TrackSegment& segment) {
+        qint32 type = 0;
+        quint64 start = 0, end = 0;
+        in >> type >> start >> end
+           >> segment.distance >> segment.elevationChange
+           >> segment.avgGradient >> segment.maxGradient >> segment.minGradient;
+        segment.type = static_cast<TrackSegment::Type>(type);
+        segment.startIndex = start;
+        segment.endIndex = end;
+        return in;
+    }
+
+    QDataStream& operator<<(QDataStream& out, const Climb& climb) {
+        return out << qint32(climb.category) << quint64(climb.startIndex) << quint64(climb.endIndex)
+                   << climb.distance << climb.elevationGain << climb.avgGradient << climb.maxGradient
+                   << climb.score;
+    }
+
+    QDataStream& operator>>(QDataStream& in, Climb& climb) {
+        qint32 category = 0;
+        quint64 start = 0, end = 0;
+        in >> category >> start >> end
+           >> climb.distance >> climb.elevationGain >> climb.avgGradient >> climb.maxGradient
+           >> climb.score;
+        climb.category = static_cast<Climb::Category>(category);
+        climb.startIndex = start;
+        climb.endIndex = end;
+        return in;
+    }
+}
+
+const qint64 AnalysisCache::DEFAULT_SIZE_LIMIT;
+
+AnalysisCache::AnalysisCache(const QString& directory, qint64 sizeLimit)
+    : m_directory(directory.isEmpty() ? defaultDirectory() : directory),
+      m_sizeLimit(sizeLimit)
+{
+}
+
+QString AnalysisCache::defaultDirectory() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("analysis");
+}
+
+quint64 AnalysisCache::contentHash(const std::vector<TrackPoint>& points) {
+    quint64 hash = mix(points.size());
+    for (const TrackPoint& point : points) {
+        hash = combine(hash, point.elevation);
+        hash = combine(hash, point.distance);
+        hash = combine(hash, point.gradient);
+    }
+    return hash;
+}
+
+quint64 AnalysisCache::paramsHash(const TrackAnalyzer& analyzer) {
+    // The chunk size only changes how the work is split, never the result
+    const SegmentationParams& params = analyzer.params();
+    const ClimbParams& climb = analyzer.climbParams();
+    quint64 hash = mix(CACHE_VERSION);
+    for (double value : {params.flatThreshold, params.changeThreshold, params.minBoundaryDistance,
+                         params.similarGradientThreshold, params.tinySegmentThreshold, params.smallSegmentThreshold,
+                         params.mergedFlatThreshold,
+                         climb.minDistance, climb.minAvgGradient, climb.minScore,
+                         climb.maxDip, climb.maxDipFraction, climb.rampTolerance}) {
+        hash = combine(hash, value);
+    }
+    return hash;
+}
+
+QString AnalysisCache::entryPath(quint64 contentHash, quint64 paramsHash) const {
+    return QDir(m_directory).filePath(QString("%1-%2.seg")
+        .arg(contentHash, 16, 16, QChar('0'))
+        .arg(paramsHash, 16, 16, QChar('0')));
+}
+
+bool AnalysisCache::load(quint64 contentHash, quint64 paramsHash, TrackAnalysisResult& result) const {
+    QFile file(entryPath(contentHash, paramsHash));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    quint64 storedContent = 0, storedParams = 0, pointCount = 0, levelCount = 0;
+    in >> magic >> version >> storedContent >> storedParams >> pointCount >> levelCount;
+    if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        storedContent != contentHash || storedParams != paramsHash ||
+        levelCount > static_cast<quint64>(TrackAnalyzer::MAX_LEVELS)) {
+        return false;
+    }
+
+    // Every count is checked against the point count before allocating, so a damaged entry is just a miss
+    std::vector<std::vector<TrackSegment>> levels(levelCount);
+    std::vector<double> resolutions(levelCount);
+    for (quint64 level = 0; level < levelCount; ++level) {
+        quint64 segmentCount = 0;
+        in >> resolutions[level] >> segmentCount;
+        if (in.status() != QDataStream::Ok || segmentCount > pointCount) {
+            return false;
+        }
+        levels[level].resize(segmentCount);
+        for (TrackSegment& segment : levels[level]) {
+            in >> segment;
+            if (segment.startIndex > segment.endIndex || segment.endIndex >= pointCount) {
+                return false;
+            }
+        }
+    }
+
+    quint64 climbCount = 0;
+    in >> climbCount;
+    if (in.status() != QDataStream::Ok || climbCount > pointCount) {
+        return false;
+    }
+    std::vector<Climb> climbs(climbCount);
+    for (Climb& climb : climbs) {
+        in >> climb;
+        if (climb.startIndex > climb.endIndex || climb.endIndex >= pointCount) {
+            return false;
+        }
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    result = TrackAnalysisResult(pointCount, std::move(levels), std::move(resolutions), std::move(climbs));
+    
+    // Keeps entries that are still read from being pruned first
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool AnalysisCache::store(quint64 contentHash, quint64 paramsHash, const TrackAnalysisResult& result) const {
+    if (!QDir().mkpath(m_directory)) {
+        logWarning("AnalysisCache", QString("Cannot create cache directory %1").arg(m_directory));
+        return false;
+    }
+
+    QSaveFile file(entryPath(contentHash, paramsHash));
+    if (!file.open(QIODevice::WriteOnly)) {
+        logWarning("AnalysisCache", QString("Cannot write cache entry %1").arg(file.fileName()));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << CACHE_MAGIC << CACHE_VERSION << contentHash << paramsHash
+        << quint64(result.pointCount()) << quint64(result.levelCount());
+    for (int level = 0; level < result.levelCount(); ++level) {
+        const std::vector<TrackSegment>& segments = result.segmentsAtLevel(level);
+        out << result.levelResolution(level) << quint64(segments.size());
+        for (const TrackSegment& segment : segments) {
+            out << segment;
+        }
+    }
+    out << quint64(result.climbs().size());
+    for (const Climb& climb : result.climbs()) {
+        out << climb;
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        return false;
+    }
+    prune();
+    return true;
+}
+
+void AnalysisCache::prune() const {
+    // Newest first; everything past the limit goes
+    const QFileInfoList entries = QDir(m_directory).entryInfoList(QStringList() << "*.seg", QDir::Files, QDir::Time);
+    qint64 total = 0;
+    int removed = 0;
+    for (const QFileInfo& entry : entries) {
+        total += entry.size();
+        if (total > m_sizeLimit && QFile::remove(entry.filePath())) {
+            ++removed;
+        }
+    }
+    if (removed > 0) {
+        logDebug("AnalysisCache", QString("Pruned %1 old entries from %2").arg(removed).arg(m_directory));
+    }
+}
+
+TrackAnalysisResult AnalysisCache::analyze(const TrackAnalyzer& analyzer, const std::vector<TrackPoint>& points) const {
+    const quint64 content = contentHash(points);
+    const quint64 params = paramsHash(analyzer);
+
+    TrackAnalysisResult result;
+    if (load(content, params, result)) {
+        logDebug("AnalysisCache", QString("Loaded cached analysis of %1 points").arg(points.size()));
+        return result;
+    }
+
+    result = analyzer.analyze(points);
+    store(content, params, result);
+    return result;
+}
+
+TrackAnalysisResult AnalysisCache::analyze(const TrackAnalyzer& analyzer, const std::vector<TrackPoint>& points,
+                                           const GradientProfile& profile) const {
+    const quint64 content = contentHash(points);
+    const quint64 params = paramsHash(analyzer);
+
+    TrackAnalysisResult result;
+    if (load(content, params, result)) {
+        logDebug("AnalysisCache", QString("Loaded cached analysis of %1 points").arg(points.size()));
+        return result;
+    }
+
+    result = analyzer.segment(points, profile);
+    store(content, params, result);
+    return result;
+}
@@ -0,0 +1,395 @@
+#include "ArrowExporter.h"
+#include "logging.h"
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+    // Arrow format constants (Schema.fbs / Message.fbs)
+    const char ARROW_MAGIC[] = "ARROW1";
+    const int16_t METADATA_VERSION_V5 = 4;
+    const uint8_t MESSAGE_HEADER_SCHEMA = 1;
+    const uint8_t MESSAGE_HEADER_RECORD_BATCH = 3;
+    const uint8_t TYPE_FLOATING_POINT = 3;
+    const uint8_t TYPE_TIMESTAMP = 10;
+    const int16_t PRECISION_DOUBLE = 2;
+    const int16_t TIME_UNIT_MILLISECOND = 1;
+    const int16_t ENDIANNESS_LITTLE = 0;
+    const uint32_t CONTINUATION_MARKER = 0xFFFFFFFF;
+    const qint64 BUFFER_ALIGNMENT = 8;
+
+    qint64 paddedLength(qint64 length) {
+        return (length + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+    }
+
+    // Fixed-layout structs referenced from flatbuffer vectors
+    struct FieldNodeStruct { int64_t length; int64_t nullCount; };
+    struct BufferStruct { int64_t offset; int64_t length; };
+    struct BlockStruct { int64_t offset; int32_t metaDataLength; int32_t padding; int64_t bodyLength; };
+
+    /**
+     * Minimal flatbuffer builder covering the subset the Arrow metadata needs:
+     * tables with scalar/offset fields, strings, vectors of offsets and
+     * vectors of structs. Like the reference implementation it fills the
+     * buffer back to front, so references are distances from the end.
+     */
+    class FlatBufferBuilder {
+    public:
+        using Ref = uint32_t;
+
+        FlatBufferBuilder() : m_buffer(256), m_head(m_buffer.size()) {}
+
+        Ref createString(const QByteArray& text) {
+            align(4, text.size() + 1);
+            pushBytes("\0", 1);
+            pushBytes(text.constData(), text.size());
+            pushScalar<uint32_t>(static_cast<uint32_t>(text.size()));
+            return size();
+        }
+
+        Ref createOffsetVector(const std::vector<Ref>& refs) {
+            align(4, refs.size() * sizeof(uint32_t));
+            for (size_t i = refs.size(); i > 0; --i) {
+                addOffset(refs[i - 1]);
+            }
+            pushScalar<uint32_t>(static_cast<uint32_t>(refs.size()));
+            return size();
+        }
+
+        template <typename T>
+        Ref createStructVector(const std::vector<T>& items) {
+            const size_t bytes = items.size() * sizeof(T);
+            align(4, bytes);
+            align(8, bytes);
+            if (bytes > 0) {
+                pushBytes(reinterpret_cast<const char*>(items.data()), bytes);
+            }
+            pushScalar<uint32_t>(static_cast<uint32_t>(items.size()));
+            return size();
+        }
+
+        void startTable() {
+            m_fields.clear();
+            m_tableStart = size();
+        }
+
+        template <typename T>
+        void addField(uint16_t id, T value) {
+            align(sizeof(T));
+            pushScalar<T>(value);
+            m_fields.push_back({id, size()});
+        }
+
+        void addOffsetField(uint16_t id, Ref ref) {
+            addOffset(ref);
+            m_fields.push_back({id, size()});
+        }
+
+        Ref endTable() {
+            // Placeholder for the signed offset to the vtable
+            align(4);
+            pushScalar<int32_t>(0);
+            const Ref table = size();
+
+            uint16_t slotCount = 0;
+            for (const auto& field : m_fields) {
+                slotCount = std::max<uint16_t>(slotCount, field.id + 1);
+            }
+            std::vector<uint16_t> vtableSlots(slotCount, 0);
+            for (const auto& field : m_fields) {
+                vtableSlots[field.id] = static_cast<uint16_t>(table - field.ref);
+            }
+
+            for (size_t i = vtableSlots.size(); i > 0; --i) {
+                pushScalar<uint16_t>(vtableSlots[i - 1]);
+            }
+            pushScalar<uint16_t>(static_cast<uint16_t>(table - m_tableStart));
+            pushScalar<uint16_t>(static_cast<uint16_t>((slotCount + 2) * sizeof(uint16_t)));
+            const Ref vtable = size();
+
+            const int32_t vtableOffset = static_cast<int32_t>(vtable - table);
+            std::memcpy(&m_buffer[m_buffer.size() - table], &vtableOffset, sizeof(vtableOffset));
+            return table;
+        }
+
+        QByteArray finish(Ref root) {
+            align(m_minAlign, sizeof(uint32_t));
+            addOffset(root);
+            return QByteArray(reinterpret_cast<const char*>(&m_buffer[m_head]), static_cast<int>(size()));
+        }
+
+    private:
+        struct FieldLocation { uint16_t id; Ref ref; };
+
+        std::vector<uint8_t> m_buffer;
+        size_t m_head;
+        size_t m_minAlign = 1;
+        Ref m_tableStart = 0;
+        std::vector<FieldLocation> m_fields;
+
+        Ref size() const { return static_cast<Ref>(m_buffer.size() - m_head); }
+
+        void reserve(size_t bytes) {
+            if (m_head >= bytes) {
+                return;
+            }
+            const size_t used = size();
+            size_t capacity = m_buffer.size();
+            while (capacity - used < bytes) {
+                capacity *= 2;
+            }
+            std::vector<uint8_t> grown(capacity);
+            std::memcpy(&grown[capacity - used], &m_buffer[m_head], used);
+            m_buffer.swap(grown);
+            m_head = capacity - used;
+        }
+
+        // Pad so that after writing `extra` more bytes the size is a multiple of `alignment`
+        void align(size_t alignment, size_t extra = 0) {
+            m_minAlign = std::max(m_minAlign, alignment);
+            const size_t padding = (~(size() + extra) + 1) & (alignment - 1);
+            reserve(padding);
+            m_head -= padding;
+            std::memset(&m_buffer[m_head], 0, padding);
+        }
+
+        void pushBytes(const char* data, size_t length) {
+            reserve(length);
+            m_head -= length;
+            std::memcpy(&m_buffer[m_head], data, length);
+        }
+
+        template <typename T>
+        void pushScalar(T value) {
+            pushBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void addOffset(Ref target) {
+            align(4);
+            pushScalar<uint32_t>(size() + sizeof(uint32_t) - target);
+        }
+    };
+
+    // One exported column and the memory its buffers are written from
+    struct ColumnSpec {
+        QByteArray name;
+        bool isTimestamp;
+        const char* data;
+        qint64 dataLength;
+        const char* validity;
+        qint64 validityLength;
+        qint64 nullCount;
+    };
+
+    std::vector<ColumnSpec> collectColumns(const TrackColumns& columns) {
+        std::vector<ColumnSpec> specs;
+        const qint64 rows = static_cast<qint64>(columns.size());
+
+        auto addDouble = [&specs, rows](const char* name, const std::vector<double>& column) {
+            if (column.empty()) {
+                return;
+            }
+            specs.push_back({name, false, reinterpret_cast<const char*>(column.data()),
+                             rows * static_cast<qint64>(sizeof(double)), nullptr, 0, 0});
+        };
+
+        if (columns.hasTimestamps()) {
+            specs.push_back({"time", true, reinterpret_cast<const char*>(columns.timestampMs.data()),
+                             rows * static_cast<qint64>(sizeof(qint64)),
+                             reinterpret_cast<const char*>(columns.timestampValidity.data()),
+                             static_cast<qint64>(columns.timestampValidity.size()),
+                             static_cast<qint64>(columns.timestampNullCount)});
+        }
+        addDouble("latitude", columns.latitude);
+        addDouble("longitude", columns.longitude);
+        addDouble("elevation", columns.elevation);
+        addDouble("distance", columns.distance);
+        addDouble("gradient", columns.gradient);
+        addDouble("heart_rate", columns.heartRate);
+        addDouble("cadence", columns.cadence);
+        addDouble("power", columns.power);
+        addDouble("temperature", columns.temperature);
+        return specs;
+    }
+
+    FlatBufferBuilder::Ref buildSchema(FlatBufferBuilder& builder, const std::vector<ColumnSpec>& specs) {
+        std::vector<FlatBufferBuilder::Ref> fields;
+        fields.reserve(specs.size());
+
+        for (const auto& spec : specs) {
+            FlatBufferBuilder::Ref typeRef;
+            if (spec.isTimestamp) {
+                FlatBufferBuilder::Ref timezone = builder.createString("UTC");
+                builder.startTable();
+                builder.addField<int16_t>(0, TIME_UNIT_MILLISECOND);
+                builder.addOffsetField(1, timezone);
+                typeRef = builder.endTable();
+            } else {
+                builder.startTable();
+                builder.addField<int16_t>(0, PRECISION_DOUBLE);
+                typeRef = builder.endTable();
+            }
+
+            FlatBufferBuilder::Ref name = builder.createString(spec.name);
+            FlatBufferBuilder::Ref children = builder.createOffsetVector({});
+
+            builder.startTable();
+            builder.addOffsetField(0, name);
+            builder.addField<uint8_t>(1, 1); // nullable
+            builder.addField<uint8_t>(2, spec.isTimestamp ? TYPE_TIMESTAMP : TYPE_FLOATING_POINT);
+            builder.addOffsetField(3, typeRef);
+            builder.addOffsetField(5, children);
+            fields.push_back(builder.endTable());
+        }
+
+        FlatBufferBuilder::Ref fieldVector = builder.createOffsetVector(fields);
+        builder.startTable();
+        builder.addField<int16_t>(0, ENDIANNESS_LITTLE);
+        builder.addOffsetField(1, fieldVector);
+        return builder.endTable();
+    }
+
+    QByteArray buildMessage(uint8_t headerType,
+                            const std::function<FlatBufferBuilder::Ref(FlatBufferBuilder&)>& buildHeader,
+                            qint64 bodyLength) {
+        FlatBufferBuilder builder;
+        FlatBufferBuilder::Ref header = buildHeader(builder);
+        builder.startTable();
+        builder.addField<int64_t>(3, bodyLength);
+        builder.addOffsetField(2, header);
+        builder.addField<int16_t>(0, METADATA_VERSION_V5);
+        builder.addField<uint8_t>(1, headerType);
+        return builder.finish(builder.endTable());
+    }
+
+    class ArrowFileWriter {
+    public:
+        explicit ArrowFileWriter(QSaveFile& file) : m_file(file) {}
+
+        qint64 position() const { return m_position; }
+
+        bool write(const char* data, qint64 length) {
+            if (length > 0 && m_file.write(data, length) != length) {
+                return false;
+            }
+            m_position += length;
+            return true;
+        }
+
+        bool writePadding(qint64 length) {
+            static const char zeros[BUFFER_ALIGNMENT] = {};
+            return write(zeros, length);
+        }
+
+        // Encapsulated IPC message: continuation marker, metadata length, flatbuffer, padding
+        bool writeMessage(const QByteArray& metadata, int32_t* metaDataLength) {
+            const qint64 prefix = 2 * sizeof(uint32_t);
+            const qint64 padded = paddedLength(prefix + metadata.size()) - prefix;
+            const int32_t length = static_cast<int32_t>(padded);
+            if (!write(reinterpret_cast<const char*>(&CONTINUATION_MARKER), sizeof(uint32_t)) ||
+                !write(reinterpret_cast<const char*>(&length), sizeof(length)) ||
+                !write(metadata.constData(), metadata.size()) ||
+                !writePadding(padded - metadata.size())) {
+                return false;
+            }
+            if (metaDataLength) {
+                *metaDataLength = static_cast<int32_t>(prefix + padded);
+            }
+            return true;
+        }
+
+    private:
+        QSaveFile& m_file;
+        qint64 m_position = 0;
+    };
+}
+
+bool ArrowExporter::exportColumns(const TrackColumns& columns, const QString& filename)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_errorString.clear();
+
+    const std::vector<ColumnSpec> specs = collectColumns(columns);
+    const qint64 rows = static_cast<qint64>(columns.size());
+
+    // Lay out the record batch body: validity buffer then data buffer per column
+    std::vector<FieldNodeStruct> nodes;
+    std::vector<BufferStruct> buffers;
+    qint64 bodyLength = 0;
+    for (const auto& spec : specs) {
+        nodes.push_back({rows, spec.nullCount});
+        buffers.push_back({bodyLength, spec.validityLength});
+        bodyLength += paddedLength(spec.validityLength);
+        buffers.push_back({bodyLength, spec.dataLength});
+        bodyLength += paddedLength(spec.dataLength);
+    }
+
+    const QByteArray schemaMessage = buildMessage(MESSAGE_HEADER_SCHEMA,
+        [&specs](FlatBufferBuilder& builder) { return buildSchema(builder, specs); }, 0);
+
+    const QByteArray batchMessage = buildMessage(MESSAGE_HEADER_RECORD_BATCH,
+        [&nodes, &buffers, rows](FlatBufferBuilder& builder) {
+            FlatBufferBuilder::Ref nodeVector = builder.createStructVector(nodes);
+            FlatBufferBuilder::Ref bufferVector = builder.createStructVector(buffers);
+            builder.startTable();
+            builder.addField<int64_t>(0, rows);
+            builder.addOffsetField(1, nodeVector);
+            builder.addOffsetField(2, bufferVector);
+            return builder.endTable();
+        }, bodyLength);
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_errorString = QString("Cannot open %1 for writing: %2").arg(filename, file.errorString());
+        logWarning("ArrowExporter", m_errorString);
+        return false;
+    }
+
+    ArrowFileWriter writer(file);
+    bool ok = writer.write(ARROW_MAGIC, 6) && writer.writePadding(2);
+    ok = ok && writer.writeMessage(schemaMessage, nullptr);
+
+    BlockStruct batchBlock = {writer.position(), 0, 0, bodyLength};
+    ok = ok && writer.writeMessage(batchMessage, &batchBlock.metaDataLength);
+
+    // Body: column buffers go straight from the column arrays to the file
+    for (const auto& spec : specs) {
+        ok = ok && writer.write(spec.validity, spec.validityLength)
+                && writer.writePadding(paddedLength(spec.validityLength) - spec.validityLength)
+                && writer.write(spec.data, spec.dataLength)
+                && writer.writePadding(paddedLength(spec.dataLength) - spec.dataLength);
+    }
+
+    // End-of-stream marker, then the footer repeating the schema and locating the batch
+    const uint32_t endOfStream[2] = {CONTINUATION_MARKER, 0};
+    ok = ok && writer.write(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream));
+
+    FlatBufferBuilder footerBuilder;
+    FlatBufferBuilder::Ref footerSchema = buildSchema(footerBuilder, specs);
+    FlatBufferBuilder::Ref dictionaries = footerBuilder.createStructVector(std::vector<BlockStruct>());
+    FlatBufferBuilder::Ref recordBatches = footerBuilder.createStructVector(std::vector<BlockStruct>{batchBlock});
+    footerBuilder.startTable();
+    footerBuilder.addOffsetField(1, footerSchema);
+    footerBuilder.addOffsetField(2, dictionaries);
+    footerBuilder.addOffsetField(3, recordBatches);
+    footerBuilder.addField<int16_t>(0, METADATA_VERSION_V5);
+    const QByteArray footer = footerBuilder.finish(footerBuilder.endTable());
+    const int32_t footerLength = footer.size();
+
+    ok = ok && writer.write(footer.constData(), footer.size())
+            && writer.write(reinterpret_cast<const char*>(&footerLength), sizeof(footerLength))
+            && writer.write(ARROW_MAGIC, 6);
+
+    if (!ok || !file.commit()) {
+        m_errorString = QString("Failed to write %1: %2").arg(filename, file.errorString());
+        logWarning("ArrowExporter", m_errorString);
+        return false;
+    }
+
+    logInfo("ArrowExporter", QString("Exported %1 rows x %2 columns to %3 in %4 ms")
+            .arg(rows).arg(specs.size()).arg(filename).arg(timer.elapsed()));
+    return true;
+}
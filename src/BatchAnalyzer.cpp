@@ -0,0 +1,253 @@
+#include "BatchAnalyzer.h"
+#include "AnalysisCache.h"
+#include "MotionAnalyzer.h"
+#include "TrackAnalyzer.h"
+#include "TrackColumns.h"
+#include "logging.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+    QJsonArray toJsonArray(const std::vector<double>& values) {
+        QJsonArray array;
+        for (double value : values) {
+            array.append(value);
+        }
+        return array;
+    }
+
+    QJsonObject zoneJson(const ZoneHistogram& histogram) {
+        QJsonObject object;
+        object["bounds"] = toJsonArray(histogram.bounds);
+        object["time"] = toJsonArray(histogram.time);
+        object["distance"] = toJsonArray(histogram.distance);
+        return object;
+    }
+
+    QByteArray joinTimes(const ZoneHistogram& histogram) {
+        QStringList times;
+        if (!histogram.isEmpty()) {
+            for (double time : histogram.time) {
+                times << QString::number(time, 'f', 0);
+            }
+        }
+        return times.join(';').toUtf8();
+    }
+
+    // Quote a CSV field if it contains a separator, quote or line break
+    QByteArray csvField(const QString& text) {
+        QByteArray field = text.toUtf8();
+        if (field.contains(',') || field.contains('"') || field.contains('\n')) {
+            field.replace("\"", "\"\"");
+            field = '"' + field + '"';
+        }
+        return field;
+    }
+
+    QByteArray number(double value, int decimals) {
+        return QByteArray::number(value, 'f', decimals);
+    }
+}
+
+QStringList BatchAnalyzer::collectFiles(const QStringList& paths) {
+    QStringList files;
+    for (const QString& path : paths) {
+        if (!QFileInfo(path).isDir()) {
+            files << path;
+            continue;
+        }
+        QStringList found;
+        QDirIterator it(path, QStringList() << "*.gpx" << "*.GPX", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            found << it.next();
+        }
+        std::sort(found.begin(), found.end());
+        files << found;
+    }
+    return files;
+}
+
+std::vector<TrackSummary> BatchAnalyzer::analyzeFiles(const QStringList& files) const {
+    std::vector<TrackSummary> summaries(files.size());
+    for (int i = 0; i < files.size(); ++i) {
+        summaries[i].file = files[i];
+    }
+
+    QtConcurrent::blockingMap(summaries, [this](TrackSummary& summary) {
+        summary = analyzeFile(summary.file);
+    });
+    return summaries;
+}
+
+TrackSummary BatchAnalyzer::analyzeFile(const QString& file) const {
+    GPXParser parser;
+    if (!parser.parse(file)) {
+        TrackSummary summary;
+        summary.file = file;
+        summary.error = QFileInfo(file).exists() ? "Cannot parse GPX file" : "File not found";
+        logWarning("BatchAnalyzer", QString("%1: %2").arg(file, summary.error));
+        return summary;
+    }
+    return summarize(file, parser);
+}
+
+TrackSummary BatchAnalyzer::summarize(const QString& file, const GPXParser& parser) const {
+    const std::vector<TrackPoint>& points = parser.getPoints();
+    TrackSummary summary;
+    summary.file = file;
+    summary.pointCount = points.size();
+    if (points.size() < 2) {
+        summary.error = "Track has fewer than two points";
+        return summary;
+    }
+
+    summary.distance = parser.getTotalDistance();
+    summary.elevationGain = parser.getTotalElevationGain();
+    summary.maxElevation = parser.getMaxElevation();
+    summary.minElevation = parser.getMinElevation();
+
+    // Files already run in parallel, so each track is analyzed on its worker alone
+    TrackAnalyzer analyzer;
+    analyzer.setChunkSize(0);
+    TrackAnalysisResult analysis = m_useCache ? AnalysisCache().analyze(analyzer, points)
+                                              : analyzer.analyze(points);
+    summary.segmentCount = analysis.segments().size();
+    summary.uphillPercent = analysis.uphillPercent();
+    summary.downhillPercent = analysis.downhillPercent();
+    summary.flatPercent = analysis.flatPercent();
+    summary.steepestUphill = analysis.steepestUphill();
+    summary.steepestDownhill = analysis.steepestDownhill();
+    summary.climbs = analysis.climbs();
+    for (const Climb& climb : summary.climbs) {
+        summary.climbStarts.push_back(points[climb.startIndex].distance);
+    }
+
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    MotionProfile motion = MotionAnalyzer().analyze(columns);
+    summary.elapsedTime = motion.elapsedTime;
+    summary.movingTime = motion.movingTime;
+    summary.averageMovingSpeed = motion.averageMovingSpeed();
+    summary.maxSpeed = motion.maxSpeed;
+
+    summary.gains = ElevationGainEstimator().estimate(columns);
+    summary.zones = ZoneAnalyzer(m_zoneSettings).analyze(columns);
+    return summary;
+}
+
+QJsonObject BatchAnalyzer::toJson(const TrackSummary& summary) {
+    QJsonObject object;
+    object["file"] = summary.file;
+    if (!summary.ok()) {
+        object["error"] = summary.error;
+        return object;
+    }
+
+    object["points"] = static_cast<double>(summary.pointCount);
+    object["distance"] = summary.distance;
+    object["elevation_gain"] = summary.elevationGain;
+    object["max_elevation"] = summary.maxElevation;
+    object["min_elevation"] = summary.minElevation;
+
+    QJsonObject gains;
+    gains["raw"] = summary.gains.raw;
+    gains["threshold"] = summary.gains.threshold;
+    gains["hysteresis"] = summary.gains.hysteresis;
+    gains["smoothed"] = summary.gains.smoothed;
+    object["gain_estimates"] = gains;
+
+    if (summary.elapsedTime > 0.0) {
+        object["elapsed_time"] = summary.elapsedTime;
+        object["moving_time"] = summary.movingTime;
+        object["average_moving_speed"] = summary.averageMovingSpeed;
+        object["max_speed"] = summary.maxSpeed;
+    }
+
+    QJsonObject segments;
+    segments["count"] = static_cast<double>(summary.segmentCount);
+    segments["uphill_percent"] = summary.uphillPercent;
+    segments["downhill_percent"] = summary.downhillPercent;
+    segments["flat_percent"] = summary.flatPercent;
+    segments["steepest_uphill"] = summary.steepestUphill;
+    segments["steepest_downhill"] = summary.steepestDownhill;
+    object["segments"] = segments;
+
+    QJsonArray climbs;
+    for (size_t i = 0; i < summary.climbs.size(); ++i) {
+        const Climb& climb = summary.climbs[i];
+        QJsonObject entry;
+        entry["category"] = ClimbDetector::categoryName(climb.category);
+        entry["start"] = summary.climbStarts[i];
+        entry["distance"] = climb.distance;
+        entry["elevation_gain"] = climb.elevationGain;
+        entry["average_gradient"] = climb.avgGradient;
+        entry["max_gradient"] = climb.maxGradient;
+        entry["score"] = climb.score;
+        climbs.append(entry);
+    }
+    object["climbs"] = climbs;
+
+    QJsonObject zones;
+    if (!summary.zones.heartRate.isEmpty()) {
+        zones["heart_rate"] = zoneJson(summary.zones.heartRate);
+    }
+    if (!summary.zones.power.isEmpty()) {
+        zones["power"] = zoneJson(summary.zones.power);
+    }
+    if (!summary.zones.gradient.isEmpty()) {
+        zones["gradient"] = zoneJson(summary.zones.gradient);
+    }
+    object["zones"] = zones;
+    return object;
+}
+
+QByteArray BatchAnalyzer::csvHeader() {
+    return "file,error,points,distance,elevation_gain,max_elevation,min_elevation,"
+           "gain_raw,gain_threshold,gain_hysteresis,gain_smoothed,"
+           "elapsed_time,moving_time,average_moving_speed,max_speed,"
+           "segments,uphill_percent,downhill_percent,flat_percent,steepest_uphill,steepest_downhill,"
+           "climbs,climb_gain,hardest_climb,"
+           "heart_rate_zone_time,power_zone_time,gradient_zone_time\n";
+}
+
+QByteArray BatchAnalyzer::toCsv(const TrackSummary& summary) {
+    QByteArray row = csvField(summary.file) + ',' + csvField(summary.error) + ',';
+    if (!summary.ok()) {
+        return row + QByteArray(24, ',') + '\n';
+    }
+
+    double climbGain = 0.0;
+    QString hardest;
+    double hardestScore = 0.0;
+    for (const Climb& climb : summary.climbs) {
+        climbGain += climb.elevationGain;
+        if (climb.score > hardestScore) {
+            hardestScore = climb.score;
+            hardest = ClimbDetector::categoryName(climb.category);
+        }
+    }
+
+    QList<QByteArray> fields;
+    fields << QByteArray::number(static_cast<qulonglong>(summary.pointCount))
+           << number(summary.distance, 1) << number(summary.elevationGain, 1)
+           << number(summary.maxElevation, 1) << number(summary.minElevation, 1)
+           << number(summary.gains.raw, 1) << number(summary.gains.threshold, 1)
+           << number(summary.gains.hysteresis, 1) << number(summary.gains.smoothed, 1)
+           << number(summary.elapsedTime, 0) << number(summary.movingTime, 0)
+           << number(summary.averageMovingSpeed, 2) << number(summary.maxSpeed, 2)
+           << QByteArray::number(static_cast<qulonglong>(summary.segmentCount))
+           << number(summary.uphillPercent, 1) << number(summary.downhillPercent, 1)
+           << number(summary.flatPercent, 1) << number(summary.steepestUphill, 1)
+           << number(summary.steepestDownhill, 1)
+           << QByteArray::number(static_cast<qulonglong>(summary.climbs.size()))
+           << number(climbGain, 1) << hardest.toUtf8()
+           << joinTimes(summary.zones.heartRate) << joinTimes(summary.zones.power)
+           << joinTimes(summary.zones.gradient);
+    for (int i = 0; i < fields.size(); ++i) {
+        row += fields[i];
+        row += (i + 1 < fields.size()) ? ',' : '\n';
+    }
+    return row;
+}
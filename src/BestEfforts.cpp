@@ -0,0 +1,130 @@
+#include "BestEfforts.h"
+#include <QtConcurrent>
+
+namespace {
+
+// Timed points only, in track order
+struct TimedSeries {
+    std::vector<size_t> index;      // Row in the track columns
+    std::vector<double> seconds;    // Since the first timed point
+    std::vector<double> distance;
+    std::vector<double> elevation;
+    
+    size_t size() const { return index.size(); }
+};
+
+TimedSeries collectTimed(const TrackColumns& columns) {
+    TimedSeries series;
+    if (!columns.hasTimestamps()) {
+        return series;
+    }
+    
+    const size_t count = columns.size();
+    series.index.reserve(count - columns.timestampNullCount);
+    series.seconds.reserve(count - columns.timestampNullCount);
+    series.distance.reserve(count - columns.timestampNullCount);
+    series.elevation.reserve(count - columns.timestampNullCount);
+    qint64 origin = 0;
+    for (size_t row = 0; row < count; ++row) {
+        if (!columns.timestampValid(row)) {
+            continue;
+        }
+        if (series.index.empty()) {
+            origin = columns.timestampMs[row];
+        }
+        series.index.push_back(row);
+        series.seconds.push_back((columns.timestampMs[row] - origin) / 1000.0);
+        series.distance.push_back(columns.distance[row]);
+        series.elevation.push_back(columns.elevation[row]);
+    }
+    return series;
+}
+
+void setRange(BestEffort& effort, const TimedSeries& series, size_t first, size_t last) {
+    effort.found = true;
+    effort.startIndex = series.index[first];
+    effort.endIndex = series.index[last];
+    effort.distance = series.distance[last] - series.distance[first];
+    effort.duration = series.seconds[last] - series.seconds[first];
+    effort.climb = series.elevation[last] - series.elevation[first];
+}
+
+// Shortest time for any stretch of at least the given distance: for each end
+// point the start is the latest one that still leaves enough distance, and it
+// only ever moves forward
+void fastestDistance(const TimedSeries& series, BestEffort& effort) {
+    size_t start = 0;
+    double bestTime = 0.0;
+    for (size_t end = 1; end < series.size(); ++end) {
+        if (series.distance[end] - series.distance[start] < effort.window) {
+            continue;
+        }
+        while (start + 1 < end && series.distance[end] - series.distance[start + 1] >= effort.window) {
+            ++start;
+        }
+        double time = series.seconds[end] - series.seconds[start];
+        if (time > 0.0 && (!effort.found || time < bestTime)) {
+            bestTime = time;
+            setRange(effort, series, start, end);
+        }
+    }
+}
+
+// Highest net ascent rate for any stretch lasting at least the given time
+void maxClimbRate(const TimedSeries& series, BestEffort& effort) {
+    size_t start = 0;
+    double bestRate = 0.0;
+    for (size_t end = 1; end < series.size(); ++end) {
+        if (series.seconds[end] - series.seconds[start] < effort.window) {
+            continue;
+        }
+        while (start + 1 < end && series.seconds[end] - series.seconds[start + 1] >= effort.window) {
+            ++start;
+        }
+        double rate = (series.elevation[end] - series.elevation[start]) /
+                      (series.seconds[end] - series.seconds[start]);
+        if (!effort.found || rate > bestRate) {
+            bestRate = rate;
+            setRange(effort, series, start, end);
+        }
+    }
+}
+
+} // namespace
+
+BestEffortFinder::BestEffortFinder()
+    : m_distances({1000.0, 5000.0, 10000.0, 21097.5}),
+      m_durations({300.0, 600.0, 1200.0})
+{
+}
+
+std::vector<BestEffort> BestEffortFinder::find(const TrackColumns& columns) const {
+    std::vector<BestEffort> efforts;
+    for (double meters : m_distances) {
+        BestEffort effort;
+        effort.kind = BestEffort::FASTEST_DISTANCE;
+        effort.window = meters;
+        efforts.push_back(effort);
+    }
+    for (double seconds : m_durations) {
+        BestEffort effort;
+        effort.kind = BestEffort::MAX_CLIMB_RATE;
+        effort.window = seconds;
+        efforts.push_back(effort);
+    }
+    
+    const TimedSeries series = collectTimed(columns);
+    if (series.size() < 2) {
+        return efforts;
+    }
+    
+    // One independent sweep per window size
+    QtConcurrent::blockingMap(efforts, [&series](BestEffort& effort) {
+        if (effort.kind == BestEffort::FASTEST_DISTANCE) {
+            fastestDistance(series, effort);
+        } else {
+            maxClimbRate(series, effort);
+        }
+    });
+    return efforts;
+}
@@ -0,0 +1,168 @@
+#include "ClimbDetector.h"
+#include "RangeQuery.h"
+#include <algorithm>
+
+namespace {
+    // Scores are distance (m) x average gradient (%), as used by common climb rankings
+    const double CATEGORY_THRESHOLDS[] = {8000.0, 16000.0, 32000.0, 64000.0, 80000.0};
+
+    struct Candidate {
+        size_t start;
+        size_t summit;
+    };
+
+    // Last index in [first, last] whose value is at most limit (first if none)
+    size_t lastAtMost(const RangeMinimum& lows, size_t first, size_t last, double limit) {
+        if (lows.extreme(first, last) > limit) {
+            return first;
+        }
+        // min(j..last) grows with j, so search for the largest j where it is still <= limit
+        size_t lo = first, hi = last;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo + 1) / 2;
+            if (lows.extreme(mid, last) <= limit) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return lo;
+    }
+
+    // First index in [first, last] whose value is at least limit (last if none)
+    size_t firstAtLeast(const RangeMaximum& highs, size_t first, size_t last, double limit) {
+        if (highs.extreme(first, last) < limit) {
+            return last;
+        }
+        // max(first..j) grows with j, so search for the smallest j where it reaches limit
+        size_t lo = first, hi = last;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (highs.extreme(first, mid) >= limit) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+}
+
+double ClimbDetector::dipTolerance(double gain) const {
+    return std::max(m_params.maxDip, m_params.maxDipFraction * gain);
+}
+
+std::vector<Climb> ClimbDetector::detect(const std::vector<TrackPoint>& points) const {
+    std::vector<Climb> climbs;
+    if (points.size() < 2) {
+        return climbs;
+    }
+    
+    std::vector<double> elevations(points.size());
+    std::vector<double> gradients(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        elevations[i] = points[i].elevation;
+        gradients[i] = points[i].gradient;
+    }
+    RangeMinimum lows(elevations);
+    RangeMaximum highs(elevations);
+    RangeMaximum steepest(gradients);
+    const std::vector<double>& elev = lows.values();
+    
+    // Valley-to-summit candidates: a candidate ends once the track drops further
+    // below its summit than the dip tolerance for the gain climbed so far
+    std::vector<Candidate> candidates;
+    size_t start = 0;
+    size_t summit = 0;
+    for (size_t i = 1; i < elev.size(); ++i) {
+        if (elev[i] > elev[summit]) {
+            summit = i;
+            continue;
+        }
+        if (elev[summit] - elev[i] > dipTolerance(elev[summit] - elev[start])) {
+            if (summit > start) {
+                candidates.push_back({start, summit});
+            }
+            start = summit = i;
+        } else if (elev[i] < elev[start]) {
+            start = summit = i;
+        }
+    }
+    if (summit > start) {
+        candidates.push_back({start, summit});
+    }
+    
+    // Trim flat lead-ins and run-outs so gradients describe the actual ramp
+    for (auto& candidate : candidates) {
+        double low = elev[candidate.start];
+        double high = elev[candidate.summit];
+        candidate.start = lastAtMost(lows, candidate.start, candidate.summit, low + m_params.rampTolerance);
+        candidate.summit = firstAtLeast(highs, candidate.start, candidate.summit, high - m_params.rampTolerance);
+    }
+    
+    // Merge a candidate into the climbs before it while it leads to a higher summit
+    // and the dip in between is small compared to the combined climb (monotonic stack)
+    std::vector<Candidate> merged;
+    for (Candidate candidate : candidates) {
+        while (!merged.empty()) {
+            const Candidate& previous = merged.back();
+            if (elev[candidate.summit] <= elev[previous.summit] ||
+                elev[previous.start] > elev[candidate.start]) {
+                break;
+            }
+            double dip = elev[previous.summit] - lows.extreme(previous.summit, candidate.start);
+            if (dip > dipTolerance(elev[candidate.summit] - elev[previous.start])) {
+                break;
+            }
+            candidate.start = previous.start;
+            merged.pop_back();
+        }
+        merged.push_back(candidate);
+    }
+    
+    for (const auto& candidate : merged) {
+        Climb climb;
+        climb.startIndex = candidate.start;
+        climb.endIndex = candidate.summit;
+        climb.distance = points[candidate.summit].distance - points[candidate.start].distance;
+        climb.elevationGain = elev[candidate.summit] - elev[candidate.start];
+        if (climb.distance < m_params.minDistance) {
+            continue;
+        }
+        climb.avgGradient = climb.elevationGain / climb.distance * 100.0;
+        climb.score = climb.distance * climb.avgGradient;
+        if (climb.avgGradient < m_params.minAvgGradient || climb.score < m_params.minScore) {
+            continue;
+        }
+        climb.maxGradient = steepest.extreme(candidate.start, candidate.summit);
+        climb.category = categorize(climb.score);
+        climbs.push_back(climb);
+    }
+    
+    return climbs;
+}
+
+Climb::Category ClimbDetector::categorize(double score) {
+    Climb::Category category = Climb::CATEGORY_4;
+    for (int i = Climb::CATEGORY_3; i <= Climb::HORS_CATEGORIE; ++i) {
+        if (score >= CATEGORY_THRESHOLDS[i]) {
+            category = static_cast<Climb::Category>(i);
+        }
+    }
+    return category;
+}
+
+double ClimbDetector::categoryThreshold(Climb::Category category) {
+    return CATEGORY_THRESHOLDS[category];
+}
+
+QString ClimbDetector::categoryName(Climb::Category category) {
+    switch (category) {
+        case Climb::CATEGORY_4: return "Cat 4";
+        case Climb::CATEGORY_3: return "Cat 3";
+        case Climb::CATEGORY_2: return "Cat 2";
+        case Climb::CATEGORY_1: return "Cat 1";
+        case Climb::HORS_CATEGORIE: return "HC";
+    }
+    return QString();
+}
@@ -0,0 +1,495 @@
+#include "ContractionHierarchy.h"
+#include "logging.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+    const quint32 CACHE_MAGIC = 0x47504348; // "GPCH"
+    const quint32 CACHE_VERSION = 1;
+    const double INF = std::numeric_limits<double>::infinity();
+    // Settled nodes after which a witness search gives up (a missed witness only costs a spare shortcut)
+    const int SIMULATION_SETTLE_LIMIT = 60;
+    const int CONTRACTION_SETTLE_LIMIT = 600;
+
+    template <typename T>
+    using MinQueue = std::priority_queue<std::pair<T, qint32>, std::vector<std::pair<T, qint32>>,
+                                         std::greater<std::pair<T, qint32>>>;
+}
+
+ContractionHierarchy::ContractionHierarchy(const RoadGraph& graph)
+    : m_graph(&graph)
+{
+    if (graph.isEmpty()) {
+        return;
+    }
+    for (qint32 node = 0; node < static_cast<qint32>(graph.nodeCount()); ++node) {
+        for (const RoadGraph::Arc* arc = graph.arcsBegin(node); arc != graph.arcsEnd(node); ++arc) {
+            m_edges.push_back(Edge{node, arc->target, arc->length, -1, -1});
+        }
+    }
+    contract();
+}
+
+void ContractionHierarchy::contract() {
+    QElapsedTimer timer;
+    timer.start();
+    const size_t n = m_graph->nodeCount();
+    std::vector<std::vector<qint32>> out(n), in(n);
+    for (size_t e = 0; e < m_edges.size(); ++e) {
+        out[m_edges[e].from].push_back(static_cast<qint32>(e));
+        in[m_edges[e].to].push_back(static_cast<qint32>(e));
+    }
+    std::vector<char> contracted(n, 0);
+    std::vector<int> contractedNeighbors(n, 0);
+    std::vector<int> depth(n, 0);          // Longest chain of contracted nodes below each node
+    std::vector<float> witness(n, std::numeric_limits<float>::infinity());
+    std::vector<qint32> touched;
+
+    // Shortest paths from a node avoiding the node being contracted, up to a length
+    // Stops early once every neighbor the shortcuts would lead to is settled
+    std::vector<char> isTarget(n, 0);
+    auto witnessSearch = [&](qint32 source, qint32 skipped, float limit, int settleLimit, int targets) {
+        MinQueue<float> queue;
+        witness[source] = 0.0f;
+        touched.push_back(source);
+        queue.push(std::make_pair(0.0f, source));
+        int settled = 0;
+        while (!queue.empty() && settled < settleLimit && targets > 0) {
+            const std::pair<float, qint32> top = queue.top();
+            queue.pop();
+            if (top.first > witness[top.second]) {
+                continue;
+            }
+            if (top.first > limit) {
+                break;
+            }
+            ++settled;
+            targets -= isTarget[top.second];
+            for (qint32 e : out[top.second]) {
+                const Edge& edge = m_edges[e];
+                if (contracted[edge.to] || edge.to == skipped) {
+                    continue;
+                }
+                const float distance = top.first + edge.weight;
+                if (distance < witness[edge.to]) {
+                    if (std::isinf(witness[edge.to])) {
+                        touched.push_back(edge.to);
+                    }
+                    witness[edge.to] = distance;
+                    queue.push(std::make_pair(distance, edge.to));
+                }
+            }
+        }
+    };
+    auto clearWitness = [&]() {
+        for (qint32 node : touched) {
+            witness[node] = std::numeric_limits<float>::infinity();
+        }
+        touched.clear();
+    };
+
+    // Shortcuts needed to contract a node; added unless only simulating
+    auto contractNode = [&](qint32 v, bool simulate) {
+        int shortcuts = 0;
+        int targets = 0;
+        for (qint32 e : out[v]) {
+            const qint32 x = m_edges[e].to;
+            if (!contracted[x] && x != v && !isTarget[x]) {
+                isTarget[x] = 1;
+                ++targets;
+            }
+        }
+        for (size_t i = 0; i < in[v].size(); ++i) {
+            const Edge incoming = m_edges[in[v][i]];
+            if (contracted[incoming.from] || incoming.from == v) {
+                continue;
+            }
+            float longest = -1.0f;
+            for (qint32 e : out[v]) {
+                const Edge& outgoing = m_edges[e];
+                if (!contracted[outgoing.to] && outgoing.to != incoming.from && outgoing.to != v) {
+                    longest = std::max(longest, outgoing.weight);
+                }
+            }
+            if (longest < 0.0f) {
+                continue;
+            }
+            witnessSearch(incoming.from, v, incoming.weight + longest,
+                          simulate ? SIMULATION_SETTLE_LIMIT : CONTRACTION_SETTLE_LIMIT, targets);
+            for (size_t j = 0; j < out[v].size(); ++j) {
+                const qint32 outgoingId = out[v][j];
+                const Edge outgoing = m_edges[outgoingId];
+                if (contracted[outgoing.to] || outgoing.to == incoming.from || outgoing.to == v) {
+                    continue;
+                }
+                const float via = incoming.weight + outgoing.weight;
+                if (witness[outgoing.to] <= via) {
+                    continue;
+                }
+                ++shortcuts;
+                if (std::isinf(witness[outgoing.to])) {
+                    touched.push_back(outgoing.to);
+                }
+                witness[outgoing.to] = via;     // Parallel edges to the same neighbor need one shortcut
+                if (!simulate) {
+                    // A longer edge between the two neighbors is replaced; no shortcut refers to it yet
+                    auto existing = std::find_if(out[incoming.from].begin(), out[incoming.from].end(),
+                                                 [&](qint32 e) { return m_edges[e].to == outgoing.to; });
+                    if (existing != out[incoming.from].end()) {
+                        if (m_edges[*existing].weight > via) {
+                            m_edges[*existing] = Edge{incoming.from, outgoing.to, via, in[v][i], outgoingId};
+                        }
+                    } else {
+                        const qint32 id = static_cast<qint32>(m_edges.size());
+                        m_edges.push_back(Edge{incoming.from, outgoing.to, via, in[v][i], outgoingId});
+                        out[incoming.from].push_back(id);
+                        in[outgoing.to].push_back(id);
+                    }
+                }
+            }
+            clearWitness();
+        }
+        for (qint32 e : out[v]) {
+            isTarget[m_edges[e].to] = 0;
+        }
+        return shortcuts;
+    };
+    auto priority = [&](qint32 v) {
+        int removed = 0;
+        for (qint32 e : in[v]) removed += contracted[m_edges[e].from] ? 0 : 1;
+        for (qint32 e : out[v]) removed += contracted[m_edges[e].to] ? 0 : 1;
+        return 2 * (contractNode(v, true) - removed) + contractedNeighbors[v] + depth[v];
+    };
+
+    MinQueue<int> queue;
+    for (size_t v = 0; v < n; ++v) {
+        queue.push(std::make_pair(priority(static_cast<qint32>(v)), static_cast<qint32>(v)));
+    }
+    const size_t roadEdges = m_edges.size();
+    m_rank.assign(n, 0);
+    qint32 order = 0;
+    while (!queue.empty()) {
+        const qint32 v = queue.top().second;
+        queue.pop();
+        if (contracted[v]) {
+            continue;
+        }
+        // Lazy update: contract only if still the least important after recomputing
+        const int current = priority(v);
+        if (!queue.empty() && current > queue.top().first) {
+            queue.push(std::make_pair(current, v));
+            continue;
+        }
+        contractNode(v, false);
+        contracted[v] = 1;
+        m_rank[v] = order++;
+
+        // Neighbors forget the edges of the contracted node, keeping their later searches short
+        auto dropContracted = [&](std::vector<qint32>& edges, bool outgoing) {
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [&](qint32 e) {
+                return contracted[outgoing ? m_edges[e].to : m_edges[e].from];
+            }), edges.end());
+        };
+        std::vector<qint32> neighbors;
+        for (qint32 e : in[v]) {
+            const qint32 u = m_edges[e].from;
+            if (!contracted[u]) {
+                dropContracted(out[u], true);
+                neighbors.push_back(u);
+            }
+        }
+        for (qint32 e : out[v]) {
+            const qint32 x = m_edges[e].to;
+            if (!contracted[x]) {
+                dropContracted(in[x], false);
+                neighbors.push_back(x);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        for (qint32 u : neighbors) {
+            ++contractedNeighbors[u];
+            depth[u] = std::max(depth[u], depth[v] + 1);
+        }
+    }
+    m_shortcutCount = m_edges.size() - roadEdges;
+    buildSearchGraphs();
+    logInfo("ContractionHierarchy", QString("Contracted %1 nodes with %2 shortcuts in %3 ms")
+            .arg(n).arg(m_shortcutCount).arg(timer.elapsed()));
+}
+
+void ContractionHierarchy::buildSearchGraphs() {
+    const size_t n = m_rank.size();
+
+    // Every edge leads up the order from exactly one end
+    m_upOffsets.assign(n + 1, 0);
+    m_downOffsets.assign(n + 1, 0);
+    for (const Edge& edge : m_edges) {
+        if (m_rank[edge.from] < m_rank[edge.to]) {
+            ++m_upOffsets[edge.from + 1];
+        } else {
+            ++m_downOffsets[edge.to + 1];
+        }
+    }
+    for (size_t v = 0; v < n; ++v) {
+        m_upOffsets[v + 1] += m_upOffsets[v];
+        m_downOffsets[v + 1] += m_downOffsets[v];
+    }
+    m_upEdges.resize(m_upOffsets[n]);
+    m_downEdges.resize(m_downOffsets[n]);
+    std::vector<quint32> upFill(m_upOffsets.begin(), m_upOffsets.end() - 1);
+    std::vector<quint32> downFill(m_downOffsets.begin(), m_downOffsets.end() - 1);
+    for (size_t e = 0; e < m_edges.size(); ++e) {
+        const Edge& edge = m_edges[e];
+        if (m_rank[edge.from] < m_rank[edge.to]) {
+            m_upEdges[upFill[edge.from]++] = static_cast<qint32>(e);
+        } else {
+            m_downEdges[downFill[edge.to]++] = static_cast<qint32>(e);
+        }
+    }
+
+    m_forwardDistance.assign(n, INF);
+    m_backwardDistance.assign(n, INF);
+    m_forwardEdge.assign(n, -1);
+    m_backwardEdge.assign(n, -1);
+}
+
+QString ContractionHierarchy::cachePath(const QString& extractFile) {
+    const QFileInfo info(extractFile);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QString("%1|%2|%3").arg(info.absoluteFilePath()).arg(info.size())
+                 .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8());
+    const QString name = QString::fromLatin1(hash.result().toHex().left(16));
+    return QDir(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("routing"))
+        .filePath(name + ".ch");
+}
+
+bool ContractionHierarchy::save(const QString& filename) const {
+    if (isEmpty() || !QDir().mkpath(QFileInfo(filename).absolutePath())) {
+        return false;
+    }
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logWarning("ContractionHierarchy", QString("Cannot write %1").arg(filename));
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << CACHE_MAGIC << CACHE_VERSION << quint64(m_rank.size()) << quint64(m_edges.size() - m_shortcutCount)
+        << quint64(m_edges.size());
+    for (const Edge& edge : m_edges) {
+        out << edge.from << edge.to << edge.weight << edge.first << edge.second;
+    }
+    for (qint32 rank : m_rank) {
+        out << rank;
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool ContractionHierarchy::load(const QString& filename, const RoadGraph& graph) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    size_t roadArcs = 0;
+    for (qint32 node = 0; node < static_cast<qint32>(graph.nodeCount()); ++node) {
+        roadArcs += graph.arcsEnd(node) - graph.arcsBegin(node);
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    quint64 nodeCount = 0, roadEdges = 0, edgeCount = 0;
+    in >> magic >> version >> nodeCount >> roadEdges >> edgeCount;
+    if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        nodeCount != graph.nodeCount() || roadEdges != roadArcs || edgeCount < roadEdges ||
+        edgeCount > static_cast<quint64>(file.size())) {
+        return false;
+    }
+
+    std::vector<Edge> edges(edgeCount);
+    for (Edge& edge : edges) {
+        in >> edge.from >> edge.to >> edge.weight >> edge.first >> edge.second;
+        const qint32 limit = static_cast<qint32>(edgeCount);
+        if (edge.from < 0 || edge.to < 0 || edge.from >= static_cast<qint32>(nodeCount) ||
+            edge.to >= static_cast<qint32>(nodeCount) || edge.first >= limit || edge.second >= limit) {
+            return false;
+        }
+    }
+    std::vector<qint32> rank(nodeCount);
+    for (qint32& value : rank) {
+        in >> value;
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    m_graph = &graph;
+    m_edges = std::move(edges);
+    m_rank = std::move(rank);
+    m_shortcutCount = edgeCount - roadEdges;
+    buildSearchGraphs();
+    logInfo("ContractionHierarchy", QString("Loaded %1 shortcuts from %2").arg(m_shortcutCount).arg(filename));
+    return true;
+}
+
+double ContractionHierarchy::query(const std::vector<Seed>& sources, const std::vector<Seed>& targets,
+                                   std::vector<qint32>* nodes) {
+    std::vector<qint32> touched;
+    MinQueue<double> forward, backward;
+    for (const Seed& seed : sources) {
+        if (seed.distance < m_forwardDistance[seed.node]) {
+            m_forwardDistance[seed.node] = seed.distance;
+            touched.push_back(seed.node);
+            forward.push(std::make_pair(seed.distance, seed.node));
+        }
+    }
+    for (const Seed& seed : targets) {
+        if (seed.distance < m_backwardDistance[seed.node]) {
+            m_backwardDistance[seed.node] = seed.distance;
+            touched.push_back(seed.node);
+            backward.push(std::make_pair(seed.distance, seed.node));
+        }
+    }
+
+    double best = INF;
+    qint32 meeting = -1;
+    auto step = [&](MinQueue<double>& queue, std::vector<double>& distance, std::vector<qint32>& parent,
+                    const std::vector<double>& other, const std::vector<quint32>& offsets,
+                    const std::vector<qint32>& edges, bool upward) {
+        const std::pair<double, qint32> top = queue.top();
+        queue.pop();
+        const qint32 v = top.second;
+        if (top.first > distance[v]) {
+            return;
+        }
+        if (top.first + other[v] < best) {
+            best = top.first + other[v];
+            meeting = v;
+        }
+        for (quint32 k = offsets[v]; k < offsets[v + 1]; ++k) {
+            const Edge& edge = m_edges[edges[k]];
+            const qint32 next = upward ? edge.to : edge.from;
+            const double d = top.first + edge.weight;
+            if (d < distance[next]) {
+                if (std::isinf(distance[next]) && std::isinf(other[next])) {
+                    touched.push_back(next);
+                }
+                distance[next] = d;
+                parent[next] = edges[k];
+                queue.push(std::make_pair(d, next));
+            }
+        }
+    };
+    // Each direction stops once its closest unsettled node cannot improve the best meeting
+    while ((!forward.empty() && forward.top().first < best) || (!backward.empty() && backward.top().first < best)) {
+        const bool forwardTurn = !forward.empty() && forward.top().first < best &&
+                                 (backward.empty() || backward.top().first >= best || forward.top().first <= backward.top().first);
+        if (forwardTurn) {
+            step(forward, m_forwardDistance, m_forwardEdge, m_backwardDistance, m_upOffsets, m_upEdges, true);
+        } else {
+            step(backward, m_backwardDistance, m_backwardEdge, m_forwardDistance, m_downOffsets, m_downEdges, false);
+        }
+    }
+
+    if (nodes && meeting >= 0) {
+        // Edges in travel order: up from the start to the meeting node, then down to the end
+        std::vector<qint32> path;
+        qint32 v = meeting;
+        while (m_forwardEdge[v] >= 0) {
+            path.push_back(m_forwardEdge[v]);
+            v = m_edges[m_forwardEdge[v]].from;
+        }
+        std::reverse(path.begin(), path.end());
+        nodes->assign(1, v);
+        v = meeting;
+        while (m_backwardEdge[v] >= 0) {
+            path.push_back(m_backwardEdge[v]);
+            v = m_edges[m_backwardEdge[v]].to;
+        }
+        for (qint32 edge : path) {
+            unpack(edge, *nodes);
+        }
+    }
+
+    for (qint32 node : touched) {
+        m_forwardDistance[node] = INF;
+        m_backwardDistance[node] = INF;
+        m_forwardEdge[node] = -1;
+        m_backwardEdge[node] = -1;
+    }
+    return best;
+}
+
+void ContractionHierarchy::unpack(qint32 edge, std::vector<qint32>& nodes) const {
+    std::vector<qint32> stack{edge};
+    while (!stack.empty()) {
+        const Edge& top = m_edges[stack.back()];
+        stack.pop_back();
+        if (top.first < 0) {
+            nodes.push_back(top.to);
+        } else {
+            stack.push_back(top.second);
+            stack.push_back(top.first);
+        }
+    }
+}
+
+double ContractionHierarchy::distance(qint32 source, qint32 target) {
+    if (isEmpty()) {
+        return INF;
+    }
+    return query({Seed{source, 0.0}}, {Seed{target, 0.0}}, nullptr);
+}
+
+RouteLeg ContractionHierarchy::route(const RoadCandidate& from, const RoadCandidate& to) {
+    RouteLeg leg;
+    if (isEmpty() || from.segment < 0 || to.segment < 0) {
+        return leg;
+    }
+    const RoadSegment& start = m_graph->segment(from.segment);
+    const RoadSegment& end = m_graph->segment(to.segment);
+    const QGeoCoordinate startPosition = m_graph->unproject(from.x, from.y);
+    const QGeoCoordinate endPosition = m_graph->unproject(to.x, to.y);
+
+    // Further along the same segment, in an allowed direction
+    if (from.segment == to.segment &&
+        ((to.fraction >= from.fraction && start.forward) || (to.fraction <= from.fraction && start.backward))) {
+        leg.found = true;
+        leg.length = std::abs(to.fraction - from.fraction) * start.length;
+        leg.points = {startPosition, endPosition};
+        return leg;
+    }
+
+    // Leave the start segment by either allowed end, join the end segment likewise
+    std::vector<Seed> sources, targets;
+    if (start.forward) sources.push_back(Seed{start.to, (1.0 - from.fraction) * start.length});
+    if (start.backward) sources.push_back(Seed{start.from, from.fraction * start.length});
+    if (end.forward) targets.push_back(Seed{end.from, to.fraction * end.length});
+    if (end.backward) targets.push_back(Seed{end.to, (1.0 - to.fraction) * end.length});
+
+    std::vector<qint32> nodes;
+    leg.length = query(sources, targets, &nodes);
+    if (std::isinf(leg.length)) {
+        leg.length = 0.0;
+        return leg;
+    }
+    leg.found = true;
+    leg.points.push_back(startPosition);
+    for (qint32 node : nodes) {
+        leg.points.push_back(m_graph->nodeCoordinate(node));
+    }
+    leg.points.push_back(endPosition);
+    return leg;
+}
@@ -0,0 +1,95 @@
+#include "ElevationGain.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ElevationGainReport ElevationGainEstimator::estimate(const TrackColumns& columns,
+                                                     const std::vector<double>& demElevation) const {
+    ElevationGainReport report;
+    const size_t count = columns.size();
+    const bool hasDem = demElevation.size() == count;
+    if (!hasDem) {
+        report.dem = std::numeric_limits<double>::quiet_NaN();
+    }
+    if (count == 0) {
+        return report;
+    }
+
+    const double* elevation = columns.elevation.data();
+    const double* distance = columns.distance.data();
+    const double halfWindow = m_params.smoothingWindow / 2.0;
+
+    // Smoothing window [tail, head) around the current point
+    size_t tail = 0;
+    size_t head = 0;
+    double windowSum = 0.0;
+    double previousSmoothed = 0.0;
+    double turningPoint = elevation[0];
+
+    for (size_t i = 0; i < count; ++i) {
+        while (head < count && distance[head] <= distance[i] + halfWindow) {
+            windowSum += elevation[head++];
+        }
+        while (distance[tail] < distance[i] - halfWindow) {
+            windowSum -= elevation[tail++];
+        }
+        const double smoothed = windowSum / static_cast<double>(head - tail);
+
+        if (i > 0) {
+            const double step = elevation[i] - elevation[i - 1];
+            report.raw += std::max(step, 0.0);
+            report.threshold += (step > m_params.threshold) ? step : 0.0;
+            report.smoothed += std::max(smoothed - previousSmoothed, 0.0);
+            if (hasDem) {
+                // NaN anywhere in the DEM series propagates into the estimate
+                const double demStep = demElevation[i] - demElevation[i - 1];
+                report.dem += (demStep > m_params.threshold || std::isnan(demStep)) ? demStep : 0.0;
+            }
+        }
+
+        // Count a rise only once it clears the band above the last low; a drop
+        // through the band below the last high starts looking for the next rise
+        if (elevation[i] > turningPoint + m_params.hysteresisBand) {
+            report.hysteresis += elevation[i] - turningPoint;
+            turningPoint = elevation[i];
+        } else if (elevation[i] < turningPoint - m_params.hysteresisBand) {
+            turningPoint = elevation[i];
+        }
+        previousSmoothed = smoothed;
+    }
+    return report;
+}
+
+std::vector<double> ElevationGainEstimator::sampleDem(const std::vector<std::vector<float>>& grid,
+                                                      const QGeoCoordinate& topLeft, const QGeoCoordinate& bottomRight,
+                                                      const TrackColumns& columns) {
+    std::vector<double> result(columns.size(), std::numeric_limits<double>::quiet_NaN());
+    const size_t rows = grid.size();
+    const size_t cols = rows > 0 ? grid[0].size() : 0;
+    if (rows < 2 || cols < 2) {
+        return result;
+    }
+
+    const double south = bottomRight.latitude();
+    const double west = topLeft.longitude();
+    const double rowScale = (rows - 1) / (topLeft.latitude() - south);
+    const double colScale = (cols - 1) / (bottomRight.longitude() - west);
+
+    for (size_t i = 0; i < result.size(); ++i) {
+        const double y = (columns.latitude[i] - south) * rowScale;
+        const double x = (columns.longitude[i] - west) * colScale;
+        if (!(y >= 0.0 && y <= rows - 1 && x >= 0.0 && x <= cols - 1)) {
+            continue;
+        }
+
+        // Clamp the cell so points on the north or east edge use the last one
+        const size_t row = std::min(static_cast<size_t>(y), rows - 2);
+        const size_t col = std::min(static_cast<size_t>(x), cols - 2);
+        const double fy = y - row;
+        const double fx = x - col;
+        const double southEdge = grid[row][col] + (grid[row][col + 1] - grid[row][col]) * fx;
+        const double northEdge = grid[row + 1][col] + (grid[row + 1][col + 1] - grid[row + 1][col]) * fx;
+        result[i] = southEdge + (northEdge - southEdge) * fy;
+    }
+    return result;
+}
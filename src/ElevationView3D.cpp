@@ -45,6 +45,7 @@ ElevationView3D::ElevationView3D(QWidget* parent)
       m_routeRenderer(nullptr),
       m_flythroughController(nullptr),
       m_markerEntity(nullptr),
+      m_ghostEntity(nullptr),
       m_terrainEntity(nullptr),
       m_terrainService(new TerrainService(this)),
       m_elevationScale(1.0f),
@@ -149,12 +150,29 @@ void ElevationView3D::setupUi()
     m_markerEntity->addComponent(markerMaterial);
     m_markerEntity->addComponent(markerTransform);
     m_markerEntity->setEnabled(false); // Initially hidden
+    
+    // Ghost rider marker, shown only while a ghost is loaded
+    m_ghostEntity = new Qt3DCore::QEntity(m_rootEntity);
+    auto* ghostMesh = new Qt3DExtras::QSphereMesh();
+    ghostMesh->setRadius(2.0f);
+    auto* ghostMaterial = new Qt3DExtras::QPhongMaterial();
+    ghostMaterial->setDiffuse(QColor(QRgb(0x9C27B0)));
+    auto* ghostTransform = new Qt3DCore::QTransform();
+    m_ghostEntity->addComponent(ghostMesh);
+    m_ghostEntity->addComponent(ghostMaterial);
+    m_ghostEntity->addComponent(ghostTransform);
+    m_ghostEntity->setEnabled(false);
 }
 
 void ElevationView3D::setTrackData(const std::vector<TrackPoint>& points)
 {
-    logInfo("ElevationView3D", QString("Setting new track data with %1 points.").arg(points.size()));
-    m_trackPoints = points;
+    setTrackData(TrackView::fromPoints(points));
+}
+
+void ElevationView3D::setTrackData(const TrackView& track)
+{
+    logInfo("ElevationView3D", QString("Setting new track data with %1 points.").arg(track.size()));
+    m_track = track;
 
     // 1. Clean up old data
     delete m_flythroughController;
@@ -164,8 +182,9 @@ void ElevationView3D::setTrackData(const std::vector<TrackPoint>& points)
     delete m_routeData;
     m_routeData = nullptr;
     m_markerEntity->setEnabled(false);
+    m_ghostEntity->setEnabled(false);
 
-    if (m_trackPoints.size() < 2) {
+    if (m_track.size() < 2) {
         logWarning("ElevationView3D", "Not enough points to draw a route.");
         m_playPauseButton->setEnabled(false);
         m_stopButton->setEnabled(false);
@@ -174,7 +193,7 @@ void ElevationView3D::setTrackData(const std::vector<TrackPoint>& points)
     }
 
     // 2. Create data and renderer
-    m_routeData = new RouteData(m_trackPoints, m_elevationScale);
+    m_routeData = new RouteData(m_track.toPoints(), m_elevationScale);
     m_routeRenderer = new RouteRenderer(m_routeData, m_rootEntity);
 
     // 3. Create controller and connect UI
@@ -206,11 +225,13 @@ void ElevationView3D::setTrackData(const std::vector<TrackPoint>& points)
     updatePosition(0);
 
     // 4. Fetch terrain data
-    double minLat = m_trackPoints.front().coord.latitude();
-    double maxLat = m_trackPoints.front().coord.latitude();
-    double minLon = m_trackPoints.front().coord.longitude();
-    double maxLon = m_trackPoints.front().coord.longitude();
-    for (const auto& point : m_trackPoints) {
+    const QGeoCoordinate& start = m_track.sourcePoint(0).coord;
+    double minLat = start.latitude();
+    double maxLat = start.latitude();
+    double minLon = start.longitude();
+    double maxLon = start.longitude();
+    for (size_t i = 0; i < m_track.size(); ++i) {
+        const TrackPoint& point = m_track.sourcePoint(i);
         minLat = std::min(minLat, point.coord.latitude());
         maxLat = std::max(maxLat, point.coord.latitude());
         minLon = std::min(minLon, point.coord.longitude());
@@ -264,6 +285,21 @@ void ElevationView3D::updatePosition(size_t pointIndex)
     }
 }
 
+void ElevationView3D::updateGhostPosition(const QGeoCoordinate& coord, double elevation)
+{
+    if (!m_routeData || !m_ghostEntity) {
+        return;
+    }
+    
+    m_ghostEntity->setEnabled(coord.isValid());
+    if (!coord.isValid()) {
+        return;
+    }
+    if (auto* transform = m_ghostEntity->findChild<Qt3DCore::QTransform*>()) {
+        transform->setTranslation(m_routeData->positionOf(coord, elevation));
+    }
+}
+
 void ElevationView3D::onTerrainDataReady(const TerrainData& data)
 {
     logInfo("ElevationView3D", "Received terrain data. Generating mesh...");
@@ -276,6 +312,7 @@ void ElevationView3D::onTerrainDataReady(const TerrainData& data)
         logWarning("ElevationView3D", "Terrain data is empty, cannot generate mesh.");
         return;
     }
+    emit terrainLoaded(data);
 
     auto* geometry = new Qt3DRender::QGeometry(m_terrainEntity);
     QByteArray vertexBufferData;
@@ -292,8 +329,8 @@ void ElevationView3D::onTerrainDataReady(const TerrainData& data)
     indexBufferData.resize(numIndices * sizeof(unsigned int));
     unsigned int* indices = reinterpret_cast<unsigned int*>(indexBufferData.data());
 
-    const double originLon = m_trackPoints.front().coord.longitude();
-    const double originLat = m_trackPoints.front().coord.latitude();
+    const double originLon = m_track.sourcePoint(0).coord.longitude();
+    const double originLat = m_track.sourcePoint(0).coord.latitude();
 
     // Generate vertices
     for (int i = 0; i < gridHeight; ++i) {
@@ -382,8 +419,8 @@ void ElevationView3D::setElevationScale(float scale)
     m_elevationScale = scale;
 
     // Trigger a full rebuild of the scene with the new scale
-    if (!m_trackPoints.empty()) {
-        setTrackData(m_trackPoints);
+    if (!m_track.empty()) {
+        setTrackData(m_track);
     }
 }
 
@@ -0,0 +1,128 @@
+#include "GhostTrack.h"
+#include "TrackAligner.h"
+#include "logging.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Forward steps tried from the cursor before falling back to the per-second table
+    const size_t CURSOR_STEPS = 8;
+}
+
+GhostTrack::GhostTrack(const std::vector<TrackPoint>& ghost, const std::vector<TrackPoint>& reference) {
+    if (ghost.size() < 2 || reference.size() < 2 ||
+        !ghost.front().timestamp.isValid() || !reference.front().timestamp.isValid()) {
+        logWarning("GhostTrack", "A ghost needs two timed tracks");
+        return;
+    }
+
+    // Elapsed times, forced monotone so a clock hiccup cannot break the lookups
+    m_points = ghost;
+    m_elapsedMs.resize(ghost.size());
+    const QDateTime ghostStart = ghost.front().timestamp;
+    for (size_t i = 0; i < ghost.size(); ++i) {
+        const qint64 ms = ghost[i].timestamp.isValid() ? ghostStart.msecsTo(ghost[i].timestamp) : 0;
+        m_elapsedMs[i] = std::max(ms, i > 0 ? m_elapsedMs[i - 1] : qint64(0));
+    }
+    m_referenceElapsedMs.resize(reference.size());
+    const QDateTime referenceStart = reference.front().timestamp;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const qint64 ms = reference[i].timestamp.isValid() ? referenceStart.msecsTo(reference[i].timestamp) : 0;
+        m_referenceElapsedMs[i] = std::max(ms, i > 0 ? m_referenceElapsedMs[i - 1] : qint64(0));
+    }
+
+    const size_t seconds = static_cast<size_t>(m_elapsedMs.back() / 1000) + 1;
+    m_indexAtSecond.resize(seconds);
+    size_t index = 0;
+    for (size_t s = 0; s < seconds; ++s) {
+        while (index + 1 < m_elapsedMs.size() && m_elapsedMs[index + 1] <= static_cast<qint64>(s) * 1000) {
+            ++index;
+        }
+        m_indexAtSecond[s] = index;
+    }
+
+    // Same place on the road from the alignment: gap per reference point, reference distance per ghost point
+    TrackAlignment alignment = TrackAligner().align(reference, ghost);
+    m_timeGap.resize(reference.size());
+    for (const AlignedPoint& point : alignment.points) {
+        m_timeGap[point.index] = (m_referenceElapsedMs[point.index] - m_elapsedMs[point.otherIndex]) / 1000.0;
+    }
+    m_referenceDistance.assign(ghost.size(), 0.0);
+    for (const auto& step : alignment.path) {
+        m_referenceDistance[step.second] = reference[step.first].distance;
+    }
+
+    logInfo("GhostTrack", QString("Ghost of %1 points over %2 s").arg(ghost.size()).arg(duration(), 0, 'f', 0));
+}
+
+size_t GhostTrack::indexAtTime(double elapsed) {
+    if (isEmpty()) {
+        return 0;
+    }
+    const qint64 ms = static_cast<qint64>(std::floor(elapsed * 1000.0));
+    if (ms <= 0) {
+        m_cursor = 0;
+        return 0;
+    }
+
+    // Playback moves forward a little at a time: try the cursor first
+    if (m_elapsedMs[m_cursor] <= ms) {
+        for (size_t step = 0; step < CURSOR_STEPS; ++step) {
+            if (m_cursor + 1 >= m_elapsedMs.size() || m_elapsedMs[m_cursor + 1] > ms) {
+                return m_cursor;
+            }
+            ++m_cursor;
+        }
+    }
+
+    // Jumps (seeking, rewinding) start from the table entry of the whole second
+    const size_t second = std::min(static_cast<size_t>(ms / 1000), m_indexAtSecond.size() - 1);
+    m_cursor = m_indexAtSecond[second];
+    while (m_cursor + 1 < m_elapsedMs.size() && m_elapsedMs[m_cursor + 1] <= ms) {
+        ++m_cursor;
+    }
+    return m_cursor;
+}
+
+GhostPosition GhostTrack::positionAt(double elapsed) {
+    GhostPosition position;
+    if (isEmpty()) {
+        return position;
+    }
+
+    const size_t i = indexAtTime(elapsed);
+    position.valid = true;
+    position.index = i;
+    position.finished = elapsed * 1000.0 >= m_elapsedMs.back();
+    if (i + 1 >= m_points.size() || position.finished) {
+        position.coord = m_points.back().coord;
+        position.elevation = m_points.back().elevation;
+        position.distance = m_referenceDistance.back();
+        return position;
+    }
+
+    const TrackPoint& a = m_points[i];
+    const TrackPoint& b = m_points[i + 1];
+    const qint64 span = m_elapsedMs[i + 1] - m_elapsedMs[i];
+    const double t = span > 0 ? std::min(std::max((elapsed * 1000.0 - m_elapsedMs[i]) / span, 0.0), 1.0) : 0.0;
+    position.coord = QGeoCoordinate(a.coord.latitude() + (b.coord.latitude() - a.coord.latitude()) * t,
+                                    a.coord.longitude() + (b.coord.longitude() - a.coord.longitude()) * t);
+    position.elevation = a.elevation + (b.elevation - a.elevation) * t;
+    position.distance = m_referenceDistance[i] + (m_referenceDistance[i + 1] - m_referenceDistance[i]) * t;
+    return position;
+}
+
+double GhostTrack::referenceElapsed(size_t referenceIndex) const {
+    if (referenceIndex >= m_referenceElapsedMs.size()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_referenceElapsedMs[referenceIndex] / 1000.0;
+}
+
+double GhostTrack::timeGapAt(size_t referenceIndex) const {
+    if (referenceIndex >= m_timeGap.size()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_timeGap[referenceIndex];
+}
@@ -0,0 +1,379 @@
+#include "GpxIndex.h"
+#include "logging.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const quint32 INDEX_MAGIC = 0x47504958; // "GPIX"
+    const quint32 INDEX_VERSION = 1;
+
+    // Find the next occurrence of a tag (e.g. "<ele") in [p, end)
+    const char* findTag(const char* p, const char* end, const char* tag, size_t length)
+    {
+        while (p < end) {
+            p = static_cast<const char*>(std::memchr(p, '<', end - p));
+            if (!p || static_cast<size_t>(end - p) < length) {
+                return end;
+            }
+            if (std::memcmp(p, tag, length) == 0) {
+                return p;
+            }
+            ++p;
+        }
+        return end;
+    }
+
+    // Find the next "<trkpt" start tag, skipping "<trkpts..." style lookalikes
+    const char* findTrackPoint(const char* p, const char* end)
+    {
+        static const char TAG[] = "<trkpt";
+        const size_t length = sizeof(TAG) - 1;
+        while ((p = findTag(p, end, TAG, length)) < end) {
+            const char next = (p + length < end) ? p[length] : '\0';
+            if (next == ' ' || next == '\t' || next == '\r' || next == '\n' || next == '>' || next == '/') {
+                return p;
+            }
+            p += length;
+        }
+        return end;
+    }
+
+    // Read a numeric attribute value (lat="..." or lon='...') from a start tag
+    bool parseAttribute(const char* tagBegin, const char* tagEnd, const char* name, double& value)
+    {
+        const size_t nameLength = std::strlen(name);
+        for (const char* p = tagBegin + 1; p + nameLength + 2 < tagEnd; ++p) {
+            const char before = *(p - 1);
+            if (std::memcmp(p, name, nameLength) != 0 || !(before == ' ' || before == '\t' || before == '\r' || before == '\n')) {
+                continue;
+            }
+            const char* q = p + nameLength;
+            while (q < tagEnd && (*q == ' ' || *q == '=')) {
+                ++q;
+            }
+            if (q >= tagEnd || (*q != '"' && *q != '\'')) {
+                continue;
+            }
+            const char quote = *q++;
+            const char* valueEnd = static_cast<const char*>(std::memchr(q, quote, tagEnd - q));
+            if (!valueEnd) {
+                return false;
+            }
+            bool ok = false;
+            value = QByteArray::fromRawData(q, static_cast<int>(valueEnd - q)).toDouble(&ok);
+            return ok;
+        }
+        return false;
+    }
+
+    // Text content of the first <name>...</name> child in [begin, end)
+    QByteArray childText(const char* begin, const char* end, const char* openTag, size_t length)
+    {
+        const char* open = findTag(begin, end, openTag, length);
+        if (open >= end) {
+            return QByteArray();
+        }
+        const char* textBegin = static_cast<const char*>(std::memchr(open, '>', end - open));
+        if (!textBegin) {
+            return QByteArray();
+        }
+        ++textBegin;
+        const char* textEnd = static_cast<const char*>(std::memchr(textBegin, '<', end - textBegin));
+        if (!textEnd) {
+            return QByteArray();
+        }
+        return QByteArray(textBegin, static_cast<int>(textEnd - textBegin)).trimmed();
+    }
+
+    qint64 parseTimeMs(const QByteArray& text)
+    {
+        if (text.isEmpty()) {
+            return -1;
+        }
+        // Same formats as GPXParser
+        QString timeText = QString::fromLatin1(text);
+        QDateTime timestamp = QDateTime::fromString(timeText, Qt::ISODate);
+        if (!timestamp.isValid()) {
+            timestamp = QDateTime::fromString(timeText, "yyyy-MM-ddTHH:mm:ss");
+        }
+        return timestamp.isValid() ? timestamp.toMSecsSinceEpoch() : -1;
+    }
+}
+
+void GpxIndex::clear()
+{
+    m_sourceFile.clear();
+    m_sourceSize = 0;
+    m_sourceModified = 0;
+    m_pointCount = 0;
+    m_totalDistance = 0.0;
+    m_prefixLength = 0;
+    m_suffixOffset = 0;
+    m_entries.clear();
+}
+
+bool GpxIndex::build(const QString& filename, int stride)
+{
+    QElapsedTimer timer;
+    timer.start();
+    clear();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        logWarning("GpxIndex", QString("Cannot open %1").arg(filename));
+        return false;
+    }
+
+    const qint64 size = file.size();
+    QByteArray fallback;
+    const char* data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) {
+        // Mapping can fail on some file systems; read the whole file instead
+        fallback = file.readAll();
+        data = fallback.constData();
+    }
+    const char* const begin = data;
+    const char* const end = data + size;
+
+    m_sourceFile = filename;
+    m_sourceSize = size;
+    m_sourceModified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+    m_stride = std::max(1, stride);
+
+    QGeoCoordinate lastCoord;
+    const char* lastPointEnd = nullptr;
+    Entry lastEntry;
+
+    const char* p = findTrackPoint(begin, end);
+    while (p < end) {
+        const char* tagEnd = static_cast<const char*>(std::memchr(p, '>', end - p));
+        if (!tagEnd) {
+            break;
+        }
+
+        const bool selfClosing = *(tagEnd - 1) == '/';
+        const char* bodyEnd = selfClosing ? tagEnd : findTag(tagEnd, end, "</trkpt>", 8);
+        const char* pointEnd = selfClosing ? tagEnd + 1 : std::min(bodyEnd + 8, end);
+        const char* next = findTrackPoint(pointEnd, end);
+
+        double lat = 0.0, lon = 0.0;
+        if (!parseAttribute(p, tagEnd, "lat", lat) || !parseAttribute(p, tagEnd, "lon", lon)) {
+            // GPXParser drops points without valid coordinates as well
+            p = next;
+            continue;
+        }
+
+        QGeoCoordinate coord(lat, lon);
+        if (m_pointCount == 0) {
+            m_prefixLength = p - begin;
+        } else {
+            m_totalDistance += lastCoord.distanceTo(coord);
+        }
+        lastCoord = coord;
+
+        // Only indexed points (and the final one) need their children scanned
+        const bool indexed = (m_pointCount % m_stride) == 0;
+        if (indexed || next >= end) {
+            lastEntry.pointIndex = m_pointCount;
+            lastEntry.byteOffset = p - begin;
+            lastEntry.distance = m_totalDistance;
+            lastEntry.latitude = lat;
+            lastEntry.longitude = lon;
+            lastEntry.elevation = childText(tagEnd, bodyEnd, "<ele", 4).toDouble();
+            lastEntry.timeMs = parseTimeMs(childText(tagEnd, bodyEnd, "<time", 5));
+            if (indexed) {
+                m_entries.push_back(lastEntry);
+            }
+        }
+
+        lastPointEnd = pointEnd;
+        ++m_pointCount;
+        p = next;
+    }
+
+    if (m_pointCount == 0) {
+        logWarning("GpxIndex", QString("No track points found in %1").arg(filename));
+        clear();
+        return false;
+    }
+
+    // Always index the final point so windows and overviews reach the end of the track
+    if (m_entries.back().pointIndex != lastEntry.pointIndex) {
+        m_entries.push_back(lastEntry);
+    }
+    m_suffixOffset = lastPointEnd - begin;
+
+    logInfo("GpxIndex", QString("Indexed %1 points (%2 entries, %3 MB) in %4 ms")
+            .arg(m_pointCount).arg(m_entries.size())
+            .arg(size / (1024.0 * 1024.0), 0, 'f', 1).arg(timer.elapsed()));
+    return true;
+}
+
+QString GpxIndex::sidecarPath(const QString& filename)
+{
+    return filename + ".idx";
+}
+
+bool GpxIndex::save(const QString& path) const
+{
+    QSaveFile file(path.isEmpty() ? sidecarPath(m_sourceFile) : path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logWarning("GpxIndex", QString("Cannot write index %1").arg(file.fileName()));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << INDEX_MAGIC << INDEX_VERSION
+        << m_sourceSize << m_sourceModified << qint32(m_stride)
+        << m_pointCount << m_totalDistance << m_prefixLength << m_suffixOffset
+        << quint64(m_entries.size());
+    for (const auto& entry : m_entries) {
+        out << entry.pointIndex << entry.byteOffset << entry.distance << entry.timeMs
+            << entry.latitude << entry.longitude << entry.elevation;
+    }
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool GpxIndex::load(const QString& filename)
+{
+    clear();
+
+    QFile file(sidecarPath(filename));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    qint32 stride = 0;
+    quint64 entryCount = 0;
+    in >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        return false;
+    }
+    in >> m_sourceSize >> m_sourceModified >> stride
+       >> m_pointCount >> m_totalDistance >> m_prefixLength >> m_suffixOffset
+       >> entryCount;
+
+    // The sidecar is only valid for the exact file it was built from
+    QFileInfo info(filename);
+    if (in.status() != QDataStream::Ok || m_sourceSize != info.size() ||
+        m_sourceModified != info.lastModified().toMSecsSinceEpoch() ||
+        entryCount == 0 || entryCount > static_cast<quint64>(m_pointCount)) {
+        clear();
+        return false;
+    }
+
+    m_entries.resize(entryCount);
+    for (auto& entry : m_entries) {
+        in >> entry.pointIndex >> entry.byteOffset >> entry.distance >> entry.timeMs
+           >> entry.latitude >> entry.longitude >> entry.elevation;
+    }
+    if (in.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    m_sourceFile = filename;
+    m_stride = stride;
+    return true;
+}
+
+bool GpxIndex::loadOrBuild(const QString& filename, int stride)
+{
+    if (load(filename)) {
+        logInfo("GpxIndex", QString("Loaded index for %1 (%2 points)").arg(filename).arg(m_pointCount));
+        return true;
+    }
+    if (!build(filename, stride)) {
+        return false;
+    }
+    save();
+    return true;
+}
+
+GpxWindow GpxIndex::windowForEntries(size_t first, size_t last) const
+{
+    GpxWindow window;
+    if (m_entries.empty()) {
+        return window;
+    }
+
+    last = std::min(std::max(last, first + 1), m_entries.size() - 1);
+    first = std::min(first, last);
+
+    window.beginOffset = m_entries[first].byteOffset;
+    window.endOffset = (last == m_entries.size() - 1) ? m_suffixOffset : m_entries[last].byteOffset;
+    window.firstPointIndex = static_cast<size_t>(m_entries[first].pointIndex);
+    window.startDistance = m_entries[first].distance;
+    return window;
+}
+
+GpxWindow GpxIndex::windowForDistance(double startDistance, double endDistance) const
+{
+    if (m_entries.empty() || endDistance < startDistance) {
+        return GpxWindow();
+    }
+
+    // Last entry at or before the start, first entry at or after the end
+    auto startIt = std::upper_bound(m_entries.begin(), m_entries.end(), startDistance,
+                                    [](double value, const Entry& entry) { return value < entry.distance; });
+    auto endIt = std::lower_bound(m_entries.begin(), m_entries.end(), endDistance,
+                                  [](const Entry& entry, double value) { return entry.distance < value; });
+
+    size_t first = (startIt == m_entries.begin()) ? 0 : static_cast<size_t>(startIt - m_entries.begin()) - 1;
+    size_t last = (endIt == m_entries.end()) ? m_entries.size() - 1 : static_cast<size_t>(endIt - m_entries.begin());
+    return windowForEntries(first, last);
+}
+
+GpxWindow GpxIndex::windowForTime(const QDateTime& start, const QDateTime& end) const
+{
+    if (m_entries.empty() || !start.isValid() || !end.isValid() || end < start) {
+        return GpxWindow();
+    }
+
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 endMs = end.toMSecsSinceEpoch();
+
+    // Entries without a time are skipped; recorded times are assumed to be non-decreasing
+    size_t first = m_entries.size();
+    size_t last = m_entries.size();
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        const qint64 timeMs = m_entries[i].timeMs;
+        if (timeMs < 0) {
+            continue;
+        }
+        if (timeMs <= startMs || first == m_entries.size()) {
+            first = i;
+        }
+        if (timeMs >= endMs) {
+            last = i;
+            break;
+        }
+    }
+
+    if (first == m_entries.size()) {
+        return GpxWindow();
+    }
+    return windowForEntries(first, last == m_entries.size() ? m_entries.size() - 1 : last);
+}
+
+std::vector<TrackPoint> GpxIndex::overviewPoints() const
+{
+    std::vector<TrackPoint> points;
+    points.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        QDateTime time = entry.timeMs >= 0 ? QDateTime::fromMSecsSinceEpoch(entry.timeMs) : QDateTime();
+        points.emplace_back(QGeoCoordinate(entry.latitude, entry.longitude), entry.elevation, entry.distance, time);
+    }
+    return points;
+}
@@ -1,4 +1,5 @@
 #include "GpxParser.h"
+#include "GpxIndex.h"
 #include <QFile>
 #include <QXmlStreamReader>
 #include <QDebug>
@@ -32,6 +33,55 @@ bool GPXParser::parseData(const QString& data) {
     return parseXmlStream(xml);
 }
 
+bool GPXParser::parseWindow(const GpxIndex& index, const GpxWindow& window) {
+    if (!window.isValid() || index.isEmpty()) {
+        clear();
+        return false;
+    }
+    
+    QFile file(index.sourceFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Error: Cannot open file" << index.sourceFile();
+        clear();
+        return false;
+    }
+    
+    // Header up to the first point + the window + closing tags form a valid document
+    QByteArray data = file.read(index.prefixLength());
+    file.seek(window.beginOffset);
+    data += file.read(window.endOffset - window.beginOffset);
+    file.seek(index.suffixOffset());
+    data += file.readAll();
+    
+    QXmlStreamReader xml(data);
+    if (!parseXmlStream(xml)) {
+        return false;
+    }
+    
+    // Shift distances so they are cumulative from the start of the whole track
+    for (auto& point : *m_points) {
+        point.distance += window.startDistance;
+    }
+    m_firstPointIndex = window.firstPointIndex;
+    return true;
+}
+
+void GPXParser::setPoints(std::vector<TrackPoint> points) {
+    clear();
+    *m_points = std::move(points);
+    
+    for (const auto& point : *m_points) {
+        if (&point == &m_points->front()) {
+            m_minElevation = m_maxElevation = point.elevation;
+        } else {
+            m_minElevation = std::min(m_minElevation, point.elevation);
+            m_maxElevation = std::max(m_maxElevation, point.elevation);
+        }
+    }
+    
+    calculateGradients();
+}
+
 // Centralized parsing logic
 bool GPXParser::parseXmlStream(QXmlStreamReader& xml) {
     clear();
@@ -47,24 +97,24 @@ bool GPXParser::parseXmlStream(QXmlStreamReader& xml) {
             if (processTrackPoint(xml)) {
                 // Calculate cumulative distance
                 if (!firstPoint) {
-                    double segmentDistance = lastCoord.distanceTo(m_points.back().coord);
+                    double segmentDistance = lastCoord.distanceTo(m_points->back().coord);
                     totalDistance += segmentDistance;
-                    m_points.back().distance = totalDistance;
+                    m_points->back().distance = totalDistance;
                 } else {
-                    m_points.back().distance = 0.0;
+                    m_points->back().distance = 0.0;
                     firstPoint = false;
                 }
 
                 // Track min/max elevation
-                double elevation = m_points.back().elevation;
-                if (m_points.size() == 1) {
+                double elevation = m_points->back().elevation;
+                if (m_points->size() == 1) {
                     m_minElevation = m_maxElevation = elevation;
                 } else {
                     if (elevation < m_minElevation) m_minElevation = elevation;
                     if (elevation > m_maxElevation) m_maxElevation = elevation;
                 }
 
-                lastCoord = m_points.back().coord;
+                lastCoord = m_points->back().coord;
             }
         }
     }
@@ -76,21 +126,21 @@ bool GPXParser::parseXmlStream(QXmlStreamReader& xml) {
     }
 
     calculateGradients();
-    return !m_points.empty();
+    return !m_points->empty();
 }
 
 // New method to calculate gradients for all track points
 void GPXParser::calculateGradients() {
-    if (m_points.size() < 2) {
+    if (m_points->size() < 2) {
         return;
     }
     
     // First pass: calculate raw point-to-point gradients
-    std::vector<double> rawGradients(m_points.size(), 0.0);
+    std::vector<double> rawGradients(m_points->size(), 0.0);
     
-    for (size_t i = 1; i < m_points.size(); i++) {
-        double distDiff = m_points[i].distance - m_points[i-1].distance;
-        double elevDiff = m_points[i].elevation - m_points[i-1].elevation;
+    for (size_t i = 1; i < m_points->size(); i++) {
+        double distDiff = (*m_points)[i].distance - (*m_points)[i-1].distance;
+        double elevDiff = (*m_points)[i].elevation - (*m_points)[i-1].elevation;
         
         if (distDiff > DISTANCE_THRESHOLD) {
             double gradient = (elevDiff / distDiff) * 100.0;
@@ -104,9 +154,9 @@ void GPXParser::calculateGradients() {
     }
     
     // Second pass: apply weighted moving average for smoother gradients
-    std::vector<double> smoothGradients(m_points.size(), 0.0);
+    std::vector<double> smoothGradients(m_points->size(), 0.0);
     
-    for (size_t i = 0; i < m_points.size(); i++) {
+    for (size_t i = 0; i < m_points->size(); i++) {
         double weightedSum = 0.0;
         double weightSum = 0.0;
         int halfWindow = GRADIENT_WINDOW_SIZE / 2;
@@ -114,7 +164,7 @@ void GPXParser::calculateGradients() {
         // Apply Gaussian-like weighting to the window
         for (int j = -halfWindow; j <= halfWindow; j++) {
             int idx = static_cast<int>(i) + j;
-            if (idx >= 0 && idx < static_cast<int>(m_points.size())) {
+            if (idx >= 0 && idx < static_cast<int>(m_points->size())) {
                 // Use a triangular weight - closer points have more influence
                 double weight = halfWindow + 1 - std::abs(j);
                 weightedSum += rawGradients[idx] * weight;
@@ -129,23 +179,23 @@ void GPXParser::calculateGradients() {
     }
     
     // Third pass: segment-aware gradient smoothing to maintain consistency within segments
-    for (size_t i = 0; i < m_points.size(); i++) {
+    for (size_t i = 0; i < m_points->size(); i++) {
         // Store the smoothed gradient in the point data
-        m_points[i].gradient = smoothGradients[i];
+        (*m_points)[i].gradient = smoothGradients[i];
     }
 }
 
 double GPXParser::getCumulativeElevationGain(int upToIndex) const {
-    if (m_points.empty() || upToIndex < 0) {
+    if (m_points->empty() || upToIndex < 0) {
         return 0.0;
     }
     
-    int lastIndex = std::min(upToIndex, static_cast<int>(m_points.size()) - 1);
+    int lastIndex = std::min(upToIndex, static_cast<int>(m_points->size()) - 1);
     double elevationGain = 0.0;
     const double ELEVATION_THRESHOLD = 0.6; // Threshold of 0.6 meters to ignore small changes
     
     for (int i = 1; i <= lastIndex; ++i) {
-        double diff = m_points[i].elevation - m_points[i-1].elevation;
+        double diff = (*m_points)[i].elevation - (*m_points)[i-1].elevation;
         // Only count elevation gains greater than the threshold
         if (diff > ELEVATION_THRESHOLD) {
             elevationGain += diff;
@@ -157,15 +207,15 @@ double GPXParser::getCumulativeElevationGain(int upToIndex) const {
 }
 
 double GPXParser::getTotalDistance() const {
-    if (m_points.empty()) {
+    if (m_points->empty()) {
         return 0.0;
     }
     // Return in meters (don't convert to miles here - that's done in the UI layer)
-    return m_points.back().distance;
+    return m_points->back().distance;
 }
 
 double GPXParser::getTotalElevationGain() const {
-    return getCumulativeElevationGain(m_points.size() - 1);
+    return getCumulativeElevationGain(m_points->size() - 1);
 }
 
 double GPXParser::getMaxElevation() const {
@@ -177,18 +227,25 @@ double GPXParser::getMinElevation() const {
 }
 
 double GPXParser::getGradientAtPoint(int pointIndex) const {
-    if (pointIndex < 0 || pointIndex >= static_cast<int>(m_points.size())) {
+    if (pointIndex < 0 || pointIndex >= static_cast<int>(m_points->size())) {
         return 0.0;
     }
     
     // Return the pre-calculated gradient
-    return m_points[pointIndex].gradient;
+    return (*m_points)[pointIndex].gradient;
 }
 
 void GPXParser::clear() {
-    m_points.clear();
+    m_points = std::make_shared<std::vector<TrackPoint>>();
     m_minElevation = 0.0;
     m_maxElevation = 0.0;
+    m_firstPointIndex = 0;
+}
+
+double GPXParser::parseSensorValue(QXmlStreamReader& xml) {
+    bool ok = false;
+    double value = xml.readElementText().toDouble(&ok);
+    return ok ? value : std::numeric_limits<double>::quiet_NaN();
 }
 
 bool GPXParser::processTrackPoint(QXmlStreamReader& xml) {
@@ -214,7 +271,11 @@ bool GPXParser::processTrackPoint(QXmlStreamReader& xml) {
     // Find the elevation and timestamp
     double elevation = 0.0;
     QDateTime timestamp;
-    
+
+    // Sensor values from <extensions> (Garmin TrackPointExtension, plain <power>) are
+    // written straight into the point while walking its children
+    TrackPoint point(coord, elevation, 0.0, timestamp); // Distance will be calculated later
+
     // Process all elements within the trackpoint
     while (!(xml.isEndElement() && xml.name() == QLatin1String("trkpt"))) {
         xml.readNext();
@@ -235,13 +296,22 @@ bool GPXParser::processTrackPoint(QXmlStreamReader& xml) {
                     // Try alternate format without Z
                     timestamp = QDateTime::fromString(timeText, "yyyy-MM-ddTHH:mm:ss");
                 }
+            } else if (xml.name() == QLatin1String("hr")) {
+                point.heartRate = parseSensorValue(xml);
+            } else if (xml.name() == QLatin1String("cad")) {
+                point.cadence = parseSensorValue(xml);
+            } else if (xml.name() == QLatin1String("power")) {
+                point.power = parseSensorValue(xml);
+            } else if (xml.name() == QLatin1String("atemp")) {
+                point.temperature = parseSensorValue(xml);
             }
         }
     }
-    
-    // Create and add the track point
-    TrackPoint point(coord, elevation, 0.0, timestamp); // Distance will be calculated later
-    m_points.push_back(point);
+
+    // Add the track point
+    point.elevation = elevation;
+    point.timestamp = timestamp;
+    m_points->push_back(point);
     
     return true;
 }
@@ -1,4 +1,5 @@
 #include "LandingPage.h"
+#include "BatchAnalyzer.h"
 #include "build_info.h"
 #include <QApplication>
 #include <QScreen>
@@ -12,10 +13,13 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QDate>
+#include <QFileDialog>
+#include <QtConcurrent>
 
 LandingPage::LandingPage(QWidget *parent)
     : QWidget(parent),
-      m_currentTipIndex(0)
+      m_currentTipIndex(0),
+      m_similarityWatcher(new QFutureWatcher<std::vector<RouteMatch>>(this))
 {
     setupStyles();
     setupUI();
@@ -150,6 +154,39 @@ void LandingPage::setupUI() {
     m_samplesListWidget->setMinimumHeight(150);
     leftLayout->addWidget(m_samplesListWidget);
     
+    // Similar routes section: rides in the library that follow the same roads as a chosen track
+    QHBoxLayout* similarHeader = new QHBoxLayout();
+    QLabel* similarLabel = new QLabel("Similar Routes", this);
+    similarLabel->setObjectName("sectionLabel");
+    similarHeader->addWidget(similarLabel);
+    similarHeader->addStretch();
+    
+    QPushButton* libraryButton = new QPushButton("Library...", this);
+    libraryButton->setObjectName("linkButton");
+    libraryButton->setToolTip("Choose the folder of GPX files to search");
+    similarHeader->addWidget(libraryButton);
+    
+    m_findSimilarButton = new QPushButton("Find Rides Like...", this);
+    m_findSimilarButton->setObjectName("linkButton");
+    m_findSimilarButton->setToolTip("Pick a track and list library rides that overlap it");
+    similarHeader->addWidget(m_findSimilarButton);
+    leftLayout->addLayout(similarHeader);
+    
+    m_similarStatusLabel = new QLabel(this);
+    m_similarStatusLabel->setStyleSheet("color: #757575; font-size: 12px;");
+    m_similarStatusLabel->setWordWrap(true);
+    leftLayout->addWidget(m_similarStatusLabel);
+    
+    m_similarListWidget = new QListWidget(this);
+    m_similarListWidget->setMinimumHeight(120);
+    leftLayout->addWidget(m_similarListWidget);
+    
+    connect(libraryButton, &QPushButton::clicked, this, &LandingPage::handleChooseLibraryClicked);
+    connect(m_findSimilarButton, &QPushButton::clicked, this, &LandingPage::handleFindSimilarClicked);
+    connect(m_similarListWidget, &QListWidget::itemClicked, this, &LandingPage::handleSimilarRouteClicked);
+    connect(m_similarityWatcher, &QFutureWatcher<std::vector<RouteMatch>>::finished,
+            this, &LandingPage::handleSimilarityFinished);
+    
     // Tips section
     QWidget* tipContainer = new QWidget(this);
     QVBoxLayout* tipLayout = new QVBoxLayout(tipContainer);
@@ -484,3 +521,98 @@ void LandingPage::handleShow3DViewClicked() {
     // Emit a signal to show the 3D view
     emit show3DView();
 }
+
+QString LandingPage::libraryDirectory() const {
+    QSettings settings;
+    return settings.value("libraryDirectory").toString();
+}
+
+void LandingPage::handleChooseLibraryClicked() {
+    QString directory = QFileDialog::getExistingDirectory(this, "Choose GPX Library Folder", libraryDirectory());
+    if (directory.isEmpty()) {
+        return;
+    }
+    
+    QSettings settings;
+    settings.setValue("libraryDirectory", directory);
+    m_similarStatusLabel->setText(QString("Library: %1").arg(truncateFilePath(directory)));
+}
+
+void LandingPage::handleFindSimilarClicked() {
+    if (libraryDirectory().isEmpty()) {
+        handleChooseLibraryClicked();
+        if (libraryDirectory().isEmpty()) {
+            return;
+        }
+    }
+    
+    QString filePath = QFileDialog::getOpenFileName(this, "Find Rides Like", libraryDirectory(),
+                                                    "GPX Files (*.gpx);;All Files (*)");
+    if (!filePath.isEmpty()) {
+        findSimilarRoutes(filePath);
+    }
+}
+
+void LandingPage::findSimilarRoutes(const QString& filePath) {
+    if (m_similarityWatcher->isRunning()) {
+        return;
+    }
+    
+    m_similarQuery = filePath;
+    m_findSimilarButton->setEnabled(false);
+    m_similarListWidget->clear();
+    m_similarStatusLabel->setText(QString("Searching the library for rides like %1...").arg(QFileInfo(filePath).fileName()));
+    
+    // Refreshing the index only sketches files added or changed since the last search
+    const QString directory = libraryDirectory();
+    m_similarityWatcher->setFuture(QtConcurrent::run([filePath, directory]() {
+        RouteSimilarityIndex index;
+        const QString indexPath = RouteSimilarityIndex::defaultIndexPath();
+        index.load(indexPath);
+        if (index.update(BatchAnalyzer::collectFiles(QStringList() << directory)) > 0) {
+            index.save(indexPath);
+        }
+        
+        GPXParser parser;
+        if (!parser.parse(filePath)) {
+            return std::vector<RouteMatch>();
+        }
+        // One extra result, since the query itself is usually part of the library
+        return index.query(index.sketch(parser.getPoints()), 21);
+    }));
+}
+
+void LandingPage::handleSimilarityFinished() {
+    m_findSimilarButton->setEnabled(true);
+    std::vector<RouteMatch> matches = m_similarityWatcher->result();
+    
+    const QString queryPath = QFileInfo(m_similarQuery).absoluteFilePath();
+    for (const RouteMatch& match : matches) {
+        if (QFileInfo(match.file).absoluteFilePath() == queryPath) {
+            continue;
+        }
+        QListWidgetItem* item = new QListWidgetItem(QIcon(":/icons/map-marker.svg"),
+            QString("%1  (%2% shared, covers %3%)")
+                .arg(QFileInfo(match.file).fileName())
+                .arg(qRound(match.similarity * 100))
+                .arg(qRound(match.coverage * 100)));
+        item->setData(Qt::UserRole, match.file);
+        item->setToolTip(match.file);
+        m_similarListWidget->addItem(item);
+    }
+    
+    if (m_similarListWidget->count() == 0) {
+        m_similarStatusLabel->setText(QString("No rides like %1 in the library").arg(QFileInfo(m_similarQuery).fileName()));
+    } else {
+        m_similarStatusLabel->setText(QString("Rides like %1:").arg(QFileInfo(m_similarQuery).fileName()));
+    }
+}
+
+void LandingPage::handleSimilarRouteClicked(QListWidgetItem* item) {
+    if (!item) return;
+    
+    QString filePath = item->data(Qt::UserRole).toString();
+    if (!filePath.isEmpty()) {
+        emit openFile(filePath);
+    }
+}
@@ -1,10 +1,13 @@
 #include "MainWindow.h"
+#include "ArrowExporter.h"
+#include "BatchAnalyzer.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
 #include <QLabel>
+#include <QPushButton>
 #include <QIcon>
 #include <QMenuBar>
 #include <QMenu>
@@ -18,13 +21,36 @@
 #include <QSplitter>
 #include <QApplication>
 #include <QRandomGenerator>
+#include <QSpinBox>
+#include <QLineEdit>
+#include <QFormLayout>
+#include <QSettings>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QtConcurrent>
+#include <QCryptographicHash>
 #include <algorithm>
+#include <cmath>
+
+namespace {
+    // Files at least this large are indexed and loaded as an overview plus detail windows
+    const qint64 LAZY_LOAD_FILE_SIZE = 64LL * 1024 * 1024;
+    
+    // Farthest a clicked waypoint may be from a road (m)
+    const double WAYPOINT_SNAP_RADIUS = 200.0;
+}
 
 MainWindow::MainWindow(QWidget *parent) 
     : QMainWindow(parent),
       m_currentPointIndex(0),
+      m_selectionStart(0),
+      m_selectionEnd(0),
+      m_planning(false),
       m_updatingFromHover(false),
-      m_updatingFrom3D(false)
+      m_updatingFrom3D(false),
+      m_lazyLoaded(false),
+      m_detailStart(0.0),
+      m_detailEnd(0.0)
 {
     setupUi();
     
@@ -121,6 +147,65 @@ void MainWindow::setupUi() {
     QAction* openAction = toolBar->addAction(QIcon(":/icons/open-file.svg"), "Open File");
     connect(openAction, &QAction::triggered, this, QOverload<>::of(&MainWindow::openFile));
     
+    // Track edits produce views over the loaded points, so they are instant and never copy them
+    QToolButton* editButton = new QToolButton(toolBar);
+    editButton->setText("Edit Track");
+    editButton->setPopupMode(QToolButton::InstantPopup);
+    QMenu* editMenu = new QMenu(editButton);
+    connect(editMenu->addAction("Trim Start to Marker"), &QAction::triggered, this, &MainWindow::trimStartAtMarker);
+    connect(editMenu->addAction("Trim End to Marker"), &QAction::triggered, this, &MainWindow::trimEndAtMarker);
+    connect(editMenu->addAction("Reverse Direction"), &QAction::triggered, this, &MainWindow::reverseTrack);
+    connect(editMenu->addAction("Append GPX File..."), &QAction::triggered, this, &MainWindow::appendTrack);
+    connect(editMenu->addAction("Snap to Roads..."), &QAction::triggered, this, &MainWindow::snapToRoads);
+    editMenu->addSeparator();
+    connect(editMenu->addAction("Reset to Original"), &QAction::triggered, this, &MainWindow::resetTrack);
+    editButton->setMenu(editMenu);
+    toolBar->addWidget(editButton);
+    m_snapWatcher = new QFutureWatcher<MapMatchResult>(this);
+    connect(m_snapWatcher, &QFutureWatcher<MapMatchResult>::finished, this, &MainWindow::handleSnapFinished);
+    
+    // Shown while a new route is planned by clicking on the map
+    m_undoWaypointAction = toolBar->addAction("Undo Waypoint");
+    m_undoWaypointAction->setVisible(false);
+    connect(m_undoWaypointAction, &QAction::triggered, this, &MainWindow::undoRouteWaypoint);
+    m_finishRouteAction = toolBar->addAction("Finish Route");
+    m_finishRouteAction->setVisible(false);
+    connect(m_finishRouteAction, &QAction::triggered, this, &MainWindow::finishRoute);
+    m_routingWatcher = new QFutureWatcher<bool>(this);
+    connect(m_routingWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::handleRoutingReady);
+    
+    QAction* exportAction = toolBar->addAction("Export Data");
+    exportAction->setToolTip("Export track columns as an Arrow/Feather file");
+    connect(exportAction, &QAction::triggered, this, &MainWindow::exportTrackData);
+    
+    // Enabled while a stretch of the profile is selected
+    m_segmentEffortsAction = toolBar->addAction("Segment Efforts");
+    m_segmentEffortsAction->setToolTip("Find every ride in the library through the selected stretch, fastest first");
+    m_segmentEffortsAction->setEnabled(false);
+    connect(m_segmentEffortsAction, &QAction::triggered, this, &MainWindow::findSegmentEfforts);
+    m_segmentWatcher = new QFutureWatcher<SegmentSearch>(this);
+    connect(m_segmentWatcher, &QFutureWatcher<SegmentSearch>::finished,
+            this, &MainWindow::handleSegmentEffortsFound);
+    
+    QAction* compareAction = toolBar->addAction("Compare Ride...");
+    compareAction->setToolTip("Time gap and elevation difference to another ride of the same route");
+    connect(compareAction, &QAction::triggered, this, &MainWindow::compareWithRide);
+    m_comparisonWatcher = new QFutureWatcher<TrackAlignment>(this);
+    connect(m_comparisonWatcher, &QFutureWatcher<TrackAlignment>::finished,
+            this, &MainWindow::handleComparisonFinished);
+    
+    QToolButton* ghostButton = new QToolButton(toolBar);
+    ghostButton->setText("Ghost");
+    ghostButton->setToolTip("Replay another ride alongside this one");
+    ghostButton->setPopupMode(QToolButton::InstantPopup);
+    QMenu* ghostMenu = new QMenu(ghostButton);
+    connect(ghostMenu->addAction("Load Ghost Ride..."), &QAction::triggered, this, &MainWindow::loadGhost);
+    connect(ghostMenu->addAction("Remove Ghost"), &QAction::triggered, this, &MainWindow::removeGhost);
+    ghostButton->setMenu(ghostMenu);
+    toolBar->addWidget(ghostButton);
+    m_ghostWatcher = new QFutureWatcher<GhostTrack>(this);
+    connect(m_ghostWatcher, &QFutureWatcher<GhostTrack>::finished, this, &MainWindow::handleGhostLoaded);
+    
     toolBar->addSeparator();
     
     QAction* settingsAction = toolBar->addAction(QIcon(":/icons/settings.svg"), "Settings");
@@ -144,6 +229,7 @@ void MainWindow::setupUi() {
     
     // Create the stats widget
     m_statsWidget = new TrackStatsWidget();
+    applyZoneSettings();
     
     // Add widgets to splitter
     mapSplitter->addWidget(m_mapView);
@@ -161,6 +247,7 @@ void MainWindow::setupUi() {
     
     // Create the elevation plot
     m_elevationPlot = new QCustomPlot();
+    m_elevationPlot->setObjectName("elevationPlot");
     m_elevationPlot->setMinimumHeight(150);
     m_elevationPlot->addGraph(); // Elevation profile graph
     m_elevationPlot->addGraph(); // Position marker graph (will be a single point)
@@ -168,6 +255,17 @@ void MainWindow::setupUi() {
     m_elevationPlot->graph(0)->setBrush(QBrush(QColor(200, 230, 255, 100)));  // Light blue fill
     m_elevationPlot->graph(1)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QPen(Qt::black), QBrush(Qt::red), 10));  // Red position marker
     m_elevationPlot->graph(1)->setLineStyle(QCPGraph::lsNone);  // No line, only points
+    m_elevationPlot->addGraph(); // Full-resolution window of an indexed (lazily loaded) file
+    m_elevationPlot->graph(2)->setPen(QPen(QColor(25, 60, 160), 1.0));
+    m_elevationPlot->addGraph(m_elevationPlot->xAxis, m_elevationPlot->yAxis2); // Smoothed speed of timed tracks
+    m_elevationPlot->graph(3)->setPen(QPen(QColor(76, 175, 80, 200), 1.0));
+    m_elevationPlot->addGraph(); // Ghost rider marker
+    m_elevationPlot->graph(4)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QPen(Qt::white), QBrush(QColor(156, 39, 176)), 9));
+    m_elevationPlot->graph(4)->setLineStyle(QCPGraph::lsNone);
+    m_elevationPlot->yAxis2->setLabel("Speed (mph)");
+    m_elevationPlot->yAxis2->setTickLabelFont(QFont("Roboto", 8));
+    m_elevationPlot->xAxis2->setLabel("Projected time");
+    m_elevationPlot->xAxis2->setTickLabelFont(QFont("Roboto", 8));
     
     // Set axis labels
     m_elevationPlot->xAxis->setLabel("Distance (mi)");
@@ -182,9 +280,38 @@ void MainWindow::setupUi() {
     // Interactive features
     m_elevationPlot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
     
+    // Shaded interval of a brush selection, spanning the full plot height
+    m_rangeHighlight = new QCPItemRect(m_elevationPlot);
+    m_rangeHighlight->topLeft->setTypeX(QCPItemPosition::ptPlotCoords);
+    m_rangeHighlight->topLeft->setTypeY(QCPItemPosition::ptAxisRectRatio);
+    m_rangeHighlight->bottomRight->setTypeX(QCPItemPosition::ptPlotCoords);
+    m_rangeHighlight->bottomRight->setTypeY(QCPItemPosition::ptAxisRectRatio);
+    m_rangeHighlight->setPen(QPen(QColor(255, 152, 0, 160)));
+    m_rangeHighlight->setBrush(QBrush(QColor(255, 152, 0, 50)));
+    m_rangeHighlight->setVisible(false);
+    
     // Add elevation plot to layout
     elevationLayout->addWidget(m_elevationPlot);
     
+    // Brush selection: drag over the profile to get statistics for that stretch
+    QHBoxLayout* rangeLayout = new QHBoxLayout();
+    m_rangeSelectButton = new QPushButton("Select Range");
+    m_rangeSelectButton->setCheckable(true);
+    m_rangeSelectButton->setEnabled(false);
+    m_rangeSelectButton->setToolTip("Drag over the elevation profile to show statistics for that stretch");
+    m_rangeSelectButton->setObjectName("rangeSelectButton");
+    connect(m_rangeSelectButton, &QPushButton::toggled, this, &MainWindow::setRangeSelectionEnabled);
+    connect(m_elevationPlot->selectionRect(), &QCPSelectionRect::accepted, this, &MainWindow::handleRangeSelected);
+    m_rangeStatsLabel = new QLabel();
+    m_rangeStatsLabel->setObjectName("rangeStatsLabel");
+    m_rangeStatsLabel->setStyleSheet("color: #424242;");
+    rangeLayout->addWidget(m_rangeSelectButton);
+    rangeLayout->addWidget(m_rangeStatsLabel, 1);
+    m_ghostLabel = new QLabel();
+    m_ghostLabel->setStyleSheet("color: #7B1FA2; font-weight: bold;");
+    rangeLayout->addWidget(m_ghostLabel);
+    elevationLayout->addLayout(rangeLayout);
+    
     // Create position slider
     m_positionSlider = new QSlider(Qt::Horizontal);
     m_positionSlider->setRange(0, 1000);
@@ -219,6 +346,23 @@ void MainWindow::setupUi() {
     connect(m_positionSlider, &QSlider::valueChanged, this, &MainWindow::updatePosition);
     connect(m_mapView, &MapWidget::routeHovered, this, &MainWindow::handleRouteHover);
     connect(m_elevation3DView, &ElevationView3D::positionChanged, this, &MainWindow::handleFlythrough3DPositionChanged);
+    connect(m_elevation3DView, &ElevationView3D::terrainLoaded, m_statsWidget, &TrackStatsWidget::setTerrain);
+    
+    // Segment analysis runs in the background; color the route once it is done
+    connect(m_statsWidget, &TrackStatsWidget::analysisChanged, m_mapView, &MapWidget::setAnalysis);
+    connect(m_statsWidget, &TrackStatsWidget::metricsChanged, this, &MainWindow::handleMetricsChanged);
+    
+    // Zooming the profile or the map of an indexed file loads that window at full resolution
+    m_detailTimer = new QTimer(this);
+    m_detailTimer->setSingleShot(true);
+    m_detailTimer->setInterval(250);
+    connect(m_detailTimer, &QTimer::timeout, this, &MainWindow::loadDetailWindow);
+    m_detailWatcher = new QFutureWatcher<LazyLoad>(this);
+    connect(m_detailWatcher, &QFutureWatcher<LazyLoad>::finished, this, &MainWindow::handleLazyLoadFinished);
+    connect(m_elevationPlot->xAxis, QOverload<const QCPRange&>::of(&QCPAxis::rangeChanged),
+            this, &MainWindow::handleProfileRangeChanged);
+    connect(m_mapView, &MapWidget::viewportChanged, this, &MainWindow::handleMapViewportChanged);
+    connect(m_mapView, &MapWidget::mapClicked, this, &MainWindow::addRouteWaypoint);
     
     // Connect landing page signals
     connect(m_landingPage, &LandingPage::openFile, this, 
@@ -251,71 +395,27 @@ void MainWindow::openFile() {
 void MainWindow::openFile(const QString& filePath) {
     qDebug() << "MainWindow::openFile - Opening file:" << filePath;
     
+    if (QFileInfo(filePath).size() >= LAZY_LOAD_FILE_SIZE) {
+        openIndexedFile(filePath);
+        return;
+    }
+    m_lazyLoaded = false;
+    loadDetailWindow(); // Drops any detail window left over from an indexed file
+    
     if (m_gpxParser.parse(filePath)) {
-        const std::vector<TrackPoint>& points = m_gpxParser.getPoints();
-        
-        if (points.empty()) {
+        if (m_gpxParser.getPoints().empty()) {
             statusBar()->showMessage("No track points found in GPX file", 3000);
             return;
         }
         
-        qDebug() << "MainWindow::openFile - Successfully parsed" << points.size() << "points";
+        qDebug() << "MainWindow::openFile - Successfully parsed" << m_gpxParser.getPoints().size() << "points";
         
         // Show the main view
         showMainView();
         
-        // Create route on map
-        std::vector<QGeoCoordinate> coordinates;
-        coordinates.reserve(points.size());
-        
-        for (const auto& point : points) {
-            coordinates.push_back(point.coord);
-        }
-        
-        // First update stats widget to analyze segments
-        m_statsWidget->setTrackInfo(m_gpxParser);
-        
-        // Get segments from stats widget
-        const std::vector<TrackSegment>& segments = m_statsWidget->getSegments();
-        
-        // Provide track points to the map for hover information
-        m_mapView->setTrackPoints(points);
-        
-        // Use segmented route if available
-        if (!segments.empty()) {
-            qDebug() << "MainWindow::openFile - Setting route with" << segments.size() << "segments";
-            m_mapView->setRouteWithSegments(coordinates, segments, points);
-        } else {
-            qDebug() << "MainWindow::openFile - Setting route without segments";
-            m_mapView->setRoute(coordinates);
-        }
-        
-        // Plot elevation profile
-        qDebug() << "MainWindow::openFile - Plotting elevation profile";
-        plotElevationProfile();
-        
-        // Set up position slider
-        m_positionSlider->setRange(0, 1000);
-        m_positionSlider->setValue(0);
-        m_positionSlider->setEnabled(true);
-        
-        // Update display
-        m_currentPointIndex = 0;
-        updatePosition(0);
-        
-        // Update 3D view
-        try {
-            qDebug() << "MainWindow::openFile - Updating 3D view with" << points.size() << "points";
-            if (m_elevation3DView) {
-                m_elevation3DView->setTrackData(points);
-            } else {
-                qWarning() << "MainWindow::openFile - 3D view is null";
-            }
-        } catch (const std::exception& e) {
-            qCritical() << "MainWindow::openFile - Exception in 3D view update:" << e.what();
-        } catch (...) {
-            qCritical() << "MainWindow::openFile - Unknown exception in 3D view update";
-        }
+        // Display a view over the whole parsed track
+        m_track = TrackView(m_gpxParser.sharedPoints());
+        displayTrack();
         
         // Add to recent files
         addToRecentFiles(filePath);
@@ -323,12 +423,377 @@ void MainWindow::openFile(const QString& filePath) {
         // Show the main view
         showMainView();
         
-        statusBar()->showMessage(QString("Loaded %1 with %2 points").arg(QFileInfo(filePath).fileName()).arg(points.size()), 3000);
+        statusBar()->showMessage(QString("Loaded %1 with %2 points").arg(QFileInfo(filePath).fileName()).arg(m_track.size()), 3000);
     } else {
         statusBar()->showMessage("Failed to load GPX file", 3000);
     }
 }
 
+void MainWindow::openIndexedFile(const QString& filePath) {
+    // The previous track stays on screen until the index is ready
+    m_lazyLoaded = false;
+    loadDetailWindow();
+    
+    // Building the index scans the whole file, so it runs in the task that also parses detail
+    // windows; a window parse still going for the previous file is superseded
+    statusBar()->showMessage(QString("Indexing %1...").arg(QFileInfo(filePath).fileName()));
+    m_pendingIndexFile = filePath;
+    m_detailWatcher->setFuture(QtConcurrent::run([filePath]() {
+        LazyLoad load;
+        load.indexedFile = filePath;
+        load.indexed = load.index.loadOrBuild(filePath);
+        return load;
+    }));
+}
+
+void MainWindow::showIndexedFile(const QString& filePath, const GpxIndex& index) {
+    // Show one point per index entry; detail windows are parsed on demand
+    m_gpxIndex = index;
+    m_gpxParser.setPoints(m_gpxIndex.overviewPoints());
+    m_lazyLoaded = true;
+    m_detailWindow = GpxWindow();
+    m_pendingWindow = GpxWindow();
+    
+    showMainView();
+    m_track = TrackView(m_gpxParser.sharedPoints());
+    displayTrack();
+    addToRecentFiles(filePath);
+    
+    statusBar()->showMessage(QString("Loaded overview of %1 (%2 of %3 points), zoom in for full detail")
+                             .arg(QFileInfo(filePath).fileName()).arg(m_track.size()).arg(m_gpxIndex.pointCount()), 5000);
+}
+
+void MainWindow::handleProfileRangeChanged(const QCPRange& range) {
+    if (!m_lazyLoaded) {
+        return;
+    }
+    // Profile axis is in miles
+    m_detailStart = range.lower / 0.000621371;
+    m_detailEnd = range.upper / 0.000621371;
+    m_detailTimer->start();
+}
+
+void MainWindow::handleMapViewportChanged(const QGeoCoordinate& topLeft, const QGeoCoordinate& bottomRight) {
+    if (!m_lazyLoaded) {
+        return;
+    }
+    
+    // Distance range of the overview points inside the visible map area
+    double start = -1.0;
+    double end = -1.0;
+    for (const auto& point : m_gpxParser.getPoints()) {
+        double lat = point.coord.latitude();
+        double lon = point.coord.longitude();
+        if (lat <= topLeft.latitude() && lat >= bottomRight.latitude() &&
+            lon >= topLeft.longitude() && lon <= bottomRight.longitude()) {
+            if (start < 0.0) {
+                start = point.distance;
+            }
+            end = point.distance;
+        }
+    }
+    if (start < 0.0) {
+        return;
+    }
+    
+    m_detailStart = start;
+    m_detailEnd = end;
+    m_detailTimer->start();
+}
+
+void MainWindow::loadDetailWindow() {
+    // Windows use whole-track distances, so they only apply to the unedited overview
+    bool unedited = m_track == TrackView(m_gpxParser.sharedPoints());
+    bool zoomedIn = (m_detailEnd - m_detailStart) < m_gpxIndex.totalDistance() * 0.5;
+    
+    if (!m_lazyLoaded || !unedited || !zoomedIn) {
+        m_pendingIndexFile.clear();
+        m_pendingWindow = GpxWindow();
+        if (m_detailWindow.isValid()) {
+            m_detailWindow = GpxWindow();
+            m_elevationPlot->graph(2)->data()->clear();
+            m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+            m_mapView->setDetailRoute(std::vector<QGeoCoordinate>());
+        }
+        return;
+    }
+    
+    // One window is parsed at a time, never while indexing; try again once the task is done
+    if (m_detailWatcher->isRunning()) {
+        m_detailTimer->start();
+        return;
+    }
+    
+    GpxWindow window = m_gpxIndex.windowForDistance(m_detailStart, m_detailEnd);
+    if (!window.isValid() || (window.beginOffset == m_detailWindow.beginOffset &&
+                              window.endOffset == m_detailWindow.endOffset)) {
+        return;
+    }
+    
+    // Up to half of a large file, so it is parsed in the background
+    m_pendingWindow = window;
+    GpxIndex index = m_gpxIndex;
+    m_detailWatcher->setFuture(QtConcurrent::run([index, window]() {
+        LazyLoad load;
+        GPXParser detail;
+        if (detail.parseWindow(index, window)) {
+            load.points = detail.sharedPoints();
+        }
+        return load;
+    }));
+}
+
+void MainWindow::handleLazyLoadFinished() {
+    LazyLoad load = m_detailWatcher->result();
+    
+    if (!load.indexedFile.isEmpty()) {
+        // Dropped if another file was opened while indexing
+        if (load.indexedFile != m_pendingIndexFile) {
+            return;
+        }
+        m_pendingIndexFile.clear();
+        if (!load.indexed) {
+            statusBar()->showMessage("Failed to load GPX file", 3000);
+            return;
+        }
+        showIndexedFile(load.indexedFile, load.index);
+        return;
+    }
+    
+    GpxWindow window = m_pendingWindow;
+    m_pendingWindow = GpxWindow();
+    
+    // Another file was opened, the track was edited or the view zoomed out meanwhile
+    if (!window.isValid() || !m_lazyLoaded || m_track != TrackView(m_gpxParser.sharedPoints())) {
+        return;
+    }
+    if (!load.points) {
+        qWarning() << "MainWindow::handleLazyLoadFinished - Failed to parse detail window";
+        return;
+    }
+    m_detailWindow = window;
+    
+    const std::vector<TrackPoint>& points = *load.points;
+    QVector<double> distances, elevations;
+    std::vector<QGeoCoordinate> coordinates;
+    distances.reserve(points.size());
+    elevations.reserve(points.size());
+    coordinates.reserve(points.size());
+    for (const auto& point : points) {
+        distances.append(point.distance * 0.000621371); // meters to miles
+        elevations.append(point.elevation * 3.28084); // meters to feet
+        coordinates.push_back(point.coord);
+    }
+    
+    m_elevationPlot->graph(2)->setData(distances, elevations, true);
+    m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+    m_mapView->setDetailRoute(coordinates);
+    
+    statusBar()->showMessage(QString("Loaded %1 points from %2 to %3 mi at full resolution")
+                             .arg(points.size())
+                             .arg(m_detailStart * 0.000621371, 0, 'f', 1)
+                             .arg(m_detailEnd * 0.000621371, 0, 'f', 1), 3000);
+}
+
+void MainWindow::displayTrack() {
+    // Update stats widget; a changed track is analyzed in the background
+    m_statsWidget->setTrackInfo(m_track);
+    
+    // Segments of an unchanged track are available immediately, others arrive via analysisChanged
+    const TrackAnalysisResult& analysis = m_statsWidget->getAnalysis();
+    
+    // Route, segment colors and hover information all come from the view
+    qDebug() << "MainWindow::displayTrack - Setting route with" << analysis.segments().size() << "segments";
+    m_mapView->setRouteWithSegments(m_track, analysis);
+    
+    // Brush selections are answered from the stats widget's range tables, built once per track
+    m_rangeSelectButton->setEnabled(true);
+    clearRangeSelection();
+    
+    // A ghost is aligned to the track it was loaded for
+    removeGhost();
+    
+    // Plot elevation profile
+    qDebug() << "MainWindow::displayTrack - Plotting elevation profile";
+    plotElevationProfile();
+    
+    // Set up position slider
+    m_positionSlider->setRange(0, 1000);
+    m_positionSlider->setValue(0);
+    m_positionSlider->setEnabled(true);
+    
+    // Update display
+    m_currentPointIndex = 0;
+    updatePosition(0);
+    
+    // Update 3D view
+    try {
+        qDebug() << "MainWindow::displayTrack - Updating 3D view with" << m_track.size() << "points";
+        if (m_elevation3DView) {
+            m_elevation3DView->setTrackData(m_track);
+        } else {
+            qWarning() << "MainWindow::displayTrack - 3D view is null";
+        }
+    } catch (const std::exception& e) {
+        qCritical() << "MainWindow::displayTrack - Exception in 3D view update:" << e.what();
+    } catch (...) {
+        qCritical() << "MainWindow::displayTrack - Unknown exception in 3D view update";
+    }
+}
+
+void MainWindow::trimStartAtMarker() {
+    if (m_currentPointIndex == 0 || m_currentPointIndex + 1 >= m_track.size()) {
+        return;
+    }
+    m_track = m_track.splitAt(m_currentPointIndex).second;
+    displayTrack();
+    statusBar()->showMessage(QString("Trimmed start, %1 points remaining").arg(m_track.size()), 3000);
+}
+
+void MainWindow::trimEndAtMarker() {
+    if (m_currentPointIndex < 1 || m_currentPointIndex + 1 >= m_track.size()) {
+        return;
+    }
+    m_track = m_track.trimmed(0, m_currentPointIndex);
+    displayTrack();
+    statusBar()->showMessage(QString("Trimmed end, %1 points remaining").arg(m_track.size()), 3000);
+}
+
+void MainWindow::reverseTrack() {
+    if (m_track.empty()) {
+        return;
+    }
+    m_track = m_track.reversed();
+    displayTrack();
+    statusBar()->showMessage("Reversed track direction", 3000);
+}
+
+void MainWindow::appendTrack() {
+    if (m_track.empty()) {
+        return;
+    }
+    
+    QString filename = QFileDialog::getOpenFileName(this,
+                                                   "Append GPX File",
+                                                   QString(),
+                                                   "GPX Files (*.gpx);;All Files (*)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    // Parse into a separate parser; the view keeps its point store alive
+    GPXParser parser;
+    if (!parser.parse(filename) || parser.getPoints().empty()) {
+        statusBar()->showMessage("Failed to load GPX file", 3000);
+        return;
+    }
+    
+    m_track = m_track.concatenated(TrackView(parser.sharedPoints()));
+    displayTrack();
+    statusBar()->showMessage(QString("Appended %1, %2 points total").arg(QFileInfo(filename).fileName()).arg(m_track.size()), 3000);
+}
+
+void MainWindow::resetTrack() {
+    if (m_gpxParser.getPoints().empty()) {
+        return;
+    }
+    m_track = TrackView(m_gpxParser.sharedPoints());
+    displayTrack();
+}
+
+QString MainWindow::roadExtractFile() {
+    QSettings settings;
+    QString extract = settings.value("roadExtract").toString();
+    if (extract.isEmpty() || !QFileInfo::exists(extract)) {
+        extract = QFileDialog::getOpenFileName(this, "Choose OpenStreetMap Extract", QString(),
+                                               "OpenStreetMap Extracts (*.osm.pbf *.pbf);;All Files (*)");
+        if (!extract.isEmpty()) {
+            settings.setValue("roadExtract", extract);
+        }
+    }
+    return extract;
+}
+
+void MainWindow::useRoadExtract(const QString& extract) {
+    // The extract is read once; snapping and planning share the graph
+    if (!m_roadGraph || m_roadGraphFile != extract) {
+        m_roadGraph = std::make_shared<RoadGraph>();
+        m_roadGraphFile = extract;
+        m_routing.reset();
+    }
+}
+
+void MainWindow::snapToRoads() {
+    // Both tasks may load the shared graph, so they never run together
+    if (m_track.empty() || m_planning || m_snapWatcher->isRunning() || m_routingWatcher->isRunning()) {
+        return;
+    }
+    
+    const QString extract = roadExtractFile();
+    if (extract.isEmpty()) {
+        return;
+    }
+    useRoadExtract(extract);
+    if (m_roadGraph->isEmpty()) {
+        statusBar()->showMessage(QString("Loading roads from %1...").arg(QFileInfo(extract).fileName()));
+    } else {
+        statusBar()->showMessage("Snapping track to roads...");
+    }
+    
+    std::shared_ptr<RoadGraph> graph = m_roadGraph;
+    std::vector<TrackPoint> points = m_track.toPoints();
+    m_snapTrack = m_track;
+    m_snapWatcher->setFuture(QtConcurrent::run([graph, extract, points]() {
+        if (graph->isEmpty() && !graph->loadPbf(extract)) {
+            return MapMatchResult();
+        }
+        return MapMatcher(*graph).match(points);
+    }));
+}
+
+void MainWindow::handleSnapFinished() {
+    MapMatchResult result = m_snapWatcher->result();
+    if (m_roadGraph->isEmpty()) {
+        QMessageBox::warning(this, "Snap to Roads", QString("Could not read roads from %1:\n%2")
+                             .arg(m_roadGraphFile, m_roadGraph->errorString()));
+        m_roadGraph.reset();
+        m_routing.reset();
+        statusBar()->clearMessage();
+        return;
+    }
+    
+    // Reversed, trimmed or replaced while snapping: the positions belong to another track
+    TrackView snapped = m_snapTrack;
+    m_snapTrack = TrackView();
+    if (m_track != snapped) {
+        statusBar()->showMessage("Track changed while snapping, snap to roads again", 5000);
+        return;
+    }
+    
+    std::vector<TrackPoint> points = snapped.toPoints();
+    if (result.points.size() != points.size() || result.matchedCount() == 0) {
+        statusBar()->showMessage("No roads near this track in the extract", 5000);
+        return;
+    }
+    
+    // Snapped positions keep their elevation and time; distances follow the new positions
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (result.points[i].matched) {
+            points[i].coord = result.points[i].coord;
+        }
+        points[i].distance = i > 0 ? points[i - 1].distance + points[i - 1].coord.distanceTo(points[i].coord) : 0.0;
+    }
+    GPXParser parser;
+    parser.setPoints(std::move(points));
+    m_track = TrackView(parser.sharedPoints());
+    displayTrack();
+    
+    statusBar()->showMessage(QString("Snapped %1 of %2 points to roads%3")
+                             .arg(result.matchedCount()).arg(result.points.size())
+                             .arg(result.breaks > 0 ? QString(", %1 gaps without a road route").arg(result.breaks) : QString()),
+                             5000);
+}
+
 void MainWindow::addToRecentFiles(const QString& filePath) {
     QSettings settings;
     QStringList recentFiles = settings.value("recentFiles").toStringList();
@@ -361,32 +826,247 @@ void MainWindow::showMainView() {
 }
 
 void MainWindow::createNewRoute() {
-    QMessageBox::information(this, "Create New Route", 
-                           "This feature is coming soon! You'll be able to create new routes by placing points on the map.");
+    if (m_planning || m_snapWatcher->isRunning() || m_routingWatcher->isRunning()) {
+        return;
+    }
+    
+    const QString extract = roadExtractFile();
+    if (extract.isEmpty()) {
+        return;
+    }
+    useRoadExtract(extract);
+    if (!m_routing) {
+        m_routing = std::make_shared<ContractionHierarchy>();
+    }
+    if (m_roadGraph->isEmpty() || m_routing->isEmpty()) {
+        statusBar()->showMessage(QString("Preparing routing on %1...").arg(QFileInfo(extract).fileName()));
+    }
+    
+    // Contraction takes seconds for a city, so the hierarchy is kept on disk per extract
+    std::shared_ptr<RoadGraph> graph = m_roadGraph;
+    std::shared_ptr<ContractionHierarchy> routing = m_routing;
+    m_routingWatcher->setFuture(QtConcurrent::run([graph, routing, extract]() {
+        if (graph->isEmpty() && !graph->loadPbf(extract)) {
+            return false;
+        }
+        if (routing->isEmpty()) {
+            const QString cacheFile = ContractionHierarchy::cachePath(extract);
+            if (!routing->load(cacheFile, *graph)) {
+                *routing = ContractionHierarchy(*graph);
+                routing->save(cacheFile);
+            }
+        }
+        return true;
+    }));
+}
+
+void MainWindow::handleRoutingReady() {
+    if (!m_routingWatcher->result()) {
+        QMessageBox::warning(this, "Create New Route", QString("Could not read roads from %1:\n%2")
+                             .arg(m_roadGraphFile, m_roadGraph->errorString()));
+        m_roadGraph.reset();
+        m_routing.reset();
+        statusBar()->clearMessage();
+        return;
+    }
+    if (m_roadGraph->nodeCount() == 0 || m_routing->isEmpty()) {
+        QMessageBox::warning(this, "Create New Route", QString("No routing graph is available: %1 contains no roads")
+                             .arg(QFileInfo(m_roadGraphFile).fileName()));
+        statusBar()->clearMessage();
+        return;
+    }
+    
+    // The planned route replaces whatever was shown, like opening a file
+    m_lazyLoaded = false;
+    loadDetailWindow();
+    m_planning = true;
+    m_waypointRoads.clear();
+    m_waypoints.clear();
+    m_plannedPoints.clear();
+    m_waypointEnds.clear();
+    m_undoWaypointAction->setVisible(true);
+    m_finishRouteAction->setVisible(true);
+    m_mapView->setPlanningMode(true);
+    
+    // Stats, 3D view and slider still describe the previous track until the route is finished
+    m_positionSlider->setEnabled(false);
+    m_rangeSelectButton->setChecked(false);
+    m_rangeSelectButton->setEnabled(false);
+    clearRangeSelection();
+    updatePlannedRoute();
+    showMainView();
+    switchToTab(0);
+    
+    // Start over the middle of the extract unless the map already shows a track there
+    if (m_track.empty()) {
+        double latitude = 0.0, longitude = 0.0;
+        const size_t step = std::max<size_t>(1, m_roadGraph->nodeCount() / 1000);
+        size_t count = 0;
+        for (size_t node = 0; node < m_roadGraph->nodeCount(); node += step, ++count) {
+            latitude += m_roadGraph->nodeCoordinate(static_cast<qint32>(node)).latitude();
+            longitude += m_roadGraph->nodeCoordinate(static_cast<qint32>(node)).longitude();
+        }
+        m_mapView->centerOn(QGeoCoordinate(latitude / count, longitude / count), 13);
+    }
+    statusBar()->showMessage("Click on the map to add waypoints; each leg follows the roads");
+}
+
+void MainWindow::addRouteWaypoint(const QGeoCoordinate& coordinate) {
+    if (!m_planning) {
+        return;
+    }
+    
+    double x = 0.0, y = 0.0;
+    m_roadGraph->project(coordinate.latitude(), coordinate.longitude(), x, y);
+    const std::vector<RoadCandidate> roads = m_roadGraph->candidates(x, y, WAYPOINT_SNAP_RADIUS, 1);
+    if (roads.empty()) {
+        statusBar()->showMessage("No road near that point in the extract", 3000);
+        return;
+    }
+    const RoadCandidate& road = roads.front();
+    const QGeoCoordinate snapped = m_roadGraph->unproject(road.x, road.y);
+    
+    QString message;
+    if (m_waypointRoads.empty()) {
+        TrackPoint start;
+        start.coord = snapped;
+        m_plannedPoints.push_back(start);
+        message = "Start placed, click to add the next waypoint";
+    } else {
+        QElapsedTimer timer;
+        timer.start();
+        const RouteLeg leg = m_routing->route(m_waypointRoads.back(), road);
+        if (!leg.found) {
+            statusBar()->showMessage("No road route to that point", 3000);
+            return;
+        }
+        
+        // The leg starts where the route ends; no elevation is known offline
+        for (size_t i = 1; i < leg.points.size(); ++i) {
+            TrackPoint point;
+            point.coord = leg.points[i];
+            point.distance = m_plannedPoints.back().distance + m_plannedPoints.back().coord.distanceTo(point.coord);
+            m_plannedPoints.push_back(point);
+        }
+        message = QString("Leg of %1 mi routed in %2 ms, route %3 mi")
+                  .arg(leg.length * 0.000621371, 0, 'f', 2)
+                  .arg(timer.elapsed())
+                  .arg(m_plannedPoints.back().distance * 0.000621371, 0, 'f', 2);
+    }
+    m_waypointRoads.push_back(road);
+    m_waypoints.push_back(snapped);
+    m_waypointEnds.push_back(m_plannedPoints.size());
+    updatePlannedRoute();
+    statusBar()->showMessage(message, 5000);
+}
+
+void MainWindow::undoRouteWaypoint() {
+    if (!m_planning || m_waypoints.empty()) {
+        return;
+    }
+    m_waypointRoads.pop_back();
+    m_waypoints.pop_back();
+    m_waypointEnds.pop_back();
+    m_plannedPoints.resize(m_waypointEnds.empty() ? 0 : m_waypointEnds.back());
+    updatePlannedRoute();
+}
+
+void MainWindow::updatePlannedRoute() {
+    m_mapView->setWaypoints(m_waypoints);
+    if (m_plannedPoints.size() < 2) {
+        m_track = TrackView();
+        m_mapView->setRoute(std::vector<QGeoCoordinate>());
+        m_elevationPlot->graph(0)->data()->clear();
+        m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+        return;
+    }
+    
+    // Only the map and the profile follow each leg; the full analysis, the disk
+    // cache and the 3D terrain download run once, when the route is finished
+    m_track = TrackView::fromPoints(m_plannedPoints);
+    std::vector<QGeoCoordinate> coordinates;
+    coordinates.reserve(m_plannedPoints.size());
+    for (const TrackPoint& point : m_plannedPoints) {
+        coordinates.push_back(point.coord);
+    }
+    m_mapView->setRoute(coordinates);
+    m_mapView->setTrackView(m_track);
+    plotElevationProfile();
+}
+
+void MainWindow::finishRoute() {
+    if (!m_planning) {
+        return;
+    }
+    m_planning = false;
+    m_undoWaypointAction->setVisible(false);
+    m_finishRouteAction->setVisible(false);
+    m_mapView->setPlanningMode(false);
+    
+    if (m_plannedPoints.size() < 2) {
+        statusBar()->showMessage("Route planning cancelled", 3000);
+        return;
+    }
+    
+    // The finished route becomes the original that track edits reset to
+    m_gpxParser.setPoints(std::move(m_plannedPoints));
+    m_plannedPoints.clear();
+    m_track = TrackView(m_gpxParser.sharedPoints());
+    displayTrack();
+    statusBar()->showMessage(QString("Planned route of %1 mi through %2 waypoints")
+                             .arg(m_track.totalDistance() * 0.000621371, 0, 'f', 2)
+                             .arg(m_waypoints.size()), 5000);
+}
+
+void MainWindow::exportTrackData() {
+    if (m_track.empty()) {
+        statusBar()->showMessage("No track loaded to export", 3000);
+        return;
+    }
+    
+    QString filename = QFileDialog::getSaveFileName(this,
+                                                    "Export Track Data",
+                                                    QString(),
+                                                    "Arrow IPC / Feather Files (*.arrow *.feather);;All Files (*)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    // The stats widget keeps a column copy of the displayed track once its metrics are done;
+    // only an export right after a change (or of a route being planned) converts the points
+    std::shared_ptr<const TrackColumns> columns = m_statsWidget->getColumns();
+    if (!columns || m_planning || columns->size() != m_track.size()) {
+        columns = std::make_shared<TrackColumns>(TrackColumns::fromPoints(m_track.toPoints()));
+    }
+    ArrowExporter exporter;
+    if (exporter.exportColumns(*columns, filename)) {
+        statusBar()->showMessage(QString("Exported %1 points to %2").arg(columns->size()).arg(QFileInfo(filename).fileName()), 3000);
+    } else {
+        QMessageBox::warning(this, "Export Failed", exporter.errorString());
+    }
 }
 
 void MainWindow::plotElevationProfile() {
-    const std::vector<TrackPoint>& points = m_gpxParser.getPoints();
-    if (points.empty()) {
+    if (m_track.empty()) {
         return;
     }
     
     QVector<double> distances, elevations;
-    distances.reserve(points.size());
-    elevations.reserve(points.size());
+    distances.reserve(m_track.size());
+    elevations.reserve(m_track.size());
     
     // Convert to miles and feet for display
-    for (const auto& point : points) {
-        distances.append(point.distance * 0.000621371); // meters to miles
-        elevations.append(point.elevation * 3.28084); // meters to feet
+    for (size_t i = 0; i < m_track.size(); ++i) {
+        distances.append(m_track.distanceAt(i) * 0.000621371); // meters to miles
+        elevations.append(m_track.sourcePoint(i).elevation * 3.28084); // meters to feet
     }
     
     // Set data for the elevation profile
     m_elevationPlot->graph(0)->setData(distances, elevations);
     
     // Set nice-looking axis ranges
-    double minEle = m_gpxParser.getMinElevation() * 3.28084; // meters to feet
-    double maxEle = m_gpxParser.getMaxElevation() * 3.28084; // meters to feet
+    double minEle = m_track.minElevation() * 3.28084; // meters to feet
+    double maxEle = m_track.maxElevation() * 3.28084; // meters to feet
     double elevRange = maxEle - minEle;
     
     // Add 10% padding to elevation range
@@ -398,6 +1078,8 @@ void MainWindow::plotElevationProfile() {
     // X-axis range is from 0 to max distance
     m_elevationPlot->xAxis->setRange(0, distances.last());
     
+    plotMotionOverlays(distances);
+    
     // Make sure plot takes full width - update the margins
     m_elevationPlot->setViewport(QRect(0, 0, m_elevationPlot->width(), m_elevationPlot->height()));
     m_elevationPlot->axisRect()->setAutoMargins(QCP::msBottom|QCP::msTop);
@@ -433,16 +1115,67 @@ void MainWindow::plotElevationProfile() {
     // Set up the position marker point (second graph)
     // Initialize with the first point
     QVector<double> x, y;
-    if (!points.empty()) {
-        x.append(points.front().distance * 0.000621371); // meters to miles
-        y.append(points.front().elevation * 3.28084); // meters to feet
-        m_elevationPlot->graph(1)->setData(x, y);
-    }
+    x.append(0.0); // The view always starts at distance zero
+    y.append(m_track.sourcePoint(0).elevation * 3.28084); // meters to feet
+    m_elevationPlot->graph(1)->setData(x, y);
     
     // Force the plot to update
     m_elevationPlot->replot();
 }
 
+void MainWindow::plotMotionOverlays(const QVector<double>& distances) {
+    // Speed on the right axis for tracks with timestamps; NaN entries leave gaps
+    const MotionProfile& motion = m_statsWidget->getMotion();
+    bool showSpeed = motion.hasTime() && motion.smoothedSpeed.size() == m_track.size();
+    QVector<double> speeds;
+    if (showSpeed) {
+        speeds.reserve(m_track.size());
+        for (double speed : motion.smoothedSpeed) {
+            speeds.append(speed * 2.23694); // m/s to mph
+        }
+        m_elevationPlot->graph(3)->setData(distances, speeds, true);
+        m_elevationPlot->yAxis2->setRange(0, std::max(1.0, motion.maxSpeed * 2.23694 * 1.1));
+    } else {
+        m_elevationPlot->graph(3)->data()->clear();
+    }
+    m_elevationPlot->yAxis2->setVisible(showSpeed);
+    
+    // Untimed (planned) routes get the pacing model's projected time along the top axis
+    const PacingEstimate& pacing = m_statsWidget->getPacing();
+    bool showProjection = !motion.hasTime() && pacing.elapsed.size() == m_track.size();
+    if (showProjection) {
+        double total = pacing.totalTime();
+        double step = total > 4 * 3600.0 ? 3600.0 : (total > 3600.0 ? 1800.0 : 600.0);
+        QSharedPointer<QCPAxisTickerText> ticker(new QCPAxisTickerText);
+        size_t index = 0;
+        for (double time = step; time < total; time += step) {
+            while (index < pacing.elapsed.size() && pacing.elapsed[index] < time) {
+                ++index;
+            }
+            int minutes = qRound(time / 60.0);
+            ticker->addTick(distances[static_cast<int>(index)],
+                            QString("%1:%2").arg(minutes / 60).arg(minutes % 60, 2, 10, QChar('0')));
+        }
+        m_elevationPlot->xAxis2->setTicker(ticker);
+        m_elevationPlot->xAxis2->setRange(m_elevationPlot->xAxis->range());
+    }
+    m_elevationPlot->xAxis2->setVisible(showProjection);
+}
+
+void MainWindow::handleMetricsChanged() {
+    // Speed and projected time arrive after the profile was plotted; the sizes tell stale results apart
+    if (m_track.empty()) {
+        return;
+    }
+    QVector<double> distances;
+    distances.reserve(m_track.size());
+    for (size_t i = 0; i < m_track.size(); ++i) {
+        distances.append(m_track.distanceAt(i) * 0.000621371); // meters to miles
+    }
+    plotMotionOverlays(distances);
+    m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+}
+
 void MainWindow::updatePosition(int value) {
     // If this update is coming from a hover event, skip to avoid feedback
     if (m_updatingFromHover) {
@@ -453,13 +1186,12 @@ void MainWindow::updatePosition(int value) {
     double percentage = value / 1000.0;
     
     // Find nearest track point to this percentage of total distance
-    const std::vector<TrackPoint>& points = m_gpxParser.getPoints();
-    if (points.empty()) {
+    if (m_track.empty()) {
         return;
     }
     
     // Get total distance
-    double totalDistance = points.back().distance;
+    double totalDistance = m_track.totalDistance();
     
     // Calculate target distance
     double targetDistance = totalDistance * percentage;
@@ -471,18 +1203,20 @@ void MainWindow::updatePosition(int value) {
     if (m_currentPointIndex != nearestIndex) {
         m_currentPointIndex = nearestIndex;
         
-        const TrackPoint& point = points[m_currentPointIndex];
+        const TrackPoint point = m_track[m_currentPointIndex];
         m_mapView->updateMarker(point.coord);
         updatePlotPosition(point);
         
         // Update statistics display via the stats widget
-        m_statsWidget->updatePosition(point, m_currentPointIndex, m_gpxParser);
+        m_statsWidget->updatePosition(point, m_currentPointIndex, m_track);
     }
     
     // Update 3D view position if not coming from 3D view
     if (!m_updatingFrom3D) {
         m_elevation3DView->updatePosition(m_currentPointIndex);
     }
+    
+    updateGhost();
 }
 
 void MainWindow::updatePlotPosition(const TrackPoint& point) {
@@ -500,27 +1234,366 @@ void MainWindow::updatePlotPosition(const TrackPoint& point) {
     m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
 }
 
+void MainWindow::setRangeSelectionEnabled(bool enabled) {
+    // In custom mode dragging draws a selection rect instead of panning the plot
+    m_elevationPlot->setSelectionRectMode(enabled ? QCP::srmCustom : QCP::srmNone);
+    if (!enabled) {
+        clearRangeSelection();
+        m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
+
+void MainWindow::handleRangeSelected(const QRect& rect, QMouseEvent* event) {
+    Q_UNUSED(event);
+    const TrackRangeStats& rangeStats = m_statsWidget->getRangeStats();
+    if (rangeStats.empty()) {
+        return;
+    }
+    
+    // The profile is plotted in miles
+    double fromMiles = m_elevationPlot->xAxis->pixelToCoord(rect.left());
+    double toMiles = m_elevationPlot->xAxis->pixelToCoord(rect.right());
+    RangeStats stats = rangeStats.statsForDistance(fromMiles / 0.000621371, toMiles / 0.000621371);
+    if (stats.startIndex == stats.endIndex) {
+        clearRangeSelection();
+        m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+        return;
+    }
+    
+    double startMiles = m_track.distanceAt(stats.startIndex) * 0.000621371;
+    double endMiles = m_track.distanceAt(stats.endIndex) * 0.000621371;
+    m_rangeHighlight->topLeft->setCoords(startMiles, 0.0);
+    m_rangeHighlight->bottomRight->setCoords(endMiles, 1.0);
+    m_rangeHighlight->setVisible(true);
+    m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+    m_selectionStart = stats.startIndex;
+    m_selectionEnd = stats.endIndex;
+    m_segmentEffortsAction->setEnabled(!m_segmentWatcher->isRunning());
+    
+    QString text = QString("%1 - %2 mi: %3 mi, +%4 ft / -%5 ft, %6 - %7 ft, avg %8%, max %9%")
+        .arg(startMiles, 0, 'f', 2)
+        .arg(endMiles, 0, 'f', 2)
+        .arg(stats.distance * 0.000621371, 0, 'f', 2)
+        .arg(stats.elevationGain * 3.28084, 0, 'f', 0)
+        .arg(stats.elevationLoss * 3.28084, 0, 'f', 0)
+        .arg(stats.minElevation * 3.28084, 0, 'f', 0)
+        .arg(stats.maxElevation * 3.28084, 0, 'f', 0)
+        .arg(stats.avgGradient, 0, 'f', 1)
+        .arg(stats.maxGradient, 0, 'f', 1);
+    if (!std::isnan(stats.duration)) {
+        qint64 seconds = static_cast<qint64>(stats.duration);
+        text += QString(", %1:%2:%3").arg(seconds / 3600)
+            .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+            .arg(seconds % 60, 2, 10, QChar('0'));
+        if (!std::isnan(stats.avgSpeed)) {
+            text += QString(", %1 mph").arg(stats.avgSpeed * 2.23694, 0, 'f', 1);
+        }
+    }
+    m_rangeStatsLabel->setText(text);
+}
+
+void MainWindow::clearRangeSelection() {
+    m_rangeHighlight->setVisible(false);
+    m_rangeStatsLabel->clear();
+    m_selectionStart = 0;
+    m_selectionEnd = 0;
+    m_segmentEffortsAction->setEnabled(false);
+}
+
+void MainWindow::findSegmentEfforts() {
+    if (m_selectionEnd <= m_selectionStart || m_segmentWatcher->isRunning()) {
+        return;
+    }
+    
+    QSettings settings;
+    QString directory = settings.value("libraryDirectory").toString();
+    if (directory.isEmpty()) {
+        directory = QFileDialog::getExistingDirectory(this, "Choose GPX Library Folder");
+        if (directory.isEmpty()) {
+            return;
+        }
+        settings.setValue("libraryDirectory", directory);
+    }
+    
+    SegmentDefinition segment = SegmentDefinition::fromTrack(m_track.toPoints(), m_selectionStart, m_selectionEnd);
+    if (segment.isEmpty()) {
+        return;
+    }
+    
+    // The first search of a library parses every file; later ones only look up the index
+    std::shared_ptr<SegmentIndex> index;
+    QByteArray indexState;
+    if (m_segmentIndex && m_segmentIndexDirectory == directory) {
+        index = m_segmentIndex;
+        indexState = m_segmentIndexState;
+        statusBar()->showMessage("Searching segment efforts...");
+    } else {
+        statusBar()->showMessage(QString("Indexing %1 for segment efforts...").arg(directory));
+    }
+    m_segmentIndexDirectory = directory;
+    
+    m_segmentEffortsAction->setEnabled(false);
+    m_segmentWatcher->setFuture(QtConcurrent::run([index, indexState, directory, segment]() {
+        // Files added, removed or rewritten since the index was built invalidate it
+        const QStringList files = BatchAnalyzer::collectFiles(QStringList() << directory);
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        for (const QString& file : files) {
+            const QFileInfo info(file);
+            hash.addData(QString("%1|%2|%3\n").arg(file).arg(info.size())
+                         .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8());
+        }
+        
+        SegmentSearch search;
+        search.index = index;
+        search.libraryState = hash.result();
+        if (!search.index || search.libraryState != indexState) {
+            search.index = std::make_shared<SegmentIndex>();
+            search.index->addFiles(files);
+            search.index->build();
+        }
+        search.efforts = search.index->find(segment);
+        return search;
+    }));
+}
+
+void MainWindow::handleSegmentEffortsFound() {
+    SegmentSearch search = m_segmentWatcher->result();
+    m_segmentIndex = search.index;
+    m_segmentIndexState = search.libraryState;
+    const std::vector<SegmentEffort>& efforts = search.efforts;
+    m_segmentEffortsAction->setEnabled(m_selectionEnd > m_selectionStart);
+    statusBar()->showMessage(QString("%1 efforts in %2 rides").arg(efforts.size()).arg(m_segmentIndex->trackCount()), 5000);
+    
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("Segment Efforts - %1 mi")
+                          .arg((m_track.distanceAt(m_selectionEnd) - m_track.distanceAt(m_selectionStart)) * 0.000621371, 0, 'f', 2));
+    dialog.resize(640, 420);
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+    
+    QTableWidget* table = new QTableWidget(static_cast<int>(efforts.size()), 4, &dialog);
+    table->setHorizontalHeaderLabels(QStringList() << "Ride" << "Date" << "Time" << "Speed");
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table->verticalHeader()->setVisible(true);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    for (size_t row = 0; row < efforts.size(); ++row) {
+        const SegmentEffort& effort = efforts[row];
+        QTableWidgetItem* rideItem = new QTableWidgetItem(QFileInfo(effort.file).fileName());
+        rideItem->setData(Qt::UserRole, effort.file);
+        rideItem->setToolTip(effort.file);
+        table->setItem(static_cast<int>(row), 0, rideItem);
+        table->setItem(static_cast<int>(row), 1, new QTableWidgetItem(effort.startTime.isValid()
+            ? effort.startTime.toString("yyyy-MM-dd hh:mm") : QString("-")));
+        if (std::isnan(effort.elapsedTime) || effort.elapsedTime <= 0.0) {
+            table->setItem(static_cast<int>(row), 2, new QTableWidgetItem("-"));
+            table->setItem(static_cast<int>(row), 3, new QTableWidgetItem("-"));
+        } else {
+            qint64 seconds = static_cast<qint64>(effort.elapsedTime);
+            table->setItem(static_cast<int>(row), 2, new QTableWidgetItem(QString("%1:%2:%3").arg(seconds / 3600)
+                .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+                .arg(seconds % 60, 2, 10, QChar('0'))));
+            table->setItem(static_cast<int>(row), 3, new QTableWidgetItem(
+                QString("%1 mph").arg(effort.distance / effort.elapsedTime * 2.23694, 0, 'f', 1)));
+        }
+    }
+    layout->addWidget(table);
+    
+    QLabel* hint = new QLabel(efforts.empty() ? "No ride in the library passes this stretch."
+                                              : "Double-click a ride to open it.", &dialog);
+    layout->addWidget(hint);
+    
+    QString chosenFile;
+    connect(table, &QTableWidget::cellDoubleClicked, &dialog, [table, &dialog, &chosenFile](int row, int) {
+        chosenFile = table->item(row, 0)->data(Qt::UserRole).toString();
+        dialog.accept();
+    });
+    dialog.exec();
+    
+    if (!chosenFile.isEmpty()) {
+        openFile(chosenFile);
+    }
+}
+
+void MainWindow::compareWithRide() {
+    if (m_track.empty() || m_comparisonWatcher->isRunning()) {
+        statusBar()->showMessage("Load a track to compare against first", 3000);
+        return;
+    }
+    
+    QString filename = QFileDialog::getOpenFileName(this, "Compare With Ride", QString(),
+                                                    "GPX Files (*.gpx);;All Files (*)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    m_comparedFile = filename;
+    statusBar()->showMessage(QString("Aligning %1...").arg(QFileInfo(filename).fileName()));
+    std::vector<TrackPoint> reference = m_track.toPoints();
+    m_comparisonWatcher->setFuture(QtConcurrent::run([reference, filename]() {
+        GPXParser parser;
+        if (!parser.parse(filename)) {
+            return TrackAlignment();
+        }
+        return TrackAligner().align(reference, parser.getPoints());
+    }));
+}
+
+void MainWindow::handleComparisonFinished() {
+    TrackAlignment alignment = m_comparisonWatcher->result();
+    const QString name = QFileInfo(m_comparedFile).fileName();
+    if (alignment.isEmpty()) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "Compare Ride", QString("Could not read a track from %1").arg(name));
+        return;
+    }
+    statusBar()->showMessage(QString("Aligned %1, average offset %2 ft").arg(name)
+                             .arg(alignment.cost / alignment.path.size() * 3.28084, 0, 'f', 0), 5000);
+    
+    // Time gap and elevation difference of the other ride at each point of this one;
+    // NaN gaps (untimed rides) leave holes in the line
+    QVector<double> miles, gaps, elevations;
+    bool timed = false;
+    for (const AlignedPoint& point : alignment.points) {
+        miles.append(point.distance * 0.000621371);
+        gaps.append(point.timeGap);
+        elevations.append(point.elevationDelta * 3.28084);
+        timed = timed || !std::isnan(point.timeGap);
+    }
+    
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("Compared with %1").arg(name));
+    dialog.resize(800, 420);
+    QVBoxLayout* layout = new QVBoxLayout(&dialog);
+    
+    QCustomPlot* plot = new QCustomPlot(&dialog);
+    plot->addGraph();
+    plot->graph(0)->setPen(QPen(QColor(244, 67, 54), 1.5));
+    plot->graph(0)->setName("Time gap");
+    plot->graph(0)->setData(miles, gaps, true);
+    plot->addGraph(plot->xAxis, plot->yAxis2);
+    plot->graph(1)->setPen(QPen(QColor(64, 115, 244), 1.0));
+    plot->graph(1)->setName("Elevation difference");
+    plot->graph(1)->setData(miles, elevations, true);
+    plot->xAxis->setLabel("Distance (mi)");
+    plot->yAxis->setLabel("Time behind (s)");
+    plot->yAxis2->setLabel("Elevation difference (ft)");
+    plot->yAxis2->setVisible(true);
+    plot->xAxis->setTickLabelFont(QFont("Roboto", 8));
+    plot->yAxis->setTickLabelFont(QFont("Roboto", 8));
+    plot->yAxis2->setTickLabelFont(QFont("Roboto", 8));
+    plot->legend->setVisible(true);
+    plot->legend->setFont(QFont("Roboto", 8));
+    plot->setBackground(QBrush(QColor(255, 255, 255)));
+    plot->axisRect()->setBackground(QBrush(QColor(245, 245, 245)));
+    plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    plot->graph(0)->rescaleAxes();
+    plot->graph(1)->rescaleValueAxis();
+    layout->addWidget(plot);
+    
+    if (!timed) {
+        layout->addWidget(new QLabel("One of the rides has no timestamps, so only elevation is compared.", &dialog));
+    }
+    dialog.exec();
+}
+
+void MainWindow::loadGhost() {
+    if (m_track.empty() || m_ghostWatcher->isRunning()) {
+        statusBar()->showMessage("Load a track to race against first", 3000);
+        return;
+    }
+    
+    QString filename = QFileDialog::getOpenFileName(this, "Load Ghost Ride", QString(),
+                                                    "GPX Files (*.gpx);;All Files (*)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    
+    m_ghostFile = filename;
+    statusBar()->showMessage(QString("Preparing ghost %1...").arg(QFileInfo(filename).fileName()));
+    std::vector<TrackPoint> reference = m_track.toPoints();
+    m_ghostWatcher->setFuture(QtConcurrent::run([reference, filename]() {
+        GPXParser parser;
+        if (!parser.parse(filename)) {
+            return GhostTrack();
+        }
+        return GhostTrack(parser.getPoints(), reference);
+    }));
+}
+
+void MainWindow::handleGhostLoaded() {
+    m_ghost = m_ghostWatcher->result();
+    if (m_ghost.isEmpty()) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "Ghost Ride",
+                             QString("%1 cannot be replayed as a ghost. Both rides need timestamps.")
+                             .arg(QFileInfo(m_ghostFile).fileName()));
+        return;
+    }
+    statusBar()->showMessage(QString("Racing against %1").arg(QFileInfo(m_ghostFile).fileName()), 3000);
+    updateGhost();
+}
+
+void MainWindow::removeGhost() {
+    m_ghost = GhostTrack();
+    m_ghostLabel->clear();
+    m_mapView->updateGhostMarker(QGeoCoordinate());
+    m_elevation3DView->updateGhostPosition(QGeoCoordinate(), 0.0);
+    m_elevationPlot->graph(4)->data()->clear();
+    m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void MainWindow::updateGhost() {
+    if (m_ghost.isEmpty()) {
+        return;
+    }
+    
+    // The ghost is where it was after the same elapsed time; consecutive calls advance a cursor
+    GhostPosition ghost = m_ghost.positionAt(m_ghost.referenceElapsed(m_currentPointIndex));
+    m_mapView->updateGhostMarker(ghost.coord);
+    m_elevation3DView->updateGhostPosition(ghost.coord, ghost.elevation);
+    
+    QVector<double> x, y;
+    x.append(ghost.distance * 0.000621371); // meters to miles
+    y.append(ghost.elevation * 3.28084); // meters to feet
+    m_elevationPlot->graph(4)->setData(x, y);
+    m_elevationPlot->replot(QCustomPlot::rpQueuedReplot);
+    
+    const double gap = m_ghost.timeGapAt(m_currentPointIndex);
+    if (std::isnan(gap)) {
+        m_ghostLabel->clear();
+        return;
+    }
+    const qint64 seconds = static_cast<qint64>(std::round(std::abs(gap)));
+    m_ghostLabel->setText(QString("Ghost %1%2:%3%4")
+        .arg(gap > 0.0 ? "+" : (gap < 0.0 ? "-" : ""))
+        .arg(seconds / 60)
+        .arg(seconds % 60, 2, 10, QChar('0'))
+        .arg(ghost.finished ? " (finished)" : ""));
+    m_ghostLabel->setToolTip(gap > 0.0 ? "You are behind the ghost at this point of the road"
+                                       : "You are ahead of the ghost at this point of the road");
+}
+
 size_t MainWindow::findClosestPointByDistance(double targetDistance) {
-    const std::vector<TrackPoint>& points = m_gpxParser.getPoints();
-    if (points.empty()) {
+    if (m_track.empty()) {
         return 0;
     }
     
     // Binary search to quickly find closest point
     size_t low = 0;
-    size_t high = points.size() - 1;
+    size_t high = m_track.size() - 1;
     
     // Handle special cases for beginning and end of range
-    if (targetDistance <= points[low].distance) return low;
-    if (targetDistance >= points[high].distance) return high;
+    if (targetDistance <= m_track.distanceAt(low)) return low;
+    if (targetDistance >= m_track.distanceAt(high)) return high;
     
     // Binary search for finding closest point
     while (low <= high) {
         size_t mid = low + (high - low) / 2;
         
-        if (points[mid].distance < targetDistance) {
+        double midDistance = m_track.distanceAt(mid);
+        if (midDistance < targetDistance) {
             low = mid + 1;
-        } else if (points[mid].distance > targetDistance) {
+        } else if (midDistance > targetDistance) {
             // Make sure we don't underflow
             if (mid == 0) break;
             high = mid - 1;
@@ -531,18 +1604,18 @@ size_t MainWindow::findClosestPointByDistance(double targetDistance) {
     }
     
     // After binary search, either low or high is closest to target
-    if (low >= points.size()) low = points.size() - 1;
-    if (high >= points.size()) high = points.size() - 1;
+    if (low >= m_track.size()) low = m_track.size() - 1;
+    if (high >= m_track.size()) high = m_track.size() - 1;
     
-    double lowDiff = std::abs(points[low].distance - targetDistance);
-    double highDiff = std::abs(points[high].distance - targetDistance);
+    double lowDiff = std::abs(m_track.distanceAt(low) - targetDistance);
+    double highDiff = std::abs(m_track.distanceAt(high) - targetDistance);
     
     return (lowDiff < highDiff) ? low : high;
 }
 
 // New slot to handle hover events over the route on the map
 void MainWindow::handleRouteHover(int pointIndex) {
-    if (pointIndex < 0 || pointIndex >= static_cast<int>(m_gpxParser.getPoints().size())) {
+    if (m_planning || pointIndex < 0 || pointIndex >= static_cast<int>(m_track.size())) {
         return;
     }
     
@@ -555,7 +1628,7 @@ void MainWindow::handleRouteHover(int pointIndex) {
     
     // Calculate the slider position based on point index
     // Convert from point index (0 to N) to slider range (0 to 1000)
-    int totalPoints = m_gpxParser.getPoints().size();
+    int totalPoints = m_track.size();
     int sliderPos = pointIndex * 1000 / (totalPoints - 1);
     
     // Set the position slider without triggering its valueChanged signal
@@ -567,12 +1640,12 @@ void MainWindow::handleRouteHover(int pointIndex) {
     m_currentPointIndex = pointIndex;
     
     // Update the marker on the map and in the plot
-    const TrackPoint& point = m_gpxParser.getPoints()[pointIndex];
+    const TrackPoint point = m_track[pointIndex];
     m_mapView->updateMarker(point.coord);
     updatePlotPosition(point);
     
     // Update statistics display
-    m_statsWidget->updatePosition(point, pointIndex, m_gpxParser);
+    m_statsWidget->updatePosition(point, pointIndex, m_track);
     
     // Update 3D view position
     m_elevation3DView->updatePosition(pointIndex);
@@ -583,7 +1656,7 @@ void MainWindow::handleRouteHover(int pointIndex) {
 void MainWindow::handleFlythrough3DPositionChanged(int pointIndex) {
     qDebug() << "MainWindow::handleFlythrough3DPositionChanged - Position changed to" << pointIndex;
     
-    if (pointIndex < 0 || pointIndex >= static_cast<int>(m_gpxParser.getPoints().size())) {
+    if (m_planning || pointIndex < 0 || pointIndex >= static_cast<int>(m_track.size())) {
         qWarning() << "MainWindow::handleFlythrough3DPositionChanged - Invalid point index";
         return;
     }
@@ -592,7 +1665,7 @@ void MainWindow::handleFlythrough3DPositionChanged(int pointIndex) {
     m_updatingFrom3D = true;
     
     // Calculate the slider position based on point index
-    int totalPoints = m_gpxParser.getPoints().size();
+    int totalPoints = m_track.size();
     int sliderPos = pointIndex * 1000 / (totalPoints - 1);
     
     // Set the position slider
@@ -604,12 +1677,13 @@ void MainWindow::handleFlythrough3DPositionChanged(int pointIndex) {
     m_currentPointIndex = pointIndex;
     
     // Update the marker on the map and in the plot
-    const TrackPoint& point = m_gpxParser.getPoints()[pointIndex];
+    const TrackPoint point = m_track[pointIndex];
     m_mapView->updateMarker(point.coord);
     updatePlotPosition(point);
     
     // Update statistics display
-    m_statsWidget->updatePosition(point, pointIndex, m_gpxParser);
+    m_statsWidget->updatePosition(point, pointIndex, m_track);
+    updateGhost();
     
     m_updatingFrom3D = false;
 }
@@ -718,9 +1792,42 @@ void MainWindow::showSettings() {
     view3DLayout->addWidget(cameraGroup);
     view3DLayout->addStretch(1);
     
+    // Training zones tab
+    QWidget* zonesTab = new QWidget();
+    QVBoxLayout* zonesLayout = new QVBoxLayout(zonesTab);
+    
+    QGroupBox* thresholdsGroup = new QGroupBox("Thresholds");
+    QFormLayout* thresholdsLayout = new QFormLayout(thresholdsGroup);
+    
+    QSpinBox* maxHeartRateSpin = new QSpinBox();
+    maxHeartRateSpin->setRange(100, 240);
+    maxHeartRateSpin->setSuffix(" bpm");
+    maxHeartRateSpin->setValue(settings.value("maxHeartRate", 190).toInt());
+    thresholdsLayout->addRow("Max heart rate:", maxHeartRateSpin);
+    
+    QSpinBox* ftpSpin = new QSpinBox();
+    ftpSpin->setRange(50, 600);
+    ftpSpin->setSuffix(" W");
+    ftpSpin->setValue(settings.value("functionalThresholdPower", 250).toInt());
+    thresholdsLayout->addRow("Functional threshold power:", ftpSpin);
+    
+    zonesLayout->addWidget(thresholdsGroup);
+    
+    QGroupBox* gradientGroup = new QGroupBox("Gradient Zones");
+    QFormLayout* gradientLayout = new QFormLayout(gradientGroup);
+    
+    QLineEdit* gradientBoundsEdit = new QLineEdit();
+    gradientBoundsEdit->setPlaceholderText("-8, -4, -1, 1, 4, 8");
+    gradientBoundsEdit->setText(settings.value("gradientZoneBounds").toString());
+    gradientLayout->addRow("Bounds (%):", gradientBoundsEdit);
+    
+    zonesLayout->addWidget(gradientGroup);
+    zonesLayout->addStretch(1);
+    
     // Add tabs to the tab widget
     tabWidget->addTab(generalTab, "General");
     tabWidget->addTab(view3DTab, "3D View");
+    tabWidget->addTab(zonesTab, "Training Zones");
     
     layout->addWidget(tabWidget);
     
@@ -737,11 +1844,15 @@ void MainWindow::showSettings() {
         settings.setValue("elevationScale", elevScaleSlider->value());
         settings.setValue("flyoverModeDefault", flyoverModeCheck->isChecked());
         settings.setValue("flythroughSpeed", flySpeedSlider->value());
+        settings.setValue("maxHeartRate", maxHeartRateSpin->value());
+        settings.setValue("functionalThresholdPower", ftpSpin->value());
+        settings.setValue("gradientZoneBounds", gradientBoundsEdit->text().trimmed());
         
         // Apply settings to current view
         if (m_elevation3DView) {
             m_elevation3DView->setElevationScale(elevScaleSlider->value() / 10.0f);
         }
+        applyZoneSettings();
         
         settingsDialog.accept();
     });
@@ -757,11 +1868,15 @@ void MainWindow::showSettings() {
         settings.setValue("elevationScale", elevScaleSlider->value());
         settings.setValue("flyoverModeDefault", flyoverModeCheck->isChecked());
         settings.setValue("flythroughSpeed", flySpeedSlider->value());
+        settings.setValue("maxHeartRate", maxHeartRateSpin->value());
+        settings.setValue("functionalThresholdPower", ftpSpin->value());
+        settings.setValue("gradientZoneBounds", gradientBoundsEdit->text().trimmed());
         
         // Apply settings to current view
         if (m_elevation3DView) {
             m_elevation3DView->setElevationScale(elevScaleSlider->value() / 10.0f);
         }
+        applyZoneSettings();
     });
     
     layout->addWidget(buttonBox);
@@ -769,12 +1884,25 @@ void MainWindow::showSettings() {
     settingsDialog.exec();
 }
 
+void MainWindow::applyZoneSettings() {
+    QSettings settings;
+    ZoneSettings zones(settings.value("maxHeartRate", 190).toDouble(),
+                       settings.value("functionalThresholdPower", 250).toDouble());
+    
+    // An empty or unparsable gradient list keeps the default gradient zones
+    std::vector<double> gradientBounds = ZoneSettings::parseBounds(settings.value("gradientZoneBounds").toString());
+    if (!gradientBounds.empty()) {
+        zones.gradientBounds = gradientBounds;
+    }
+    m_statsWidget->setZoneSettings(zones);
+}
+
 void MainWindow::show3DView() {
     // First show the main view
     showMainView();
     
     // If there's no data loaded, show a message and return to landing page
-    if (m_gpxParser.getPoints().empty()) {
+    if (m_track.empty()) {
         QMessageBox::information(this, "No Route Loaded", "No route is currently loaded. Please open a GPX file to view in 3D.");
         showLandingPage();
         return;
@@ -0,0 +1,366 @@
+#include "MapMatcher.h"
+#include "logging.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+    const double INF = std::numeric_limits<double>::infinity();
+    // Cached search trees before the cache is dropped (bounds memory on long tracks)
+    const size_t MAX_CACHED_TREES = 4096;
+    // Trees are searched a little past the requested bound so nearby queries can reuse them
+    const double TREE_BOUND_MARGIN = 1.5;
+}
+
+size_t MapMatchResult::matchedCount() const {
+    return static_cast<size_t>(std::count_if(points.begin(), points.end(),
+                                             [](const MatchedPoint& point) { return point.matched; }));
+}
+
+MapMatcher::MapMatcher(const RoadGraph& graph, const MapMatchParams& params)
+    : m_graph(graph)
+    , m_params(params)
+{
+}
+
+const MapMatcher::Tree& MapMatcher::treeFrom(qint32 node, double bound) {
+    auto found = m_trees.find(node);
+    if (found != m_trees.end() && found->second.bound >= bound) {
+        return found->second;
+    }
+    if (m_trees.size() >= MAX_CACHED_TREES) {
+        m_trees.clear();
+    }
+    if (m_distance.size() != m_graph.nodeCount()) {
+        m_distance.assign(m_graph.nodeCount(), std::numeric_limits<float>::infinity());
+        m_previous.assign(m_graph.nodeCount(), -1);
+    }
+
+    Tree& tree = m_trees[node];
+    tree.bound = bound * TREE_BOUND_MARGIN;
+    tree.settled.clear();
+
+    using QueueEntry = std::pair<float, qint32>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    std::vector<qint32> touched{node};
+    m_distance[node] = 0.0f;
+    queue.push(QueueEntry(0.0f, node));
+    while (!queue.empty()) {
+        const QueueEntry top = queue.top();
+        queue.pop();
+        if (top.first > m_distance[top.second]) {
+            continue;
+        }
+        tree.settled.push_back(Settled{top.second, top.first, m_previous[top.second]});
+        for (const RoadGraph::Arc* arc = m_graph.arcsBegin(top.second); arc != m_graph.arcsEnd(top.second); ++arc) {
+            const float distance = top.first + arc->length;
+            if (distance <= tree.bound && distance < m_distance[arc->target]) {
+                if (std::isinf(m_distance[arc->target])) {
+                    touched.push_back(arc->target);
+                }
+                m_distance[arc->target] = distance;
+                m_previous[arc->target] = top.second;
+                queue.push(QueueEntry(distance, arc->target));
+            }
+        }
+    }
+    for (qint32 visited : touched) {
+        m_distance[visited] = std::numeric_limits<float>::infinity();
+        m_previous[visited] = -1;
+    }
+
+    std::sort(tree.settled.begin(), tree.settled.end(), [](const Settled& a, const Settled& b) {
+        return a.node < b.node;
+    });
+    return tree;
+}
+
+const MapMatcher::Settled* MapMatcher::find(const Tree& tree, qint32 node) const {
+    auto it = std::lower_bound(tree.settled.begin(), tree.settled.end(), node,
+                               [](const Settled& settled, qint32 value) { return settled.node < value; });
+    return it != tree.settled.end() && it->node == node ? &*it : nullptr;
+}
+
+double MapMatcher::routeDistance(const RoadCandidate& a, const RoadCandidate& b, double bound,
+                                 std::vector<qint32>* nodes) {
+    if (nodes) {
+        nodes->clear();
+    }
+    const RoadSegment& from = m_graph.segment(a.segment);
+    const RoadSegment& to = m_graph.segment(b.segment);
+
+    // Further along the same segment, in an allowed direction
+    if (a.segment == b.segment) {
+        if (b.fraction >= a.fraction && from.forward) {
+            return (b.fraction - a.fraction) * from.length;
+        }
+        if (b.fraction <= a.fraction && from.backward) {
+            return (a.fraction - b.fraction) * from.length;
+        }
+    }
+
+    struct End {
+        qint32 node;
+        double cost;
+    };
+    std::vector<End> exits, entries;
+    if (from.forward) exits.push_back(End{from.to, (1.0 - a.fraction) * from.length});
+    if (from.backward) exits.push_back(End{from.from, a.fraction * from.length});
+    if (to.forward) entries.push_back(End{to.from, b.fraction * to.length});
+    if (to.backward) entries.push_back(End{to.to, (1.0 - b.fraction) * to.length});
+
+    double best = INF;
+    qint32 bestExit = -1, bestEntry = -1;
+    for (const End& exit : exits) {
+        if (exit.cost > bound) {
+            continue;
+        }
+        const Tree& tree = treeFrom(exit.node, bound);
+        for (const End& entry : entries) {
+            const Settled* settled = find(tree, entry.node);
+            if (settled && exit.cost + settled->distance + entry.cost < best) {
+                best = exit.cost + settled->distance + entry.cost;
+                bestExit = exit.node;
+                bestEntry = entry.node;
+            }
+        }
+    }
+
+    if (nodes && bestExit >= 0) {
+        const Tree& tree = treeFrom(bestExit, bound);
+        for (const Settled* settled = find(tree, bestEntry); settled;
+             settled = settled->previous >= 0 ? find(tree, settled->previous) : nullptr) {
+            nodes->push_back(settled->node);
+        }
+        std::reverse(nodes->begin(), nodes->end());
+    }
+    return best;
+}
+
+qint32 MapMatcher::segmentBetween(qint32 from, qint32 to) const {
+    qint32 best = -1;
+    float length = std::numeric_limits<float>::infinity();
+    for (const RoadGraph::Arc* arc = m_graph.arcsBegin(from); arc != m_graph.arcsEnd(from); ++arc) {
+        if (arc->target == to && arc->length < length) {
+            best = arc->segment;
+            length = arc->length;
+        }
+    }
+    return best;
+}
+
+RoadCandidate MapMatcher::projectOnto(qint32 segment, double x, double y) const {
+    const RoadSegment& road = m_graph.segment(segment);
+    const double ax = m_graph.nodeX(road.from), ay = m_graph.nodeY(road.from);
+    const double dx = m_graph.nodeX(road.to) - ax, dy = m_graph.nodeY(road.to) - ay;
+    const double lengthSquared = dx * dx + dy * dy;
+    RoadCandidate candidate;
+    candidate.segment = segment;
+    candidate.fraction = lengthSquared > 0.0 ? std::min(std::max(((x - ax) * dx + (y - ay) * dy) / lengthSquared, 0.0), 1.0) : 0.0;
+    candidate.x = ax + dx * candidate.fraction;
+    candidate.y = ay + dy * candidate.fraction;
+    candidate.distance = std::hypot(x - candidate.x, y - candidate.y);
+    return candidate;
+}
+
+MapMatchResult MapMatcher::match(const std::vector<TrackPoint>& points) {
+    QElapsedTimer timer;
+    timer.start();
+    MapMatchResult result;
+    result.points.resize(points.size());
+    if (m_graph.isEmpty() || points.empty()) {
+        return result;
+    }
+
+    const size_t n = points.size();
+    std::vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_graph.project(points[i].coord.latitude(), points[i].coord.longitude(), xs[i], ys[i]);
+    }
+    auto boundBetween = [&](size_t i, size_t j, double& straight) {
+        straight = std::hypot(xs[j] - xs[i], ys[j] - ys[i]);
+        return straight * m_params.routeFactor + m_params.routeSlack;
+    };
+
+    struct Step {
+        size_t index;
+        std::vector<RoadCandidate> candidates;
+        std::vector<double> score;      // Log probability of the best path ending in each candidate
+        std::vector<int> back;          // Candidate of the previous step on that path, -1 at a chain start
+    };
+    std::vector<Step> chain;
+    std::vector<RoadCandidate> chosen(n);
+
+    // Backtrack the best path of a chain and append its road geometry
+    auto finishChain = [&]() {
+        if (chain.empty()) {
+            return;
+        }
+        const std::vector<double>& last = chain.back().score;
+        int state = static_cast<int>(std::max_element(last.begin(), last.end()) - last.begin());
+        for (size_t k = chain.size(); k-- > 0;) {
+            chosen[chain[k].index] = chain[k].candidates[state];
+            state = chain[k].back[state];
+        }
+        std::vector<qint32> nodes, pieceSegment;
+        std::vector<double> pieceX, pieceY;
+        for (size_t k = 0; k < chain.size(); ++k) {
+            const size_t index = chain[k].index;
+            if (k > 0) {
+                const size_t previous = chain[k - 1].index;
+                double straight = 0.0;
+                routeDistance(chosen[previous], chosen[index], boundBetween(previous, index, straight), &nodes);
+                // Ridden pieces between the two positions, each with the segment it lies on
+                pieceX.assign(1, chosen[previous].x);
+                pieceY.assign(1, chosen[previous].y);
+                pieceSegment.assign(1, chosen[previous].segment);
+                for (size_t j = 0; j < nodes.size(); ++j) {
+                    result.path.push_back(m_graph.nodeCoordinate(nodes[j]));
+                    pieceX.push_back(m_graph.nodeX(nodes[j]));
+                    pieceY.push_back(m_graph.nodeY(nodes[j]));
+                    pieceSegment.push_back(j + 1 < nodes.size() ? segmentBetween(nodes[j], nodes[j + 1]) : chosen[index].segment);
+                }
+                pieceX.push_back(chosen[index].x);
+                pieceY.push_back(chosen[index].y);
+
+                // Points skipped in between go onto the route actually taken, not merely the nearest road
+                for (size_t i = previous + 1; i < index; ++i) {
+                    for (size_t j = 0; j + 1 < pieceX.size(); ++j) {
+                        const double dx = pieceX[j + 1] - pieceX[j], dy = pieceY[j + 1] - pieceY[j];
+                        const double lengthSquared = dx * dx + dy * dy;
+                        const double t = lengthSquared > 0.0 ? std::min(std::max(((xs[i] - pieceX[j]) * dx + (ys[i] - pieceY[j]) * dy) / lengthSquared, 0.0), 1.0) : 0.0;
+                        const double x = pieceX[j] + dx * t, y = pieceY[j] + dy * t;
+                        const double distance = std::hypot(xs[i] - x, ys[i] - y);
+                        if (pieceSegment[j] >= 0 && distance <= m_params.searchRadius &&
+                            (chosen[i].segment < 0 || distance < chosen[i].distance)) {
+                            chosen[i] = projectOnto(pieceSegment[j], x, y);
+                            chosen[i].distance = distance;
+                        }
+                    }
+                }
+            }
+            result.path.push_back(m_graph.unproject(chosen[index].x, chosen[index].y));
+        }
+        chain.clear();
+    };
+
+    const double emissionScale = -0.5 / (m_params.sigma * m_params.sigma);
+    bool haveLast = false;
+    double lastX = 0.0, lastY = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!points[i].coord.isValid()) {
+            continue;
+        }
+        if (haveLast && i + 1 < n && std::hypot(xs[i] - lastX, ys[i] - lastY) < m_params.minSpacing) {
+            continue;
+        }
+        Step step;
+        step.index = i;
+        step.candidates = m_graph.candidates(xs[i], ys[i], m_params.searchRadius, m_params.maxCandidates);
+        if (step.candidates.empty()) {
+            continue;
+        }
+        ++result.usedPoints;
+        const size_t count = step.candidates.size();
+        step.score.assign(count, -INF);
+        step.back.assign(count, -1);
+
+        bool connected = false;
+        if (!chain.empty()) {
+            const Step& previous = chain.back();
+            double straight = 0.0;
+            const double bound = boundBetween(previous.index, i, straight);
+            for (size_t j = 0; j < count; ++j) {
+                double best = -INF;
+                for (size_t k = 0; k < previous.candidates.size(); ++k) {
+                    if (std::isinf(previous.score[k])) {
+                        continue;
+                    }
+                    const double route = routeDistance(previous.candidates[k], step.candidates[j], bound);
+                    if (std::isinf(route)) {
+                        continue;
+                    }
+                    const double score = previous.score[k] - std::abs(route - straight) / m_params.beta;
+                    if (score > best) {
+                        best = score;
+                        step.back[j] = static_cast<int>(k);
+                    }
+                }
+                if (!std::isinf(best)) {
+                    const double distance = step.candidates[j].distance;
+                    step.score[j] = best + emissionScale * distance * distance;
+                    connected = true;
+                }
+            }
+        }
+        if (!connected) {
+            if (!chain.empty()) {
+                finishChain();
+                ++result.breaks;
+            }
+            for (size_t j = 0; j < count; ++j) {
+                const double distance = step.candidates[j].distance;
+                step.score[j] = emissionScale * distance * distance;
+                step.back[j] = -1;
+            }
+        }
+
+        // Keep the scores near zero over long tracks
+        const double top = *std::max_element(step.score.begin(), step.score.end());
+        for (double& score : step.score) {
+            score -= top;
+        }
+        chain.push_back(std::move(step));
+        haveLast = true;
+        lastX = xs[i];
+        lastY = ys[i];
+    }
+    finishChain();
+
+    // Points before or after a chain go onto the nearer of the roads chosen around them
+    std::vector<qint32> before(n, -1), after(n, -1);
+    qint32 current = -1;
+    for (size_t i = 0; i < n; ++i) {
+        current = chosen[i].segment >= 0 ? chosen[i].segment : current;
+        before[i] = current;
+    }
+    current = -1;
+    for (size_t i = n; i-- > 0;) {
+        current = chosen[i].segment >= 0 ? chosen[i].segment : current;
+        after[i] = current;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (chosen[i].segment >= 0 || !points[i].coord.isValid()) {
+            continue;
+        }
+        RoadCandidate best;
+        best.distance = INF;
+        for (qint32 segment : {before[i], after[i]}) {
+            if (segment >= 0) {
+                RoadCandidate candidate = projectOnto(segment, xs[i], ys[i]);
+                if (candidate.distance < best.distance) {
+                    best = candidate;
+                }
+            }
+        }
+        if (best.distance <= m_params.searchRadius) {
+            chosen[i] = best;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (chosen[i].segment >= 0) {
+            MatchedPoint& point = result.points[i];
+            point.matched = true;
+            point.coord = m_graph.unproject(chosen[i].x, chosen[i].y);
+            point.segment = chosen[i].segment;
+            point.offset = chosen[i].distance;
+        }
+    }
+
+    logInfo("MapMatcher", QString("Matched %1 of %2 points (%3 scored, %4 breaks) in %5 ms")
+            .arg(result.matchedCount()).arg(n).arg(result.usedPoints).arg(result.breaks).arg(timer.elapsed()));
+    return result;
+}
@@ -10,6 +10,12 @@
 
 // Constants for tile handling
 const int TILE_SIZE = 256;
+
+// Shortest segment worth coloring separately, in screen pixels
+const double MIN_SEGMENT_PIXELS = 40.0;
+
+// A press and release closer than this is a click rather than a pan, in pixels
+const int CLICK_TOLERANCE = 4;
 const QString TILE_SERVER = "https://a.tile.openstreetmap.org/%1/%2/%3.png";
 
 MapWidget::MapWidget(QWidget* parent) : QWidget(parent),
@@ -17,7 +23,9 @@ MapWidget::MapWidget(QWidget* parent) : QWidget(parent),
     mCenterCoordinate(39.8283, -98.5795), // Initialize to center on continental US
     mIsPanning(false),
     mLastMousePos(0, 0),
+    mPlanningMode(false),
     mHasSegments(false),
+    mSegmentLevel(-1),
     mNetworkManager(new QNetworkAccessManager(this)),
     mTileCache(200) // Cache up to 200 tiles
 {
@@ -39,12 +47,26 @@ MapWidget::~MapWidget()
 void MapWidget::setRoute(const std::vector<QGeoCoordinate>& coordinates) {
     // Clear any previous route
     mRouteCoordinates.clear();
-    if (coordinates.empty()) return;
+    mDetailCoordinates.clear();
+    mRouteSegments.clear();
+    mHasSegments = false;
+    mAnalysis = TrackAnalysisResult();
+    mSegmentLevel = -1;
+    if (coordinates.empty()) {
+        update();
+        return;
+    }
     
     for (const auto& coord : coordinates) {
         mRouteCoordinates.append(coord);
     }
     
+    // While planning, the route grows under the user's clicks: keep the view
+    if (mPlanningMode) {
+        update();
+        return;
+    }
+    
     // Calculate bounds of the route
     double minLat = coordinates[0].latitude();
     double maxLat = minLat;
@@ -88,24 +110,54 @@ void MapWidget::setRoute(const std::vector<QGeoCoordinate>& coordinates) {
 void MapWidget::setRouteWithSegments(const std::vector<QGeoCoordinate>& coordinates, 
                                     const std::vector<TrackSegment>& segments,
                                     const std::vector<TrackPoint>& points) {
-    // Clear previous route data
-    mRouteCoordinates.clear();
-    mRouteSegments.clear();
+    // Segment indices refer to the coordinate list, which mirrors the points
+    Q_UNUSED(points);
+    buildSegmentedRoute(coordinates, segments);
+}
+
+void MapWidget::setRouteWithSegments(const TrackView& track, const TrackAnalysisResult& analysis) {
+    mTrack = track;
     
-    if (coordinates.empty()) {
-        mHasSegments = false;
+    std::vector<QGeoCoordinate> coordinates;
+    coordinates.reserve(track.size());
+    for (size_t i = 0; i < track.size(); ++i) {
+        coordinates.push_back(track.sourcePoint(i).coord);
+    }
+    
+    buildSegmentedRoute(coordinates, std::vector<TrackSegment>());
+    setAnalysis(analysis);
+}
+
+void MapWidget::setAnalysis(const TrackAnalysisResult& analysis) {
+    mAnalysis = analysis;
+    mSegmentLevel = -1;
+    updateSegmentLevel();
+    update();
+}
+
+void MapWidget::updateSegmentLevel() {
+    if (mAnalysis.isEmpty() || mRouteCoordinates.isEmpty()) {
         return;
     }
     
-    // Always store the full route coordinates for fallback rendering
-    for (const auto& coord : coordinates) {
-        mRouteCoordinates.append(coord);
+    // Web Mercator ground resolution at the map center
+    double metersPerPixel = 156543.03392 * std::cos(mCenterCoordinate.latitude() * M_PI / 180.0)
+                          / (1 << mZoom);
+    int level = mAnalysis.levelForResolution(metersPerPixel * MIN_SEGMENT_PIXELS);
+    if (level != mSegmentLevel) {
+        mSegmentLevel = level;
+        buildRouteSegments(mAnalysis.segmentsAtLevel(level));
     }
+}
+
+void MapWidget::buildRouteSegments(const std::vector<TrackSegment>& segments) {
+    mRouteSegments.clear();
+    const size_t pointCount = static_cast<size_t>(mRouteCoordinates.size());
     
     // Create colored segments if available
-    if (!segments.empty() && !points.empty()) {
+    if (!segments.empty()) {
         // Create a boolean array to track which points are covered by segments
-        std::vector<bool> coveredPoints(points.size(), false);
+        std::vector<bool> coveredPoints(pointCount, false);
         
         // First pass: Create segments from the TrackSegment data
         for (const auto& segment : segments) {
@@ -113,8 +165,8 @@ void MapWidget::setRouteWithSegments(const std::vector<QGeoCoordinate>& coordina
             routeSegment.color = getSegmentColor(segment);
             
             // Extract points for this segment
-            for (size_t i = segment.startIndex; i <= segment.endIndex && i < points.size(); i++) {
-                routeSegment.coordinates.append(points[i].coord);
+            for (size_t i = segment.startIndex; i <= segment.endIndex && i < pointCount; i++) {
+                routeSegment.coordinates.append(mRouteCoordinates[i]);
                 coveredPoints[i] = true;
             }
             
@@ -128,9 +180,9 @@ void MapWidget::setRouteWithSegments(const std::vector<QGeoCoordinate>& coordina
             RouteSegment unclassifiedSegment;
             unclassifiedSegment.color = QColor("#A0A0A0"); // Gray for unclassified parts
             
-            for (size_t i = 0; i < points.size(); i++) {
+            for (size_t i = 0; i < pointCount; i++) {
                 if (!coveredPoints[i]) {
-                    unclassifiedSegment.coordinates.append(points[i].coord);
+                    unclassifiedSegment.coordinates.append(mRouteCoordinates[i]);
                 } else if (!unclassifiedSegment.coordinates.isEmpty()) {
                     // End current unclassified segment and add it if it has at least 2 points
                     if (unclassifiedSegment.coordinates.size() > 1) {
@@ -150,6 +202,34 @@ void MapWidget::setRouteWithSegments(const std::vector<QGeoCoordinate>& coordina
     } else {
         mHasSegments = false;
     }
+}
+
+void MapWidget::buildSegmentedRoute(const std::vector<QGeoCoordinate>& coordinates,
+                                    const std::vector<TrackSegment>& segments) {
+    // Clear previous route data
+    mRouteCoordinates.clear();
+    mDetailCoordinates.clear();
+    mRouteSegments.clear();
+    mAnalysis = TrackAnalysisResult();
+    mSegmentLevel = -1;
+    
+    if (coordinates.empty()) {
+        mHasSegments = false;
+        return;
+    }
+    
+    // Always store the full route coordinates for fallback rendering
+    for (const auto& coord : coordinates) {
+        mRouteCoordinates.append(coord);
+    }
+    
+    buildRouteSegments(segments);
+    
+    // While planning, the route grows under the user's clicks: keep the view
+    if (mPlanningMode) {
+        update();
+        return;
+    }
     
     // Calculate bounds of the route and center the map
     double minLat = coordinates[0].latitude();
@@ -197,6 +277,39 @@ void MapWidget::updateMarker(const QGeoCoordinate& coordinate)
     update();
 }
 
+void MapWidget::updateGhostMarker(const QGeoCoordinate& coordinate)
+{
+    mGhostMarkerCoordinate = coordinate;
+    update();
+}
+
+void MapWidget::setPlanningMode(bool planning)
+{
+    mPlanningMode = planning;
+    if (!planning) {
+        mWaypoints.clear();
+    }
+    update();
+}
+
+void MapWidget::centerOn(const QGeoCoordinate& coordinate, int zoom)
+{
+    mCenterCoordinate = coordinate;
+    mZoom = qMax(1, qMin(18, zoom));
+    updateSegmentLevel();
+    update();
+    emitViewportChanged();
+}
+
+void MapWidget::setWaypoints(const std::vector<QGeoCoordinate>& waypoints)
+{
+    mWaypoints.clear();
+    for (const auto& coord : waypoints) {
+        mWaypoints.append(coord);
+    }
+    update();
+}
+
 void MapWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event);
     
@@ -318,6 +431,37 @@ void MapWidget::paintEvent(QPaintEvent* event) {
         painter.drawPath(path);
     }
     
+    // Draw the full-resolution detail of a lazily loaded route on top
+    if (mDetailCoordinates.size() > 1) {
+        QPainterPath detailPath;
+        detailPath.moveTo(geoToPixel(mDetailCoordinates.first(), mCenterCoordinate, mZoom, size()));
+        for (int i = 1; i < mDetailCoordinates.size(); ++i) {
+            detailPath.lineTo(geoToPixel(mDetailCoordinates[i], mCenterCoordinate, mZoom, size()));
+        }
+        painter.setPen(QPen(QColor(20, 20, 20, 200), 1.5, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.drawPath(detailPath);
+    }
+    
+    // Draw the planned route's waypoints, numbered in click order
+    for (int i = 0; i < mWaypoints.size(); ++i) {
+        QPoint waypointPos = geoToPixel(mWaypoints[i], mCenterCoordinate, mZoom, size());
+        const int waypointSize = 18;
+        QRect waypointRect(waypointPos.x() - waypointSize/2, waypointPos.y() - waypointSize/2, waypointSize, waypointSize);
+        painter.setPen(QPen(Qt::white, 2.0));
+        painter.setBrush(QBrush(QColor(46, 125, 50)));  // Dark green
+        painter.drawEllipse(waypointRect);
+        painter.drawText(waypointRect, Qt::AlignCenter, QString::number(i + 1));
+    }
+    
+    // Draw the ghost rider below the rider's own marker
+    if (mGhostMarkerCoordinate.isValid()) {
+        QPoint ghostPos = geoToPixel(mGhostMarkerCoordinate, mCenterCoordinate, mZoom, size());
+        const int ghostSize = 12;
+        painter.setPen(QPen(Qt::white, 2.0));
+        painter.setBrush(QBrush(QColor(156, 39, 176, 170)));  // Translucent purple
+        painter.drawEllipse(QRect(ghostPos.x() - ghostSize/2, ghostPos.y() - ghostSize/2, ghostSize, ghostSize));
+    }
+    
     // Draw the marker with improved visibility
     QPoint markerPos = geoToPixel(mCurrentMarkerCoordinate, mCenterCoordinate, mZoom, size());
     
@@ -349,6 +493,7 @@ void MapWidget::mousePressEvent(QMouseEvent* event)
     if (event->button() == Qt::LeftButton) {
         mIsPanning = true;
         mLastMousePos = event->pos();
+        mPressMousePos = event->pos();
         setCursor(Qt::ClosedHandCursor);
         event->accept();
     }
@@ -383,7 +528,7 @@ void MapWidget::mouseMoveEvent(QMouseEvent* event)
         // Check if we're hovering over the route
         int newHoverIndex = findClosestRoutePoint(event->pos());
         
-        if (newHoverIndex >= 0 && newHoverIndex < static_cast<int>(mTrackPoints.size())) {
+        if (newHoverIndex >= 0 && newHoverIndex < static_cast<int>(mTrack.size())) {
             if (newHoverIndex != mHoverPointIndex) {
                 mHoverPointIndex = newHoverIndex;
                 mShowTooltip = true;
@@ -393,8 +538,8 @@ void MapWidget::mouseMoveEvent(QMouseEvent* event)
                     mHoverPoint = geoToPixel(mRouteCoordinates[mHoverPointIndex], mCenterCoordinate, mZoom, size());
                     
                     // Show tooltip with track information
-                    if (mHoverPointIndex >= 0 && mHoverPointIndex < static_cast<int>(mTrackPoints.size())) {
-                        const TrackPoint& point = mTrackPoints[mHoverPointIndex];
+                    if (mHoverPointIndex >= 0 && mHoverPointIndex < static_cast<int>(mTrack.size())) {
+                        const TrackPoint point = mTrack[mHoverPointIndex];
                         
                         // Use pre-calculated gradient for more consistent values
                         double gradient = point.gradient;
@@ -435,6 +580,11 @@ void MapWidget::mouseReleaseEvent(QMouseEvent* event)
     if (event->button() == Qt::LeftButton && mIsPanning) {
         mIsPanning = false;
         setCursor(Qt::ArrowCursor);
+        if ((event->pos() - mPressMousePos).manhattanLength() < CLICK_TOLERANCE) {
+            emit mapClicked(pixelToGeo(event->pos(), mCenterCoordinate, mZoom, size()));
+        } else {
+            emitViewportChanged();
+        }
         event->accept();
     }
 }
@@ -479,12 +629,20 @@ void MapWidget::wheelEvent(QWheelEvent *event)
             mCenterCoordinate.setLongitude(mCenterCoordinate.longitude() + dx);
         }
         
+        updateSegmentLevel();
         update();
+        emitViewportChanged();
     }
     
     event->accept();
 }
 
+void MapWidget::emitViewportChanged()
+{
+    emit viewportChanged(pixelToGeo(QPoint(0, 0), mCenterCoordinate, mZoom, size()),
+                         pixelToGeo(QPoint(width(), height()), mCenterCoordinate, mZoom, size()));
+}
+
 QPixmap MapWidget::getTile(int x, int y, int z)
 {
     // Create a cache key
@@ -639,7 +797,19 @@ QColor MapWidget::enhanceColor(const QColor& color) const {
 }
 
 void MapWidget::setTrackPoints(const std::vector<TrackPoint>& points) {
-    mTrackPoints = points;
+    mTrack = TrackView::fromPoints(points);
+}
+
+void MapWidget::setTrackView(const TrackView& track) {
+    mTrack = track;
+}
+
+void MapWidget::setDetailRoute(const std::vector<QGeoCoordinate>& coordinates) {
+    mDetailCoordinates.clear();
+    for (const auto& coord : coordinates) {
+        mDetailCoordinates.append(coord);
+    }
+    update();
 }
 
 // Helper method to find the closest point on the route to the mouse position
@@ -0,0 +1,71 @@
+#include "MotionAnalyzer.h"
+#include <algorithm>
+#include <limits>
+
+MotionProfile MotionAnalyzer::analyze(const TrackColumns& columns) const {
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+    const size_t count = columns.size();
+    
+    MotionProfile profile;
+    profile.speed.assign(count, NaN);
+    profile.smoothedSpeed.assign(count, NaN);
+    profile.pace.assign(count, NaN);
+    profile.moving.assign(count, 0);
+    if (!columns.hasTimestamps() || count < 2) {
+        return profile;
+    }
+    
+    const std::vector<double>& distance = columns.distance;
+    const std::vector<qint64>& timeMs = columns.timestampMs;
+    const qint64 windowMs = static_cast<qint64>(m_params.smoothingWindow * 1000.0);
+    
+    size_t previous = count;     // Last timed point
+    size_t windowStart = count;  // First timed point of the current smoothing window
+    size_t first = count;
+    for (size_t i = 0; i < count; ++i) {
+        if (!columns.timestampValid(i)) {
+            continue;
+        }
+        if (previous == count) {
+            first = windowStart = previous = i;
+            continue;
+        }
+        
+        double dt = (timeMs[i] - timeMs[previous]) / 1000.0;
+        double dd = distance[i] - distance[previous];
+        
+        // A long gap is paused recording; restart the smoothing window after it
+        if (dt > m_params.maxGap) {
+            windowStart = previous;
+        }
+        while (windowStart < previous && timeMs[i] - timeMs[windowStart] > windowMs) {
+            do {
+                ++windowStart;
+            } while (!columns.timestampValid(windowStart));
+        }
+        
+        if (dt > 0.0) {
+            double speed = dd / dt;
+            double windowSeconds = (timeMs[i] - timeMs[windowStart]) / 1000.0;
+            double smoothed = (distance[i] - distance[windowStart]) / windowSeconds;
+            profile.speed[i] = speed;
+            profile.smoothedSpeed[i] = smoothed;
+            
+            if (dt <= m_params.maxGap && speed >= m_params.stopSpeed) {
+                profile.moving[i] = 1;
+                profile.movingTime += dt;
+                profile.movingDistance += dd;
+                profile.maxSpeed = std::max(profile.maxSpeed, smoothed);
+                if (smoothed > 0.0) {
+                    profile.pace[i] = 1000.0 / smoothed;
+                }
+            }
+        }
+        previous = i;
+    }
+    
+    if (previous != count) {
+        profile.elapsedTime = (timeMs[previous] - timeMs[first]) / 1000.0;
+    }
+    return profile;
+}
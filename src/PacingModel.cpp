@@ -0,0 +1,91 @@
+#include "PacingModel.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double GRAVITY = 9.80665;
+    const int NEWTON_ITERATIONS = 16;
+}
+
+void PacingModel::solveSpeeds(const std::vector<double>& gradients, std::vector<double>& speeds) const {
+    const size_t count = gradients.size();
+    speeds.resize(count);
+    
+    if (m_params.mode == RiderParams::HIKING) {
+        // Tobler: 6 km/h * exp(-3.5 * |slope + 0.05|)
+        for (size_t i = 0; i < count; ++i) {
+            double slope = gradients[i] / 100.0;
+            speeds[i] = m_params.hikingFactor * (6.0 / 3.6) * std::exp(-3.5 * std::abs(slope + 0.05));
+        }
+        return;
+    }
+    
+    // a * v^3 + b * v - P = 0 with a > 0; b < 0 on descents
+    const double a = 0.5 * m_params.airDensity * m_params.dragArea;
+    const double power = m_params.power;
+    const double powerRoot = std::cbrt(power / a);
+    std::vector<double> b(count);
+    for (size_t i = 0; i < count; ++i) {
+        double angle = std::atan(gradients[i] / 100.0);
+        b[i] = m_params.mass * GRAVITY * (std::sin(angle) + m_params.rollingResistance * std::cos(angle));
+        // cbrt(P/a) + sqrt(-b/a) has f(v) >= 0, i.e. lies right of the only positive root
+        speeds[i] = powerRoot + std::sqrt(std::max(0.0, -b[i]) / a);
+    }
+    
+    for (int iteration = 0; iteration < NEWTON_ITERATIONS; ++iteration) {
+        for (size_t i = 0; i < count; ++i) {
+            double v = speeds[i];
+            double f = a * v * v * v + b[i] * v - power;
+            double slope = 3.0 * a * v * v + b[i];
+            speeds[i] = v - f / slope;
+        }
+    }
+    
+    for (size_t i = 0; i < count; ++i) {
+        speeds[i] = std::min(m_params.maxSpeed, std::max(m_params.minSpeed, speeds[i]));
+    }
+}
+
+double PacingModel::speedAt(double gradient) const {
+    std::vector<double> speeds;
+    solveSpeeds(std::vector<double>(1, gradient), speeds);
+    return speeds[0];
+}
+
+PacingEstimate PacingModel::estimate(const TrackColumns& columns) const {
+    PacingEstimate estimate;
+    const size_t count = columns.size();
+    if (count == 0) {
+        return estimate;
+    }
+    
+    solveSpeeds(columns.gradient, estimate.speed);
+    
+    // The interval ending at point i is ridden at the speed of point i's gradient
+    estimate.elapsed.resize(count);
+    estimate.elapsed[0] = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+        double distance = columns.distance[i] - columns.distance[i - 1];
+        estimate.elapsed[i] = estimate.elapsed[i - 1] + distance / estimate.speed[i];
+    }
+    return estimate;
+}
+
+std::vector<double> PacingModel::sweep(const TrackColumns& columns, const std::vector<RiderParams>& grid) {
+    std::vector<std::pair<RiderParams, double>> runs;
+    for (const RiderParams& params : grid) {
+        runs.emplace_back(params, 0.0);
+    }
+    
+    QtConcurrent::blockingMap(runs, [&columns](std::pair<RiderParams, double>& run) {
+        run.second = PacingModel(run.first).estimate(columns).totalTime();
+    });
+    
+    std::vector<double> times;
+    times.reserve(runs.size());
+    for (const auto& run : runs) {
+        times.push_back(run.second);
+    }
+    return times;
+}
@@ -0,0 +1,162 @@
+#include "PowerCurve.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    const int DENSE_DURATION_LIMIT = 120;       // Every duration up to this many seconds
+    const double DURATION_GROWTH = 1.05;        // Spacing of longer sampled durations
+    const int FIT_MIN_DURATION = 180;           // Critical power fit range in seconds
+    const int FIT_MAX_DURATION = 1200;
+    
+    // Largest sum of `duration` consecutive samples, from the prefix sums.
+    // Four independent running maxima keep the loop free of a serial
+    // dependency so it pipelines and vectorizes well.
+    double bestWindowSum(const std::vector<double>& prefix, int duration, int& start) {
+        const double* head = prefix.data() + duration;
+        const double* tail = prefix.data();
+        const size_t windows = prefix.size() - duration;
+        
+        double best[4] = {head[0] - tail[0], head[0] - tail[0], head[0] - tail[0], head[0] - tail[0]};
+        size_t k = 0;
+        for (; k + 4 <= windows; k += 4) {
+            best[0] = std::max(best[0], head[k] - tail[k]);
+            best[1] = std::max(best[1], head[k + 1] - tail[k + 1]);
+            best[2] = std::max(best[2], head[k + 2] - tail[k + 2]);
+            best[3] = std::max(best[3], head[k + 3] - tail[k + 3]);
+        }
+        for (; k < windows; ++k) {
+            best[0] = std::max(best[0], head[k] - tail[k]);
+        }
+        double result = std::max(std::max(best[0], best[1]), std::max(best[2], best[3]));
+        
+        // Locate the first window reaching the maximum
+        start = 0;
+        for (size_t i = 0; i < windows; ++i) {
+            if (head[i] - tail[i] == result) {
+                start = static_cast<int>(i);
+                break;
+            }
+        }
+        return result;
+    }
+}
+
+const int PowerCurve::MAX_HOLD_SECONDS;
+
+std::vector<int> PowerCurve::sampleDurations(int seriesLength) {
+    std::vector<int> durations;
+    for (int duration = 1; duration <= std::min(seriesLength, DENSE_DURATION_LIMIT); ++duration) {
+        durations.push_back(duration);
+    }
+    double next = DENSE_DURATION_LIMIT;
+    while (true) {
+        next *= DURATION_GROWTH;
+        int duration = static_cast<int>(std::round(next));
+        if (duration >= seriesLength) {
+            break;
+        }
+        if (duration > durations.back()) {
+            durations.push_back(duration);
+        }
+    }
+    if (seriesLength > DENSE_DURATION_LIMIT) {
+        durations.push_back(seriesLength);
+    }
+    return durations;
+}
+
+PowerCurve PowerCurve::compute(const TrackColumns& columns) {
+    if (columns.power.empty() || !columns.hasTimestamps()) {
+        return PowerCurve();
+    }
+    
+    // Timed power samples
+    std::vector<std::pair<qint64, double>> samples;
+    for (size_t row = 0; row < columns.size(); ++row) {
+        if (columns.timestampValid(row) && !std::isnan(columns.power[row])) {
+            samples.emplace_back(columns.timestampMs[row], columns.power[row]);
+        }
+    }
+    if (samples.empty()) {
+        return PowerCurve();
+    }
+    // Recorders occasionally write timestamps out of order
+    std::stable_sort(samples.begin(), samples.end(),
+                     [](const std::pair<qint64, double>& a, const std::pair<qint64, double>& b) { return a.first < b.first; });
+    
+    // Resample to 1 Hz, holding each sample until the next one or MAX_HOLD_SECONDS
+    const qint64 origin = samples.front().first;
+    const qint64 span = (samples.back().first - origin) / 1000 + 1;
+    if (span <= 0 || span > std::numeric_limits<int>::max()) {
+        return PowerCurve();
+    }
+    const int length = static_cast<int>(span);
+    std::vector<double> watts(length, 0.0);
+    size_t current = 0;
+    for (int second = 0; second < length; ++second) {
+        qint64 time = origin + static_cast<qint64>(second) * 1000;
+        while (current + 1 < samples.size() && samples[current + 1].first <= time) {
+            ++current;
+        }
+        if (time - samples[current].first <= MAX_HOLD_SECONDS * 1000LL) {
+            watts[second] = std::max(0.0, samples[current].second);
+        }
+    }
+    return fromSeries(watts);
+}
+
+PowerCurve PowerCurve::fromSeries(const std::vector<double>& watts) {
+    PowerCurve curve;
+    if (watts.empty()) {
+        return curve;
+    }
+    
+    std::vector<double> prefix(watts.size() + 1, 0.0);
+    for (size_t i = 0; i < watts.size(); ++i) {
+        prefix[i + 1] = prefix[i] + watts[i];
+    }
+    
+    for (int duration : sampleDurations(static_cast<int>(watts.size()))) {
+        curve.m_points.push_back({duration, 0.0, 0});
+    }
+    
+    // Durations are independent scans over the shared prefix sums
+    QtConcurrent::blockingMap(curve.m_points, [&prefix](PowerCurvePoint& point) {
+        point.power = bestWindowSum(prefix, point.duration, point.startSecond) / point.duration;
+    });
+    
+    curve.fitCriticalPower();
+    return curve;
+}
+
+double PowerCurve::powerAt(int seconds) const {
+    auto it = std::lower_bound(m_points.begin(), m_points.end(), seconds,
+                               [](const PowerCurvePoint& point, int value) { return point.duration < value; });
+    return it == m_points.end() ? 0.0 : it->power;
+}
+
+void PowerCurve::fitCriticalPower() {
+    // Work = CP * t + W', linear in t
+    double n = 0.0, sumT = 0.0, sumW = 0.0, sumTT = 0.0, sumTW = 0.0;
+    for (const auto& point : m_points) {
+        if (point.duration < FIT_MIN_DURATION || point.duration > FIT_MAX_DURATION) {
+            continue;
+        }
+        double t = point.duration;
+        double work = point.power * t;
+        n += 1.0;
+        sumT += t;
+        sumW += work;
+        sumTT += t * t;
+        sumTW += t * work;
+    }
+    
+    double denominator = n * sumTT - sumT * sumT;
+    if (n < 2.0 || denominator <= 0.0) {
+        return;
+    }
+    m_criticalPower = (n * sumTW - sumT * sumW) / denominator;
+    m_anaerobicCapacity = std::max(0.0, (sumW - m_criticalPower * sumT) / n);
+}
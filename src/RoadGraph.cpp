@@ -0,0 +1,637 @@
+#include "RoadGraph.h"
+#include "SpatialHash.h"
+#include "logging.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    using SpatialHash::METERS_PER_DEGREE;
+    const int BLOBS_PER_BATCH = 64;
+    const qint32 MAX_BLOB_HEADER_SIZE = 64 * 1024;
+    const qint32 MAX_BLOB_SIZE = 32 * 1024 * 1024;
+
+    /**
+     * Minimal protobuf wire-format reader over a byte range
+     */
+    class ProtoReader {
+    public:
+        ProtoReader(const char* data, size_t size)
+            : m_p(reinterpret_cast<const uchar*>(data)), m_end(m_p + size) {}
+
+        bool atEnd() const { return m_p >= m_end || m_error; }
+        bool hasError() const { return m_error; }
+        int field() const { return m_field; }
+        int wireType() const { return m_wire; }
+
+        bool next() {
+            if (atEnd()) {
+                return false;
+            }
+            const quint64 key = varint();
+            m_field = static_cast<int>(key >> 3);
+            m_wire = static_cast<int>(key & 7);
+            return !m_error;
+        }
+
+        quint64 varint() {
+            quint64 value = 0;
+            for (int shift = 0; shift < 64 && m_p < m_end; shift += 7) {
+                const uchar byte = *m_p++;
+                value |= static_cast<quint64>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            m_error = true;
+            return 0;
+        }
+
+        qint64 svarint() {
+            const quint64 value = varint();
+            return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+        }
+
+        ProtoReader bytes() {
+            const quint64 length = varint();
+            if (m_error || length > static_cast<quint64>(m_end - m_p)) {
+                m_error = true;
+                return ProtoReader(nullptr, 0);
+            }
+            ProtoReader inner(reinterpret_cast<const char*>(m_p), static_cast<size_t>(length));
+            m_p += length;
+            return inner;
+        }
+
+        QByteArray byteArray() {
+            ProtoReader inner = bytes();
+            return QByteArray(inner.data(), static_cast<int>(inner.size()));
+        }
+
+        void skip() {
+            switch (m_wire) {
+            case 0: varint(); break;
+            case 1: advance(8); break;
+            case 2: bytes(); break;
+            case 5: advance(4); break;
+            default: m_error = true; break;
+            }
+        }
+
+        const char* data() const { return reinterpret_cast<const char*>(m_p); }
+        size_t size() const { return static_cast<size_t>(m_end - m_p); }
+
+    private:
+        void advance(size_t count) {
+            if (count > size()) {
+                m_error = true;
+            } else {
+                m_p += count;
+            }
+        }
+
+        const uchar* m_p;
+        const uchar* m_end;
+        int m_field = 0;
+        int m_wire = 0;
+        bool m_error = false;
+    };
+
+    quint32 readBigEndian32(const char* data) {
+        const uchar* p = reinterpret_cast<const uchar*>(data);
+        return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+    }
+
+    /**
+     * Next OSMData blob of the file; OSMHeader and unknown blobs are skipped
+     * @return False at the end of the file or on a damaged file (error set)
+     */
+    bool readDataBlob(QFile& file, QByteArray& blob, QString& error) {
+        while (true) {
+            char lengthBytes[4];
+            const qint64 got = file.read(lengthBytes, 4);
+            if (got == 0) {
+                return false;
+            }
+            const quint32 headerSize = got == 4 ? readBigEndian32(lengthBytes) : 0;
+            if (got != 4 || headerSize == 0 || headerSize > static_cast<quint32>(MAX_BLOB_HEADER_SIZE)) {
+                error = "Damaged blob header";
+                return false;
+            }
+            QByteArray header = file.read(headerSize);
+            ProtoReader reader(header.constData(), header.size());
+            QByteArray type;
+            quint64 dataSize = 0;
+            while (reader.next()) {
+                if (reader.field() == 1 && reader.wireType() == 2) {
+                    type = reader.byteArray();
+                } else if (reader.field() == 3 && reader.wireType() == 0) {
+                    dataSize = reader.varint();
+                } else {
+                    reader.skip();
+                }
+            }
+            if (reader.hasError() || header.size() != static_cast<int>(headerSize) ||
+                dataSize > static_cast<quint64>(MAX_BLOB_SIZE)) {
+                error = "Damaged blob header";
+                return false;
+            }
+            blob = file.read(static_cast<qint64>(dataSize));
+            if (blob.size() != static_cast<int>(dataSize)) {
+                error = "Truncated blob";
+                return false;
+            }
+            if (type == QByteArray("OSMData")) {
+                return true;
+            }
+        }
+    }
+
+    // Raw or zlib-compressed block of a blob; other compressions are not supported
+    QByteArray inflateBlob(const QByteArray& blob) {
+        ProtoReader reader(blob.constData(), blob.size());
+        QByteArray raw;
+        QByteArray compressed;
+        quint64 rawSize = 0;
+        while (reader.next()) {
+            if (reader.field() == 1 && reader.wireType() == 2) {
+                raw = reader.byteArray();
+            } else if (reader.field() == 2 && reader.wireType() == 0) {
+                rawSize = reader.varint();
+            } else if (reader.field() == 3 && reader.wireType() == 2) {
+                compressed = reader.byteArray();
+            } else {
+                reader.skip();
+            }
+        }
+        if (!raw.isEmpty() || compressed.isEmpty() || rawSize > static_cast<quint64>(MAX_BLOB_SIZE)) {
+            return raw;
+        }
+        // qUncompress expects the inflated size as a big-endian prefix
+        QByteArray prefixed;
+        prefixed.reserve(compressed.size() + 4);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            prefixed.append(static_cast<char>((rawSize >> shift) & 0xff));
+        }
+        prefixed.append(compressed);
+        return qUncompress(prefixed);
+    }
+
+    // Byte ranges of a primitive block: string table and primitive groups, plus coordinate scaling
+    struct BlockLayout {
+        std::vector<std::pair<const char*, size_t>> strings;
+        std::vector<ProtoReader> groups;
+        qint64 granularity = 100;
+        qint64 latOffset = 0;
+        qint64 lonOffset = 0;
+    };
+
+    bool readBlockLayout(const QByteArray& block, BlockLayout& layout) {
+        ProtoReader reader(block.constData(), block.size());
+        while (reader.next()) {
+            if (reader.field() == 1 && reader.wireType() == 2) {
+                ProtoReader table = reader.bytes();
+                while (table.next()) {
+                    if (table.field() == 1 && table.wireType() == 2) {
+                        ProtoReader entry = table.bytes();
+                        layout.strings.emplace_back(entry.data(), entry.size());
+                    } else {
+                        table.skip();
+                    }
+                }
+            } else if (reader.field() == 2 && reader.wireType() == 2) {
+                layout.groups.push_back(reader.bytes());
+            } else if (reader.field() == 17 && reader.wireType() == 0) {
+                layout.granularity = static_cast<qint64>(reader.varint());
+            } else if (reader.field() == 19 && reader.wireType() == 0) {
+                layout.latOffset = static_cast<qint64>(reader.varint());
+            } else if (reader.field() == 20 && reader.wireType() == 0) {
+                layout.lonOffset = static_cast<qint64>(reader.varint());
+            } else {
+                reader.skip();
+            }
+        }
+        return !reader.hasError();
+    }
+
+    bool stringIs(const BlockLayout& layout, quint32 index, const char* text) {
+        if (index >= layout.strings.size()) {
+            return false;
+        }
+        const size_t length = std::strlen(text);
+        return layout.strings[index].second == length && std::memcmp(layout.strings[index].first, text, length) == 0;
+    }
+
+    bool stringIn(const BlockLayout& layout, quint32 index, std::initializer_list<const char*> texts) {
+        for (const char* text : texts) {
+            if (stringIs(layout, index, text)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct WayRecord {
+        std::vector<qint64> refs;
+        int direction = 0;      // 0 both ways, 1 along the node order, -1 against it
+    };
+
+    // Ways tagged as roads usable by bicycles or cars, with their one-way rule
+    void readRoadWays(const QByteArray& block, std::vector<WayRecord>& ways) {
+        BlockLayout layout;
+        if (!readBlockLayout(block, layout)) {
+            return;
+        }
+        for (ProtoReader group : layout.groups) {
+            while (group.next()) {
+                if (group.field() != 3 || group.wireType() != 2) {
+                    group.skip();
+                    continue;
+                }
+                ProtoReader way = group.bytes();
+                std::vector<quint32> keys, values;
+                WayRecord record;
+                while (way.next()) {
+                    if ((way.field() == 2 || way.field() == 3) && way.wireType() == 2) {
+                        std::vector<quint32>& target = way.field() == 2 ? keys : values;
+                        ProtoReader packed = way.bytes();
+                        while (!packed.atEnd()) {
+                            target.push_back(static_cast<quint32>(packed.varint()));
+                        }
+                    } else if (way.field() == 8 && way.wireType() == 2) {
+                        ProtoReader packed = way.bytes();
+                        qint64 ref = 0;
+                        while (!packed.atEnd()) {
+                            ref += packed.svarint();
+                            record.refs.push_back(ref);
+                        }
+                    } else {
+                        way.skip();
+                    }
+                }
+                if (record.refs.size() < 2 || keys.size() != values.size()) {
+                    continue;
+                }
+
+                int highway = -1;
+                bool area = false, roundabout = false, motorway = false, bicycleBothWays = false;
+                int oneway = 0;
+                bool onewayTagged = false;
+                for (size_t k = 0; k < keys.size(); ++k) {
+                    if (stringIs(layout, keys[k], "highway")) {
+                        highway = static_cast<int>(values[k]);
+                        motorway = stringIs(layout, values[k], "motorway");
+                    } else if (stringIs(layout, keys[k], "area")) {
+                        area = stringIs(layout, values[k], "yes");
+                    } else if (stringIs(layout, keys[k], "junction")) {
+                        roundabout = stringIs(layout, values[k], "roundabout");
+                    } else if (stringIs(layout, keys[k], "oneway")) {
+                        onewayTagged = true;
+                        if (stringIn(layout, values[k], {"yes", "true", "1"})) {
+                            oneway = 1;
+                        } else if (stringIn(layout, values[k], {"-1", "reverse"})) {
+                            oneway = -1;
+                        }
+                    } else if (stringIs(layout, keys[k], "oneway:bicycle")) {
+                        bicycleBothWays = stringIs(layout, values[k], "no");
+                    }
+                }
+                if (highway < 0 || area ||
+                    stringIn(layout, static_cast<quint32>(highway),
+                             {"proposed", "construction", "abandoned", "disused", "razed", "platform", "steps",
+                              "elevator", "corridor", "bus_stop", "rest_area", "services", "raceway"})) {
+                    continue;
+                }
+                if (!onewayTagged && (roundabout || motorway)) {
+                    oneway = 1;
+                }
+                record.direction = bicycleBothWays ? 0 : oneway;
+                ways.push_back(std::move(record));
+            }
+        }
+    }
+
+    struct NodeRecord {
+        qint32 slot;            // Index in the sorted list of needed ids
+        double latitude;
+        double longitude;
+    };
+
+    void readNeededNodes(const QByteArray& block, const std::vector<qint64>& needed, std::vector<NodeRecord>& nodes) {
+        BlockLayout layout;
+        if (!readBlockLayout(block, layout)) {
+            return;
+        }
+        auto keep = [&](qint64 id, qint64 lat, qint64 lon) {
+            auto found = std::lower_bound(needed.begin(), needed.end(), id);
+            if (found != needed.end() && *found == id) {
+                nodes.push_back(NodeRecord{static_cast<qint32>(found - needed.begin()),
+                                           1e-9 * (layout.latOffset + layout.granularity * lat),
+                                           1e-9 * (layout.lonOffset + layout.granularity * lon)});
+            }
+        };
+
+        for (ProtoReader group : layout.groups) {
+            while (group.next()) {
+                if (group.field() == 1 && group.wireType() == 2) {
+                    ProtoReader node = group.bytes();
+                    qint64 id = 0, lat = 0, lon = 0;
+                    while (node.next()) {
+                        if (node.field() == 1 && node.wireType() == 0) id = node.svarint();
+                        else if (node.field() == 8 && node.wireType() == 0) lat = node.svarint();
+                        else if (node.field() == 9 && node.wireType() == 0) lon = node.svarint();
+                        else node.skip();
+                    }
+                    keep(id, lat, lon);
+                } else if (group.field() == 2 && group.wireType() == 2) {
+                    // Dense nodes: ids and coordinates are delta-coded packed arrays
+                    ProtoReader dense = group.bytes();
+                    ProtoReader ids(nullptr, 0), lats(nullptr, 0), lons(nullptr, 0);
+                    while (dense.next()) {
+                        if (dense.field() == 1 && dense.wireType() == 2) ids = dense.bytes();
+                        else if (dense.field() == 8 && dense.wireType() == 2) lats = dense.bytes();
+                        else if (dense.field() == 9 && dense.wireType() == 2) lons = dense.bytes();
+                        else dense.skip();
+                    }
+                    qint64 id = 0, lat = 0, lon = 0;
+                    while (!ids.atEnd() && !lats.atEnd() && !lons.atEnd()) {
+                        id += ids.svarint();
+                        lat += lats.svarint();
+                        lon += lons.svarint();
+                        keep(id, lat, lon);
+                    }
+                } else {
+                    group.skip();
+                }
+            }
+        }
+    }
+
+    /**
+     * Read every data blob of a file in batches, inflating and decoding each batch in parallel
+     */
+    template <typename Result, typename Decode, typename Merge>
+    bool forEachBlock(const QString& filename, Decode decode, Merge merge, QString& error) {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = QString("Cannot open %1").arg(filename);
+            return false;
+        }
+        struct Job {
+            QByteArray blob;
+            Result result;
+        };
+        bool more = true;
+        while (more) {
+            std::vector<Job> jobs;
+            QByteArray blob;
+            while (static_cast<int>(jobs.size()) < BLOBS_PER_BATCH && (more = readDataBlob(file, blob, error))) {
+                jobs.push_back(Job{blob, Result()});
+            }
+            if (!error.isEmpty()) {
+                return false;
+            }
+            QtConcurrent::blockingMap(jobs, [&decode](Job& job) {
+                decode(inflateBlob(job.blob), job.result);
+                job.blob = QByteArray();
+            });
+            for (Job& job : jobs) {
+                merge(job.result);
+            }
+        }
+        return true;
+    }
+}
+
+RoadGraph::RoadGraph(double cellSize)
+    : m_cellSize(cellSize)
+{
+}
+
+bool RoadGraph::loadPbf(const QString& filename) {
+    QElapsedTimer timer;
+    timer.start();
+    *this = RoadGraph(m_cellSize);
+
+    // Pass 1: road ways and the ids of their nodes
+    std::vector<WayRecord> ways;
+    std::vector<qint64> needed;
+    bool ok = forEachBlock<std::vector<WayRecord>>(filename,
+        [](const QByteArray& block, std::vector<WayRecord>& result) { readRoadWays(block, result); },
+        [&](std::vector<WayRecord>& result) {
+            for (WayRecord& way : result) {
+                needed.insert(needed.end(), way.refs.begin(), way.refs.end());
+                ways.push_back(std::move(way));
+            }
+        }, m_errorString);
+    if (!ok) {
+        return false;
+    }
+    std::sort(needed.begin(), needed.end());
+    needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+    // Pass 2: coordinates of those nodes only
+    std::vector<qint32> nodeOfSlot(needed.size(), -1);
+    std::vector<double> latitudes(needed.size()), longitudes(needed.size());
+    ok = forEachBlock<std::vector<NodeRecord>>(filename,
+        [&needed](const QByteArray& block, std::vector<NodeRecord>& result) { readNeededNodes(block, needed, result); },
+        [&](std::vector<NodeRecord>& result) {
+            for (const NodeRecord& node : result) {
+                nodeOfSlot[node.slot] = 0;
+                latitudes[node.slot] = node.latitude;
+                longitudes[node.slot] = node.longitude;
+            }
+        }, m_errorString);
+    if (!ok) {
+        return false;
+    }
+    for (size_t slot = 0; slot < needed.size(); ++slot) {
+        if (nodeOfSlot[slot] == 0) {
+            nodeOfSlot[slot] = addNode(latitudes[slot], longitudes[slot]);
+        }
+    }
+
+    // Ways are split where an extract clipped away some of their nodes
+    for (const WayRecord& way : ways) {
+        std::vector<qint32> run;
+        auto flush = [&]() {
+            if (run.size() >= 2) {
+                if (way.direction < 0) {
+                    std::reverse(run.begin(), run.end());
+                }
+                addWay(run, way.direction != 0);
+            }
+            run.clear();
+        };
+        for (qint64 ref : way.refs) {
+            const qint32 node = nodeOfSlot[std::lower_bound(needed.begin(), needed.end(), ref) - needed.begin()];
+            if (node < 0) {
+                flush();
+            } else {
+                run.push_back(node);
+            }
+        }
+        flush();
+    }
+    build();
+
+    if (isEmpty()) {
+        m_errorString = QString("No roads in %1").arg(filename);
+        return false;
+    }
+    logInfo("RoadGraph", QString("Loaded %1 road ways, %2 nodes and %3 segments in %4 ms")
+            .arg(ways.size()).arg(nodeCount()).arg(segmentCount()).arg(timer.elapsed()));
+    return true;
+}
+
+qint32 RoadGraph::addNode(double latitude, double longitude) {
+    m_latitude.push_back(latitude);
+    m_longitude.push_back(longitude);
+    return static_cast<qint32>(m_latitude.size()) - 1;
+}
+
+void RoadGraph::addWay(const std::vector<qint32>& nodes, bool oneway) {
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        if (nodes[i] == nodes[i - 1]) {
+            continue;
+        }
+        RoadSegment segment;
+        segment.from = nodes[i - 1];
+        segment.to = nodes[i];
+        segment.forward = true;
+        segment.backward = !oneway;
+        m_segments.push_back(segment);
+    }
+}
+
+void RoadGraph::project(double latitude, double longitude, double& x, double& y) const {
+    x = longitude * m_lonScale;
+    y = latitude * METERS_PER_DEGREE;
+}
+
+QGeoCoordinate RoadGraph::unproject(double x, double y) const {
+    return QGeoCoordinate(y / METERS_PER_DEGREE, x / m_lonScale);
+}
+
+void RoadGraph::build() {
+    const size_t nodes = m_latitude.size();
+    double latitudeSum = 0.0;
+    for (double latitude : m_latitude) {
+        latitudeSum += latitude;
+    }
+    m_lonScale = METERS_PER_DEGREE * std::cos((nodes > 0 ? latitudeSum / nodes : 0.0) * M_PI / 180.0);
+    m_x.resize(nodes);
+    m_y.resize(nodes);
+    for (size_t i = 0; i < nodes; ++i) {
+        project(m_latitude[i], m_longitude[i], m_x[i], m_y[i]);
+    }
+
+    // CSR adjacency over the allowed directions
+    m_arcOffsets.assign(nodes + 1, 0);
+    for (RoadSegment& segment : m_segments) {
+        segment.length = static_cast<float>(std::hypot(m_x[segment.to] - m_x[segment.from], m_y[segment.to] - m_y[segment.from]));
+        if (segment.forward) ++m_arcOffsets[segment.from + 1];
+        if (segment.backward) ++m_arcOffsets[segment.to + 1];
+    }
+    for (size_t i = 0; i < nodes; ++i) {
+        m_arcOffsets[i + 1] += m_arcOffsets[i];
+    }
+    m_arcs.resize(m_arcOffsets[nodes]);
+    std::vector<quint32> fill(m_arcOffsets.begin(), m_arcOffsets.end() - 1);
+    for (size_t s = 0; s < m_segments.size(); ++s) {
+        const RoadSegment& segment = m_segments[s];
+        if (segment.forward) m_arcs[fill[segment.from]++] = Arc{segment.to, static_cast<qint32>(s), segment.length};
+        if (segment.backward) m_arcs[fill[segment.to]++] = Arc{segment.from, static_cast<qint32>(s), segment.length};
+    }
+
+    m_cells.clear();
+    for (size_t s = 0; s < m_segments.size(); ++s) {
+        addSegmentCells(static_cast<qint32>(s));
+    }
+    std::sort(m_cells.begin(), m_cells.end(), [](const CellEntry& a, const CellEntry& b) {
+        return a.cell < b.cell;
+    });
+}
+
+quint64 RoadGraph::cellKey(qint64 row, qint64 column) const {
+    return (static_cast<quint64>(static_cast<quint32>(row)) << 32) | static_cast<quint32>(column);
+}
+
+void RoadGraph::addSegmentCells(qint32 id) {
+    // Grid traversal: every cell the segment crosses, no more
+    const RoadSegment& segment = m_segments[id];
+    const double x0 = m_x[segment.from], y0 = m_y[segment.from];
+    const double dx = m_x[segment.to] - x0, dy = m_y[segment.to] - y0;
+    qint64 column = static_cast<qint64>(std::floor(x0 / m_cellSize));
+    qint64 row = static_cast<qint64>(std::floor(y0 / m_cellSize));
+    const qint64 lastColumn = static_cast<qint64>(std::floor(m_x[segment.to] / m_cellSize));
+    const qint64 lastRow = static_cast<qint64>(std::floor(m_y[segment.to] / m_cellSize));
+    const int stepX = dx > 0 ? 1 : -1;
+    const int stepY = dy > 0 ? 1 : -1;
+    const double inf = std::numeric_limits<double>::infinity();
+    double tMaxX = dx != 0.0 ? ((column + (stepX > 0 ? 1 : 0)) * m_cellSize - x0) / dx : inf;
+    double tMaxY = dy != 0.0 ? ((row + (stepY > 0 ? 1 : 0)) * m_cellSize - y0) / dy : inf;
+    const double tDeltaX = dx != 0.0 ? m_cellSize / std::abs(dx) : inf;
+    const double tDeltaY = dy != 0.0 ? m_cellSize / std::abs(dy) : inf;
+
+    m_cells.push_back(CellEntry{cellKey(row, column), id});
+    qint64 steps = std::abs(lastColumn - column) + std::abs(lastRow - row);
+    while (steps-- > 0) {
+        if (tMaxX < tMaxY) {
+            column += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            row += stepY;
+            tMaxY += tDeltaY;
+        }
+        m_cells.push_back(CellEntry{cellKey(row, column), id});
+    }
+}
+
+std::vector<RoadCandidate> RoadGraph::candidates(double x, double y, double radius, int maxCount) const {
+    std::vector<qint32> nearby;
+    const qint64 firstRow = static_cast<qint64>(std::floor((y - radius) / m_cellSize));
+    const qint64 lastRow = static_cast<qint64>(std::floor((y + radius) / m_cellSize));
+    const qint64 firstColumn = static_cast<qint64>(std::floor((x - radius) / m_cellSize));
+    const qint64 lastColumn = static_cast<qint64>(std::floor((x + radius) / m_cellSize));
+    for (qint64 row = firstRow; row <= lastRow; ++row) {
+        for (qint64 column = firstColumn; column <= lastColumn; ++column) {
+            auto range = std::equal_range(m_cells.begin(), m_cells.end(), CellEntry{cellKey(row, column), 0},
+                                          [](const CellEntry& a, const CellEntry& b) { return a.cell < b.cell; });
+            for (auto it = range.first; it != range.second; ++it) {
+                nearby.push_back(it->segment);
+            }
+        }
+    }
+    std::sort(nearby.begin(), nearby.end());
+    nearby.erase(std::unique(nearby.begin(), nearby.end()), nearby.end());
+
+    std::vector<RoadCandidate> result;
+    for (qint32 id : nearby) {
+        const RoadSegment& segment = m_segments[id];
+        const double ax = m_x[segment.from], ay = m_y[segment.from];
+        const double dx = m_x[segment.to] - ax, dy = m_y[segment.to] - ay;
+        const double lengthSquared = dx * dx + dy * dy;
+        const double t = lengthSquared > 0.0 ? std::min(std::max(((x - ax) * dx + (y - ay) * dy) / lengthSquared, 0.0), 1.0) : 0.0;
+        RoadCandidate candidate;
+        candidate.segment = id;
+        candidate.fraction = t;
+        candidate.x = ax + dx * t;
+        candidate.y = ay + dy * t;
+        candidate.distance = std::hypot(x - candidate.x, y - candidate.y);
+        if (candidate.distance <= radius) {
+            result.push_back(candidate);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const RoadCandidate& a, const RoadCandidate& b) {
+        return a.distance < b.distance;
+    });
+    if (maxCount >= 0 && result.size() > static_cast<size_t>(maxCount)) {
+        result.resize(maxCount);
+    }
+    return result;
+}
@@ -42,6 +42,9 @@ void RouteData::processPoints(const std::vector<TrackPoint>& trackPoints, float
     // First pass: convert all points to local 3D coordinates
     const double originLon = trackPoints.front().coord.longitude();
     const double originLat = trackPoints.front().coord.latitude();
+    m_originLon = originLon;
+    m_originLat = originLat;
+    m_elevationScale = elevationScale;
     for (const auto& point : trackPoints) {
         QVector2D mercatorCoords = lonLatToMercator(
             point.coord.longitude(), point.coord.latitude(), originLon, originLat);
@@ -70,6 +73,12 @@ void RouteData::processPoints(const std::vector<TrackPoint>& trackPoints, float
     }
 }
 
+QVector3D RouteData::positionOf(const QGeoCoordinate& coord, double elevation) const
+{
+    QVector2D mercatorCoords = lonLatToMercator(coord.longitude(), coord.latitude(), m_originLon, m_originLat);
+    return QVector3D(mercatorCoords.x(), static_cast<float>(elevation) * m_elevationScale, mercatorCoords.y());
+}
+
 RoutePoint RouteData::getPointAtProgress(float progress) const
 {
     if (m_routePoints.empty()) {
@@ -0,0 +1,308 @@
+#include "RouteSimilarity.h"
+#include "SpatialHash.h"
+#include "logging.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    const quint32 INDEX_MAGIC = 0x47505349;   // "GPSI"
+    const quint32 INDEX_VERSION = 1;
+
+    // The MurmurHash3 finalizer seeded per row is the family of MinHash functions
+    using SpatialHash::mix;
+    using SpatialHash::cellKey;
+}
+
+RouteSimilarityIndex::RouteSimilarityIndex(const SimilarityParams& params)
+    : m_params(params), m_buckets(params.bands)
+{
+}
+
+QString RouteSimilarityIndex::defaultIndexPath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("route_similarity.idx");
+}
+
+RouteSketch RouteSimilarityIndex::sketch(const std::vector<TrackPoint>& points) const {
+    RouteSketch result;
+    const double step = m_params.cellSize / 2.0;
+    const TrackPoint* previous = nullptr;
+    for (const TrackPoint& point : points) {
+        if (!point.coord.isValid()) {
+            continue;
+        }
+        if (previous) {
+            // Fill gaps longer than half a cell so no cell along the way is skipped
+            const double gap = point.distance - previous->distance;
+            const int steps = gap > step ? static_cast<int>(std::ceil(gap / step)) : 1;
+            for (int k = 1; k < steps; ++k) {
+                const double t = static_cast<double>(k) / steps;
+                const double latitude = previous->coord.latitude() + (point.coord.latitude() - previous->coord.latitude()) * t;
+                const double longitude = previous->coord.longitude() + (point.coord.longitude() - previous->coord.longitude()) * t;
+                result.cells.push_back(cellKey(latitude, longitude, m_params.cellSize));
+            }
+        }
+        result.cells.push_back(cellKey(point.coord.latitude(), point.coord.longitude(), m_params.cellSize));
+        previous = &point;
+    }
+    std::sort(result.cells.begin(), result.cells.end());
+    result.cells.erase(std::unique(result.cells.begin(), result.cells.end()), result.cells.end());
+    if (result.cells.empty()) {
+        return result;
+    }
+
+    // Function i hashes a cell as mix(cell ^ seed_i)
+    const int size = m_params.signatureSize();
+    result.signature.assign(size, std::numeric_limits<quint64>::max());
+    std::vector<quint64> seeds(size);
+    for (int i = 0; i < size; ++i) {
+        seeds[i] = mix(0x9e3779b97f4a7c15ULL * (i + 1));
+    }
+    for (quint64 cell : result.cells) {
+        for (int i = 0; i < size; ++i) {
+            result.signature[i] = std::min(result.signature[i], mix(cell ^ seeds[i]));
+        }
+    }
+    return result;
+}
+
+quint64 RouteSimilarityIndex::bandKey(const std::vector<quint64>& signature, int band) const {
+    quint64 key = mix(band + 1);
+    for (int row = 0; row < m_params.rowsPerBand; ++row) {
+        key = mix(key ^ signature[band * m_params.rowsPerBand + row]) + 0x9e3779b97f4a7c15ULL;
+    }
+    return key;
+}
+
+void RouteSimilarityIndex::add(const QString& file, RouteSketch sketch, qint64 fileSize, qint64 modified) {
+    if (static_cast<int>(sketch.signature.size()) != m_params.signatureSize()) {
+        return;
+    }
+    auto existing = std::find_if(m_entries.begin(), m_entries.end(),
+                                 [&file](const Entry& entry) { return entry.file == file; });
+    if (existing != m_entries.end()) {
+        existing->fileSize = fileSize;
+        existing->modified = modified;
+        existing->sketch = std::move(sketch);
+        rebuildBuckets();
+        return;
+    }
+
+    Entry entry;
+    entry.file = file;
+    entry.fileSize = fileSize;
+    entry.modified = modified;
+    entry.sketch = std::move(sketch);
+    m_entries.push_back(std::move(entry));
+    const int id = static_cast<int>(m_entries.size()) - 1;
+    for (int band = 0; band < m_params.bands; ++band) {
+        m_buckets[band][bandKey(m_entries[id].sketch.signature, band)].push_back(id);
+    }
+}
+
+void RouteSimilarityIndex::rebuildBuckets() {
+    m_buckets.assign(m_params.bands, std::unordered_map<quint64, std::vector<int>>());
+    for (size_t id = 0; id < m_entries.size(); ++id) {
+        for (int band = 0; band < m_params.bands; ++band) {
+            m_buckets[band][bandKey(m_entries[id].sketch.signature, band)].push_back(static_cast<int>(id));
+        }
+    }
+}
+
+int RouteSimilarityIndex::update(const QStringList& files) {
+    struct Job {
+        QString file;
+        qint64 fileSize;
+        qint64 modified;
+        RouteSketch sketch;
+    };
+
+    std::unordered_map<std::string, const Entry*> current;
+    for (const Entry& entry : m_entries) {
+        current[entry.file.toStdString()] = &entry;
+    }
+
+    std::vector<Entry> kept;
+    std::vector<Job> jobs;
+    for (const QString& file : files) {
+        QFileInfo info(file);
+        const qint64 size = info.size();
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        auto found = current.find(file.toStdString());
+        if (found != current.end() && found->second->fileSize == size && found->second->modified == modified) {
+            kept.push_back(*found->second);
+        } else {
+            jobs.push_back(Job{file, size, modified, RouteSketch()});
+        }
+    }
+
+    QtConcurrent::blockingMap(jobs, [this](Job& job) {
+        GPXParser parser;
+        if (parser.parse(job.file)) {
+            job.sketch = sketch(parser.getPoints());
+        }
+    });
+
+    m_entries = std::move(kept);
+    for (Job& job : jobs) {
+        if (!job.sketch.isEmpty()) {
+            Entry entry;
+            entry.file = job.file;
+            entry.fileSize = job.fileSize;
+            entry.modified = job.modified;
+            entry.sketch = std::move(job.sketch);
+            m_entries.push_back(std::move(entry));
+        }
+    }
+    rebuildBuckets();
+    logInfo("RouteSimilarity", QString("Indexed %1 routes, %2 sketched").arg(m_entries.size()).arg(jobs.size()));
+    return static_cast<int>(jobs.size());
+}
+
+std::vector<int> RouteSimilarityIndex::candidates(const RouteSketch& sketch) const {
+    std::vector<int> result;
+    if (static_cast<int>(sketch.signature.size()) != m_params.signatureSize()) {
+        return result;
+    }
+    for (int band = 0; band < m_params.bands; ++band) {
+        auto bucket = m_buckets[band].find(bandKey(sketch.signature, band));
+        if (bucket != m_buckets[band].end()) {
+            result.insert(result.end(), bucket->second.begin(), bucket->second.end());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+size_t RouteSimilarityIndex::candidateCount(const RouteSketch& sketch) const {
+    return candidates(sketch).size();
+}
+
+std::vector<RouteMatch> RouteSimilarityIndex::query(const RouteSketch& sketch, int maxResults, double minSimilarity) const {
+    std::vector<RouteMatch> matches;
+    for (int id : candidates(sketch)) {
+        const std::vector<quint64>& cells = m_entries[id].sketch.cells;
+        const double similarity = jaccard(sketch.cells, cells);
+        if (similarity < minSimilarity) {
+            continue;
+        }
+        // |A ∩ B| = J (|A| + |B|) / (1 + J)
+        const double shared = similarity * (sketch.cells.size() + cells.size()) / (1.0 + similarity);
+        RouteMatch match;
+        match.file = m_entries[id].file;
+        match.similarity = similarity;
+        match.coverage = shared / sketch.cells.size();
+        matches.push_back(match);
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const RouteMatch& a, const RouteMatch& b) {
+        return a.similarity > b.similarity;
+    });
+    if (maxResults >= 0 && matches.size() > static_cast<size_t>(maxResults)) {
+        matches.resize(maxResults);
+    }
+    return matches;
+}
+
+double RouteSimilarityIndex::jaccard(const std::vector<quint64>& a, const std::vector<quint64>& b) {
+    if (a.empty() && b.empty()) {
+        return 0.0;
+    }
+    size_t shared = 0;
+    auto i = a.begin();
+    auto j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        if (*i < *j) {
+            ++i;
+        } else if (*j < *i) {
+            ++j;
+        } else {
+            ++shared;
+            ++i;
+            ++j;
+        }
+    }
+    return static_cast<double>(shared) / (a.size() + b.size() - shared);
+}
+
+bool RouteSimilarityIndex::save(const QString& filename) const {
+    QDir().mkpath(QFileInfo(filename).absolutePath());
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logWarning("RouteSimilarity", QString("Cannot write index %1").arg(filename));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << INDEX_MAGIC << INDEX_VERSION << m_params.cellSize << qint32(m_params.bands) << qint32(m_params.rowsPerBand)
+        << quint64(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        out << entry.file << entry.fileSize << entry.modified << quint64(entry.sketch.cells.size());
+        for (quint64 cell : entry.sketch.cells) {
+            out << cell;
+        }
+        for (quint64 value : entry.sketch.signature) {
+            out << value;
+        }
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+bool RouteSimilarityIndex::load(const QString& filename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    double cellSize = 0.0;
+    qint32 bands = 0, rows = 0;
+    quint64 count = 0;
+    in >> magic >> version >> cellSize >> bands >> rows >> count;
+    if (in.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION ||
+        cellSize != m_params.cellSize || bands != m_params.bands || rows != m_params.rowsPerBand) {
+        return false;
+    }
+
+    // Counts are bounded by the file size before allocating, so a damaged index is just a miss
+    const quint64 maxValues = static_cast<quint64>(file.size()) / sizeof(quint64);
+    std::vector<Entry> entries;
+    for (quint64 k = 0; k < count && k < maxValues; ++k) {
+        Entry entry;
+        quint64 cellCount = 0;
+        in >> entry.file >> entry.fileSize >> entry.modified >> cellCount;
+        if (in.status() != QDataStream::Ok || cellCount > maxValues) {
+            return false;
+        }
+        entry.sketch.cells.resize(cellCount);
+        for (quint64& cell : entry.sketch.cells) {
+            in >> cell;
+        }
+        entry.sketch.signature.resize(m_params.signatureSize());
+        for (quint64& value : entry.sketch.signature) {
+            in >> value;
+        }
+        if (in.status() != QDataStream::Ok) {
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    if (entries.size() != count) {
+        return false;
+    }
+
+    m_entries = std::move(entries);
+    rebuildBuckets();
+    return true;
+}
@@ -0,0 +1,287 @@
+#include "SegmentMatcher.h"
+#include "SpatialHash.h"
+#include "logging.h"
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    using SpatialHash::METERS_PER_DEGREE;
+    const double PATH_SAMPLE_SPACING = 10.0;    // Segment path resolution (m)
+
+    // Equirectangular distance, accurate to well under a meter over a few hundred meters
+    double metersBetween(double lat1, double lon1, double lat2, double lon2) {
+        const double dy = (lat2 - lat1) * METERS_PER_DEGREE;
+        const double dx = (lon2 - lon1) * METERS_PER_DEGREE * std::cos((lat1 + lat2) * 0.5 * M_PI / 180.0);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // Run of consecutive point indices of one track near the start or end, reduced to its closest point
+    struct Pass {
+        size_t index;
+        bool isStart;
+    };
+
+    void collectPasses(std::vector<std::pair<size_t, double>>& near, bool isStart, std::vector<Pass>& passes) {
+        std::sort(near.begin(), near.end());
+        size_t runStart = 0;
+        for (size_t i = 1; i <= near.size(); ++i) {
+            if (i == near.size() || near[i].first != near[i - 1].first + 1) {
+                auto closest = std::min_element(near.begin() + runStart, near.begin() + i,
+                    [](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) {
+                        return a.second < b.second;
+                    });
+                passes.push_back(Pass{closest->first, isStart});
+                runStart = i;
+            }
+        }
+    }
+}
+
+SegmentDefinition SegmentDefinition::fromTrack(const std::vector<TrackPoint>& points, size_t startIndex, size_t endIndex) {
+    SegmentDefinition segment;
+    if (endIndex >= points.size() || startIndex >= endIndex) {
+        return segment;
+    }
+
+    segment.length = points[endIndex].distance - points[startIndex].distance;
+    segment.path.push_back(points[startIndex].coord);
+    double next = points[startIndex].distance + PATH_SAMPLE_SPACING;
+    for (size_t i = startIndex + 1; i <= endIndex; ++i) {
+        const TrackPoint& a = points[i - 1];
+        const TrackPoint& b = points[i];
+        while (next < b.distance && b.distance > a.distance) {
+            const double t = (next - a.distance) / (b.distance - a.distance);
+            segment.path.push_back(QGeoCoordinate(a.coord.latitude() + (b.coord.latitude() - a.coord.latitude()) * t,
+                                                  a.coord.longitude() + (b.coord.longitude() - a.coord.longitude()) * t));
+            next += PATH_SAMPLE_SPACING;
+        }
+    }
+    segment.path.push_back(points[endIndex].coord);
+    return segment;
+}
+
+SegmentIndex::SegmentIndex(double cellSize)
+    : m_cellSize(cellSize)
+{
+}
+
+quint64 SegmentIndex::cellOf(double latitude, double longitude) const {
+    return SpatialHash::cellKey(latitude, longitude, m_cellSize);
+}
+
+int SegmentIndex::addTrack(const QString& file, const std::vector<TrackPoint>& points) {
+    Track track;
+    track.file = file;
+    track.latitude.reserve(points.size());
+    track.longitude.reserve(points.size());
+    track.distance.reserve(points.size());
+    track.timestampMs.reserve(points.size());
+    for (const TrackPoint& point : points) {
+        track.latitude.push_back(point.coord.latitude());
+        track.longitude.push_back(point.coord.longitude());
+        track.distance.push_back(point.distance);
+        track.timestampMs.push_back(point.timestamp.isValid() ? point.timestamp.toMSecsSinceEpoch() : 0);
+    }
+
+    const qint32 id = static_cast<qint32>(m_tracks.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].coord.isValid()) {
+            m_cells.push_back(PointRef{cellOf(track.latitude[i], track.longitude[i]), id, static_cast<qint32>(i)});
+        }
+    }
+    m_tracks.push_back(std::move(track));
+    m_built = false;
+    return id;
+}
+
+int SegmentIndex::addFiles(const QStringList& files) {
+    struct Job {
+        QString file;
+        std::vector<TrackPoint> points;
+    };
+
+    // Parse in batches, so only a bounded number of full point lists is alive at a time
+    const int batchSize = std::max(QThreadPool::globalInstance()->maxThreadCount() * 4, 16);
+    int added = 0;
+    for (int first = 0; first < files.size(); first += batchSize) {
+        std::vector<Job> jobs;
+        for (int i = first; i < std::min(first + batchSize, static_cast<int>(files.size())); ++i) {
+            jobs.push_back(Job{files[i], std::vector<TrackPoint>()});
+        }
+        QtConcurrent::blockingMap(jobs, [](Job& job) {
+            GPXParser parser;
+            if (parser.parse(job.file)) {
+                job.points = parser.getPoints();
+            }
+        });
+        for (const Job& job : jobs) {
+            if (job.points.size() >= 2) {
+                addTrack(job.file, job.points);
+                ++added;
+            }
+        }
+    }
+    return added;
+}
+
+void SegmentIndex::build() {
+    std::sort(m_cells.begin(), m_cells.end(), [](const PointRef& a, const PointRef& b) {
+        return a.cell < b.cell;
+    });
+    m_built = true;
+}
+
+std::vector<SegmentIndex::PointRef> SegmentIndex::pointsNear(const QGeoCoordinate& coord, double radius) const {
+    std::vector<PointRef> result;
+    const double rowHeight = m_cellSize / METERS_PER_DEGREE;
+    const double latRadius = radius / METERS_PER_DEGREE;
+    const double lonRadius = latRadius / std::max(std::cos(coord.latitude() * M_PI / 180.0), 1e-6);
+
+    // Visit every cell overlapping the radius' bounding box
+    const qint64 firstRow = static_cast<qint64>(std::floor((coord.latitude() - latRadius) / rowHeight));
+    const qint64 lastRow = static_cast<qint64>(std::floor((coord.latitude() + latRadius) / rowHeight));
+    for (qint64 row = firstRow; row <= lastRow; ++row) {
+        const double rowLatitude = (row + 0.5) * rowHeight;
+        const double columnWidth = rowHeight / std::max(std::cos(rowLatitude * M_PI / 180.0), 1e-6);
+        const qint64 firstColumn = static_cast<qint64>(std::floor((coord.longitude() - lonRadius) / columnWidth));
+        const qint64 lastColumn = static_cast<qint64>(std::floor((coord.longitude() + lonRadius) / columnWidth));
+        for (qint64 column = firstColumn; column <= lastColumn; ++column) {
+            const quint64 cell = (static_cast<quint64>(static_cast<quint32>(row)) << 32) | static_cast<quint32>(column);
+            auto range = std::equal_range(m_cells.begin(), m_cells.end(), PointRef{cell, 0, 0},
+                                          [](const PointRef& a, const PointRef& b) { return a.cell < b.cell; });
+            for (auto it = range.first; it != range.second; ++it) {
+                const Track& track = m_tracks[it->track];
+                if (metersBetween(coord.latitude(), coord.longitude(),
+                                  track.latitude[it->index], track.longitude[it->index]) <= radius) {
+                    result.push_back(*it);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<SegmentEffort> SegmentIndex::find(const SegmentDefinition& segment, const SegmentMatchParams& params) const {
+    std::vector<SegmentEffort> efforts;
+    if (segment.isEmpty() || !m_built) {
+        return efforts;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Passes near the start and end, grouped by track
+    const QGeoCoordinate& startCoord = segment.path.front();
+    const QGeoCoordinate& endCoord = segment.path.back();
+    std::vector<PointRef> nearStart = pointsNear(startCoord, params.passRadius);
+    std::vector<PointRef> nearEnd = pointsNear(endCoord, params.passRadius);
+    auto byTrack = [](const PointRef& a, const PointRef& b) { return a.track < b.track; };
+    std::sort(nearStart.begin(), nearStart.end(), byTrack);
+    std::sort(nearEnd.begin(), nearEnd.end(), byTrack);
+
+    auto endIt = nearEnd.begin();
+    for (auto startIt = nearStart.begin(); startIt != nearStart.end();) {
+        const qint32 id = startIt->track;
+        auto startRun = std::equal_range(startIt, nearStart.end(), *startIt, byTrack);
+        endIt = std::lower_bound(endIt, nearEnd.end(), *startIt, byTrack);
+        auto endRun = std::equal_range(endIt, nearEnd.end(), *startIt, byTrack);
+        startIt = startRun.second;
+        if (endRun.first == endRun.second) {
+            continue;
+        }
+
+        const Track& track = m_tracks[id];
+        std::vector<std::pair<size_t, double>> starts, ends;
+        for (auto it = startRun.first; it != startRun.second; ++it) {
+            starts.emplace_back(it->index, metersBetween(startCoord.latitude(), startCoord.longitude(),
+                                                         track.latitude[it->index], track.longitude[it->index]));
+        }
+        for (auto it = endRun.first; it != endRun.second; ++it) {
+            ends.emplace_back(it->index, metersBetween(endCoord.latitude(), endCoord.longitude(),
+                                                       track.latitude[it->index], track.longitude[it->index]));
+        }
+        std::vector<Pass> passes;
+        collectPasses(starts, true, passes);
+        collectPasses(ends, false, passes);
+        std::sort(passes.begin(), passes.end(), [](const Pass& a, const Pass& b) { return a.index < b.index; });
+
+        // Pair every end pass with the latest start pass before it; passing the end
+        // before the start (riding the segment backwards) never forms a pair
+        bool hasStart = false;
+        size_t start = 0;
+        for (const Pass& pass : passes) {
+            if (pass.isStart) {
+                hasStart = true;
+                start = pass.index;
+            } else if (hasStart && pass.index > start) {
+                SegmentEffort effort;
+                if (matchEffort(track, start, pass.index, segment, params, effort)) {
+                    effort.track = id;
+                    efforts.push_back(effort);
+                    hasStart = false;
+                }
+            }
+        }
+    }
+
+    std::sort(efforts.begin(), efforts.end(), [](const SegmentEffort& a, const SegmentEffort& b) {
+        if (std::isnan(a.elapsedTime) != std::isnan(b.elapsedTime)) {
+            return std::isnan(b.elapsedTime);
+        }
+        return a.elapsedTime < b.elapsedTime;
+    });
+    logDebug("SegmentMatcher", QString("Found %1 efforts from %2 start and %3 end points in %4 ms")
+             .arg(efforts.size()).arg(nearStart.size()).arg(nearEnd.size()).arg(timer.elapsed()));
+    return efforts;
+}
+
+bool SegmentIndex::matchEffort(const Track& track, size_t start, size_t end, const SegmentDefinition& segment,
+                               const SegmentMatchParams& params, SegmentEffort& effort) const {
+    const double distance = track.distance[end] - track.distance[start];
+    if (distance > segment.length * params.maxLengthRatio || distance * params.maxLengthRatio < segment.length) {
+        return false;
+    }
+
+    // Walk the path samples in order with a cursor that only moves forward, so the track must
+    // follow the path in the same direction. A sample is passed when the track comes within
+    // the tolerance before it is expected to be too far along; a missed sample leaves the
+    // cursor in place for the next one.
+    const double sampleSpacing = segment.length / (segment.path.size() - 1);
+    size_t cursor = start;
+    size_t passed = 0;
+    for (size_t k = 0; k < segment.path.size(); ++k) {
+        const QGeoCoordinate& sample = segment.path[k];
+        const double horizon = track.distance[start] + (k * sampleSpacing) * params.maxLengthRatio + params.pathTolerance;
+        for (size_t i = cursor; i <= end && track.distance[i] <= horizon; ++i) {
+            if (metersBetween(sample.latitude(), sample.longitude(), track.latitude[i], track.longitude[i])
+                <= params.pathTolerance) {
+                cursor = i;
+                ++passed;
+                break;
+            }
+        }
+    }
+
+    const double fidelity = static_cast<double>(passed) / segment.path.size();
+    if (fidelity < params.minPathFidelity) {
+        return false;
+    }
+
+    effort.file = track.file;
+    effort.startIndex = start;
+    effort.endIndex = end;
+    effort.distance = distance;
+    effort.pathFidelity = fidelity;
+    const qint64 startMs = track.timestampMs[start];
+    const qint64 endMs = track.timestampMs[end];
+    effort.elapsedTime = (startMs != 0 && endMs != 0) ? (endMs - startMs) / 1000.0
+                                                       : std::numeric_limits<double>::quiet_NaN();
+    if (startMs != 0) {
+        effort.startTime = QDateTime::fromMSecsSinceEpoch(startMs);
+    }
+    return true;
+}
@@ -19,12 +19,13 @@ namespace {
 }
 
 TerrainService::TerrainService(QObject* parent)
-    : QObject(parent), m_networkManager(new QNetworkAccessManager(this)), m_gridWidth(0), m_gridHeight(0)
+    : QObject(parent), m_networkManager(new QNetworkAccessManager(this)), m_gridWidth(0), m_gridHeight(0), m_generation(0)
 {
 }
 
 void TerrainService::fetchTerrainData(double northLat, double southLat, double westLon, double eastLon, int width, int height)
 {
+    ++m_generation;
     m_terrainData = TerrainData();
     m_terrainData.topLeft = QGeoCoordinate(northLat, westLon);
     m_terrainData.bottomRight = QGeoCoordinate(southLat, eastLon);
@@ -67,6 +68,7 @@ void TerrainService::fetchElevationData(double northLat, double southLat, double
 
     QNetworkRequest request(url);
     QNetworkReply* reply = m_networkManager->get(request);
+    reply->setProperty("generation", m_generation);
     connect(reply, &QNetworkReply::finished, this, &TerrainService::handleElevationReply);
 }
 
@@ -88,6 +90,7 @@ void TerrainService::fetchSatelliteImage(double northLat, double southLat, doubl
 
     QNetworkRequest request(url);
     QNetworkReply* reply = m_networkManager->get(request);
+    reply->setProperty("generation", m_generation);
     connect(reply, &QNetworkReply::finished, this, &TerrainService::handleSatelliteImageReply);
 }
 
@@ -96,6 +99,12 @@ void TerrainService::handleElevationReply()
     QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
     if (!reply) return;
 
+    // Still in flight when the next area was requested, e.g. for the previous track
+    if (reply->property("generation").toInt() != m_generation) {
+        reply->deleteLater();
+        return;
+    }
+
     if (reply->error()) {
         emit error("Elevation data request failed: " + reply->errorString());
         reply->deleteLater();
@@ -131,6 +140,12 @@ void TerrainService::handleSatelliteImageReply()
     QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
     if (!reply) return;
 
+    // Still in flight when the next area was requested, e.g. for the previous track
+    if (reply->property("generation").toInt() != m_generation) {
+        reply->deleteLater();
+        return;
+    }
+
     if (reply->error()) {
         emit error("Satellite image request failed: " + reply->errorString());
         reply->deleteLater();
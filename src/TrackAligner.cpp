@@ -0,0 +1,250 @@
+#include "TrackAligner.h"
+#include "SpatialHash.h"
+#include "logging.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRACK_ALIGNER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    using SpatialHash::METERS_PER_DEGREE;
+    const double INF = std::numeric_limits<double>::infinity();
+
+    // Steps into a cell, stored per band cell for the backtrack
+    enum Step : unsigned char { Diagonal = 0, Up = 1, Left = 2 };
+
+    // Positions in meters on a plane tangent at the reference start
+    struct Plane {
+        std::vector<double> x;
+        std::vector<double> y;
+    };
+
+    Plane project(const std::vector<TrackPoint>& points, const QGeoCoordinate& origin) {
+        const double lonScale = METERS_PER_DEGREE * std::cos(origin.latitude() * M_PI / 180.0);
+        Plane plane;
+        plane.x.reserve(points.size());
+        plane.y.reserve(points.size());
+        for (const TrackPoint& point : points) {
+            plane.x.push_back((point.coord.longitude() - origin.longitude()) * lonScale);
+            plane.y.push_back((point.coord.latitude() - origin.latitude()) * METERS_PER_DEGREE);
+        }
+        return plane;
+    }
+
+    // Local cost plus the cheaper of the diagonal and upper predecessor, for columns [lo, hi].
+    // previous/current are indexed by column + 1, so column -1 is a valid (infinite) slot.
+    void rowScalar(double ax, double ay, const Plane& b, size_t lo, size_t hi,
+                   const double* previous, double* cost, double* partial, unsigned char* steps) {
+        for (size_t j = lo; j <= hi; ++j) {
+            const double dx = b.x[j] - ax;
+            const double dy = b.y[j] - ay;
+            const double c = std::sqrt(dx * dx + dy * dy);
+            const double diagonal = previous[j];
+            const double up = previous[j + 1];
+            cost[j - lo] = c;
+            if (diagonal <= up) {
+                partial[j - lo] = c + diagonal;
+                steps[j - lo] = Diagonal;
+            } else {
+                partial[j - lo] = c + up;
+                steps[j - lo] = Up;
+            }
+        }
+    }
+
+#ifdef TRACK_ALIGNER_SSE2
+    void rowSse2(double ax, double ay, const Plane& b, size_t lo, size_t hi,
+                 const double* previous, double* cost, double* partial, unsigned char* steps) {
+        const __m128d vax = _mm_set1_pd(ax);
+        const __m128d vay = _mm_set1_pd(ay);
+        size_t j = lo;
+        for (; j + 1 <= hi; j += 2) {
+            const __m128d dx = _mm_sub_pd(_mm_loadu_pd(&b.x[j]), vax);
+            const __m128d dy = _mm_sub_pd(_mm_loadu_pd(&b.y[j]), vay);
+            const __m128d c = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+            const __m128d diagonal = _mm_loadu_pd(previous + j);
+            const __m128d up = _mm_loadu_pd(previous + j + 1);
+            // Same tie-break as the scalar loop: the diagonal wins when equal
+            const int upWins = _mm_movemask_pd(_mm_cmpgt_pd(diagonal, up));
+            _mm_storeu_pd(cost + (j - lo), c);
+            _mm_storeu_pd(partial + (j - lo), _mm_add_pd(c, _mm_min_pd(diagonal, up)));
+            steps[j - lo] = (upWins & 1) ? Up : Diagonal;
+            steps[j - lo + 1] = (upWins & 2) ? Up : Diagonal;
+        }
+        if (j <= hi) {
+            rowScalar(ax, ay, b, j, hi, previous, cost + (j - lo), partial + (j - lo), steps + (j - lo));
+        }
+    }
+#endif
+}
+
+TrackAligner::TrackAligner(const AlignmentParams& params)
+    : m_params(params)
+{
+}
+
+bool TrackAligner::simdAvailable() {
+#ifdef TRACK_ALIGNER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+TrackAlignment TrackAligner::align(const std::vector<TrackPoint>& reference, const std::vector<TrackPoint>& other) const {
+    TrackAlignment result;
+    const size_t n = reference.size();
+    const size_t m = other.size();
+    if (n < 2 || m < 2) {
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const Plane a = project(reference, reference.front().coord);
+    const Plane b = project(other, reference.front().coord);
+
+    // Band rows: centered on the point of the other track at the same share of its distance,
+    // widened where needed so every row connects to the previous one
+    const double aStart = reference.front().distance;
+    const double aLength = reference.back().distance - aStart;
+    const double bStart = other.front().distance;
+    const double bLength = other.back().distance - bStart;
+    const size_t radius = static_cast<size_t>(std::max(m_params.bandRadius, 1));
+    std::vector<size_t> lo(n), hi(n), offsets(n + 1, 0);
+    size_t center = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (aLength > 0.0 && bLength > 0.0) {
+            const double target = bStart + (reference[i].distance - aStart) / aLength * bLength;
+            while (center + 1 < m && other[center + 1].distance <= target) {
+                ++center;
+            }
+            if (center + 1 < m && target - other[center].distance > other[center + 1].distance - target) {
+                ++center;
+            }
+        } else {
+            center = i * (m - 1) / (n - 1);
+        }
+        lo[i] = center > radius ? center - radius : 0;
+        hi[i] = std::min(center + radius, m - 1);
+        if (i > 0) {
+            lo[i] = std::max(lo[i - 1], std::min(lo[i], hi[i - 1] + 1));
+            hi[i] = std::max(hi[i], lo[i]);
+        }
+    }
+    lo[0] = 0;
+    hi[n - 1] = m - 1;
+    for (size_t i = 0; i < n; ++i) {
+        offsets[i + 1] = offsets[i] + (hi[i] - lo[i] + 1);
+    }
+
+    // Two full-width rows (shifted by one so column -1 exists) hold the accumulated costs;
+    // only the slots a row can read outside its predecessor's band are reset to infinity
+    std::vector<unsigned char> steps(offsets[n]);
+    std::vector<double> previous(m + 1, INF), current(m + 1, INF);
+    std::vector<double> cost(m), partial(m);
+    const bool simd = m_params.useSimd && simdAvailable();
+
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char* rowSteps = steps.data() + offsets[i];
+        if (i == 0) {
+            // First row: only left steps, starting from the corner
+            double accumulated = 0.0;
+            for (size_t j = 0; j <= hi[0]; ++j) {
+                const double dx = b.x[j] - a.x[0];
+                const double dy = b.y[j] - a.y[0];
+                accumulated += std::sqrt(dx * dx + dy * dy);
+                current[j + 1] = accumulated;
+                rowSteps[j] = Left;
+            }
+        } else {
+#ifdef TRACK_ALIGNER_SSE2
+            if (simd) {
+                rowSse2(a.x[i], a.y[i], b, lo[i], hi[i], previous.data(), cost.data(), partial.data(), rowSteps);
+            } else
+#endif
+            {
+                rowScalar(a.x[i], a.y[i], b, lo[i], hi[i], previous.data(), cost.data(), partial.data(), rowSteps);
+            }
+
+            // Left steps depend on the cell just computed, so this pass stays serial
+            double left = INF;
+            for (size_t j = lo[i]; j <= hi[i]; ++j) {
+                const size_t k = j - lo[i];
+                double value = partial[k];
+                if (left + cost[k] < value) {
+                    value = left + cost[k];
+                    rowSteps[k] = Left;
+                }
+                current[j + 1] = value;
+                left = value;
+            }
+        }
+
+        // Cells the next row may read that this row did not write
+        current[lo[i]] = INF;
+        if (i + 1 < n) {
+            for (size_t j = hi[i] + 1; j <= hi[i + 1]; ++j) {
+                current[j + 1] = INF;
+            }
+        }
+        std::swap(previous, current);
+    }
+    result.cost = previous[m];
+    result.cellCount = offsets[n];
+
+    // Backtrack from the end corner
+    size_t i = n - 1;
+    size_t j = m - 1;
+    result.path.push_back(std::make_pair(i, j));
+    while (i > 0 || j > 0) {
+        const unsigned char step = steps[offsets[i] + (j - lo[i])];
+        if (i == 0 || step == Left) {
+            --j;
+        } else if (step == Up) {
+            --i;
+        } else {
+            --i;
+            --j;
+        }
+        result.path.push_back(std::make_pair(i, j));
+    }
+    std::reverse(result.path.begin(), result.path.end());
+
+    // One aligned point per reference point: the middle of the run of matches it received
+    const bool timed = reference.front().timestamp.isValid() && other.front().timestamp.isValid();
+    result.points.resize(n);
+    size_t first = 0;
+    while (first < result.path.size()) {
+        size_t last = first;
+        while (last + 1 < result.path.size() && result.path[last + 1].first == result.path[first].first) {
+            ++last;
+        }
+        const size_t ri = result.path[first].first;
+        const size_t oi = result.path[(first + last) / 2].second;
+        AlignedPoint& point = result.points[ri];
+        point.index = ri;
+        point.otherIndex = oi;
+        point.distance = reference[ri].distance;
+        point.elevationDelta = other[oi].elevation - reference[ri].elevation;
+        point.offset = std::hypot(b.x[oi] - a.x[ri], b.y[oi] - a.y[ri]);
+        if (timed && reference[ri].timestamp.isValid() && other[oi].timestamp.isValid()) {
+            const qint64 referenceMs = reference.front().timestamp.msecsTo(reference[ri].timestamp);
+            const qint64 otherMs = other.front().timestamp.msecsTo(other[oi].timestamp);
+            point.timeGap = (otherMs - referenceMs) / 1000.0;
+        } else {
+            point.timeGap = std::numeric_limits<double>::quiet_NaN();
+        }
+        first = last + 1;
+    }
+
+    logDebug("TrackAligner", QString("Aligned %1 x %2 points over %3 band cells in %4 ms (%5)")
+             .arg(n).arg(m).arg(result.cellCount).arg(timer.elapsed()).arg(simd ? "SSE2" : "scalar"));
+    return result;
+}
@@ -0,0 +1,642 @@
+#include "TrackAnalyzer.h"
+#include "logging.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Run func(begin, end) over [0, count) on the global thread pool, split into one
+// piece per chunkSize units of totalWork. Small inputs run inline on the caller.
+template <typename Func>
+void forEachChunk(size_t chunkSize, size_t totalWork, size_t count, Func func) {
+    if (chunkSize == 0 || totalWork < 2 * chunkSize || count < 2) {
+        func(0, count);
+        return;
+    }
+    
+    size_t pieces = std::min(count, totalWork / chunkSize);
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t piece = 0; piece < pieces; ++piece) {
+        ranges.emplace_back(count * piece / pieces, count * (piece + 1) / pieces);
+    }
+    QtConcurrent::blockingMap(ranges, [&func](const std::pair<size_t, size_t>& range) {
+        func(range.first, range.second);
+    });
+}
+
+template <typename Func>
+void forEachChunk(size_t chunkSize, size_t count, Func func) {
+    forEachChunk(chunkSize, count, count, func);
+}
+
+} // namespace
+
+const size_t TrackAnalyzer::DEFAULT_CHUNK_SIZE;
+const int TrackAnalyzer::MAX_LEVELS;
+
+SegmentationParams SegmentationParams::coarser() const {
+    // Each level roughly quadruples the shortest segment it keeps apart
+    SegmentationParams params = *this;
+    params.similarGradientThreshold += 2.0;
+    params.tinySegmentThreshold *= 4.0;
+    params.smallSegmentThreshold *= 4.0;
+    return params;
+}
+
+TrackAnalysisResult::TrackAnalysisResult(size_t pointCount, std::vector<TrackSegment> segments)
+    : TrackAnalysisResult(pointCount, std::vector<std::vector<TrackSegment>>(1, std::move(segments)),
+                          std::vector<double>(1, SegmentationParams().tinySegmentThreshold))
+{
+}
+
+TrackAnalysisResult::TrackAnalysisResult(size_t pointCount, std::vector<std::vector<TrackSegment>> levels,
+                                         std::vector<double> levelResolutions, std::vector<Climb> climbs)
+    : m_pointCount(pointCount),
+      m_levels(std::move(levels)),
+      m_levelResolutions(std::move(levelResolutions)),
+      m_climbs(std::move(climbs))
+{
+    // Summary figures describe the detailed level
+    for (const auto& segment : segments()) {
+        switch (segment.type) {
+            case TrackSegment::CLIMB:
+                m_uphillDistance += segment.distance;
+                m_steepestUphill = std::max(m_steepestUphill, segment.maxGradient);
+                break;
+            case TrackSegment::DESCENT:
+                m_downhillDistance += segment.distance;
+                m_steepestDownhill = std::min(m_steepestDownhill, segment.minGradient);
+                break;
+            case TrackSegment::FLAT:
+                m_flatDistance += segment.distance;
+                break;
+        }
+    }
+}
+
+double TrackAnalysisResult::percentOf(double distance) const {
+    double total = m_uphillDistance + m_downhillDistance + m_flatDistance;
+    return (total > 0) ? (distance / total) * 100.0 : 0.0;
+}
+
+const std::vector<TrackSegment>& TrackAnalysisResult::segmentsAtLevel(int level) const {
+    static const std::vector<TrackSegment> empty;
+    if (level < 0 || level >= levelCount()) {
+        return empty;
+    }
+    return m_levels[level];
+}
+
+double TrackAnalysisResult::levelResolution(int level) const {
+    if (level < 0 || level >= static_cast<int>(m_levelResolutions.size())) {
+        return 0.0;
+    }
+    return m_levelResolutions[level];
+}
+
+int TrackAnalysisResult::levelForResolution(double meters) const {
+    for (int level = 0; level < levelCount(); ++level) {
+        if (levelResolution(level) >= meters) {
+            return level;
+        }
+    }
+    return std::max(0, levelCount() - 1);
+}
+
+double TrackAnalysisResult::uphillPercent() const {
+    return percentOf(m_uphillDistance);
+}
+
+double TrackAnalysisResult::downhillPercent() const {
+    return percentOf(m_downhillDistance);
+}
+
+double TrackAnalysisResult::flatPercent() const {
+    return percentOf(m_flatDistance);
+}
+
+TrackAnalysisResult TrackAnalyzer::analyze(const std::vector<TrackPoint>& points) const {
+    QElapsedTimer timer;
+    timer.start();
+    logInfo("TrackAnalyzer", QString("Starting segment analysis with %1 points").arg(points.size()));
+    
+    if (points.size() < 2) {
+        logInfo("TrackAnalyzer", "Too few points for segment analysis, returning");
+        return TrackAnalysisResult(points.size(), std::vector<TrackSegment>());
+    }
+    
+    GradientProfile profile = prepare(points);
+    logDebug("TrackAnalyzer", QString("Smoothed gradients and %1 climbs prepared in %2 ms")
+             .arg(profile.climbs.size()).arg(timer.elapsed()));
+    
+    timer.restart();
+    TrackAnalysisResult result = segment(points, profile);
+    logInfo("TrackAnalyzer", QString("Finished analyzing %1 segments (%2 levels) and %3 climbs in %4 ms")
+            .arg(result.segments().size()).arg(result.levelCount())
+            .arg(result.climbs().size()).arg(timer.elapsed()));
+    return result;
+}
+
+GradientProfile TrackAnalyzer::prepare(const std::vector<TrackPoint>& points) const {
+    GradientProfile profile;
+    profile.smoothGradients = calculateSmoothedGradients(points);
+    profile.climbs = ClimbDetector(m_climbParams).detect(points);
+    return profile;
+}
+
+TrackAnalysisResult TrackAnalyzer::segment(const std::vector<TrackPoint>& points, const GradientProfile& profile) const {
+    if (points.size() < 2 || profile.smoothGradients.size() != points.size()) {
+        return TrackAnalysisResult(points.size(), std::vector<TrackSegment>());
+    }
+    
+    std::vector<size_t> segmentBoundaries = identifySegmentBoundaries(points, profile.smoothGradients);
+    std::vector<TrackSegment> rawSegments = createRawSegments(points, profile.smoothGradients, segmentBoundaries);
+    
+    std::vector<std::vector<TrackSegment>> levels;
+    std::vector<double> levelResolutions;
+    SegmentationParams params = m_params;
+    levels.push_back(optimizeSegments(rawSegments, points, params));
+    levelResolutions.push_back(params.tinySegmentThreshold);
+    
+    // Coarser levels merge the level below, so their segments nest
+    while (static_cast<int>(levels.size()) < MAX_LEVELS && levels.back().size() > 1) {
+        params = params.coarser();
+        std::vector<TrackSegment> coarse = optimizeSegments(levels.back(), points, params);
+        if (coarse.size() == levels.back().size()) {
+            break;
+        }
+        levels.push_back(std::move(coarse));
+        levelResolutions.push_back(params.tinySegmentThreshold);
+    }
+    
+    return TrackAnalysisResult(points.size(), std::move(levels), std::move(levelResolutions), profile.climbs);
+}
+
+std::vector<double> TrackAnalyzer::calculateSmoothedGradients(const std::vector<TrackPoint>& points) const {
+    
+    // Skip expensive smoothing for very large datasets
+    const int MAX_POINTS_FULL_SMOOTHING = 8000;
+    const int WINDOW_SIZE = points.size() > MAX_POINTS_FULL_SMOOTHING ? 7 : 15; 
+    
+    // Apply segment-aware smoothing to avoid blurring segment boundaries
+    std::vector<double> smoothedGradients(points.size());
+    
+    // Define a Gaussian-like kernel for smoothing
+    int halfWindow = WINDOW_SIZE / 2;
+    std::vector<double> kernel(WINDOW_SIZE);
+    double kernelSum = 0.0;
+    
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        double x = (i - halfWindow) / (halfWindow / 2.0);
+        kernel[i] = exp(-0.5 * x * x);
+        kernelSum += kernel[i];
+    }
+    
+    // Normalize kernel
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        kernel[i] /= kernelSum;
+    }
+    
+    // Apply the kernel to the pre-calculated GPXParser gradients. Every point only
+    // reads its neighbours, so ranges of points can be smoothed independently.
+    forEachChunk(m_chunkSize, points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double sum = 0.0;
+            double weightSum = 0.0;
+            
+            for (int j = -halfWindow; j <= halfWindow; j++) {
+                int idx = static_cast<int>(i) + j;
+                
+                if (idx >= 0 && idx < static_cast<int>(points.size())) {
+                    // If points are close in distance, apply the kernel weight
+                    if (j == 0 || 
+                        (idx > 0 && points[idx].distance - points[idx-1].distance < 100.0)) {
+                        double weight = kernel[j + halfWindow];
+                        sum += points[idx].gradient * weight;
+                        weightSum += weight;
+                    }
+                }
+            }
+            
+            smoothedGradients[i] = (weightSum > 0) ? (sum / weightSum) : points[i].gradient;
+        }
+    });
+    
+    return smoothedGradients;
+}
+
+namespace {
+
+const int STABILITY_WINDOW = 7; // Smaller window for quicker response
+const int STABLE_COUNT = STABILITY_WINDOW * 2 / 3;
+
+// Points scanned before a chunk seam so a speculative scan has settled when it reaches the seam
+const size_t BOUNDARY_CHUNK_OVERLAP = 4096;
+
+enum GradientType { FLAT, CLIMB, DESCENT, TYPE_COUNT };
+
+GradientType classifyGradient(double gradient, double flatThreshold) {
+    if (gradient > flatThreshold) {
+        return CLIMB;
+    } else if (gradient < -flatThreshold) {
+        return DESCENT;
+    }
+    return FLAT;
+}
+
+/**
+ * State machine behind identifySegmentBoundaries(), one point per step().
+ *
+ * Its state is the current segment type, the last boundary, the running gradient
+ * sum since that boundary and the types of the last STABILITY_WINDOW points. The
+ * window only depends on the data, so two scanners that agree on type and last
+ * boundary at the same point behave identically from there on.
+ */
+class BoundaryScanner {
+public:
+    // Scan from the start of the track
+    BoundaryScanner(const std::vector<TrackPoint>& points, const std::vector<double>& smoothGradients,
+                    const SegmentationParams& params)
+        : m_points(&points), m_gradients(&smoothGradients),
+          m_flatThreshold(params.flatThreshold), m_changeThreshold(params.changeThreshold),
+          m_minDistance(params.minBoundaryDistance)
+    {
+        m_type = points.size() > 1 ? classifyGradient(smoothGradients[1], m_flatThreshold) : FLAT;
+        std::fill(m_recentTypes, m_recentTypes + STABILITY_WINDOW, m_type);
+        m_typeCounts[m_type] = STABILITY_WINDOW;
+    }
+    
+    // Speculative scan that assumes a boundary at index (>= STABILITY_WINDOW)
+    BoundaryScanner(const std::vector<TrackPoint>& points, const std::vector<double>& smoothGradients,
+                    const SegmentationParams& params, size_t index)
+        : m_points(&points), m_gradients(&smoothGradients),
+          m_flatThreshold(params.flatThreshold), m_changeThreshold(params.changeThreshold),
+          m_minDistance(params.minBoundaryDistance), m_lastBoundary(index)
+    {
+        m_type = classifyGradient(smoothGradients[index], m_flatThreshold);
+        for (int k = 0; k < STABILITY_WINDOW; ++k) {
+            m_recentTypes[k] = classifyGradient(smoothGradients[index + 1 - STABILITY_WINDOW + k], m_flatThreshold);
+            ++m_typeCounts[m_recentTypes[k]];
+        }
+    }
+    
+    // Process point i (the scan must be at i); returns true if a boundary is placed at i
+    bool step(size_t i) {
+        const std::vector<double>& smoothGradients = *m_gradients;
+        m_segmentGradientSum += smoothGradients[i - 1];
+        
+        GradientType pointType = classifyGradient(smoothGradients[i], m_flatThreshold);
+        --m_typeCounts[m_recentTypes[m_ringPos]];
+        m_recentTypes[m_ringPos] = pointType;
+        ++m_typeCounts[pointType];
+        m_ringPos = (m_ringPos + 1) % STABILITY_WINDOW;
+        
+        // A stable change needs another type to hold a clear majority of the window
+        // (with more than half the window, that type is also the unique dominant one)
+        GradientType dominantType = m_type;
+        for (int type = 0; type < TYPE_COUNT; ++type) {
+            if (type != m_type && m_typeCounts[type] >= STABLE_COUNT) {
+                dominantType = static_cast<GradientType>(type);
+                break;
+            }
+        }
+        
+        if (dominantType == m_type || 
+            (*m_points)[i].distance - (*m_points)[m_lastBoundary].distance < m_minDistance) {
+            return false;
+        }
+        
+        double avgCurrentGradient = m_segmentGradientSum / (i - m_lastBoundary);
+        
+        // Sample potential new segment
+        double avgNewGradient = 0.0;
+        size_t sampleEnd = std::min(i + STABILITY_WINDOW, m_points->size());
+        for (size_t j = i; j < sampleEnd; j++) {
+            avgNewGradient += smoothGradients[j];
+        }
+        avgNewGradient /= (sampleEnd - i);
+        
+        // Only create a new segment if the gradient change is significant
+        if (std::abs(avgNewGradient - avgCurrentGradient) < m_changeThreshold) {
+            return false;
+        }
+        
+        m_lastBoundary = i;
+        m_type = dominantType;
+        m_segmentGradientSum = 0.0;
+        return true;
+    }
+    
+    GradientType type() const { return m_type; }
+    size_t lastBoundary() const { return m_lastBoundary; }
+    bool sameState(const BoundaryScanner& other) const {
+        return m_type == other.m_type && m_lastBoundary == other.m_lastBoundary;
+    }
+    
+private:
+    const std::vector<TrackPoint>* m_points;
+    const std::vector<double>* m_gradients;
+    double m_flatThreshold;
+    double m_changeThreshold;
+    double m_minDistance;
+    GradientType m_type = FLAT;
+    size_t m_lastBoundary = 0;
+    // Sum of the smoothed gradients since the last boundary, accumulated in index
+    // order so the average matches a straight loop over the segment
+    double m_segmentGradientSum = 0.0;
+    GradientType m_recentTypes[STABILITY_WINDOW];
+    int m_typeCounts[TYPE_COUNT] = {0, 0, 0};
+    int m_ringPos = 0;
+};
+
+// Result of scanning one chunk [begin, end) of the track
+struct BoundaryChunk {
+    size_t begin = 0;
+    size_t end = 0;
+    std::vector<size_t> boundaries;       // Boundaries placed inside the chunk
+    std::vector<GradientType> types;      // Segment type starting at each boundary
+    std::vector<BoundaryScanner> entry;   // Scanner state on reaching begin
+    std::vector<BoundaryScanner> exit;    // Scanner state after end - 1
+    
+    // Index into boundaries of a boundary at i with the given type, or -1
+    int find(size_t i, GradientType type) const {
+        auto it = std::lower_bound(boundaries.begin(), boundaries.end(), i);
+        if (it == boundaries.end() || *it != i || types[it - boundaries.begin()] != type) {
+            return -1;
+        }
+        return static_cast<int>(it - boundaries.begin());
+    }
+};
+
+} // namespace
+
+std::vector<size_t> TrackAnalyzer::identifySegmentBoundaries(
+    const std::vector<TrackPoint>& points, 
+    const std::vector<double>& smoothGradients) const
+{
+    std::vector<size_t> boundaries;
+    boundaries.push_back(0);
+    
+    BoundaryScanner scanner(points, smoothGradients, m_params);
+    
+    if (m_chunkSize == 0 || points.size() < 2 * m_chunkSize) {
+        for (size_t i = 1; i < points.size(); i++) {
+            if (scanner.step(i)) {
+                boundaries.push_back(i);
+            }
+        }
+    } else {
+        // Every chunk after the first is scanned speculatively in parallel, starting
+        // BOUNDARY_CHUNK_OVERLAP points early from an assumed boundary
+        std::vector<BoundaryChunk> chunks;
+        for (size_t begin = 1; begin < points.size(); begin += m_chunkSize) {
+            BoundaryChunk chunk;
+            chunk.begin = begin;
+            chunk.end = std::min(begin + m_chunkSize, points.size());
+            chunks.push_back(chunk);
+        }
+        
+        QtConcurrent::blockingMap(chunks, [&](BoundaryChunk& chunk) {
+            size_t i = 1;
+            BoundaryScanner chunkScanner = scanner;
+            if (chunk.begin > 1) {
+                size_t start = std::max(chunk.begin - std::min(chunk.begin, BOUNDARY_CHUNK_OVERLAP),
+                                        static_cast<size_t>(STABILITY_WINDOW));
+                chunkScanner = BoundaryScanner(points, smoothGradients, m_params, start);
+                for (i = start + 1; i < chunk.begin; i++) {
+                    chunkScanner.step(i);
+                }
+            }
+            chunk.entry.push_back(chunkScanner);
+            for (; i < chunk.end; i++) {
+                if (chunkScanner.step(i)) {
+                    chunk.boundaries.push_back(i);
+                    chunk.types.push_back(chunkScanner.type());
+                }
+            }
+            chunk.exit.push_back(chunkScanner);
+        });
+        
+        // Stitch: continue the exact scan into each chunk until it agrees with the
+        // speculative one, then take the rest of the chunk's boundaries as they are.
+        // The first chunk starts from the true initial state, so it is exact.
+        for (const BoundaryChunk& chunk : chunks) {
+            if (scanner.sameState(chunk.entry.front())) {
+                boundaries.insert(boundaries.end(), chunk.boundaries.begin(), chunk.boundaries.end());
+                scanner = chunk.exit.front();
+                continue;
+            }
+            
+            for (size_t i = chunk.begin; i < chunk.end; i++) {
+                if (!scanner.step(i)) {
+                    continue;
+                }
+                boundaries.push_back(i);
+                int match = chunk.find(i, scanner.type());
+                if (match >= 0) {
+                    boundaries.insert(boundaries.end(), chunk.boundaries.begin() + match + 1, chunk.boundaries.end());
+                    scanner = chunk.exit.front();
+                    break;
+                }
+            }
+        }
+    }
+    
+    // Always include the last point
+    if (boundaries.back() != points.size() - 1) {
+        boundaries.push_back(points.size() - 1);
+    }
+    
+    return boundaries;
+}
+
+std::vector<TrackSegment> TrackAnalyzer::createRawSegments(
+    const std::vector<TrackPoint>& points,
+    const std::vector<double>& smoothGradients,
+    const std::vector<size_t>& boundaries) const
+{
+    const double GRADIENT_THRESHOLD_FLAT = 1.0;
+    const size_t MIN_SEGMENT_POINTS = 5;
+    const double MIN_SEGMENT_DISTANCE = 402.336;
+    
+    if (boundaries.size() < 2) {
+        return std::vector<TrackSegment>();
+    }
+    
+    // Each boundary pair is independent; segments too short to keep are flagged and dropped afterwards
+    std::vector<TrackSegment> candidates(boundaries.size() - 1);
+    std::vector<char> keep(candidates.size(), 0);
+    
+    forEachChunk(m_chunkSize, points.size(), boundaries.size() - 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            size_t startIdx = boundaries[i];
+            size_t endIdx = boundaries[i+1];
+            
+            if (endIdx - startIdx < MIN_SEGMENT_POINTS) continue;
+            
+            double segmentDistance = points[endIdx].distance - points[startIdx].distance;
+            if (segmentDistance < MIN_SEGMENT_DISTANCE) continue;
+            
+            double segmentElevChange = points[endIdx].elevation - points[startIdx].elevation;
+            
+            double sumGradient = 0.0;
+            double maxGradient = -100.0;
+            double minGradient = 100.0;
+            
+            for (size_t j = startIdx; j <= endIdx; j++) {
+                sumGradient += smoothGradients[j];
+                maxGradient = std::max(maxGradient, smoothGradients[j]);
+                minGradient = std::min(minGradient, smoothGradients[j]);
+            }
+            
+            double avgGradient = sumGradient / (endIdx - startIdx + 1);
+            
+            TrackSegment::Type segmentType = TrackSegment::FLAT;
+            if (avgGradient > GRADIENT_THRESHOLD_FLAT) {
+                segmentType = TrackSegment::CLIMB;
+            } else if (avgGradient < -GRADIENT_THRESHOLD_FLAT) {
+                segmentType = TrackSegment::DESCENT;
+            }
+            
+            TrackSegment& segment = candidates[i];
+            segment.type = segmentType;
+            segment.startIndex = startIdx;
+            segment.endIndex = endIdx;
+            segment.distance = segmentDistance;
+            segment.elevationChange = segmentElevChange;
+            segment.avgGradient = avgGradient;
+            segment.maxGradient = maxGradient;
+            segment.minGradient = minGradient;
+            keep[i] = 1;
+        }
+    });
+    
+    std::vector<TrackSegment> segments;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (keep[i]) {
+            segments.push_back(candidates[i]);
+        }
+    }
+    
+    return segments;
+}
+
+std::vector<TrackSegment> TrackAnalyzer::optimizeSegments(
+    const std::vector<TrackSegment>& rawSegments,
+    const std::vector<TrackPoint>& points) const
+{
+    return optimizeSegments(rawSegments, points, m_params);
+}
+
+std::vector<TrackSegment> TrackAnalyzer::optimizeSegments(
+    const std::vector<TrackSegment>& rawSegments,
+    const std::vector<TrackPoint>& points,
+    const SegmentationParams& params) const
+{
+    if (rawSegments.empty()) return rawSegments;
+    
+    const double SIMILAR_GRADIENT_THRESHOLD = params.similarGradientThreshold;
+    const double TINY_SEGMENT_THRESHOLD = params.tinySegmentThreshold;
+    const double SMALL_SEGMENT_THRESHOLD = params.smallSegmentThreshold;
+    
+    std::vector<TrackSegment> mergedSegments;
+    TrackSegment currentSegment = rawSegments[0];
+    
+    for (size_t i = 1; i < rawSegments.size(); i++) {
+        const TrackSegment& nextSegment = rawSegments[i];
+        bool shouldMerge = false;
+        
+        // Check if segments are of the same type and similar gradient
+        if (nextSegment.type == currentSegment.type) {
+            double gradientDiff = std::abs(nextSegment.avgGradient - currentSegment.avgGradient);
+            if (gradientDiff < SIMILAR_GRADIENT_THRESHOLD) {
+                shouldMerge = true;
+            }
+        }
+        
+        // Merge tiny segments with larger ones to avoid fragmentation
+        if (!shouldMerge && nextSegment.distance < TINY_SEGMENT_THRESHOLD) {
+            shouldMerge = true;
+        }
+        
+        // Merge small segments with much larger next segments
+        if (!shouldMerge && 
+            currentSegment.distance < SMALL_SEGMENT_THRESHOLD &&
+            nextSegment.distance > currentSegment.distance * 2) {
+            shouldMerge = true;
+        }
+        
+        if (shouldMerge) {
+            // Special handling for flat-to-flat transitions to preserve important features
+            if (currentSegment.type == TrackSegment::FLAT && nextSegment.type == TrackSegment::FLAT &&
+                std::abs(currentSegment.avgGradient - nextSegment.avgGradient) > 1.0) {
+                // Don't merge significantly different flat segments
+                mergedSegments.push_back(currentSegment);
+                currentSegment = nextSegment;
+                continue;
+            }
+            
+            // Update current segment by merging with next segment
+            currentSegment.endIndex = nextSegment.endIndex;
+            currentSegment.distance += nextSegment.distance;
+            currentSegment.elevationChange += nextSegment.elevationChange;
+            
+            // Recalculate gradient stats
+            currentSegment.maxGradient = std::max(currentSegment.maxGradient, nextSegment.maxGradient);
+            currentSegment.minGradient = std::min(currentSegment.minGradient, nextSegment.minGradient);
+            
+            // Get more accurate average gradient using start and end points
+            currentSegment.avgGradient = currentSegment.elevationChange / currentSegment.distance * 100.0;
+            
+            // Re-evaluate segment type based on merged gradient
+            if (nextSegment.type != currentSegment.type) {
+                if (currentSegment.avgGradient > params.mergedFlatThreshold) {
+                    currentSegment.type = TrackSegment::CLIMB;
+                } else if (currentSegment.avgGradient < -params.mergedFlatThreshold) {
+                    currentSegment.type = TrackSegment::DESCENT;
+                } else {
+                    currentSegment.type = TrackSegment::FLAT;
+                }
+            }
+        } else {
+            mergedSegments.push_back(currentSegment);
+            currentSegment = nextSegment;
+        }
+    }
+    
+    // Add the last segment
+    mergedSegments.push_back(currentSegment);
+    
+    // Final pass: consistent segment type calculation. Only the merge above depends on
+    // the previous segment; this per-segment recalculation can run in parallel.
+    forEachChunk(m_chunkSize, mergedSegments.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            TrackSegment& segment = mergedSegments[i];
+            
+            // Calculate actual start-to-end gradient for better accuracy
+            double startElev = points[segment.startIndex].elevation;
+            double endElev = points[segment.endIndex].elevation;
+            double actualDistance = points[segment.endIndex].distance - points[segment.startIndex].distance;
+            
+            if (actualDistance > 0) {
+                double actualGradient = ((endElev - startElev) / actualDistance) * 100.0;
+                segment.avgGradient = actualGradient;
+                
+                // Recalculate segment type based on the more accurate gradient
+                if (segment.avgGradient > params.mergedFlatThreshold) {
+                    segment.type = TrackSegment::CLIMB;
+                } else if (segment.avgGradient < -params.mergedFlatThreshold) {
+                    segment.type = TrackSegment::DESCENT;
+                } else {
+                    segment.type = TrackSegment::FLAT;
+                }
+            }
+        }
+    });
+    
+    return mergedSegments;
+}
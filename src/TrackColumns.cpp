@@ -0,0 +1,81 @@
+#include "TrackColumns.h"
+#include <cmath>
+
+namespace {
+    // Copy one optional sensor channel, leaving the column empty if no point has it
+    void copySensorChannel(const std::vector<TrackPoint>& points,
+                           double TrackPoint::*channel,
+                           std::vector<double>& column)
+    {
+        bool present = false;
+        for (const auto& point : points) {
+            if (!std::isnan(point.*channel)) {
+                present = true;
+                break;
+            }
+        }
+        if (!present) {
+            column.clear();
+            return;
+        }
+
+        column.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            column[i] = points[i].*channel;
+        }
+    }
+}
+
+TrackColumns TrackColumns::fromPoints(const std::vector<TrackPoint>& points)
+{
+    TrackColumns columns;
+    const size_t count = points.size();
+
+    columns.latitude.resize(count);
+    columns.longitude.resize(count);
+    columns.elevation.resize(count);
+    columns.distance.resize(count);
+    columns.gradient.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const TrackPoint& point = points[i];
+        columns.latitude[i] = point.coord.latitude();
+        columns.longitude[i] = point.coord.longitude();
+        columns.elevation[i] = point.elevation;
+        columns.distance[i] = point.distance;
+        columns.gradient[i] = point.gradient;
+    }
+
+    // Timestamps: keep the column only if at least one point is timed, and
+    // record missing values in an Arrow-compatible validity bitmap
+    size_t validCount = 0;
+    for (const auto& point : points) {
+        if (point.timestamp.isValid()) {
+            ++validCount;
+        }
+    }
+
+    if (validCount > 0) {
+        columns.timestampMs.resize(count, 0);
+        columns.timestampNullCount = count - validCount;
+        if (columns.timestampNullCount > 0) {
+            columns.timestampValidity.assign((count + 7) / 8, 0);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (points[i].timestamp.isValid()) {
+                columns.timestampMs[i] = points[i].timestamp.toMSecsSinceEpoch();
+                if (!columns.timestampValidity.empty()) {
+                    columns.timestampValidity[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                }
+            }
+        }
+    }
+
+    copySensorChannel(points, &TrackPoint::heartRate, columns.heartRate);
+    copySensorChannel(points, &TrackPoint::cadence, columns.cadence);
+    copySensorChannel(points, &TrackPoint::power, columns.power);
+    copySensorChannel(points, &TrackPoint::temperature, columns.temperature);
+
+    return columns;
+}
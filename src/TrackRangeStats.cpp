@@ -0,0 +1,160 @@
+#include "TrackRangeStats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    const double ELEVATION_GAIN_THRESHOLD = 0.6; // Same threshold as GPXParser::getCumulativeElevationGain
+}
+
+TrackRangeStats::TrackRangeStats(const std::vector<TrackPoint>& points) {
+    const size_t count = points.size();
+    if (count == 0) {
+        return;
+    }
+    
+    m_distances.resize(count);
+    m_gainPrefix.resize(count);
+    m_lossPrefix.resize(count);
+    m_seconds.resize(count);
+    std::vector<double> elevations(count);
+    std::vector<double> gradients(count);
+    
+    // Times are measured from the first timed point, which need not be the first point
+    auto firstTimed = std::find_if(points.begin(), points.end(),
+                                   [](const TrackPoint& point) { return point.timestamp.isValid(); });
+    const QDateTime origin = firstTimed != points.end() ? firstTimed->timestamp : QDateTime();
+    QDateTime clockOrigin;
+    double clock = 0.0;
+    double gain = 0.0;
+    double loss = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        const TrackPoint& point = points[i];
+        if (i > 0) {
+            double diff = point.elevation - points[i - 1].elevation;
+            if (diff > ELEVATION_GAIN_THRESHOLD) {
+                gain += diff;
+            } else if (diff < -ELEVATION_GAIN_THRESHOLD) {
+                loss -= diff;
+            }
+        }
+        m_distances[i] = point.distance;
+        m_gainPrefix[i] = gain;
+        m_lossPrefix[i] = loss;
+        m_seconds[i] = (origin.isValid() && point.timestamp.isValid())
+            ? origin.msecsTo(point.timestamp) / 1000.0
+            : std::numeric_limits<double>::quiet_NaN();
+        
+        // Carry the clock over missing or out-of-order timestamps so it can be binary searched
+        if (point.timestamp.isValid()) {
+            if (!clockOrigin.isValid()) {
+                clockOrigin = point.timestamp;
+                m_clock.assign(i, 0.0);
+            }
+            clock = std::max(clock, clockOrigin.msecsTo(point.timestamp) / 1000.0);
+        }
+        if (clockOrigin.isValid()) {
+            m_clock.push_back(clock);
+        }
+        elevations[i] = point.elevation;
+        gradients[i] = point.gradient;
+    }
+    
+    m_lowestElevation = RangeMinimum(elevations);
+    m_highestElevation = RangeMaximum(std::move(elevations));
+    m_minGradient = RangeMinimum(gradients);
+    m_maxGradient = RangeMaximum(std::move(gradients));
+}
+
+RangeStats TrackRangeStats::stats(size_t first, size_t last) const {
+    RangeStats result;
+    if (empty()) {
+        return result;
+    }
+    
+    if (first > last) {
+        std::swap(first, last);
+    }
+    last = std::min(last, size() - 1);
+    first = std::min(first, last);
+    
+    result.startIndex = first;
+    result.endIndex = last;
+    result.distance = m_distances[last] - m_distances[first];
+    result.elevationGain = m_gainPrefix[last] - m_gainPrefix[first];
+    result.elevationLoss = m_lossPrefix[last] - m_lossPrefix[first];
+    result.minElevation = m_lowestElevation.extreme(first, last);
+    result.maxElevation = m_highestElevation.extreme(first, last);
+    result.minGradient = m_minGradient.extreme(first, last);
+    result.maxGradient = m_maxGradient.extreme(first, last);
+    
+    double netChange = m_lowestElevation.value(last) - m_lowestElevation.value(first);
+    result.avgGradient = (result.distance > 0) ? netChange / result.distance * 100.0 : 0.0;
+    
+    // NaN propagates when either end has no timestamp
+    result.duration = m_seconds[last] - m_seconds[first];
+    result.avgSpeed = (result.duration > 0) ? result.distance / result.duration
+                                            : std::numeric_limits<double>::quiet_NaN();
+    return result;
+}
+
+RangeStats TrackRangeStats::statsForDistance(double from, double to) const {
+    return stats(indexAtDistance(from), indexAtDistance(to));
+}
+
+size_t TrackRangeStats::indexAtDistance(double meters) const {
+    if (empty()) {
+        return 0;
+    }
+    
+    auto it = std::lower_bound(m_distances.begin(), m_distances.end(), meters);
+    if (it == m_distances.begin()) {
+        return 0;
+    }
+    if (it == m_distances.end()) {
+        return size() - 1;
+    }
+    
+    size_t index = it - m_distances.begin();
+    return (meters - m_distances[index - 1] <= m_distances[index] - meters) ? index - 1 : index;
+}
+
+std::vector<RangeStats> TrackRangeStats::splitsByDistance(double interval) const {
+    return splits(m_distances, interval);
+}
+
+std::vector<RangeStats> TrackRangeStats::splitsByTime(double interval) const {
+    return splits(m_clock, interval);
+}
+
+std::vector<RangeStats> TrackRangeStats::splits(const std::vector<double>& axis, double interval) const {
+    std::vector<RangeStats> result;
+    if (axis.size() < 2 || !(interval > 0.0)) {
+        return result;
+    }
+    
+    const size_t last = axis.size() - 1;
+    size_t first = 0;
+    for (size_t k = 1; first < last; ++k) {
+        // Targets are multiples of the interval, so long tracks don't accumulate rounding drift
+        double target = axis.front() + k * interval;
+        size_t next = last;
+        if (target < axis.back()) {
+            // Boundaries only move forward, so each search starts at the previous one
+            auto it = std::lower_bound(axis.begin() + first, axis.end(), target);
+            next = it - axis.begin();
+            if (target - axis[next - 1] <= axis[next] - target) {
+                --next;
+            }
+        }
+        
+        if (next <= first) {
+            // Sparse points: jump to the first target past the next point
+            k = std::max(k, static_cast<size_t>((axis[first + 1] - axis.front()) / interval));
+            continue;
+        }
+        result.push_back(stats(first, next));
+        first = next;
+    }
+    return result;
+}
@@ -1,13 +1,26 @@
 #include "TrackStatsWidget.h"
+#include "AnalysisCache.h"
 #include "logging.h"
 
 #include <QPushButton>
 #include <QScrollArea>
-#include <deque>
+#include <QHeaderView>
+#include <QtConcurrent>
+
+namespace {
+    const int MIN_PROFILE_SEGMENT_PIXELS = 12; // Shortest segment drawn separately in the mini profile
+    const double PROJECTION_POWER_SPREAD = 0.2; // Projected time range covers +/- this share of the power
+    const double METERS_PER_MILE = 1609.344;
+    const int SPLIT_PER_DISTANCE = 0;           // First split interval entry; the others hold minutes
+}
 
 TrackStatsWidget::TrackStatsWidget(QWidget *parent) : 
     QWidget(parent),
-    m_useMetricUnits(false) // Default to imperial units
+    m_useMetricUnits(false), // Default to imperial units
+    m_analysisWatcher(new QFutureWatcher<TrackSegmentation>(this)),
+    m_metricsWatcher(new QFutureWatcher<TrackMetrics>(this)),
+    m_projectedFastest(0.0),
+    m_projectedSlowest(0.0)
 {
     // Set fixed width
     setMinimumWidth(280);
@@ -27,8 +40,9 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     mainLayout->addWidget(m_titleLabel);
     
     // Current position section
-    QStringList posLabels = {"Distance:", "Elevation:", "Elevation Gain:", "Gradient:", "Latitude:", "Longitude:"};
-    QLabel* posLabelsArr[6];
+    QStringList posLabels = {"Distance:", "Elevation:", "Elevation Gain:", "Gradient:", "Latitude:", "Longitude:",
+                             "Speed:", "Pace:", "ETA:"};
+    QLabel* posLabelsArr[9];
     QWidget* positionSection = createStatsSection("Current Position", posLabelsArr, posLabels);
     m_positionTitle = posLabelsArr[0]->parentWidget()->findChild<QLabel*>("sectionTitle");
     m_distanceLabel = posLabelsArr[0];
@@ -37,12 +51,17 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     m_gradientLabel = posLabelsArr[3];
     m_latitudeLabel = posLabelsArr[4];
     m_longitudeLabel = posLabelsArr[5];
+    m_speedLabel = posLabelsArr[6];
+    m_paceLabel = posLabelsArr[7];
+    m_etaLabel = posLabelsArr[8];
     mainLayout->addWidget(positionSection);
     
     // Track information section
     QStringList trackLabels = {"Total Distance:", "Max Elevation:", "Min Elevation:", "Total Gain:", 
-                              "% Uphill:", "% Downhill:", "% Flat:", "Steepest Uphill:", "Steepest Downhill:"};
-    QLabel* trackLabelsArr[9]; // Updated to 9 elements
+                              "% Uphill:", "% Downhill:", "% Flat:", "Steepest Uphill:", "Steepest Downhill:",
+                              "Elapsed Time:", "Moving Time:", "Avg Moving Speed:", "Max Speed:",
+                              "Projected Time:"};
+    QLabel* trackLabelsArr[14];
     QWidget* trackSection = createStatsSection("Track Information", trackLabelsArr, trackLabels);
     m_trackTitle = trackLabelsArr[0]->parentWidget()->findChild<QLabel*>("sectionTitle");
     m_totalDistanceLabel = trackLabelsArr[0];
@@ -54,8 +73,34 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     m_flatPercentLabel = trackLabelsArr[6];
     m_steepestUphillLabel = trackLabelsArr[7];
     m_steepestDownhillLabel = trackLabelsArr[8];
+    m_elapsedTimeLabel = trackLabelsArr[9];
+    m_movingTimeLabel = trackLabelsArr[10];
+    m_avgMovingSpeedLabel = trackLabelsArr[11];
+    m_maxSpeedLabel = trackLabelsArr[12];
+    m_projectedTimeLabel = trackLabelsArr[13];
     mainLayout->addWidget(trackSection);
     
+    // Elevation gain estimators section
+    QWidget* gainsContainer = new QWidget(this);
+    QVBoxLayout* gainsLayout = new QVBoxLayout(gainsContainer);
+    gainsLayout->setContentsMargins(0, 0, 0, 0);
+    gainsLayout->setSpacing(4);
+    
+    m_gainsTitle = new QLabel("Elevation Gain", gainsContainer);
+    m_gainsTitle->setObjectName("sectionTitle");
+    m_gainsTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    gainsLayout->addWidget(m_gainsTitle);
+    
+    m_gainsLabel = new QLabel("-", gainsContainer);
+    m_gainsLabel->setWordWrap(true);
+    m_gainsLabel->setTextFormat(Qt::RichText);
+    m_gainsLabel->setStyleSheet("color: #212121; border: none;");
+    m_gainsLabel->setToolTip("Devices usually report something close to the hysteresis or smoothed figure; "
+                             "the threshold figure is the one used elsewhere in this panel");
+    gainsLayout->addWidget(m_gainsLabel);
+    
+    mainLayout->addWidget(gainsContainer);
+    
     // Create mini elevation profile
     m_miniProfile = new QCustomPlot(this);
     m_miniProfile->setMinimumHeight(100);
@@ -86,6 +131,39 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     m_segmentTitle->setStyleSheet("font-weight: bold; color: #424242;");
     segmentLayout->addWidget(m_segmentTitle);
     
+    // Segmentation thresholds; moving a slider re-segments the current track in place
+    QGridLayout* thresholdsGrid = new QGridLayout();
+    thresholdsGrid->setContentsMargins(0, 0, 0, 0);
+    thresholdsGrid->setHorizontalSpacing(6);
+    thresholdsGrid->setVerticalSpacing(2);
+    auto addThreshold = [&](int row, const QString& text, int minimum, int maximum, int value,
+                            QSlider** slider, QLabel** valueLabel) {
+        QLabel* label = new QLabel(text, segmentContainer);
+        label->setStyleSheet("color: #616161; font-size: 11px; border: none;");
+        *slider = new QSlider(Qt::Horizontal, segmentContainer);
+        (*slider)->setRange(minimum, maximum);
+        (*slider)->setValue(value);
+        *valueLabel = new QLabel(segmentContainer);
+        (*valueLabel)->setStyleSheet("color: #212121; font-size: 11px; border: none;");
+        (*valueLabel)->setMinimumWidth(48);
+        thresholdsGrid->addWidget(label, row, 0);
+        thresholdsGrid->addWidget(*slider, row, 1);
+        thresholdsGrid->addWidget(*valueLabel, row, 2);
+        connect(*slider, &QSlider::valueChanged, this, &TrackStatsWidget::handleThresholdChanged);
+    };
+    addThreshold(0, "Flat", 5, 50, qRound(m_segmentationParams.flatThreshold * 10),
+                 &m_flatThresholdSlider, &m_flatThresholdValue);
+    addThreshold(1, "Change", 10, 100, qRound(m_segmentationParams.changeThreshold * 10),
+                 &m_changeThresholdSlider, &m_changeThresholdValue);
+    addThreshold(2, "Min length", 100, 2000, qRound(m_segmentationParams.minBoundaryDistance),
+                 &m_minSegmentSlider, &m_minSegmentValue);
+    addThreshold(3, "Merge", 5, 100, qRound(m_segmentationParams.similarGradientThreshold * 10),
+                 &m_mergeThresholdSlider, &m_mergeThresholdValue);
+    m_minSegmentSlider->setSingleStep(50);
+    m_minSegmentSlider->setPageStep(250);
+    segmentLayout->addLayout(thresholdsGrid);
+    updateThresholdLabels();
+    
     // Add mini profile to segments section
     segmentLayout->addWidget(m_miniProfile);
     
@@ -103,6 +181,33 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     scrollArea->setWidget(m_segmentListWidget);
     segmentLayout->addWidget(scrollArea);
     
+    // Splits table, next to the segment list
+    QHBoxLayout* splitsHeader = new QHBoxLayout();
+    QLabel* splitsTitle = new QLabel("Splits", segmentContainer);
+    splitsTitle->setObjectName("sectionTitle");
+    splitsTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    splitsHeader->addWidget(splitsTitle);
+    
+    m_splitIntervalCombo = new QComboBox(segmentContainer);
+    m_splitIntervalCombo->addItem("Every km / mi", 0);
+    m_splitIntervalCombo->addItem("Every 5 min", 5);
+    m_splitIntervalCombo->addItem("Every 10 min", 10);
+    m_splitIntervalCombo->addItem("Every 30 min", 30);
+    splitsHeader->addWidget(m_splitIntervalCombo);
+    segmentLayout->addLayout(splitsHeader);
+    
+    m_splitsTable = new QTableWidget(0, 5, segmentContainer);
+    m_splitsTable->setHorizontalHeaderLabels({"#", "Time", "Gain", "Grad", "Speed"});
+    m_splitsTable->verticalHeader()->setVisible(false);
+    m_splitsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_splitsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_splitsTable->setSelectionMode(QAbstractItemView::NoSelection);
+    m_splitsTable->setStyleSheet("font-size: 11px; border: none;");
+    m_splitsTable->setMaximumHeight(180);
+    segmentLayout->addWidget(m_splitsTable);
+    connect(m_splitIntervalCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &TrackStatsWidget::updateSplitsTable);
+    
     // Segment details section
     m_segmentDetailsWidget = new QWidget(this);
     QVBoxLayout* detailsLayout = new QVBoxLayout(m_segmentDetailsWidget);
@@ -153,6 +258,82 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     
     mainLayout->addWidget(segmentContainer);
     
+    // Climbs section
+    QWidget* climbsContainer = new QWidget(this);
+    QVBoxLayout* climbsLayout = new QVBoxLayout(climbsContainer);
+    climbsLayout->setContentsMargins(0, 0, 0, 0);
+    climbsLayout->setSpacing(4);
+    
+    m_climbsTitle = new QLabel("Climbs", climbsContainer);
+    m_climbsTitle->setObjectName("sectionTitle");
+    m_climbsTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    climbsLayout->addWidget(m_climbsTitle);
+    
+    m_climbsLabel = new QLabel("No categorized climbs", climbsContainer);
+    m_climbsLabel->setWordWrap(true);
+    m_climbsLabel->setTextFormat(Qt::RichText);
+    m_climbsLabel->setStyleSheet("color: #212121; border: none;");
+    climbsLayout->addWidget(m_climbsLabel);
+    
+    mainLayout->addWidget(climbsContainer);
+    
+    // Best efforts section
+    QWidget* effortsContainer = new QWidget(this);
+    QVBoxLayout* effortsLayout = new QVBoxLayout(effortsContainer);
+    effortsLayout->setContentsMargins(0, 0, 0, 0);
+    effortsLayout->setSpacing(4);
+    
+    m_bestEffortsTitle = new QLabel("Best Efforts", effortsContainer);
+    m_bestEffortsTitle->setObjectName("sectionTitle");
+    m_bestEffortsTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    effortsLayout->addWidget(m_bestEffortsTitle);
+    
+    m_bestEffortsLabel = new QLabel("No timestamps", effortsContainer);
+    m_bestEffortsLabel->setWordWrap(true);
+    m_bestEffortsLabel->setTextFormat(Qt::RichText);
+    m_bestEffortsLabel->setStyleSheet("color: #212121; border: none;");
+    effortsLayout->addWidget(m_bestEffortsLabel);
+    
+    mainLayout->addWidget(effortsContainer);
+    
+    // Power curve section
+    QWidget* powerContainer = new QWidget(this);
+    QVBoxLayout* powerLayout = new QVBoxLayout(powerContainer);
+    powerLayout->setContentsMargins(0, 0, 0, 0);
+    powerLayout->setSpacing(4);
+    
+    m_powerCurveTitle = new QLabel("Power Curve", powerContainer);
+    m_powerCurveTitle->setObjectName("sectionTitle");
+    m_powerCurveTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    powerLayout->addWidget(m_powerCurveTitle);
+    
+    m_powerCurveLabel = new QLabel("No power data", powerContainer);
+    m_powerCurveLabel->setWordWrap(true);
+    m_powerCurveLabel->setTextFormat(Qt::RichText);
+    m_powerCurveLabel->setStyleSheet("color: #212121; border: none;");
+    powerLayout->addWidget(m_powerCurveLabel);
+    
+    mainLayout->addWidget(powerContainer);
+    
+    // Time-in-zone section
+    QWidget* zonesContainer = new QWidget(this);
+    QVBoxLayout* zonesLayout = new QVBoxLayout(zonesContainer);
+    zonesLayout->setContentsMargins(0, 0, 0, 0);
+    zonesLayout->setSpacing(4);
+    
+    m_zonesTitle = new QLabel("Zones", zonesContainer);
+    m_zonesTitle->setObjectName("sectionTitle");
+    m_zonesTitle->setStyleSheet("font-weight: bold; color: #424242;");
+    zonesLayout->addWidget(m_zonesTitle);
+    
+    m_zonesLabel = new QLabel("No zone data", zonesContainer);
+    m_zonesLabel->setWordWrap(true);
+    m_zonesLabel->setTextFormat(Qt::RichText);
+    m_zonesLabel->setStyleSheet("color: #212121; border: none;");
+    zonesLayout->addWidget(m_zonesLabel);
+    
+    mainLayout->addWidget(zonesContainer);
+    
     // Units toggle button with modern styling
     m_unitsToggleButton = new QPushButton("Switch to Metric", this);
     m_unitsToggleButton->setStyleSheet(
@@ -173,6 +354,10 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
         "}"
     );
     connect(m_unitsToggleButton, &QPushButton::clicked, this, &TrackStatsWidget::toggleUnits);
+    connect(m_analysisWatcher, &QFutureWatcher<TrackSegmentation>::finished,
+            this, &TrackStatsWidget::handleAnalysisFinished);
+    connect(m_metricsWatcher, &QFutureWatcher<TrackMetrics>::finished,
+            this, &TrackStatsWidget::handleMetricsFinished);
     mainLayout->addWidget(m_unitsToggleButton);
     
     // Add stretch at bottom to push everything to the top
@@ -185,6 +370,9 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     m_gradientLabel->setText("0.0%");
     m_latitudeLabel->setText("0° 00' 00\"N");
     m_longitudeLabel->setText("0° 00' 00\"E");
+    m_speedLabel->setText("-");
+    m_paceLabel->setText("-");
+    m_etaLabel->setText("-");
     
     m_totalDistanceLabel->setText("0.00 mi");
     m_maxElevationLabel->setText("0.0 ft");
@@ -195,6 +383,7 @@ TrackStatsWidget::TrackStatsWidget(QWidget *parent) :
     m_flatPercentLabel->setText("0.0%");
     m_steepestUphillLabel->setText("0.0%");
     m_steepestDownhillLabel->setText("0.0%");
+    updateMotionSummary();
 }
 
 QWidget* TrackStatsWidget::createStatsSection(const QString& title, QLabel** labelArray, const QStringList& labelTexts) 
@@ -248,8 +437,12 @@ QWidget* TrackStatsWidget::createStatsSection(const QString& title, QLabel** lab
 }
 
 void TrackStatsWidget::updateStats(const TrackPoint& point, int pointIndex, const GPXParser& parser) {
-    updatePosition(point, pointIndex, parser);
-    setTrackInfo(parser);
+    updateStats(point, pointIndex, TrackView(parser.sharedPoints()));
+}
+
+void TrackStatsWidget::updateStats(const TrackPoint& point, int pointIndex, const TrackView& track) {
+    updatePosition(point, pointIndex, track);
+    setTrackInfo(track);
     
     if (m_miniProfile->graph(0)->dataCount() > 0) {
         QVector<double> x, y;
@@ -261,14 +454,17 @@ void TrackStatsWidget::updateStats(const TrackPoint& point, int pointIndex, cons
 }
 
 void TrackStatsWidget::updatePosition(const TrackPoint& point, int pointIndex, const GPXParser& parser) {
+    updatePosition(point, pointIndex, TrackView(parser.sharedPoints()));
+}
+
+void TrackStatsWidget::updatePosition(const TrackPoint& point, int pointIndex, const TrackView& track) {
     double currentDistance = point.distance;
-    double elevationGain = parser.getCumulativeElevationGain(pointIndex);
+    double elevationGain = pointIndex > 0 ? track.cumulativeElevationGain(pointIndex) : 0.0;
     
     double currentGradient = 0.0;
-    const std::vector<TrackPoint>& points = parser.getPoints();
-    if (pointIndex > 0 && pointIndex < static_cast<int>(points.size())) {
-        double prevDistance = points[pointIndex-1].distance;
-        double prevElevation = points[pointIndex-1].elevation;
+    if (pointIndex > 0 && pointIndex < static_cast<int>(track.size())) {
+        double prevDistance = track.distanceAt(pointIndex-1);
+        double prevElevation = track.sourcePoint(pointIndex-1).elevation;
         double distDiff = point.distance - prevDistance;
         double elevDiff = point.elevation - prevElevation;
         
@@ -315,9 +511,18 @@ void TrackStatsWidget::updatePosition(const TrackPoint& point, int pointIndex, c
     m_latitudeLabel->setStyleSheet("color: #212121; font-weight: bold; font-size: 8pt;");
     m_longitudeLabel->setStyleSheet("color: #212121; font-weight: bold; font-size: 8pt;");
     
-    for (size_t i = 0; i < m_segments.size(); i++) {
-        if (pointIndex >= static_cast<int>(m_segments[i].startIndex) && 
-            pointIndex <= static_cast<int>(m_segments[i].endIndex)) {
+    // Speed and pace of the interval ending at this point, once the motion profile matches the track
+    bool timed = pointIndex >= 0 && pointIndex < static_cast<int>(m_motion.speed.size());
+    m_speedLabel->setText(timed ? formatSpeed(m_motion.smoothedSpeed[pointIndex]) : "-");
+    m_paceLabel->setText(timed ? formatPace(m_motion.pace[pointIndex]) : "-");
+    
+    bool projected = pointIndex >= 0 && pointIndex < static_cast<int>(m_pacing.elapsed.size());
+    m_etaLabel->setText(projected ? formatDuration(m_pacing.elapsed[pointIndex]) : "-");
+    
+    const std::vector<TrackSegment>& segments = m_analysis.segments();
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (pointIndex >= static_cast<int>(segments[i].startIndex) && 
+            pointIndex <= static_cast<int>(segments[i].endIndex)) {
             
             QWidget* segmentList = m_segmentListWidget;
             for (int j = 0; j < segmentList->layout()->count(); j++) {
@@ -338,9 +543,13 @@ void TrackStatsWidget::updatePosition(const TrackPoint& point, int pointIndex, c
 }
 
 void TrackStatsWidget::setTrackInfo(const GPXParser& parser) {
-    const std::vector<TrackPoint>& points = parser.getPoints();
-    
-    if (points.empty()) {
+    setTrackInfo(TrackView(parser.sharedPoints()));
+}
+
+void TrackStatsWidget::setTrackInfo(const TrackView& track) {
+    if (track.empty()) {
+        m_track = TrackView();
+        
         m_totalDistanceLabel->setText(m_useMetricUnits ? "0.00 km" : "0.00 mi");
         m_maxElevationLabel->setText(m_useMetricUnits ? "0.0 m" : "0.0 ft");
         m_minElevationLabel->setText(m_useMetricUnits ? "0.0 m" : "0.0 ft");
@@ -355,7 +564,26 @@ void TrackStatsWidget::setTrackInfo(const GPXParser& parser) {
         m_miniProfile->graph(1)->data()->clear();
         m_miniProfile->replot();
         
-        m_segments.clear();
+        m_analysis = TrackAnalysisResult();
+        m_analysisWatcher->cancel();
+        m_gradientProfile = GradientProfile();
+        m_analysisPoints.clear();
+        m_metricsWatcher->cancel();
+        m_columns.reset();
+        m_motion = MotionProfile();
+        m_bestEfforts.clear();
+        m_pacing = PacingEstimate();
+        m_powerCurve = PowerCurve();
+        updatePowerCurveList();
+        m_zones = ZoneReport();
+        updateZonesList();
+        m_rangeStats = TrackRangeStats();
+        updateSplitsTable();
+        m_terrain = TerrainData();
+        m_gains = ElevationGainReport();
+        updateGainsList();
+        m_projectedFastest = m_projectedSlowest = 0.0;
+        updateMotionSummary();
         QLayoutItem* child;
         while ((child = m_segmentListWidget->layout()->takeAt(0)) != nullptr) {
             delete child->widget();
@@ -363,76 +591,28 @@ void TrackStatsWidget::setTrackInfo(const GPXParser& parser) {
         }
         
         m_segmentDetailsWidget->setVisible(false);
+        updateClimbsList();
         return;
     }
     
-    static size_t lastPointsCount = 0;
-    if (lastPointsCount != points.size()) {
-        analyzeSegments(parser);
-        updateMiniProfile(parser);
-        updateSegmentsList();
-        lastPointsCount = points.size();
+    // Re-analyze only when the track or the view of it (trim, reverse, ...) changed
+    if (m_track != track) {
+        m_track = track;
+        startAnalysis(track);
+        startMetrics(track);
+        updateMiniProfile(track);
     }
     
-    double totalDistance = parser.getTotalDistance();
-    double totalGain = parser.getTotalElevationGain();
-    double maxElev = parser.getMaxElevation();
-    double minElev = parser.getMinElevation();
-    
-    double steepestUphill = 0.0;
-    double steepestDownhill = 0.0;
-    
-    for (const auto& segment : m_segments) {
-        if (segment.type == TrackSegment::CLIMB) {
-            steepestUphill = std::max(steepestUphill, segment.maxGradient);
-        } else if (segment.type == TrackSegment::DESCENT) {
-            steepestDownhill = std::min(steepestDownhill, segment.minGradient);
-        }
-    }
-    
-    double uphillDistance = 0.0;
-    double downhillDistance = 0.0;
-    double flatDistance = 0.0;
-    
-    for (const auto& segment : m_segments) {
-        switch (segment.type) {
-            case TrackSegment::CLIMB:
-                uphillDistance += segment.distance;
-                break;
-            case TrackSegment::DESCENT:
-                downhillDistance += segment.distance;
-                break;
-            case TrackSegment::FLAT:
-                flatDistance += segment.distance;
-                break;
-        }
-    }
-    
-    double totalSegmentDistance = uphillDistance + downhillDistance + flatDistance;
-    double uphillPercent = (totalSegmentDistance > 0) ? (uphillDistance / totalSegmentDistance) * 100.0 : 0.0;
-    double downhillPercent = (totalSegmentDistance > 0) ? (downhillDistance / totalSegmentDistance) * 100.0 : 0.0;
-    double flatPercent = (totalSegmentDistance > 0) ? (flatDistance / totalSegmentDistance) * 100.0 : 0.0;
-    
-    double totalPercent = uphillPercent + downhillPercent + flatPercent;
-    if (totalPercent > 0) {
-        uphillPercent = (uphillPercent / totalPercent) * 100.0;
-        downhillPercent = (downhillPercent / totalPercent) * 100.0;
-        flatPercent = (flatPercent / totalPercent) * 100.0;
-    }
+    double totalDistance = track.totalDistance();
+    double totalGain = track.totalElevationGain();
+    double maxElev = track.maxElevation();
+    double minElev = track.minElevation();
     
     m_totalDistanceLabel->setText(formatDistance(totalDistance));
     m_maxElevationLabel->setText(formatElevation(maxElev));
     m_minElevationLabel->setText(formatElevation(minElev));
     m_totalElevGainLabel->setText(formatElevation(totalGain));
-    m_uphillPercentLabel->setText(QString("%1%").arg(uphillPercent, 0, 'f', 1));
-    m_downhillPercentLabel->setText(QString("%1%").arg(downhillPercent, 0, 'f', 1));
-    m_flatPercentLabel->setText(QString("%1%").arg(flatPercent, 0, 'f', 1));
-    
-    m_steepestUphillLabel->setText(formatGradient(steepestUphill));
-    m_steepestUphillLabel->setStyleSheet(getGradientColorStyle(steepestUphill));
-    
-    m_steepestDownhillLabel->setText(formatGradient(steepestDownhill));
-    m_steepestDownhillLabel->setStyleSheet(getGradientColorStyle(steepestDownhill));
+    updateSegmentSummary();
 }
 
 void TrackStatsWidget::toggleUnits() {
@@ -446,403 +626,415 @@ void TrackStatsWidget::toggleUnits() {
         method.invoke(this, Qt::DirectConnection);
     }
     
-    updateMiniProfile(GPXParser());
+    updateMiniProfile(m_track);
+    updateClimbsList();
+    updateMotionSummary();
+    updateZonesList();
+    updateSplitsTable();
+    updateGainsList();
+    updateThresholdLabels();
 }
 
-void TrackStatsWidget::analyzeSegments(const GPXParser& parser) {
-    QElapsedTimer timer;
-    timer.start();
-    logInfo("TrackStatsWidget", QString("Starting segment analysis with %1 points").arg(parser.getPoints().size()));
-    
-    const std::vector<TrackPoint>& points = parser.getPoints();
-    if (points.size() < 2) {
-        m_segments.clear();
-        logInfo("TrackStatsWidget", "Too few points for segment analysis, returning");
-        return;
+void TrackStatsWidget::setTerrain(const TerrainData& terrain) {
+    m_terrain = terrain;
+    if (m_columns) {
+        updateElevationGains(*m_columns);
     }
-    
-    m_segments.clear();
-    
-    // Process in chunks to avoid freezing the UI
-    QCoreApplication::processEvents();
-    logDebug("TrackStatsWidget", "Calculating smoothed gradients...");
-    std::vector<double> smoothGradients = calculateSmoothedGradients(points);
-    logDebug("TrackStatsWidget", QString("Smoothed gradients calculated in %1 ms").arg(timer.elapsed()));
-    
-    QCoreApplication::processEvents();
-    timer.restart();
-    logDebug("TrackStatsWidget", "Identifying segment boundaries...");
-    std::vector<size_t> segmentBoundaries = identifySegmentBoundaries(points, smoothGradients);
-    logDebug("TrackStatsWidget", QString("Found %1 segment boundaries in %2 ms").arg(segmentBoundaries.size()).arg(timer.elapsed()));
-    
-    QCoreApplication::processEvents();
-    timer.restart();
-    logDebug("TrackStatsWidget", "Creating raw segments...");
-    std::vector<TrackSegment> rawSegments = createRawSegments(points, smoothGradients, segmentBoundaries);
-    logDebug("TrackStatsWidget", QString("Created %1 raw segments in %2 ms").arg(rawSegments.size()).arg(timer.elapsed()));
-    
-    QCoreApplication::processEvents();
-    timer.restart();
-    logDebug("TrackStatsWidget", "Optimizing segments...");
-    m_segments = optimizeSegments(rawSegments, points);
-    logInfo("TrackStatsWidget", QString("Finished analyzing %1 segments in %2 ms").arg(m_segments.size()).arg(timer.elapsed()));
 }
 
-std::vector<double> TrackStatsWidget::calculateSmoothedGradients(const std::vector<TrackPoint>& points) {
-    QElapsedTimer timer;
-    timer.start();
-    logDebug("TrackStatsWidget", QString("Smoothing gradients for %1 points").arg(points.size()));
-    
-    // Skip expensive smoothing for very large datasets
-    const int MAX_POINTS_FULL_SMOOTHING = 8000;
-    const int WINDOW_SIZE = points.size() > MAX_POINTS_FULL_SMOOTHING ? 7 : 15; 
-    
-    // Use the pre-calculated gradients from GPXParser as a starting point
-    std::vector<double> gradients(points.size());
-    for (size_t i = 0; i < points.size(); i++) {
-        gradients[i] = points[i].gradient;
-        
-        // Process events periodically for very large datasets
-        if (points.size() > 10000 && i % 5000 == 0) {
-            QCoreApplication::processEvents();
-            logDebug("TrackStatsWidget", QString("Gradient initialization: %1/%2 points processed").arg(i).arg(points.size()));
-        }
+void TrackStatsWidget::updateElevationGains(const TrackColumns& columns) {
+    // Terrain is dropped on every track change and the service discards replies to older
+    // requests, so the grid always belongs to the current track
+    std::vector<double> dem;
+    if (!m_terrain.elevationGrid.empty()) {
+        dem = ElevationGainEstimator::sampleDem(m_terrain.elevationGrid, m_terrain.topLeft,
+                                                m_terrain.bottomRight, columns);
     }
-    
-    // Apply segment-aware smoothing to avoid blurring segment boundaries
-    std::vector<double> smoothedGradients = gradients;
-    
-    // Define a Gaussian-like kernel for smoothing
-    int halfWindow = WINDOW_SIZE / 2;
-    std::vector<double> kernel(WINDOW_SIZE);
-    double kernelSum = 0.0;
-    
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        double x = (i - halfWindow) / (halfWindow / 2.0);
-        kernel[i] = exp(-0.5 * x * x);
-        kernelSum += kernel[i];
-    }
-    
-    // Normalize kernel
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        kernel[i] /= kernelSum;
+    m_gains = ElevationGainEstimator().estimate(columns, dem);
+    updateGainsList();
+}
+
+void TrackStatsWidget::setZoneSettings(const ZoneSettings& settings) {
+    m_zoneSettings = settings;
+    if (m_columns) {
+        m_zones = ZoneAnalyzer(m_zoneSettings).analyze(*m_columns);
     }
+    updateZonesList();
+}
+
+void TrackStatsWidget::startAnalysis(const TrackView& track) {
+    // Drop the segments of the previous track right away, they no longer match the indices
+    m_analysis = TrackAnalysisResult();
+    updateSegmentsList();
+    m_segmentDetailsWidget->setVisible(false);
     
-    // Apply the kernel to smooth gradients
-    for (size_t i = 0; i < points.size(); i++) {
-        double sum = 0.0;
-        double weightSum = 0.0;
+    // The analyzer owns no widget state, so it can run on the global thread pool. Reopening
+    // a track (or an identical view of it) with the same parameters loads the cached result.
+    // Smoothing and climbs are prepared here too, so threshold changes only re-segment.
+    m_gradientProfile = GradientProfile();
+    m_analysisPoints.clear();
+    std::vector<TrackPoint> points = track.toPoints();
+    SegmentationParams params = m_segmentationParams;
+    m_analysisWatcher->setFuture(QtConcurrent::run([points, params]() {
+        TrackAnalyzer analyzer;
+        analyzer.setParams(params);
+        TrackSegmentation run;
+        run.profile = analyzer.prepare(points);
+        run.analysis = AnalysisCache().analyze(analyzer, points, run.profile);
+        run.points = points;
+        return run;
+    }));
+}
+
+void TrackStatsWidget::startMetrics(const TrackView& track) {
+    // Results of the previous track would be misread against this one
+    m_columns.reset();
+    m_motion = MotionProfile();
+    m_bestEfforts.clear();
+    m_pacing = PacingEstimate();
+    m_powerCurve = PowerCurve();
+    m_zones = ZoneReport();
+    m_gains = ElevationGainReport();
+    m_rangeStats = TrackRangeStats();
+    m_terrain = TerrainData();
+    m_projectedFastest = m_projectedSlowest = 0.0;
+    updatePowerCurveList();
+    updateZonesList();
+    updateGainsList();
+    updateSplitsTable();
+    updateMotionSummary();
+    
+    // The power curve alone is hundreds of passes and the pacing sweep several Newton
+    // solves, so all of it runs on the thread pool from a single copy of the track
+    std::vector<TrackPoint> points = track.toPoints();
+    m_metricsWatcher->setFuture(QtConcurrent::run([points]() {
+        TrackMetrics metrics;
+        std::shared_ptr<TrackColumns> columns = std::make_shared<TrackColumns>(TrackColumns::fromPoints(points));
+        metrics.motion = MotionAnalyzer().analyze(*columns);
+        metrics.bestEfforts = BestEffortFinder().find(*columns);
+        metrics.powerCurve = PowerCurve::compute(*columns);
         
-        for (int j = -halfWindow; j <= halfWindow; j++) {
-            int idx = static_cast<int>(i) + j;
-            
-            if (idx >= 0 && idx < static_cast<int>(points.size())) {
-                // If points are close in distance, apply the kernel weight
-                if (j == 0 || 
-                    (idx > 0 && points[idx].distance - points[idx-1].distance < 100.0)) {
-                    double weight = kernel[j + halfWindow];
-                    sum += gradients[idx] * weight;
-                    weightSum += weight;
-                }
-            }
-        }
+        // Projected time with default rider parameters, and the range for stronger and weaker riders
+        RiderParams rider;
+        metrics.pacing = PacingModel(rider).estimate(*columns);
+        std::vector<RiderParams> grid(2, rider);
+        grid[0].power *= 1.0 + PROJECTION_POWER_SPREAD;
+        grid[1].power *= 1.0 - PROJECTION_POWER_SPREAD;
+        std::vector<double> times = PacingModel::sweep(*columns, grid);
+        metrics.projectedFastest = times[0];
+        metrics.projectedSlowest = times[1];
         
-        smoothedGradients[i] = (weightSum > 0) ? (sum / weightSum) : gradients[i];
+        // Splits come from the range tables, so re-cutting them on unit or interval changes is free
+        metrics.rangeStats = TrackRangeStats(points);
+        metrics.columns = columns;
+        return metrics;
+    }));
+}
+
+void TrackStatsWidget::handleMetricsFinished() {
+    // A cancelled run belongs to a cleared track
+    if (m_metricsWatcher->isCanceled()) {
+        return;
     }
     
-    return smoothedGradients;
+    TrackMetrics metrics = m_metricsWatcher->result();
+    m_columns = metrics.columns;
+    m_motion = std::move(metrics.motion);
+    m_bestEfforts = std::move(metrics.bestEfforts);
+    m_powerCurve = std::move(metrics.powerCurve);
+    m_pacing = std::move(metrics.pacing);
+    m_projectedFastest = metrics.projectedFastest;
+    m_projectedSlowest = metrics.projectedSlowest;
+    m_rangeStats = std::move(metrics.rangeStats);
+    
+    // Zones and gains depend on settings and terrain that may change meanwhile; both are single passes
+    m_zones = ZoneAnalyzer(m_zoneSettings).analyze(*m_columns);
+    updateElevationGains(*m_columns);
+    updatePowerCurveList();
+    updateZonesList();
+    updateSplitsTable();
+    updateMotionSummary();
+    emit metricsChanged();
 }
 
-std::vector<size_t> TrackStatsWidget::identifySegmentBoundaries(
-    const std::vector<TrackPoint>& points, 
-    const std::vector<double>& smoothGradients) 
-{
-    const double GRADIENT_THRESHOLD_FLAT = 1.5; // Slightly increased for better sensitivity
-    const double SEGMENT_CHANGE_THRESHOLD = 2.5; // Slightly decreased for more sensitive detection
-    const double MIN_SEGMENT_DISTANCE = 300.0; // Shorter minimum segment length for better detail
-    
-    std::vector<size_t> boundaries;
-    boundaries.push_back(0);
-    
-    enum class GradientType { FLAT, CLIMB, DESCENT };
-    
-    // Determine initial segment type
-    GradientType currentType = GradientType::FLAT;
-    if (points.size() > 1) {
-        if (smoothGradients[1] > GRADIENT_THRESHOLD_FLAT) {
-            currentType = GradientType::CLIMB;
-        } else if (smoothGradients[1] < -GRADIENT_THRESHOLD_FLAT) {
-            currentType = GradientType::DESCENT;
-        }
+void TrackStatsWidget::handleAnalysisFinished() {
+    // The watcher only reports the most recent run; a cancelled one belongs to a cleared track
+    if (m_analysisWatcher->isCanceled()) {
+        return;
     }
     
-    // Use a more sophisticated approach for detecting changes
-    const int STABILITY_WINDOW = 7; // Smaller window for quicker response
-    std::deque<GradientType> recentTypes(STABILITY_WINDOW, currentType);
-    
-    for (size_t i = 1; i < points.size(); i++) {
-        // Determine point type from smoothed gradient
-        GradientType pointType;
-        if (smoothGradients[i] > GRADIENT_THRESHOLD_FLAT) {
-            pointType = GradientType::CLIMB;
-        } else if (smoothGradients[i] < -GRADIENT_THRESHOLD_FLAT) {
-            pointType = GradientType::DESCENT;
-        } else {
-            pointType = GradientType::FLAT;
-        }
-        
-        // Update recent types
-        recentTypes.pop_front();
-        recentTypes.push_back(pointType);
-        
-        // Check if there's a stable type change
-        std::map<GradientType, int> typeCounts;
-        for (const auto& type : recentTypes) {
-            typeCounts[type]++;
-        }
-        
-        // Find the dominant type in the window
-        GradientType dominantType = currentType;
-        int maxCount = 0;
-        
-        // Use a different approach instead of C++17 structured bindings
-        for (auto typeCountPair : typeCounts) {
-            GradientType type = typeCountPair.first;
-            int count = typeCountPair.second;
-            if (count > maxCount) {
-                maxCount = count;
-                dominantType = type;
-            }
-        }
-        
-        // If the dominant type is different and stable (above threshold), register a change
-        if (dominantType != currentType && 
-            typeCounts[dominantType] >= (STABILITY_WINDOW * 2 / 3) && 
-            (i > 0) && 
-            (points[i].distance - points[boundaries.back()].distance >= MIN_SEGMENT_DISTANCE)) {
-            
-            // Calculate average gradients for current and new segment
-            double avgCurrentGradient = 0.0;
-            double avgNewGradient = 0.0;
-            
-            // Sample current segment
-            for (size_t j = boundaries.back(); j < i; j++) {
-                avgCurrentGradient += smoothGradients[j];
-            }
-            avgCurrentGradient /= (i - boundaries.back());
-            
-            // Sample potential new segment
-            size_t sampleEnd = std::min(i + STABILITY_WINDOW, points.size());
-            for (size_t j = i; j < sampleEnd; j++) {
-                avgNewGradient += smoothGradients[j];
-            }
-            avgNewGradient /= (sampleEnd - i);
-            
-            // Only create a new segment if the gradient change is significant
-            if (std::abs(avgNewGradient - avgCurrentGradient) >= SEGMENT_CHANGE_THRESHOLD) {
-                boundaries.push_back(i);
-                currentType = dominantType;
-            }
-        }
+    TrackSegmentation run = m_analysisWatcher->result();
+    m_analysis = std::move(run.analysis);
+    m_gradientProfile = std::move(run.profile);
+    m_analysisPoints = std::move(run.points);
+    updateMiniProfile(m_track);
+    updateSegmentsList();
+    updateSegmentSummary();
+    emit analysisChanged(m_analysis);
+}
+
+void TrackStatsWidget::handleThresholdChanged() {
+    m_segmentationParams.flatThreshold = m_flatThresholdSlider->value() / 10.0;
+    m_segmentationParams.changeThreshold = m_changeThresholdSlider->value() / 10.0;
+    m_segmentationParams.minBoundaryDistance = m_minSegmentSlider->value();
+    m_segmentationParams.similarGradientThreshold = m_mergeThresholdSlider->value() / 10.0;
+    updateThresholdLabels();
+    if (m_track.empty()) {
+        return;
     }
     
-    // Always include the last point
-    if (boundaries.back() != points.size() - 1) {
-        boundaries.push_back(points.size() - 1);
+    // Until the background run has prepared smoothing and climbs, restart it with the new thresholds
+    if (m_gradientProfile.isEmpty()) {
+        startAnalysis(m_track);
+        return;
     }
     
-    return boundaries;
+    // Smoothing and climbs don't depend on the thresholds, so a slider move only re-runs
+    // boundary detection and merging
+    TrackAnalyzer analyzer;
+    analyzer.setParams(m_segmentationParams);
+    m_analysis = analyzer.segment(m_analysisPoints, m_gradientProfile);
+    m_segmentDetailsWidget->setVisible(false);
+    updateMiniProfile(m_track);
+    updateSegmentsList();
+    updateSegmentSummary();
+    emit analysisChanged(m_analysis);
 }
 
-std::vector<TrackSegment> TrackStatsWidget::createRawSegments(
-    const std::vector<TrackPoint>& points,
-    const std::vector<double>& smoothGradients,
-    const std::vector<size_t>& boundaries)
-{
-    const double GRADIENT_THRESHOLD_FLAT = 1.0;
-    const size_t MIN_SEGMENT_POINTS = 5;
-    const double MIN_SEGMENT_DISTANCE = 402.336;
+void TrackStatsWidget::updateThresholdLabels() {
+    m_flatThresholdValue->setText(formatGradient(m_segmentationParams.flatThreshold));
+    m_changeThresholdValue->setText(formatGradient(m_segmentationParams.changeThreshold));
+    m_minSegmentValue->setText(formatDistance(m_segmentationParams.minBoundaryDistance));
+    m_mergeThresholdValue->setText(formatGradient(m_segmentationParams.similarGradientThreshold));
+}
+
+void TrackStatsWidget::updateSegmentSummary() {
+    m_uphillPercentLabel->setText(QString("%1%").arg(m_analysis.uphillPercent(), 0, 'f', 1));
+    m_downhillPercentLabel->setText(QString("%1%").arg(m_analysis.downhillPercent(), 0, 'f', 1));
+    m_flatPercentLabel->setText(QString("%1%").arg(m_analysis.flatPercent(), 0, 'f', 1));
     
-    std::vector<TrackSegment> segments;
+    m_steepestUphillLabel->setText(formatGradient(m_analysis.steepestUphill()));
+    m_steepestUphillLabel->setStyleSheet(getGradientColorStyle(m_analysis.steepestUphill()));
     
-    for (size_t i = 0; i < boundaries.size() - 1; i++) {
-        size_t startIdx = boundaries[i];
-        size_t endIdx = boundaries[i+1];
-        
-        if (endIdx - startIdx < MIN_SEGMENT_POINTS) continue;
-        
-        double segmentDistance = points[endIdx].distance - points[startIdx].distance;
-        if (segmentDistance < MIN_SEGMENT_DISTANCE) continue;
-        
-        double segmentElevChange = points[endIdx].elevation - points[startIdx].elevation;
-        
-        double sumGradient = 0.0;
-        double maxGradient = -100.0;
-        double minGradient = 100.0;
-        
-        for (size_t j = startIdx; j <= endIdx; j++) {
-            sumGradient += smoothGradients[j];
-            maxGradient = std::max(maxGradient, smoothGradients[j]);
-            minGradient = std::min(minGradient, smoothGradients[j]);
-        }
-        
-        double avgGradient = sumGradient / (endIdx - startIdx + 1);
-        
-        TrackSegment::Type segmentType = TrackSegment::FLAT;
-        if (avgGradient > GRADIENT_THRESHOLD_FLAT) {
-            segmentType = TrackSegment::CLIMB;
-        } else if (avgGradient < -GRADIENT_THRESHOLD_FLAT) {
-            segmentType = TrackSegment::DESCENT;
-        }
-        
-        TrackSegment segment;
-        segment.type = segmentType;
-        segment.startIndex = startIdx;
-        segment.endIndex = endIdx;
-        segment.distance = segmentDistance;
-        segment.elevationChange = segmentElevChange;
-        segment.avgGradient = avgGradient;
-        segment.maxGradient = maxGradient;
-        segment.minGradient = minGradient;
-        
-        segments.push_back(segment);
-    }
+    m_steepestDownhillLabel->setText(formatGradient(m_analysis.steepestDownhill()));
+    m_steepestDownhillLabel->setStyleSheet(getGradientColorStyle(m_analysis.steepestDownhill()));
     
-    return segments;
+    updateClimbsList();
 }
 
-std::vector<TrackSegment> TrackStatsWidget::optimizeSegments(
-    const std::vector<TrackSegment>& rawSegments,
-    const std::vector<TrackPoint>& points)
-{
-    if (rawSegments.empty()) return rawSegments;
+void TrackStatsWidget::updateMotionSummary() {
+    updateBestEffortsList();
     
-    const double SIMILAR_GRADIENT_THRESHOLD = 3.0; // Slightly decreased for more precise segmentation
-    const double TINY_SEGMENT_THRESHOLD = 300.0; // Shorter to allow more detailed segments
-    const double SMALL_SEGMENT_THRESHOLD = 500.0;
+    if (m_pacing.elapsed.empty()) {
+        m_projectedTimeLabel->setText("-");
+    } else {
+        m_projectedTimeLabel->setText(QString("%1 (%2 - %3)")
+            .arg(formatDuration(m_pacing.totalTime()))
+            .arg(formatDuration(m_projectedFastest))
+            .arg(formatDuration(m_projectedSlowest)));
+    }
     
-    std::vector<TrackSegment> mergedSegments;
-    TrackSegment currentSegment = rawSegments[0];
+    if (!m_motion.hasTime()) {
+        m_elapsedTimeLabel->setText("-");
+        m_movingTimeLabel->setText("-");
+        m_avgMovingSpeedLabel->setText("-");
+        m_maxSpeedLabel->setText("-");
+        return;
+    }
     
-    for (size_t i = 1; i < rawSegments.size(); i++) {
-        const TrackSegment& nextSegment = rawSegments[i];
-        bool shouldMerge = false;
-        
-        // Check if segments are of the same type and similar gradient
-        if (nextSegment.type == currentSegment.type) {
-            double gradientDiff = std::abs(nextSegment.avgGradient - currentSegment.avgGradient);
-            if (gradientDiff < SIMILAR_GRADIENT_THRESHOLD) {
-                shouldMerge = true;
-            }
+    m_elapsedTimeLabel->setText(formatDuration(m_motion.elapsedTime));
+    m_movingTimeLabel->setText(formatDuration(m_motion.movingTime));
+    m_avgMovingSpeedLabel->setText(formatSpeed(m_motion.averageMovingSpeed()));
+    m_maxSpeedLabel->setText(formatSpeed(m_motion.maxSpeed));
+}
+
+void TrackStatsWidget::updatePowerCurveList() {
+    if (m_powerCurve.isEmpty()) {
+        m_powerCurveLabel->setText("No power data");
+        return;
+    }
+    
+    QStringList lines;
+    const int durations[] = {5, 60, 300, 1200, 3600};
+    const char* names[] = {"5 s", "1 min", "5 min", "20 min", "60 min"};
+    for (int i = 0; i < 5; ++i) {
+        if (durations[i] > m_powerCurve.points().back().duration) {
+            break;
         }
-        
-        // Merge tiny segments with larger ones to avoid fragmentation
-        if (!shouldMerge && nextSegment.distance < TINY_SEGMENT_THRESHOLD) {
-            shouldMerge = true;
+        lines << QString("<b>%1</b>: %2 W").arg(names[i]).arg(qRound(m_powerCurve.powerAt(durations[i])));
+    }
+    if (m_powerCurve.criticalPower() > 0.0) {
+        lines << QString("<b>CP</b>: %1 W, <b>W'</b>: %2 kJ")
+                 .arg(qRound(m_powerCurve.criticalPower()))
+                 .arg(m_powerCurve.anaerobicCapacity() / 1000.0, 0, 'f', 1);
+    }
+    m_powerCurveLabel->setText(lines.join("<br>"));
+}
+
+namespace {
+    // "Z1 < 114", "Z2 114-133", ..., "Z5 >= 171" lines with the time and share of one histogram
+    QStringList zoneLines(const ZoneHistogram& histogram, const QString& unit, bool byDistance) {
+        QStringList lines;
+        const double total = byDistance ? histogram.totalDistance() : histogram.totalTime();
+        for (size_t zone = 0; zone < histogram.zoneCount(); ++zone) {
+            QString range;
+            if (zone == 0) {
+                range = QString("&lt; %1").arg(histogram.bounds.front());
+            } else if (zone == histogram.bounds.size()) {
+                range = QString("&ge; %1").arg(histogram.bounds.back());
+            } else {
+                range = QString("%1 to %2").arg(histogram.bounds[zone - 1]).arg(histogram.bounds[zone]);
+            }
+            double share = (byDistance ? histogram.distance[zone] : histogram.time[zone]) / total * 100.0;
+            lines << QString("Z%1 (%2 %3): %4%").arg(zone + 1).arg(range).arg(unit).arg(share, 0, 'f', 1);
         }
-        
-        // Merge small segments with much larger next segments
-        if (!shouldMerge && 
-            currentSegment.distance < SMALL_SEGMENT_THRESHOLD &&
-            nextSegment.distance > currentSegment.distance * 2) {
-            shouldMerge = true;
+        return lines;
+    }
+}
+
+void TrackStatsWidget::updateZonesList() {
+    QStringList lines;
+    auto addChannel = [&](const QString& name, const ZoneHistogram& histogram, const QString& unit, bool byDistance) {
+        if (histogram.isEmpty()) {
+            return;
         }
-        
-        if (shouldMerge) {
-            // Special handling for flat-to-flat transitions to preserve important features
-            if (currentSegment.type == TrackSegment::FLAT && nextSegment.type == TrackSegment::FLAT &&
-                std::abs(currentSegment.avgGradient - nextSegment.avgGradient) > 1.0) {
-                // Don't merge significantly different flat segments
-                mergedSegments.push_back(currentSegment);
-                currentSegment = nextSegment;
-                continue;
-            }
-            
-            // Update current segment by merging with next segment
-            currentSegment.endIndex = nextSegment.endIndex;
-            currentSegment.distance += nextSegment.distance;
-            currentSegment.elevationChange += nextSegment.elevationChange;
-            
-            // Recalculate gradient stats
-            currentSegment.maxGradient = std::max(currentSegment.maxGradient, nextSegment.maxGradient);
-            currentSegment.minGradient = std::min(currentSegment.minGradient, nextSegment.minGradient);
-            
-            // Get more accurate average gradient using start and end points
-            currentSegment.avgGradient = currentSegment.elevationChange / currentSegment.distance * 100.0;
-            
-            // Re-evaluate segment type based on merged gradient
-            if (nextSegment.type != currentSegment.type) {
-                if (currentSegment.avgGradient > 1.5) {
-                    currentSegment.type = TrackSegment::CLIMB;
-                } else if (currentSegment.avgGradient < -1.5) {
-                    currentSegment.type = TrackSegment::DESCENT;
-                } else {
-                    currentSegment.type = TrackSegment::FLAT;
-                }
-            }
+        lines << QString("<b>%1</b>, %2").arg(name)
+                 .arg(byDistance ? formatDistance(histogram.totalDistance()) : formatDuration(histogram.totalTime()));
+        lines << zoneLines(histogram, unit, byDistance);
+    };
+    // Sensor zones are shared out by time, falling back to distance on untimed tracks;
+    // gradient zones are a property of the route, so they always go by distance
+    addChannel("Heart rate", m_zones.heartRate, "bpm", m_zones.heartRate.totalTime() <= 0.0);
+    addChannel("Power", m_zones.power, "W", m_zones.power.totalTime() <= 0.0);
+    addChannel("Gradient", m_zones.gradient, "%", true);
+    m_zonesLabel->setText(lines.isEmpty() ? QString("No zone data") : lines.join("<br>"));
+}
+
+void TrackStatsWidget::updateSplitsTable() {
+    const int minutes = m_splitIntervalCombo->currentData().toInt();
+    const bool byDistance = minutes == SPLIT_PER_DISTANCE;
+    if (byDistance) {
+        m_splits = m_rangeStats.splitsByDistance(m_useMetricUnits ? 1000.0 : METERS_PER_MILE);
+    } else {
+        m_splits = m_rangeStats.splitsByTime(minutes * 60.0);
+    }
+    
+    // Distance splits show their time, time splits the distance covered
+    m_splitsTable->setHorizontalHeaderItem(1, new QTableWidgetItem(byDistance ? "Time" : "Dist"));
+    m_splitsTable->setRowCount(static_cast<int>(m_splits.size()));
+    for (size_t i = 0; i < m_splits.size(); ++i) {
+        const RangeStats& split = m_splits[i];
+        QString measure;
+        if (!byDistance) {
+            measure = formatDistance(split.distance);
+        } else if (!qIsNaN(split.duration)) {
+            measure = formatDuration(split.duration);
+        } else if (split.endIndex < m_pacing.elapsed.size()) {
+            // Untimed track: the pacing model's projection, marked as an estimate
+            measure = "~" + formatDuration(m_pacing.elapsed[split.endIndex] - m_pacing.elapsed[split.startIndex]);
         } else {
-            mergedSegments.push_back(currentSegment);
-            currentSegment = nextSegment;
+            measure = "-";
         }
+        
+        int row = static_cast<int>(i);
+        m_splitsTable->setItem(row, 0, new QTableWidgetItem(QString::number(i + 1)));
+        m_splitsTable->setItem(row, 1, new QTableWidgetItem(measure));
+        m_splitsTable->setItem(row, 2, new QTableWidgetItem(formatElevation(split.elevationGain)));
+        m_splitsTable->setItem(row, 3, new QTableWidgetItem(formatGradient(split.avgGradient)));
+        m_splitsTable->setItem(row, 4, new QTableWidgetItem(formatSpeed(split.avgSpeed)));
+    }
+}
+
+void TrackStatsWidget::updateGainsList() {
+    if (m_track.empty()) {
+        m_gainsLabel->setText("-");
+        return;
     }
     
-    // Add the last segment
-    mergedSegments.push_back(currentSegment);
-    
-    // Final pass: consistent segment type calculation
-    for (auto& segment : mergedSegments) {
-        // Calculate actual start-to-end gradient for better accuracy
-        double startElev = points[segment.startIndex].elevation;
-        double endElev = points[segment.endIndex].elevation;
-        double actualDistance = points[segment.endIndex].distance - points[segment.startIndex].distance;
-        
-        if (actualDistance > 0) {
-            double actualGradient = ((endElev - startElev) / actualDistance) * 100.0;
-            segment.avgGradient = actualGradient;
-            
-            // Recalculate segment type based on the more accurate gradient
-            if (segment.avgGradient > 1.5) {
-                segment.type = TrackSegment::CLIMB;
-            } else if (segment.avgGradient < -1.5) {
-                segment.type = TrackSegment::DESCENT;
-            } else {
-                segment.type = TrackSegment::FLAT;
-            }
+    GainParams params;
+    QStringList lines;
+    lines << QString("<b>Threshold</b> (%1): %2").arg(formatElevation(params.threshold)).arg(formatElevation(m_gains.threshold));
+    lines << QString("<b>Hysteresis</b> (%1): %2").arg(formatElevation(params.hysteresisBand)).arg(formatElevation(m_gains.hysteresis));
+    lines << QString("<b>Smoothed</b> (%1): %2").arg(formatDistance(params.smoothingWindow)).arg(formatElevation(m_gains.smoothed));
+    lines << QString("<b>DEM</b>: %1").arg(qIsNaN(m_gains.dem) ? QString("-") : formatElevation(m_gains.dem));
+    lines << QString("<b>Raw</b>: %1").arg(formatElevation(m_gains.raw));
+    m_gainsLabel->setText(lines.join("<br>"));
+}
+
+void TrackStatsWidget::updateBestEffortsList() {
+    QStringList lines;
+    for (const BestEffort& effort : m_bestEfforts) {
+        if (!effort.found) {
+            continue;
+        }
+        if (effort.kind == BestEffort::FASTEST_DISTANCE) {
+            lines << QString("<b>%1</b>: %2 (%3)")
+                     .arg(formatDistance(effort.window))
+                     .arg(formatDuration(effort.duration))
+                     .arg(formatSpeed(effort.speed()));
+        } else {
+            double rate = m_useMetricUnits ? effort.climbRate() : metersToFeet(effort.climbRate());
+            lines << QString("<b>%1 min climb</b>: %2 %3/h")
+                     .arg(qRound(effort.window / 60.0))
+                     .arg(rate, 0, 'f', 0)
+                     .arg(m_useMetricUnits ? "m" : "ft");
         }
     }
-    
-    return mergedSegments;
+    if (lines.isEmpty()) {
+        m_bestEffortsLabel->setText(m_motion.hasTime() ? "Track too short" : "No timestamps");
+        return;
+    }
+    m_bestEffortsLabel->setText(lines.join("<br>"));
 }
 
-void TrackStatsWidget::updateMiniProfile(const GPXParser& parser) {
-    const std::vector<TrackPoint>& points = parser.getPoints();
+void TrackStatsWidget::updateClimbsList() {
+    const std::vector<Climb>& climbs = m_analysis.climbs();
+    if (climbs.empty()) {
+        m_climbsLabel->setText("No categorized climbs");
+        return;
+    }
     
+    QStringList lines;
+    for (const Climb& climb : climbs) {
+        lines << QString("<b>%1</b> at %2: %3, %4 gain, %5 avg")
+                 .arg(ClimbDetector::categoryName(climb.category))
+                 .arg(formatDistance(m_track.distanceAt(climb.startIndex)))
+                 .arg(formatDistance(climb.distance))
+                 .arg(formatElevation(climb.elevationGain))
+                 .arg(formatGradient(climb.avgGradient));
+    }
+    m_climbsLabel->setText(lines.join("<br>"));
+}
+
+void TrackStatsWidget::updateMiniProfile(const TrackView& track) {
     m_miniProfile->graph(0)->data()->clear();
     m_miniProfile->graph(1)->data()->clear();
     
-    if (points.empty()) {
+    if (track.empty()) {
         m_miniProfile->replot();
         return;
     }
     
     QVector<double> x, y;
-    x.reserve(points.size());
-    y.reserve(points.size());
-    
-    for (const auto& point : points) {
-        double xVal = m_useMetricUnits ? metersToKilometers(point.distance) : metersToMiles(point.distance);
-        double yVal = m_useMetricUnits ? point.elevation : metersToFeet(point.elevation);
+    x.reserve(track.size());
+    y.reserve(track.size());
+    
+    for (size_t i = 0; i < track.size(); ++i) {
+        double distance = track.distanceAt(i);
+        double elevation = track.sourcePoint(i).elevation;
+        double xVal = m_useMetricUnits ? metersToKilometers(distance) : metersToMiles(distance);
+        double yVal = m_useMetricUnits ? elevation : metersToFeet(elevation);
         x.append(xVal);
         y.append(yVal);
     }
     
     m_miniProfile->graph(0)->setData(x, y);
     
-    double minElev = m_useMetricUnits ? parser.getMinElevation() : metersToFeet(parser.getMinElevation());
-    double maxElev = m_useMetricUnits ? parser.getMaxElevation() : metersToFeet(parser.getMaxElevation());
+    double minElev = m_useMetricUnits ? track.minElevation() : metersToFeet(track.minElevation());
+    double maxElev = m_useMetricUnits ? track.maxElevation() : metersToFeet(track.maxElevation());
     double elevRange = maxElev - minElev;
-    double totalDist = m_useMetricUnits ? metersToKilometers(parser.getTotalDistance()) 
-                                       : metersToMiles(parser.getTotalDistance());
+    double totalDist = m_useMetricUnits ? metersToKilometers(track.totalDistance()) 
+                                       : metersToMiles(track.totalDistance());
     
     minElev -= elevRange * 0.08;
     maxElev += elevRange * 0.08;
@@ -853,15 +1045,20 @@ void TrackStatsWidget::updateMiniProfile(const GPXParser& parser) {
     m_miniProfile->setBackground(QColor("#f8f9fa"));
     m_miniProfile->axisRect()->setBackground(QColor("#ffffff"));
     
-    if (!m_segments.empty()) {
+    // Segment overlays are rebuilt from the current analysis (none while it is running)
+    while (m_miniProfile->graphCount() > 2) {
+        m_miniProfile->removeGraph(m_miniProfile->graphCount() - 1);
+    }
+    
+    // The whole track fits the plot, so long tracks show the coarser hierarchy levels
+    double metersPerPixel = track.totalDistance() / std::max(1, m_miniProfile->axisRect()->width());
+    int level = m_analysis.levelForResolution(metersPerPixel * MIN_PROFILE_SEGMENT_PIXELS);
+    const std::vector<TrackSegment>& segments = m_analysis.segmentsAtLevel(level);
+    if (!segments.empty()) {
         QCPGraph* segGraph = nullptr;
         
-        while (m_miniProfile->graphCount() > 2) {
-            m_miniProfile->removeGraph(m_miniProfile->graphCount() - 1);
-        }
-        
-        for (size_t i = 0; i < m_segments.size(); i++) {
-            const TrackSegment& segment = m_segments[i];
+        for (size_t i = 0; i < segments.size(); i++) {
+            const TrackSegment& segment = segments[i];
             
             segGraph = m_miniProfile->addGraph();
             
@@ -892,10 +1089,11 @@ void TrackStatsWidget::updateMiniProfile(const GPXParser& parser) {
             segGraph->setBrush(QBrush(segColor.lighter(120)));
             
             QVector<double> segX, segY;
-            for (size_t j = segment.startIndex; j <= segment.endIndex && j < points.size(); j++) {
-                double xVal = m_useMetricUnits ? metersToKilometers(points[j].distance) 
-                                             : metersToMiles(points[j].distance);
-                double yVal = m_useMetricUnits ? points[j].elevation : metersToFeet(points[j].elevation);
+            for (size_t j = segment.startIndex; j <= segment.endIndex && j < track.size(); j++) {
+                double distance = track.distanceAt(j);
+                double elevation = track.sourcePoint(j).elevation;
+                double xVal = m_useMetricUnits ? metersToKilometers(distance) : metersToMiles(distance);
+                double yVal = m_useMetricUnits ? elevation : metersToFeet(elevation);
                 segX.append(xVal);
                 segY.append(yVal);
             }
@@ -905,11 +1103,12 @@ void TrackStatsWidget::updateMiniProfile(const GPXParser& parser) {
         
         m_miniProfile->graph(1)->setLayer("overlay");
         
-        if (!points.empty() && m_miniProfile->graphCount() > 1) {
+        if (m_miniProfile->graphCount() > 1) {
             QCPGraph* gridGraph = m_miniProfile->addGraph();
             gridGraph->setPen(QPen(QColor(200, 200, 200, 70), 1, Qt::DashLine));
             
-            double yVal = m_useMetricUnits ? points[0].elevation : metersToFeet(points[0].elevation);
+            double startElevation = track.sourcePoint(0).elevation;
+            double yVal = m_useMetricUnits ? startElevation : metersToFeet(startElevation);
             QVector<double> xData = {0, totalDist};
             QVector<double> yData = {yVal, yVal};
             gridGraph->setData(xData, yData);
@@ -927,8 +1126,9 @@ void TrackStatsWidget::updateSegmentsList() {
         delete child;
     }
     
-    for (size_t i = 0; i < m_segments.size(); i++) {
-        const TrackSegment& segment = m_segments[i];
+    const std::vector<TrackSegment>& segments = m_analysis.segments();
+    for (size_t i = 0; i < segments.size(); i++) {
+        const TrackSegment& segment = segments[i];
         
         QString segmentTypeText;
         QString segmentIcon;
@@ -972,12 +1172,13 @@ void TrackStatsWidget::updateSegmentsList() {
 }
 
 void TrackStatsWidget::showSegmentDetails(int segmentIndex) {
-    if (segmentIndex < 0 || segmentIndex >= static_cast<int>(m_segments.size())) {
+    if (segmentIndex < 0 || segmentIndex >= static_cast<int>(m_analysis.segments().size())) {
         m_segmentDetailsWidget->setVisible(false);
+        updateClimbsList();
         return;
     }
     
-    const TrackSegment& segment = m_segments[segmentIndex];
+    const TrackSegment& segment = m_analysis.segments()[segmentIndex];
     
     QString segmentType;
     switch (segment.type) {
@@ -1075,3 +1276,34 @@ QString TrackStatsWidget::formatElevation(double meters) const {
 QString TrackStatsWidget::formatGradient(double gradient) const {
     return QString("%1%").arg(gradient, 0, 'f', 1);
 }
+
+QString TrackStatsWidget::formatDuration(double seconds) const {
+    qint64 total = qRound64(seconds);
+    return QString("%1:%2:%3")
+        .arg(total / 3600)
+        .arg((total / 60) % 60, 2, 10, QChar('0'))
+        .arg(total % 60, 2, 10, QChar('0'));
+}
+
+QString TrackStatsWidget::formatSpeed(double metersPerSecond) const {
+    if (qIsNaN(metersPerSecond)) {
+        return "-";
+    }
+    if (m_useMetricUnits) {
+        return QString("%1 km/h").arg(metersPerSecond * 3.6, 0, 'f', 1);
+    } else {
+        return QString("%1 mph").arg(metersPerSecond * 2.23694, 0, 'f', 1);
+    }
+}
+
+QString TrackStatsWidget::formatPace(double secondsPerKilometer) const {
+    if (qIsNaN(secondsPerKilometer)) {
+        return "-";
+    }
+    // Pace per mile is the time for 1.609 km
+    qint64 seconds = qRound64(m_useMetricUnits ? secondsPerKilometer : secondsPerKilometer * 1.609344);
+    return QString("%1:%2 %3")
+        .arg(seconds / 60)
+        .arg(seconds % 60, 2, 10, QChar('0'))
+        .arg(m_useMetricUnits ? "/km" : "/mi");
+}
@@ -0,0 +1,275 @@
+#include "TrackView.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double ELEVATION_GAIN_THRESHOLD = 0.6; // Same threshold as GPXParser::getCumulativeElevationGain
+}
+
+double TrackView::Range::length() const
+{
+    return std::abs(last().distance - first().distance);
+}
+
+double TrackView::Range::gradient(size_t offset) const
+{
+    if (!reversed) {
+        return (*store)[begin + offset].gradient;
+    }
+    // Stored gradients describe the step from the previous point, which once reversed is the
+    // step from the next stored one; the last stored point has no next one and keeps its own
+    const size_t index = end - 1 - offset;
+    const std::vector<TrackPoint>& points = *store;
+    return -(index + 1 < points.size() ? points[index + 1] : points[index]).gradient;
+}
+
+TrackView::TrackView(PointStore store)
+{
+    if (store && !store->empty()) {
+        Range range;
+        range.store = std::move(store);
+        range.end = range.store->size();
+        appendRange(range);
+        updateOffsets();
+    }
+}
+
+TrackView TrackView::fromPoints(std::vector<TrackPoint> points)
+{
+    return TrackView(std::make_shared<const std::vector<TrackPoint>>(std::move(points)));
+}
+
+const TrackView::Range& TrackView::rangeFor(size_t index) const
+{
+    if (m_ranges.size() == 1) {
+        return m_ranges[0];
+    }
+
+    // Last range starting at or before the index
+    auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), index,
+                               [](size_t value, const Range& range) { return value < range.viewStart; });
+    return *(it - 1);
+}
+
+TrackPoint TrackView::at(size_t index) const
+{
+    TrackPoint point = sourcePoint(index);
+    point.distance = distanceAt(index);
+    point.gradient = gradientAt(index);
+    return point;
+}
+
+const TrackPoint& TrackView::sourcePoint(size_t index) const
+{
+    const Range& range = rangeFor(index);
+    return (*range.store)[range.sourceIndex(index - range.viewStart)];
+}
+
+double TrackView::distanceAt(size_t index) const
+{
+    const Range& range = rangeFor(index);
+    const TrackPoint& point = (*range.store)[range.sourceIndex(index - range.viewStart)];
+    return range.distanceStart + std::abs(point.distance - range.first().distance);
+}
+
+double TrackView::gradientAt(size_t index) const
+{
+    const Range& range = rangeFor(index);
+    return range.gradient(index - range.viewStart);
+}
+
+double TrackView::totalDistance() const
+{
+    if (m_ranges.isEmpty()) {
+        return 0.0;
+    }
+    const Range& last = m_ranges.last();
+    return last.distanceStart + last.length();
+}
+
+double TrackView::cumulativeElevationGain(size_t upToIndex) const
+{
+    if (m_size == 0) {
+        return 0.0;
+    }
+
+    size_t lastIndex = std::min(upToIndex, m_size - 1);
+    double elevationGain = 0.0;
+    double previous = sourcePoint(0).elevation;
+    for (size_t i = 1; i <= lastIndex; ++i) {
+        double elevation = sourcePoint(i).elevation;
+        double diff = elevation - previous;
+        if (diff > ELEVATION_GAIN_THRESHOLD) {
+            elevationGain += diff;
+        }
+        previous = elevation;
+    }
+    return elevationGain;
+}
+
+double TrackView::totalElevationGain() const
+{
+    return m_size == 0 ? 0.0 : cumulativeElevationGain(m_size - 1);
+}
+
+double TrackView::minElevation() const
+{
+    double result = 0.0;
+    for (const auto& range : m_ranges) {
+        auto it = std::min_element(range.store->begin() + range.begin, range.store->begin() + range.end,
+                                   [](const TrackPoint& a, const TrackPoint& b) { return a.elevation < b.elevation; });
+        result = (range.viewStart == 0) ? it->elevation : std::min(result, it->elevation);
+    }
+    return result;
+}
+
+double TrackView::maxElevation() const
+{
+    double result = 0.0;
+    for (const auto& range : m_ranges) {
+        auto it = std::max_element(range.store->begin() + range.begin, range.store->begin() + range.end,
+                                   [](const TrackPoint& a, const TrackPoint& b) { return a.elevation < b.elevation; });
+        result = (range.viewStart == 0) ? it->elevation : std::max(result, it->elevation);
+    }
+    return result;
+}
+
+TrackView TrackView::trimmed(size_t startIndex, size_t endIndex) const
+{
+    TrackView view;
+    if (m_size == 0 || startIndex > endIndex || startIndex >= m_size) {
+        return view;
+    }
+
+    const size_t stop = std::min(endIndex + 1, m_size);
+    for (const auto& range : m_ranges) {
+        size_t lo = std::max(startIndex, range.viewStart);
+        size_t hi = std::min(stop, range.viewStart + range.size());
+        if (lo >= hi) {
+            continue;
+        }
+
+        Range piece = range;
+        lo -= range.viewStart;
+        hi -= range.viewStart;
+        if (range.reversed) {
+            piece.begin = range.end - hi;
+            piece.end = range.end - lo;
+        } else {
+            piece.begin = range.begin + lo;
+            piece.end = range.begin + hi;
+        }
+        view.appendRange(piece);
+    }
+    view.updateOffsets();
+    return view;
+}
+
+std::pair<TrackView, TrackView> TrackView::splitAt(size_t index) const
+{
+    if (index == 0) {
+        return std::make_pair(TrackView(), *this);
+    }
+    if (index >= m_size) {
+        return std::make_pair(*this, TrackView());
+    }
+    return std::make_pair(trimmed(0, index - 1), trimmed(index, m_size - 1));
+}
+
+TrackView TrackView::reversed() const
+{
+    TrackView view;
+    for (int i = m_ranges.size() - 1; i >= 0; --i) {
+        Range range = m_ranges[i];
+        range.reversed = !range.reversed;
+        view.appendRange(range);
+    }
+    view.updateOffsets();
+    return view;
+}
+
+TrackView TrackView::concatenated(const TrackView& other) const
+{
+    TrackView view = *this;
+    for (const auto& range : other.m_ranges) {
+        view.appendRange(range);
+    }
+    view.updateOffsets();
+    return view;
+}
+
+std::vector<TrackPoint> TrackView::toPoints() const
+{
+    std::vector<TrackPoint> points;
+    points.reserve(m_size);
+
+    for (const auto& range : m_ranges) {
+        const double anchor = range.first().distance;
+        for (size_t offset = 0; offset < range.size(); ++offset) {
+            TrackPoint point = (*range.store)[range.sourceIndex(offset)];
+            point.distance = range.distanceStart + std::abs(point.distance - anchor);
+            point.gradient = range.gradient(offset);
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+bool TrackView::operator==(const TrackView& other) const
+{
+    if (m_size != other.m_size || m_ranges.size() != other.m_ranges.size()) {
+        return false;
+    }
+    for (int i = 0; i < m_ranges.size(); ++i) {
+        const Range& a = m_ranges[i];
+        const Range& b = other.m_ranges[i];
+        if (a.store != b.store || a.begin != b.begin || a.end != b.end || a.reversed != b.reversed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TrackView::appendRange(const Range& range)
+{
+    if (range.size() == 0) {
+        return;
+    }
+
+    // Re-joining adjacent pieces of the same store (e.g. after a split) keeps one range
+    if (!m_ranges.isEmpty()) {
+        Range& last = m_ranges.last();
+        if (last.store == range.store && last.reversed == range.reversed) {
+            if (!last.reversed && last.end == range.begin) {
+                last.end = range.end;
+                m_size += range.size();
+                return;
+            }
+            if (last.reversed && range.end == last.begin) {
+                last.begin = range.begin;
+                m_size += range.size();
+                return;
+            }
+        }
+    }
+
+    m_ranges.append(range);
+    m_size += range.size();
+}
+
+void TrackView::updateOffsets()
+{
+    size_t viewStart = 0;
+    double distanceStart = 0.0;
+    for (int i = 0; i < m_ranges.size(); ++i) {
+        Range& range = m_ranges[i];
+        if (i > 0) {
+            const Range& previous = m_ranges[i - 1];
+            distanceStart = previous.distanceStart + previous.length()
+                          + previous.last().coord.distanceTo(range.first().coord);
+        }
+        range.viewStart = viewStart;
+        range.distanceStart = distanceStart;
+        viewStart += range.size();
+    }
+}
@@ -0,0 +1,112 @@
+#include "ZoneHistogram.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+
+bool ZoneHistogram::isEmpty() const {
+    return totalTime() <= 0.0 && totalDistance() <= 0.0;
+}
+
+double ZoneHistogram::totalTime() const {
+    return std::accumulate(time.begin(), time.end(), 0.0);
+}
+
+double ZoneHistogram::totalDistance() const {
+    return std::accumulate(distance.begin(), distance.end(), 0.0);
+}
+
+ZoneSettings::ZoneSettings(double maxHeartRate, double functionalThresholdPower)
+    : gradientBounds({-8.0, -4.0, -1.0, 1.0, 4.0, 8.0})
+{
+    for (double share : {0.6, 0.7, 0.8, 0.9}) {
+        heartRateBounds.push_back(share * maxHeartRate);
+    }
+    for (double share : {0.55, 0.75, 0.9, 1.05, 1.2, 1.5}) {
+        powerBounds.push_back(share * functionalThresholdPower);
+    }
+}
+
+std::vector<double> ZoneSettings::parseBounds(const QString& text) {
+    std::vector<double> bounds;
+    for (const QString& part : text.split(',')) {
+        bool ok = false;
+        double value = part.trimmed().toDouble(&ok);
+        if (ok) {
+            bounds.push_back(value);
+        }
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    return bounds;
+}
+
+ZoneHistogram ZoneAnalyzer::histogram(const TrackColumns& columns, const std::vector<double>& values,
+                                      const std::vector<double>& bounds) const {
+    ZoneHistogram result;
+    result.bounds = bounds;
+    result.time.assign(bounds.size() + 1, 0.0);
+    result.distance.assign(bounds.size() + 1, 0.0);
+    
+    const size_t count = std::min(values.size(), columns.size());
+    if (count < 2) {
+        return result;
+    }
+    
+    const bool timed = columns.hasTimestamps();
+    const double maxGapMs = m_settings.maxGap * 1000.0;
+    std::vector<int> zones(count);
+    std::vector<double> seconds(count, 0.0);
+    std::vector<double> meters(count, 0.0);
+    
+    // Branch-free: comparisons become 0/1 factors, so NaN values (all
+    // comparisons false) and missing or paused intervals weigh nothing
+    for (size_t i = 1; i < count; ++i) {
+        const double value = values[i];
+        int zone = 0;
+        for (double bound : bounds) {
+            zone += (value >= bound);
+        }
+        const double present = (value == value);
+        zones[i] = zone;
+        meters[i] = present * (columns.distance[i] - columns.distance[i - 1]);
+        if (timed) {
+            const double dt = static_cast<double>(columns.timestampMs[i] - columns.timestampMs[i - 1]);
+            const double valid = columns.timestampValid(i) * columns.timestampValid(i - 1) *
+                                 (dt > 0.0) * (dt <= maxGapMs);
+            seconds[i] = present * valid * dt / 1000.0;
+        }
+    }
+    
+    for (size_t i = 1; i < count; ++i) {
+        result.time[zones[i]] += seconds[i];
+        result.distance[zones[i]] += meters[i];
+    }
+    return result;
+}
+
+ZoneReport ZoneAnalyzer::analyze(const TrackColumns& columns) const {
+    ZoneReport report;
+    report.heartRate = histogram(columns, columns.heartRate, m_settings.heartRateBounds);
+    report.power = histogram(columns, columns.power, m_settings.powerBounds);
+    report.gradient = histogram(columns, columns.gradient, m_settings.gradientBounds);
+    return report;
+}
+
+std::vector<ZoneReport> ZoneAnalyzer::analyzeBatch(const std::vector<TrackColumns>& tracks) const {
+    std::vector<std::pair<const TrackColumns*, ZoneReport>> jobs;
+    jobs.reserve(tracks.size());
+    for (const TrackColumns& columns : tracks) {
+        jobs.emplace_back(&columns, ZoneReport());
+    }
+    
+    QtConcurrent::blockingMap(jobs, [this](std::pair<const TrackColumns*, ZoneReport>& job) {
+        job.second = analyze(*job.first);
+    });
+    
+    std::vector<ZoneReport> reports;
+    reports.reserve(jobs.size());
+    for (auto& job : jobs) {
+        reports.push_back(std::move(job.second));
+    }
+    return reports;
+}
@@ -0,0 +1,148 @@
+#include "BatchAnalyzer.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QThreadPool>
+#include <cstdio>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/**
+ * Headless batch analysis of GPX files
+ *
+ * Usage: gpx_analyze [options] <file or directory>...
+ * Writes one JSON object or CSV row per file to stdout (or --output) and
+ * reports throughput and peak memory on stderr.
+ */
+
+namespace {
+
+// Peak resident set size of this process in bytes, 0 if unknown
+qint64 peakMemoryBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(Q_OS_MACOS)
+    return static_cast<qint64>(usage.ru_maxrss);          // bytes
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+#endif
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("RouteExplorer");
+    QCoreApplication::setApplicationName("GPX Viewer");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Analyze GPX files in parallel and write a summary per file.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption formatOption({"f", "format"}, "Output format: json or csv.", "format", "json");
+    QCommandLineOption outputOption({"o", "output"}, "Write to <file> instead of stdout.", "file");
+    QCommandLineOption jobsOption({"j", "jobs"}, "Number of worker threads (default: all cores).", "n");
+    QCommandLineOption cacheOption("cache", "Reuse segmentations from the viewer's analysis cache.");
+    QCommandLineOption maxHrOption("max-hr", "Maximum heart rate for the heart rate zones.", "bpm", "190");
+    QCommandLineOption ftpOption("ftp", "Functional threshold power for the power zones.", "watts", "250");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Print the per-file analysis log.");
+    parser.addOptions({formatOption, outputOption, jobsOption, cacheOption, maxHrOption, ftpOption, verboseOption});
+    parser.addPositionalArgument("paths", "GPX files or directories to search recursively.", "<path>...");
+    parser.process(app);
+
+    const QString format = parser.value(formatOption).toLower();
+    if (format != "json" && format != "csv") {
+        std::fprintf(stderr, "Unknown format '%s', expected json or csv\n", qPrintable(format));
+        return 2;
+    }
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(2);
+    }
+    if (parser.isSet(jobsOption)) {
+        const int jobs = parser.value(jobsOption).toInt();
+        if (jobs > 0) {
+            QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+        }
+    }
+    if (!parser.isSet(verboseOption)) {
+        // The analyzers log every track; in a batch only warnings are of interest
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+    }
+
+    ZoneSettings zones(parser.value(maxHrOption).toDouble(), parser.value(ftpOption).toDouble());
+    BatchAnalyzer analyzer(zones);
+    analyzer.setUseCache(parser.isSet(cacheOption));
+
+    QElapsedTimer timer;
+    timer.start();
+    const QStringList files = BatchAnalyzer::collectFiles(parser.positionalArguments());
+    const std::vector<TrackSummary> summaries = analyzer.analyzeFiles(files);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    int failed = 0;
+    for (const TrackSummary& summary : summaries) {
+        failed += summary.ok() ? 0 : 1;
+    }
+    const double filesPerSecond = seconds > 0.0 ? summaries.size() / seconds : 0.0;
+    const double peakMegabytes = peakMemoryBytes() / (1024.0 * 1024.0);
+
+    QByteArray output;
+    if (format == "csv") {
+        output = BatchAnalyzer::csvHeader();
+        for (const TrackSummary& summary : summaries) {
+            output += BatchAnalyzer::toCsv(summary);
+        }
+    } else {
+        QJsonArray tracks;
+        for (const TrackSummary& summary : summaries) {
+            tracks.append(BatchAnalyzer::toJson(summary));
+        }
+        QJsonObject run;
+        run["files"] = static_cast<int>(summaries.size());
+        run["failed"] = failed;
+        run["threads"] = QThreadPool::globalInstance()->maxThreadCount();
+        run["seconds"] = seconds;
+        run["files_per_second"] = filesPerSecond;
+        run["peak_memory_mb"] = peakMegabytes;
+        QJsonObject root;
+        root["tracks"] = tracks;
+        root["run"] = run;
+        output = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(output) != output.size()) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(file.fileName()));
+            return 1;
+        }
+    } else {
+        std::fwrite(output.constData(), 1, output.size(), stdout);
+    }
+
+    std::fprintf(stderr, "Analyzed %d files (%d failed) in %.2f s: %.1f files/s on %d threads, peak memory %.1f MB\n",
+                 static_cast<int>(summaries.size()), failed, seconds, filesPerSecond,
+                 QThreadPool::globalInstance()->maxThreadCount(), peakMegabytes);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+#include "AnalysisCache.h"
+#include "synthetic_track.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+namespace {
+
+void expectSameResult(const TrackAnalysisResult& actual, const TrackAnalysisResult& expected) {
+    ASSERT_EQ(actual.pointCount(), expected.pointCount());
+    ASSERT_EQ(actual.levelCount(), expected.levelCount());
+    for (int level = 0; level < expected.levelCount(); ++level) {
+        EXPECT_DOUBLE_EQ(actual.levelResolution(level), expected.levelResolution(level));
+        const std::vector<TrackSegment>& a = actual.segmentsAtLevel(level);
+        const std::vector<TrackSegment>& b = expected.segmentsAtLevel(level);
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(a[i].type, b[i].type);
+            EXPECT_EQ(a[i].startIndex, b[i].startIndex);
+            EXPECT_EQ(a[i].endIndex, b[i].endIndex);
+            EXPECT_DOUBLE_EQ(a[i].avgGradient, b[i].avgGradient);
+        }
+    }
+    ASSERT_EQ(actual.climbs().size(), expected.climbs().size());
+    for (size_t i = 0; i < expected.climbs().size(); ++i) {
+        EXPECT_EQ(actual.climbs()[i].category, expected.climbs()[i].category);
+        EXPECT_EQ(actual.climbs()[i].endIndex, expected.climbs()[i].endIndex);
+        EXPECT_DOUBLE_EQ(actual.climbs()[i].score, expected.climbs()[i].score);
+    }
+    EXPECT_DOUBLE_EQ(actual.uphillPercent(), expected.uphillPercent());
+    EXPECT_DOUBLE_EQ(actual.steepestDownhill(), expected.steepestDownhill());
+}
+
+} // namespace
+
+TEST(AnalysisCacheTest, RoundTrip) {
+    QTemporaryDir dir;
+    AnalysisCache cache(dir.filePath("analysis"));
+    std::vector<TrackPoint> points = makeSyntheticTrack(20000, 3);
+    TrackAnalyzer analyzer;
+    TrackAnalysisResult expected = analyzer.analyze(points);
+    ASSERT_FALSE(expected.climbs().empty());
+
+    quint64 content = AnalysisCache::contentHash(points);
+    quint64 params = AnalysisCache::paramsHash(analyzer);
+    TrackAnalysisResult loaded;
+    EXPECT_FALSE(cache.load(content, params, loaded));
+    ASSERT_TRUE(cache.store(content, params, expected));
+    ASSERT_TRUE(cache.load(content, params, loaded));
+    expectSameResult(loaded, expected);
+}
+
+TEST(AnalysisCacheTest, KeysChangeWithContentAndParams) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(1000, 4);
+    quint64 content = AnalysisCache::contentHash(points);
+    EXPECT_EQ(AnalysisCache::contentHash(makeSyntheticTrack(1000, 4)), content);
+
+    points[500].elevation += 0.01;
+    EXPECT_NE(AnalysisCache::contentHash(points), content);
+    points[500].elevation -= 0.01;
+    points.pop_back();
+    EXPECT_NE(AnalysisCache::contentHash(points), content);
+
+    TrackAnalyzer analyzer;
+    quint64 params = AnalysisCache::paramsHash(analyzer);
+    analyzer.setChunkSize(0);
+    EXPECT_EQ(AnalysisCache::paramsHash(analyzer), params);
+    SegmentationParams segmentation;
+    segmentation.tinySegmentThreshold = 250.0;
+    analyzer.setParams(segmentation);
+    EXPECT_NE(AnalysisCache::paramsHash(analyzer), params);
+    analyzer.setParams(SegmentationParams());
+    ClimbParams climbs;
+    climbs.maxDip = 20.0;
+    analyzer.setClimbParams(climbs);
+    EXPECT_NE(AnalysisCache::paramsHash(analyzer), params);
+}
+
+TEST(AnalysisCacheTest, AnalyzeUsesStoredEntry) {
+    QTemporaryDir dir;
+    AnalysisCache cache(dir.filePath("analysis"));
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 5);
+    TrackAnalyzer analyzer;
+
+    TrackAnalysisResult first = cache.analyze(analyzer, points);
+    quint64 content = AnalysisCache::contentHash(points);
+    quint64 params = AnalysisCache::paramsHash(analyzer);
+    EXPECT_TRUE(QFile::exists(cache.entryPath(content, params)));
+
+    // Replace the entry with a marker result; a second run must return it instead of re-analyzing
+    TrackAnalysisResult marker(points.size(), std::vector<TrackSegment>(1, first.segments().front()));
+    ASSERT_TRUE(cache.store(content, params, marker));
+    TrackAnalysisResult second = cache.analyze(analyzer, points);
+    EXPECT_EQ(second.segments().size(), 1u);
+}
+
+TEST(AnalysisCacheTest, PreparedProfileMatchesAnalyze) {
+    QTemporaryDir dir;
+    AnalysisCache cache(dir.filePath("analysis"));
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 8);
+    TrackAnalyzer analyzer;
+
+    // A miss segments the prepared profile and stores the same entry analyze() would
+    TrackAnalysisResult prepared = cache.analyze(analyzer, points, analyzer.prepare(points));
+    expectSameResult(prepared, analyzer.analyze(points));
+    TrackAnalysisResult stored;
+    ASSERT_TRUE(cache.load(AnalysisCache::contentHash(points), AnalysisCache::paramsHash(analyzer), stored));
+    expectSameResult(stored, prepared);
+}
+
+TEST(AnalysisCacheTest, DamagedEntryIsAMiss) {
+    QTemporaryDir dir;
+    AnalysisCache cache(dir.filePath("analysis"));
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 6);
+    TrackAnalyzer analyzer;
+    cache.analyze(analyzer, points);
+
+    quint64 content = AnalysisCache::contentHash(points);
+    quint64 params = AnalysisCache::paramsHash(analyzer);
+    QFile file(cache.entryPath(content, params));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("GPAC", 4);
+    file.close();
+
+    TrackAnalysisResult result;
+    EXPECT_FALSE(cache.load(content, params, result));
+    expectSameResult(cache.analyze(analyzer, points), analyzer.analyze(points));
+}
+
+TEST(AnalysisCacheTest, PruneKeepsRecentlyUsedEntries) {
+    QTemporaryDir dir;
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 9);
+    TrackAnalysisResult result = TrackAnalyzer().analyze(points);
+
+    // Room for two entries of this size
+    AnalysisCache probe(dir.filePath("probe"));
+    ASSERT_TRUE(probe.store(1, 1, result));
+    const qint64 entrySize = QFileInfo(probe.entryPath(1, 1)).size();
+    AnalysisCache cache(dir.filePath("analysis"), entrySize * 2 + entrySize / 2);
+
+    auto age = [&cache](quint64 key, int seconds) {
+        QFile file(cache.entryPath(key, 1));
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        ASSERT_TRUE(file.setFileTime(QDateTime::currentDateTime().addSecs(-seconds), QFileDevice::FileModificationTime));
+    };
+    ASSERT_TRUE(cache.store(1, 1, result));
+    age(1, 300);
+    ASSERT_TRUE(cache.store(2, 1, result));
+    age(2, 200);
+
+    // Reading the oldest entry makes the other one the least recently used
+    TrackAnalysisResult loaded;
+    ASSERT_TRUE(cache.load(1, 1, loaded));
+    ASSERT_TRUE(cache.store(3, 1, result));
+    EXPECT_TRUE(QFile::exists(cache.entryPath(1, 1)));
+    EXPECT_FALSE(QFile::exists(cache.entryPath(2, 1)));
+    EXPECT_TRUE(QFile::exists(cache.entryPath(3, 1)));
+}
@@ -0,0 +1,218 @@
+#include "gtest/gtest.h"
+#include "ArrowExporter.h"
+#include "TrackColumns.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    template <typename T>
+    T readScalar(const char* at) {
+        T value;
+        std::memcpy(&value, at, sizeof(T));
+        return value;
+    }
+
+    // Read-only view of a flatbuffer table, enough to walk the Arrow metadata back
+    struct FlatTable {
+        const char* buffer;
+        qint64 position;
+
+        static FlatTable root(const char* buffer) {
+            return {buffer, readScalar<quint32>(buffer)};
+        }
+
+        qint64 fieldOffset(int id) const {
+            const qint64 vtable = position - readScalar<qint32>(buffer + position);
+            const quint16 vtableSize = readScalar<quint16>(buffer + vtable);
+            if (4 + 2 * id >= vtableSize) {
+                return 0;
+            }
+            return readScalar<quint16>(buffer + vtable + 4 + 2 * id);
+        }
+
+        template <typename T>
+        T scalar(int id, T fallback = T()) const {
+            const qint64 offset = fieldOffset(id);
+            return offset ? readScalar<T>(buffer + position + offset) : fallback;
+        }
+
+        qint64 target(int id) const {
+            const qint64 at = position + fieldOffset(id);
+            return at + readScalar<quint32>(buffer + at);
+        }
+
+        FlatTable table(int id) const { return {buffer, target(id)}; }
+
+        QByteArray string(int id) const {
+            const qint64 at = target(id);
+            return QByteArray(buffer + at + 4, static_cast<int>(readScalar<quint32>(buffer + at)));
+        }
+
+        quint32 vectorLength(int id) const { return readScalar<quint32>(buffer + target(id)); }
+        const char* vectorData(int id) const { return buffer + target(id) + 4; }
+
+        FlatTable tableAt(int id, quint32 index) const {
+            const qint64 at = target(id) + 4 + 4 * static_cast<qint64>(index);
+            return {buffer, at + readScalar<quint32>(buffer + at)};
+        }
+    };
+
+    std::vector<TrackPoint> makePoints(size_t count, bool withTimes) {
+        std::vector<TrackPoint> points;
+        QDateTime start = QDateTime::fromMSecsSinceEpoch(1700000000000LL, Qt::UTC);
+        for (size_t i = 0; i < count; ++i) {
+            QDateTime time = withTimes ? start.addSecs(static_cast<qint64>(i)) : QDateTime();
+            TrackPoint point(QGeoCoordinate(45.0 + i * 1e-4, 10.0), 100.0 + i, i * 10.0, time);
+            points.push_back(point);
+        }
+        return points;
+    }
+}
+
+// Test fixture for ArrowExporter tests
+class ArrowExporterTest : public ::testing::Test {
+protected:
+    QTemporaryDir dir;
+
+    QByteArray exportAndRead(const TrackColumns& columns) {
+        QString path = dir.filePath("track.arrow");
+        ArrowExporter exporter;
+        EXPECT_TRUE(exporter.exportColumns(columns, path)) << exporter.errorString().toStdString();
+        QFile file(path);
+        EXPECT_TRUE(file.open(QIODevice::ReadOnly));
+        return file.readAll();
+    }
+};
+
+// Test case for sensor channels being dropped when absent
+TEST_F(ArrowExporterTest, ColumnsSkipMissingChannels) {
+    auto points = makePoints(10, true);
+    points[3].timestamp = QDateTime();
+    points[5].heartRate = 120.0;
+
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    EXPECT_EQ(columns.size(), 10);
+    EXPECT_TRUE(columns.hasTimestamps());
+    EXPECT_EQ(columns.timestampNullCount, 1);
+    ASSERT_EQ(columns.timestampValidity.size(), 2);
+    EXPECT_EQ(columns.timestampValidity[0] & (1 << 3), 0);
+    ASSERT_EQ(columns.heartRate.size(), 10);
+    EXPECT_TRUE(std::isnan(columns.heartRate[0]));
+    EXPECT_TRUE(columns.power.empty());
+}
+
+// Test case for the file framing: magic bytes, footer length and alignment
+TEST_F(ArrowExporterTest, FileFraming) {
+    for (bool withTimes : {true, false}) {
+        QByteArray data = exportAndRead(TrackColumns::fromPoints(makePoints(1001, withTimes)));
+        ASSERT_GT(data.size(), 20);
+        EXPECT_TRUE(data.startsWith(QByteArray("ARROW1\0\0", 8)));
+        EXPECT_TRUE(data.endsWith("ARROW1"));
+        EXPECT_EQ(data.size() % 2, 0);
+
+        qint32 footerLength = qFromLittleEndian<qint32>(data.constData() + data.size() - 10);
+        EXPECT_GT(footerLength, 0);
+        EXPECT_LT(footerLength, data.size() - 18);
+
+        // First message: continuation marker followed by an 8-byte aligned metadata length
+        EXPECT_EQ(qFromLittleEndian<quint32>(data.constData() + 8), 0xFFFFFFFFu);
+        EXPECT_EQ(qFromLittleEndian<qint32>(data.constData() + 12) % 8, 0);
+    }
+}
+
+// Test case for reading the file back: schema from the footer, then buffers of the record batch
+TEST_F(ArrowExporterTest, ReadBack) {
+    auto points = makePoints(1001, true);
+    points[3].timestamp = QDateTime();
+    points[10].heartRate = 150.0;
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    QByteArray file = exportAndRead(columns);
+    const char* data = file.constData();
+
+    // Footer: version, schema with one field per column, one record batch block
+    const qint32 footerLength = readScalar<qint32>(data + file.size() - 10);
+    const FlatTable footer = FlatTable::root(data + file.size() - 10 - footerLength);
+    EXPECT_EQ(footer.scalar<qint16>(0), 4);
+    const FlatTable schema = footer.table(1);
+    EXPECT_EQ(schema.scalar<qint16>(0), 0);    // Little endian
+
+    const std::vector<QByteArray> names = {"time", "latitude", "longitude", "elevation", "distance",
+                                           "gradient", "heart_rate"};
+    ASSERT_EQ(schema.vectorLength(1), names.size());
+    for (quint32 i = 0; i < names.size(); ++i) {
+        const FlatTable field = schema.tableAt(1, i);
+        EXPECT_EQ(field.string(0), names[i]);
+        EXPECT_EQ(field.scalar<quint8>(1), 1);  // Nullable
+        const FlatTable type = field.table(3);
+        if (i == 0) {
+            EXPECT_EQ(field.scalar<quint8>(2), 10);  // Timestamp
+            EXPECT_EQ(type.scalar<qint16>(0), 1);    // Milliseconds
+            EXPECT_EQ(type.string(1), QByteArray("UTC"));
+        } else {
+            EXPECT_EQ(field.scalar<quint8>(2), 3);   // FloatingPoint
+            EXPECT_EQ(type.scalar<qint16>(0), 2);    // Double
+        }
+    }
+
+    ASSERT_EQ(footer.vectorLength(3), 1u);
+    const char* block = footer.vectorData(3);
+    const qint64 batchOffset = readScalar<qint64>(block);
+    const qint32 metaDataLength = readScalar<qint32>(block + 8);
+    const qint64 bodyLength = readScalar<qint64>(block + 16);
+    ASSERT_LE(batchOffset + metaDataLength + bodyLength, file.size());
+
+    // Record batch message: continuation marker, length, Message table holding the RecordBatch
+    EXPECT_EQ(readScalar<quint32>(data + batchOffset), 0xFFFFFFFFu);
+    const FlatTable message = FlatTable::root(data + batchOffset + 8);
+    EXPECT_EQ(message.scalar<quint8>(1), 3);   // RecordBatch
+    EXPECT_EQ(message.scalar<qint64>(3), bodyLength);
+    const FlatTable batch = message.table(2);
+    EXPECT_EQ(batch.scalar<qint64>(0), 1001);
+
+    // Field nodes: length and null count per column
+    ASSERT_EQ(batch.vectorLength(1), names.size());
+    const char* nodes = batch.vectorData(1);
+    EXPECT_EQ(readScalar<qint64>(nodes), 1001);
+    EXPECT_EQ(readScalar<qint64>(nodes + 8), 1);
+    EXPECT_EQ(readScalar<qint64>(nodes + 16 + 8), 0);
+
+    // Buffers: validity then values per column, 8-byte aligned offsets into the body
+    ASSERT_EQ(batch.vectorLength(2), 2 * names.size());
+    const char* buffers = batch.vectorData(2);
+    for (size_t i = 0; i < 2 * names.size(); ++i) {
+        EXPECT_EQ(readScalar<qint64>(buffers + 16 * i) % 8, 0);
+    }
+    const char* body = data + batchOffset + metaDataLength;
+    auto buffer = [body, buffers](size_t index) { return body + readScalar<qint64>(buffers + 16 * index); };
+    auto bufferLength = [buffers](size_t index) { return readScalar<qint64>(buffers + 16 * index + 8); };
+
+    // Timestamp validity bitmap marks only row 3 missing; values are milliseconds
+    ASSERT_EQ(bufferLength(0), (1001 + 7) / 8);
+    const uint8_t* validity = reinterpret_cast<const uint8_t*>(buffer(0));
+    for (size_t row = 0; row < 1001; ++row) {
+        EXPECT_EQ((validity[row / 8] >> (row % 8)) & 1, row == 3 ? 0 : 1) << row;
+    }
+    ASSERT_EQ(bufferLength(1), 1001 * 8);
+    EXPECT_EQ(readScalar<qint64>(buffer(1) + 8 * 500), points[500].timestamp.toMSecsSinceEpoch());
+
+    // Latitude values, without a validity buffer
+    EXPECT_EQ(bufferLength(2), 0);
+    ASSERT_EQ(bufferLength(3), 1001 * 8);
+    for (size_t row = 0; row < 1001; row += 100) {
+        EXPECT_EQ(readScalar<double>(buffer(3) + 8 * row), points[row].coord.latitude());
+    }
+
+    // Heart rate keeps its NaN gaps
+    EXPECT_EQ(readScalar<double>(buffer(13) + 8 * 10), 150.0);
+    EXPECT_TRUE(std::isnan(readScalar<double>(buffer(13) + 8 * 11)));
+}
+
+// Test case for exporting an empty track
+TEST_F(ArrowExporterTest, EmptyTrack) {
+    QByteArray data = exportAndRead(TrackColumns::fromPoints({}));
+    EXPECT_TRUE(data.startsWith("ARROW1"));
+    EXPECT_TRUE(data.endsWith("ARROW1"));
+}
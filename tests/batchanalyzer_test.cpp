@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "BatchAnalyzer.h"
+#include "TrackAnalyzer.h"
+#include "synthetic_track.h"
+#include <QJsonArray>
+
+namespace {
+
+// Synthetic track with a point every two seconds and a heart rate channel
+GPXParser makeTimedParser(size_t count, unsigned seed) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(count, seed);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i].timestamp = QDateTime::fromMSecsSinceEpoch(1600000000000LL + static_cast<qint64>(i) * 2000);
+        points[i].heartRate = 120.0 + (i % 60);
+    }
+    GPXParser parser;
+    parser.setPoints(points);
+    return parser;
+}
+
+int countFields(const QByteArray& row) {
+    return row.count(',') + 1;
+}
+
+} // namespace
+
+TEST(BatchAnalyzerTest, SummaryMatchesAnalyzers) {
+    GPXParser parser = makeTimedParser(5000, 3);
+    TrackSummary summary = BatchAnalyzer().summarize("ride.gpx", parser);
+
+    ASSERT_TRUE(summary.ok());
+    EXPECT_EQ(summary.pointCount, 5000u);
+    EXPECT_DOUBLE_EQ(summary.distance, parser.getTotalDistance());
+    EXPECT_DOUBLE_EQ(summary.elevationGain, parser.getTotalElevationGain());
+    EXPECT_NEAR(summary.elapsedTime, 4999 * 2.0, 1e-6);
+    EXPECT_GT(summary.movingTime, 0.0);
+
+    TrackAnalysisResult analysis = TrackAnalyzer().analyze(parser.getPoints());
+    EXPECT_EQ(summary.segmentCount, analysis.segments().size());
+    ASSERT_EQ(summary.climbs.size(), analysis.climbs().size());
+    ASSERT_EQ(summary.climbStarts.size(), summary.climbs.size());
+    for (size_t i = 0; i < summary.climbs.size(); ++i) {
+        EXPECT_DOUBLE_EQ(summary.climbStarts[i], parser.getPoints()[summary.climbs[i].startIndex].distance);
+    }
+    EXPECT_NEAR(summary.uphillPercent + summary.downhillPercent + summary.flatPercent, 100.0, 0.1);
+
+    EXPECT_FALSE(summary.zones.heartRate.isEmpty());
+    EXPECT_TRUE(summary.zones.power.isEmpty());
+    EXPECT_NEAR(summary.zones.heartRate.totalTime(), summary.elapsedTime, 1e-6);
+    EXPECT_GE(summary.gains.raw, summary.gains.threshold);
+}
+
+TEST(BatchAnalyzerTest, TooShortTrackIsAnError) {
+    GPXParser parser;
+    parser.setPoints(makeSyntheticTrack(1, 1));
+    TrackSummary summary = BatchAnalyzer().summarize("point.gpx", parser);
+    EXPECT_FALSE(summary.ok());
+
+    QJsonObject json = BatchAnalyzer::toJson(summary);
+    EXPECT_EQ(json["file"].toString(), QString("point.gpx"));
+    EXPECT_TRUE(json.contains("error"));
+    EXPECT_FALSE(json.contains("distance"));
+}
+
+TEST(BatchAnalyzerTest, MissingFileIsReported) {
+    std::vector<TrackSummary> summaries = BatchAnalyzer().analyzeFiles(QStringList() << "/nonexistent/a.gpx"
+                                                                                     << "/nonexistent/b.gpx");
+    ASSERT_EQ(summaries.size(), 2u);
+    EXPECT_EQ(summaries[0].file, QString("/nonexistent/a.gpx"));
+    EXPECT_EQ(summaries[1].file, QString("/nonexistent/b.gpx"));
+    EXPECT_FALSE(summaries[0].ok());
+    EXPECT_FALSE(summaries[1].ok());
+}
+
+TEST(BatchAnalyzerTest, CsvRowsMatchHeader) {
+    const int columns = countFields(BatchAnalyzer::csvHeader());
+
+    TrackSummary good = BatchAnalyzer().summarize("good, quoted.gpx", makeTimedParser(2000, 5));
+    QByteArray row = BatchAnalyzer::toCsv(good);
+    EXPECT_TRUE(row.startsWith("\"good, quoted.gpx\","));
+    EXPECT_EQ(countFields(row), columns + 1);  // One comma inside the quoted file name
+    EXPECT_TRUE(row.endsWith('\n'));
+
+    TrackSummary bad;
+    bad.file = "bad.gpx";
+    bad.error = "File not found";
+    EXPECT_EQ(countFields(BatchAnalyzer::toCsv(bad)), columns);
+}
+
+TEST(BatchAnalyzerTest, JsonHasSectionsOfTimedTrack) {
+    TrackSummary summary = BatchAnalyzer().summarize("ride.gpx", makeTimedParser(3000, 7));
+    QJsonObject json = BatchAnalyzer::toJson(summary);
+
+    EXPECT_DOUBLE_EQ(json["distance"].toDouble(), summary.distance);
+    EXPECT_DOUBLE_EQ(json["moving_time"].toDouble(), summary.movingTime);
+    EXPECT_EQ(json["climbs"].toArray().size(), static_cast<int>(summary.climbs.size()));
+    EXPECT_TRUE(json["zones"].toObject().contains("heart_rate"));
+    EXPECT_FALSE(json["zones"].toObject().contains("power"));
+    EXPECT_DOUBLE_EQ(json["gain_estimates"].toObject()["hysteresis"].toDouble(), summary.gains.hysteresis);
+}
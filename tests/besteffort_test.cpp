@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "BestEfforts.h"
+#include "synthetic_track.h"
+#include <random>
+
+namespace {
+
+// Timed synthetic track with a random speed per point
+std::vector<TrackPoint> makeTimedTrack(size_t count, unsigned seed) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(count, seed);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> speed(2.0, 8.0);
+    qint64 ms = 1700000000000LL;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i > 0) {
+            ms += static_cast<qint64>((points[i].distance - points[i - 1].distance) / speed(rng) * 1000.0);
+        }
+        points[i].timestamp = QDateTime::fromMSecsSinceEpoch(ms);
+    }
+    return points;
+}
+
+// Quadratic reference over all point pairs; climb rates are compared over the
+// shortest stretch ending at each point, since longer ones are a different window
+BestEffort bruteForce(const std::vector<TrackPoint>& points, BestEffort::Kind kind, double window) {
+    BestEffort best;
+    best.kind = kind;
+    best.window = window;
+    double bestValue = 0.0;
+    for (size_t first = 0; first < points.size(); ++first) {
+        for (size_t last = first + 1; last < points.size(); ++last) {
+            double distance = points[last].distance - points[first].distance;
+            double duration = points[first].timestamp.msecsTo(points[last].timestamp) / 1000.0;
+            double value;
+            if (kind == BestEffort::FASTEST_DISTANCE) {
+                if (distance < window || duration <= 0.0) continue;
+                value = -duration;
+            } else {
+                double shorter = points[first + 1].timestamp.msecsTo(points[last].timestamp) / 1000.0;
+                if (duration < window || shorter >= window) continue;
+                value = (points[last].elevation - points[first].elevation) / duration;
+            }
+            if (!best.found || value > bestValue) {
+                best.found = true;
+                bestValue = value;
+                best.duration = duration;
+                best.climb = points[last].elevation - points[first].elevation;
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+TEST(BestEffortTest, MatchesBruteForce) {
+    std::vector<TrackPoint> points = makeTimedTrack(1500, 21);
+    BestEffortFinder finder;
+    finder.setDistances({200.0, 1000.0, 5000.0});
+    finder.setDurations({60.0, 300.0});
+    std::vector<BestEffort> efforts = finder.find(TrackColumns::fromPoints(points));
+    ASSERT_EQ(efforts.size(), 5u);
+
+    for (const BestEffort& effort : efforts) {
+        BestEffort expected = bruteForce(points, effort.kind, effort.window);
+        ASSERT_EQ(effort.found, expected.found) << effort.window;
+        if (effort.kind == BestEffort::FASTEST_DISTANCE) {
+            EXPECT_NEAR(effort.duration, expected.duration, 1e-9) << effort.window;
+            EXPECT_GE(effort.distance, effort.window);
+        } else {
+            EXPECT_NEAR(effort.climbRate(), expected.climb / expected.duration * 3600.0, 1e-9) << effort.window;
+            EXPECT_GE(effort.duration, effort.window);
+        }
+    }
+}
+
+TEST(BestEffortTest, FindsFastestStretch) {
+    // 10 km at 4 m/s with one kilometer at 8 m/s in the middle, points every 10 m
+    std::vector<TrackPoint> points;
+    qint64 ms = 0;
+    for (int i = 0; i <= 1000; ++i) {
+        double distance = i * 10.0;
+        if (i > 0) {
+            ms += (distance > 5000.0 && distance <= 6000.0) ? 1250 : 2500;
+        }
+        points.emplace_back(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), 100.0, distance,
+                            QDateTime::fromMSecsSinceEpoch(ms));
+    }
+    std::vector<BestEffort> efforts = BestEffortFinder().find(TrackColumns::fromPoints(points));
+
+    ASSERT_TRUE(efforts[0].found);
+    EXPECT_EQ(efforts[0].startIndex, 500u);
+    EXPECT_EQ(efforts[0].endIndex, 600u);
+    EXPECT_NEAR(efforts[0].speed(), 8.0, 1e-9);
+    EXPECT_TRUE(efforts[1].found);
+    EXPECT_TRUE(efforts[2].found);
+    EXPECT_FALSE(efforts[3].found);   // Shorter than a half marathon
+}
+
+TEST(BestEffortTest, UntimedTrack) {
+    std::vector<BestEffort> efforts = BestEffortFinder().find(TrackColumns::fromPoints(makeSyntheticTrack(500, 1)));
+    ASSERT_EQ(efforts.size(), 7u);
+    for (const BestEffort& effort : efforts) {
+        EXPECT_FALSE(effort.found);
+    }
+}
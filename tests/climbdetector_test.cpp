@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "ClimbDetector.h"
+#include "RangeQuery.h"
+#include <random>
+#include <utility>
+
+namespace {
+
+// Track of constant-gradient pieces (length in meters, gradient in percent), one point every 10 m
+std::vector<TrackPoint> makeProfile(const std::vector<std::pair<double, double>>& pieces) {
+    const double STEP = 10.0;
+    std::vector<TrackPoint> points;
+    double distance = 0.0;
+    double elevation = 200.0;
+    points.emplace_back(QGeoCoordinate(45.0, 10.0), elevation, distance);
+    for (const auto& piece : pieces) {
+        int steps = static_cast<int>(piece.first / STEP);
+        for (int i = 0; i < steps; ++i) {
+            distance += STEP;
+            elevation += STEP * piece.second / 100.0;
+            TrackPoint point(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), elevation, distance);
+            point.gradient = piece.second;
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(RangeQueryTest, MatchesBruteForce) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> value(0, 50);  // Plenty of ties
+    std::vector<double> values(1000);
+    for (double& v : values) {
+        v = value(rng);
+    }
+    RangeMinimum lows(values);
+    RangeMaximum highs(values);
+
+    std::uniform_int_distribution<size_t> index(0, values.size() - 1);
+    for (int trial = 0; trial < 2000; ++trial) {
+        size_t first = index(rng);
+        size_t last = index(rng);
+        if (first > last) {
+            std::swap(first, last);
+        }
+        size_t minIndex = first, maxIndex = first;
+        for (size_t i = first; i <= last; ++i) {
+            if (values[i] < values[minIndex]) minIndex = i;
+            if (values[i] > values[maxIndex]) maxIndex = i;
+        }
+        ASSERT_EQ(lows.query(first, last), minIndex) << first << ".." << last;
+        ASSERT_EQ(highs.query(first, last), maxIndex) << first << ".." << last;
+    }
+}
+
+TEST(ClimbDetectorTest, Categorize) {
+    EXPECT_EQ(ClimbDetector::categorize(8000.0), Climb::CATEGORY_4);
+    EXPECT_EQ(ClimbDetector::categorize(20000.0), Climb::CATEGORY_3);
+    EXPECT_EQ(ClimbDetector::categorize(40000.0), Climb::CATEGORY_2);
+    EXPECT_EQ(ClimbDetector::categorize(70000.0), Climb::CATEGORY_1);
+    EXPECT_EQ(ClimbDetector::categorize(80000.0), Climb::HORS_CATEGORIE);
+    EXPECT_EQ(ClimbDetector::categoryName(Climb::HORS_CATEGORIE), QString("HC"));
+}
+
+TEST(ClimbDetectorTest, LongSteepClimbIsHorsCategorie) {
+    std::vector<TrackPoint> points = makeProfile({{2000.0, 0.0}, {12000.0, 8.0}, {2000.0, -6.0}});
+    std::vector<Climb> climbs = ClimbDetector().detect(points);
+
+    ASSERT_EQ(climbs.size(), 1u);
+    const Climb& climb = climbs[0];
+    EXPECT_EQ(climb.category, Climb::HORS_CATEGORIE);
+    EXPECT_NEAR(climb.distance, 12000.0, 1e-6);
+    EXPECT_NEAR(climb.elevationGain, 960.0, 1e-6);
+    EXPECT_NEAR(climb.avgGradient, 8.0, 1e-6);
+    EXPECT_NEAR(climb.maxGradient, 8.0, 1e-6);
+    // The flat approach is not part of the climb
+    EXPECT_NEAR(points[climb.startIndex].distance, 2000.0, 1e-6);
+}
+
+TEST(ClimbDetectorTest, ShortClimbIsCategory4) {
+    std::vector<TrackPoint> points = makeProfile({{1000.0, 0.0}, {2000.0, 5.0}, {1000.0, 0.0}});
+    std::vector<Climb> climbs = ClimbDetector().detect(points);
+
+    ASSERT_EQ(climbs.size(), 1u);
+    EXPECT_EQ(climbs[0].category, Climb::CATEGORY_4);
+    EXPECT_NEAR(climbs[0].score, 10000.0, 1e-6);
+}
+
+TEST(ClimbDetectorTest, RollingTerrainHasNoClimbs) {
+    std::vector<std::pair<double, double>> pieces;
+    for (int i = 0; i < 20; ++i) {
+        pieces.push_back({300.0, 4.0});
+        pieces.push_back({300.0, -4.0});
+    }
+    EXPECT_TRUE(ClimbDetector().detect(makeProfile(pieces)).empty());
+}
+
+TEST(ClimbDetectorTest, ShortDipIsMergedIntoOneClimb) {
+    // 3 km at 6%, a 5 m dip, then another 3 km at 6%
+    std::vector<TrackPoint> points = makeProfile({{3000.0, 6.0}, {100.0, -5.0}, {3000.0, 6.0}});
+    std::vector<Climb> climbs = ClimbDetector().detect(points);
+
+    ASSERT_EQ(climbs.size(), 1u);
+    EXPECT_NEAR(climbs[0].distance, 6100.0, 1e-6);
+    EXPECT_NEAR(climbs[0].elevationGain, 355.0, 1e-6);
+    EXPECT_EQ(climbs[0].category, Climb::CATEGORY_2);
+}
+
+TEST(ClimbDetectorTest, LongDescentSplitsClimbs) {
+    std::vector<TrackPoint> points = makeProfile({{3000.0, 6.0}, {2000.0, -6.0}, {3000.0, 6.0}});
+    std::vector<Climb> climbs = ClimbDetector().detect(points);
+
+    ASSERT_EQ(climbs.size(), 2u);
+    EXPECT_NEAR(climbs[0].distance, 3000.0, 1e-6);
+    EXPECT_NEAR(climbs[1].distance, 3000.0, 1e-6);
+    EXPECT_LT(climbs[0].endIndex, climbs[1].startIndex);
+}
+
+TEST(ClimbDetectorTest, EarlyDipIsMergedOnceTheClimbContinues) {
+    // The 20 m dip ends the first ramp, but is small against the full climb after it
+    std::vector<TrackPoint> points = makeProfile({{1000.0, 6.0}, {400.0, -5.0}, {5000.0, 6.0}});
+    std::vector<Climb> climbs = ClimbDetector().detect(points);
+
+    ASSERT_EQ(climbs.size(), 1u);
+    EXPECT_EQ(climbs[0].startIndex, 0u);
+    EXPECT_NEAR(climbs[0].elevationGain, 340.0, 1e-6);
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "ContractionHierarchy.h"
+#include <QTemporaryDir>
+#include <cmath>
+#include <queue>
+#include <random>
+
+namespace {
+
+const double LAT0 = 45.0;
+const double LON0 = 10.0;
+const double METERS_PER_DEGREE = 111320.0;
+
+QGeoCoordinate at(double east, double north) {
+    return QGeoCoordinate(LAT0 + north / METERS_PER_DEGREE,
+                          LON0 + east / (METERS_PER_DEGREE * std::cos(LAT0 * M_PI / 180.0)));
+}
+
+// Jittered street grid with some one-way streets and missing blocks
+void addCity(RoadGraph& graph, int size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-30.0, 30.0);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::vector<qint32> nodes(size * size);
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            const QGeoCoordinate coord = at(column * 100.0 + jitter(rng), row * 100.0 + jitter(rng));
+            nodes[row * size + column] = graph.addNode(coord.latitude(), coord.longitude());
+        }
+    }
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            const qint32 here = nodes[row * size + column];
+            for (int direction = 0; direction < 2; ++direction) {
+                const int nextRow = row + direction, nextColumn = column + 1 - direction;
+                if (nextRow >= size || nextColumn >= size) {
+                    continue;
+                }
+                const qint32 there = nodes[nextRow * size + nextColumn];
+                const int k = kind(rng);
+                if (k == 0) {
+                    continue;                               // Missing block
+                } else if (k == 1) {
+                    graph.addWay({here, there}, true);
+                } else if (k == 2) {
+                    graph.addWay({there, here}, true);
+                } else {
+                    graph.addWay({here, there});
+                }
+            }
+        }
+    }
+}
+
+// Plain Dijkstra over the road graph
+double referenceDistance(const RoadGraph& graph, qint32 source, qint32 target) {
+    std::vector<double> distance(graph.nodeCount(), std::numeric_limits<double>::infinity());
+    std::priority_queue<std::pair<double, qint32>, std::vector<std::pair<double, qint32>>,
+                        std::greater<std::pair<double, qint32>>> queue;
+    distance[source] = 0.0;
+    queue.push(std::make_pair(0.0, source));
+    while (!queue.empty()) {
+        const std::pair<double, qint32> top = queue.top();
+        queue.pop();
+        if (top.second == target) {
+            return top.first;
+        }
+        if (top.first > distance[top.second]) {
+            continue;
+        }
+        for (const RoadGraph::Arc* arc = graph.arcsBegin(top.second); arc != graph.arcsEnd(top.second); ++arc) {
+            if (top.first + arc->length < distance[arc->target]) {
+                distance[arc->target] = top.first + arc->length;
+                queue.push(std::make_pair(distance[arc->target], arc->target));
+            }
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+RoadCandidate nearestRoad(const RoadGraph& graph, double east, double north) {
+    const QGeoCoordinate coord = at(east, north);
+    double x = 0.0, y = 0.0;
+    graph.project(coord.latitude(), coord.longitude(), x, y);
+    std::vector<RoadCandidate> candidates = graph.candidates(x, y, 200.0, 1);
+    return candidates.empty() ? RoadCandidate() : candidates.front();
+}
+
+} // namespace
+
+TEST(ContractionHierarchyTest, DistancesMatchDijkstra) {
+    RoadGraph graph;
+    addCity(graph, 30, 1);
+    graph.build();
+    ContractionHierarchy hierarchy(graph);
+    ASSERT_FALSE(hierarchy.isEmpty());
+
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<qint32> node(0, static_cast<qint32>(graph.nodeCount()) - 1);
+    int unreachable = 0;
+    for (int k = 0; k < 300; ++k) {
+        const qint32 source = node(rng), target = node(rng);
+        const double expected = referenceDistance(graph, source, target);
+        const double actual = hierarchy.distance(source, target);
+        if (std::isinf(expected)) {
+            EXPECT_TRUE(std::isinf(actual));
+            ++unreachable;
+        } else {
+            EXPECT_NEAR(actual, expected, 0.05) << source << " -> " << target;
+        }
+    }
+    EXPECT_LT(unreachable, 300);
+}
+
+TEST(ContractionHierarchyTest, RouteGeometryFollowsRoads) {
+    RoadGraph graph;
+    addCity(graph, 20, 3);
+    graph.build();
+    ContractionHierarchy hierarchy(graph);
+
+    RouteLeg leg = hierarchy.route(nearestRoad(graph, 120.0, 340.0), nearestRoad(graph, 1650.0, 1420.0));
+    ASSERT_TRUE(leg.found);
+    ASSERT_GE(leg.points.size(), 3u);
+
+    // The polyline is the route: its length is the reported one
+    double length = 0.0;
+    for (size_t i = 1; i < leg.points.size(); ++i) {
+        length += leg.points[i - 1].distanceTo(leg.points[i]);
+    }
+    EXPECT_NEAR(length, leg.length, leg.length * 0.002);
+    EXPECT_GE(leg.length, leg.points.front().distanceTo(leg.points.back()));
+}
+
+TEST(ContractionHierarchyTest, OneWayStreetIsTakenOnlyWithTraffic) {
+    // A one-way street east, and a two-way detour via the north
+    RoadGraph graph;
+    const QGeoCoordinate a = at(0.0, 0.0), b = at(1000.0, 0.0), c = at(0.0, 500.0), d = at(1000.0, 500.0);
+    const qint32 na = graph.addNode(a.latitude(), a.longitude());
+    const qint32 nb = graph.addNode(b.latitude(), b.longitude());
+    const qint32 nc = graph.addNode(c.latitude(), c.longitude());
+    const qint32 nd = graph.addNode(d.latitude(), d.longitude());
+    graph.addWay({na, nb}, true);
+    graph.addWay({na, nc, nd, nb});
+    graph.build();
+    ContractionHierarchy hierarchy(graph);
+
+    EXPECT_NEAR(hierarchy.distance(na, nb), 1000.0, 1.0);
+    EXPECT_NEAR(hierarchy.distance(nb, na), 2000.0, 1.0);
+
+    // Positions on the one-way street itself
+    RouteLeg along = hierarchy.route(nearestRoad(graph, 200.0, 5.0), nearestRoad(graph, 700.0, 5.0));
+    ASSERT_TRUE(along.found);
+    EXPECT_NEAR(along.length, 500.0, 1.0);
+    RouteLeg against = hierarchy.route(nearestRoad(graph, 700.0, 5.0), nearestRoad(graph, 200.0, 5.0));
+    ASSERT_TRUE(against.found);
+    EXPECT_NEAR(against.length, 300.0 + 2000.0 + 200.0, 1.0);
+}
+
+TEST(ContractionHierarchyTest, DisconnectedRoadsHaveNoRoute) {
+    RoadGraph graph;
+    const QGeoCoordinate a = at(0.0, 0.0), b = at(100.0, 0.0), c = at(0.0, 500.0), d = at(100.0, 500.0);
+    graph.addWay({graph.addNode(a.latitude(), a.longitude()), graph.addNode(b.latitude(), b.longitude())});
+    graph.addWay({graph.addNode(c.latitude(), c.longitude()), graph.addNode(d.latitude(), d.longitude())});
+    graph.build();
+    ContractionHierarchy hierarchy(graph);
+
+    EXPECT_TRUE(std::isinf(hierarchy.distance(0, 3)));
+    EXPECT_FALSE(hierarchy.route(nearestRoad(graph, 50.0, 0.0), nearestRoad(graph, 50.0, 500.0)).found);
+    EXPECT_FALSE(ContractionHierarchy().route(RoadCandidate(), RoadCandidate()).found);
+}
+
+TEST(ContractionHierarchyTest, SavedHierarchyLoadsForTheSameGraphOnly) {
+    RoadGraph graph;
+    addCity(graph, 15, 4);
+    graph.build();
+    ContractionHierarchy built(graph);
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString filename = dir.filePath("hierarchy.ch");
+    ASSERT_TRUE(built.save(filename));
+
+    ContractionHierarchy loaded;
+    ASSERT_TRUE(loaded.load(filename, graph));
+    EXPECT_EQ(loaded.shortcutCount(), built.shortcutCount());
+    for (qint32 target = 1; target < static_cast<qint32>(graph.nodeCount()); target += 7) {
+        const double expected = built.distance(0, target);
+        if (std::isinf(expected)) {
+            EXPECT_TRUE(std::isinf(loaded.distance(0, target)));
+        } else {
+            EXPECT_NEAR(loaded.distance(0, target), expected, 0.01);
+        }
+    }
+
+    RoadGraph other;
+    addCity(other, 10, 4);
+    other.build();
+    EXPECT_FALSE(ContractionHierarchy().load(filename, other));
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "ElevationGain.h"
+#include "TrackRangeStats.h"
+#include "synthetic_track.h"
+#include <cmath>
+
+namespace {
+
+// One point every 10 m, elevation given per point
+TrackColumns makeColumns(const std::vector<double>& elevations) {
+    std::vector<TrackPoint> points;
+    for (size_t i = 0; i < elevations.size(); ++i) {
+        double distance = i * 10.0;
+        points.emplace_back(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), elevations[i], distance);
+    }
+    return TrackColumns::fromPoints(points);
+}
+
+} // namespace
+
+TEST(ElevationGainTest, SteadyClimbAgrees) {
+    // 1 km at 5%
+    std::vector<double> elevations;
+    for (int i = 0; i <= 100; ++i) {
+        elevations.push_back(100.0 + i * 0.5);
+    }
+    ElevationGainReport report = ElevationGainEstimator().estimate(makeColumns(elevations));
+
+    EXPECT_NEAR(report.raw, 50.0, 1e-9);
+    // 0.5 m steps stay under the 0.6 m threshold
+    EXPECT_DOUBLE_EQ(report.threshold, 0.0);
+    // Every 3.5 m the band is cleared; the last 1.5 m are never confirmed
+    EXPECT_NEAR(report.hysteresis, 49.0, 1e-9);
+    // The centered window is truncated at both ends, which trims 1.25 m each
+    EXPECT_NEAR(report.smoothed, 47.5, 1e-9);
+    EXPECT_TRUE(std::isnan(report.dem));
+}
+
+TEST(ElevationGainTest, NoiseOnFlatGround) {
+    // +/- 1 m GPS jitter on flat ground
+    std::vector<double> elevations;
+    for (int i = 0; i < 500; ++i) {
+        elevations.push_back(200.0 + ((i % 2) ? 1.0 : -1.0));
+    }
+    ElevationGainReport report = ElevationGainEstimator().estimate(makeColumns(elevations));
+
+    EXPECT_NEAR(report.raw, 250.0 * 2.0, 1e-9);
+    EXPECT_NEAR(report.threshold, report.raw, 1e-9);
+    EXPECT_DOUBLE_EQ(report.hysteresis, 0.0);
+    // The 11-point window averages the jitter down to 2/11 m per step
+    EXPECT_LT(report.smoothed, report.raw / 10.0);
+}
+
+TEST(ElevationGainTest, ThresholdMatchesRangeStats) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(20000, 9);
+    ElevationGainReport report = ElevationGainEstimator().estimate(TrackColumns::fromPoints(points));
+    double expected = TrackRangeStats(points).stats(0, points.size() - 1).elevationGain;
+
+    EXPECT_NEAR(report.threshold, expected, 1e-6);
+    EXPECT_GE(report.raw, report.threshold);
+    EXPECT_LE(report.hysteresis, report.raw);
+    EXPECT_LE(report.smoothed, report.raw);
+}
+
+TEST(ElevationGainTest, DemSampling) {
+    // Plane rising 100 m per 0.01 degree of latitude, grid rows from south to north
+    std::vector<std::vector<float>> grid(3, std::vector<float>(3));
+    for (size_t row = 0; row < 3; ++row) {
+        for (size_t col = 0; col < 3; ++col) {
+            grid[row][col] = static_cast<float>(row * 100.0);
+        }
+    }
+    QGeoCoordinate topLeft(45.02, 10.0);
+    QGeoCoordinate bottomRight(45.0, 10.02);
+
+    std::vector<TrackPoint> points;
+    for (int i = 0; i <= 20; ++i) {
+        points.emplace_back(QGeoCoordinate(45.0 + i * 0.001, 10.01), 0.0, i * 111.32);
+    }
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    std::vector<double> dem = ElevationGainEstimator::sampleDem(grid, topLeft, bottomRight, columns);
+
+    ASSERT_EQ(dem.size(), points.size());
+    EXPECT_NEAR(dem[5], 50.0, 1e-6);
+    EXPECT_NEAR(dem[20], 200.0, 1e-6);
+    EXPECT_NEAR(ElevationGainEstimator().estimate(columns, dem).dem, 200.0, 1e-6);
+
+    // A point off the grid has no DEM elevation, so there is no DEM estimate
+    points.emplace_back(QGeoCoordinate(45.03, 10.01), 0.0, 21 * 111.32);
+    columns = TrackColumns::fromPoints(points);
+    dem = ElevationGainEstimator::sampleDem(grid, topLeft, bottomRight, columns);
+    EXPECT_TRUE(std::isnan(dem.back()));
+    EXPECT_TRUE(std::isnan(ElevationGainEstimator().estimate(columns, dem).dem));
+}
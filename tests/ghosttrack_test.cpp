@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "GhostTrack.h"
+#include "synthetic_track.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Synthetic road ridden at a constant speed, optionally with irregular sample times
+std::vector<TrackPoint> makeEffort(const std::vector<TrackPoint>& route, double speed, unsigned jitterSeed = 0) {
+    std::vector<TrackPoint> points = route;
+    std::mt19937 rng(jitterSeed);
+    std::uniform_int_distribution<int> jitter(-300, 300);
+    for (size_t i = 0; i < points.size(); ++i) {
+        qint64 ms = static_cast<qint64>(points[i].distance / speed * 1000.0);
+        if (jitterSeed != 0 && i > 0) {
+            ms += jitter(rng);
+        }
+        points[i].timestamp = QDateTime::fromMSecsSinceEpoch(1600000000000LL + ms);
+    }
+    return points;
+}
+
+// Reference lookup: last point whose elapsed time is not after t
+size_t bruteForceIndex(const std::vector<TrackPoint>& points, double t) {
+    const qint64 ms = static_cast<qint64>(std::floor(t * 1000.0));
+    size_t index = 0;
+    qint64 latest = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        latest = std::max(latest, points.front().timestamp.msecsTo(points[i].timestamp));
+        if (latest <= ms) {
+            index = i;
+        }
+    }
+    return index;
+}
+
+} // namespace
+
+TEST(GhostTrackTest, LookupsMatchBruteForce) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(3000, 3);
+    std::vector<TrackPoint> ghostPoints = makeEffort(route, 9.0, 17);
+    GhostTrack ghost(ghostPoints, makeEffort(route, 8.0));
+    ASSERT_FALSE(ghost.isEmpty());
+
+    // Playback: small steps forward
+    for (double t = 0.0; t < ghost.duration() + 5.0; t += 0.37) {
+        ASSERT_EQ(ghost.indexAtTime(t), bruteForceIndex(ghostPoints, t)) << "at " << t << " s";
+    }
+
+    // Seeking: random jumps in both directions
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> seek(-10.0, ghost.duration() + 10.0);
+    for (int k = 0; k < 500; ++k) {
+        const double t = seek(rng);
+        ASSERT_EQ(ghost.indexAtTime(t), bruteForceIndex(ghostPoints, t)) << "at " << t << " s";
+    }
+}
+
+TEST(GhostTrackTest, PositionIsInterpolatedAndWaitsAtTheFinish) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(1000, 7);
+    std::vector<TrackPoint> ghostPoints = makeEffort(route, 10.0);
+    GhostTrack ghost(ghostPoints, makeEffort(route, 10.0));
+
+    GhostPosition position = ghost.positionAt(100.0);
+    ASSERT_TRUE(position.valid);
+    EXPECT_FALSE(position.finished);
+    EXPECT_NEAR(position.distance, 1000.0, 15.0);
+    const TrackPoint& before = ghostPoints[position.index];
+    const TrackPoint& after = ghostPoints[position.index + 1];
+    EXPECT_GE(position.coord.latitude(), before.coord.latitude());
+    EXPECT_LE(position.coord.latitude(), after.coord.latitude());
+
+    GhostPosition finish = ghost.positionAt(ghost.duration() + 60.0);
+    EXPECT_TRUE(finish.finished);
+    EXPECT_EQ(finish.index, ghostPoints.size() - 1);
+    EXPECT_DOUBLE_EQ(finish.coord.latitude(), ghostPoints.back().coord.latitude());
+}
+
+TEST(GhostTrackTest, TimeGapComparesTheSamePlace) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(2000, 9);
+    GhostTrack ghost(makeEffort(route, 10.0), makeEffort(route, 8.0));
+    ASSERT_FALSE(ghost.isEmpty());
+
+    for (size_t i = 0; i < route.size(); i += 97) {
+        const double d = route[i].distance;
+        EXPECT_NEAR(ghost.timeGapAt(i), d / 8.0 - d / 10.0, 0.01) << "at " << d << " m";
+        EXPECT_NEAR(ghost.referenceElapsed(i), d / 8.0, 0.01);
+    }
+    EXPECT_TRUE(std::isnan(ghost.timeGapAt(route.size())));
+}
+
+TEST(GhostTrackTest, UntimedTracksGiveNoGhost) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(200, 11);
+    EXPECT_TRUE(GhostTrack(route, makeEffort(route, 5.0)).isEmpty());
+    EXPECT_TRUE(GhostTrack(makeEffort(route, 5.0), route).isEmpty());
+    GhostTrack empty;
+    EXPECT_FALSE(empty.positionAt(10.0).valid);
+}
@@ -1,6 +1,10 @@
 #include "gtest/gtest.h"
 #include "GpxParser.h"
+#include "GpxIndex.h"
 #include <QString>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
 
 // Test fixture for GPXParser tests
 class GPXParserTest : public ::testing::Test {
@@ -83,3 +87,84 @@ TEST_F(GPXParserTest, NoTrackPoints) {
     EXPECT_FALSE(parser.parseData(gpxData));
     EXPECT_TRUE(parser.getPoints().empty());
 }
+
+// Test case for sensor values carried in track point extensions
+TEST_F(GPXParserTest, SensorExtensions) {
+    QString gpxData = R"(
+        <gpx xmlns:gpxtpx="http://www.garmin.com/xmlschemas/TrackPointExtension/v1">
+            <trk>
+                <trkseg>
+                    <trkpt lat="45.0" lon="10.0"><ele>100</ele>
+                        <extensions>
+                            <gpxtpx:TrackPointExtension>
+                                <gpxtpx:hr>142</gpxtpx:hr>
+                                <gpxtpx:cad>88</gpxtpx:cad>
+                                <gpxtpx:atemp>21.5</gpxtpx:atemp>
+                            </gpxtpx:TrackPointExtension>
+                            <power>250</power>
+                        </extensions>
+                    </trkpt>
+                    <trkpt lat="45.1" lon="10.1"><ele>200</ele></trkpt>
+                </trkseg>
+            </trk>
+        </gpx>
+    )";
+
+    ASSERT_TRUE(parser.parseData(gpxData));
+    const auto& points = parser.getPoints();
+    ASSERT_EQ(points.size(), 2);
+    EXPECT_DOUBLE_EQ(points[0].heartRate, 142.0);
+    EXPECT_DOUBLE_EQ(points[0].cadence, 88.0);
+    EXPECT_DOUBLE_EQ(points[0].power, 250.0);
+    EXPECT_DOUBLE_EQ(points[0].temperature, 21.5);
+    EXPECT_DOUBLE_EQ(points[0].elevation, 100.0);
+    EXPECT_TRUE(std::isnan(points[1].heartRate));
+    EXPECT_TRUE(std::isnan(points[1].power));
+}
+
+// Test case for loading a distance window of an indexed file
+TEST_F(GPXParserTest, IndexedWindow) {
+    QTemporaryDir dir;
+    QString path = dir.filePath("long.gpx");
+    {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        QByteArray data = "<?xml version=\"1.0\"?>\n<gpx>\n<trk>\n<trkseg>\n";
+        for (int i = 0; i < 1000; ++i) {
+            data += QString("<trkpt lat=\"%1\" lon=\"10.0\"><ele>%2</ele></trkpt>\n")
+                        .arg(45.0 + i * 0.0001, 0, 'f', 6).arg(100 + i % 40).toUtf8();
+            if (i == 499) {
+                data += "</trkseg>\n<trkseg>\n";
+            }
+        }
+        data += "</trkseg>\n</trk>\n</gpx>\n";
+        file.write(data);
+    }
+
+    ASSERT_TRUE(parser.parse(path));
+    const std::vector<TrackPoint> full = parser.getPoints();
+
+    GpxIndex index;
+    ASSERT_TRUE(index.build(path, 100));
+    EXPECT_EQ(index.pointCount(), 1000);
+    EXPECT_NEAR(index.totalDistance(), full.back().distance, 1e-6);
+    ASSERT_TRUE(index.save());
+
+    GpxIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.entries().size(), index.entries().size());
+
+    GpxWindow window = loaded.windowForDistance(full[350].distance, full[620].distance);
+    ASSERT_TRUE(window.isValid());
+    ASSERT_TRUE(parser.parseWindow(loaded, window));
+
+    const std::vector<TrackPoint>& points = parser.getPoints();
+    size_t first = parser.getFirstPointIndex();
+    EXPECT_EQ(first % 100, 0);
+    EXPECT_LE(first, 350);
+    EXPECT_GE(first + points.size(), 620);
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_DOUBLE_EQ(points[i].elevation, full[first + i].elevation);
+        EXPECT_NEAR(points[i].distance, full[first + i].distance, 1e-3);
+    }
+}
@@ -0,0 +1,91 @@
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QLabel>
+#include <QPushButton>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include "MainWindow.h"
+
+class MainWindowTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Timed climb heading north, one point every ~11 m
+    static void writeSampleTrack(const QString& path) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream out(&file);
+        out << "<gpx><trk><trkseg>\n";
+        QDateTime start(QDate(2024, 5, 1), QTime(8, 0), Qt::UTC);
+        for (int i = 0; i < 300; ++i) {
+            out << QString("<trkpt lat=\"%1\" lon=\"10.0\"><ele>%2</ele><time>%3</time></trkpt>\n")
+                   .arg(45.0 + i * 0.0001, 0, 'f', 6)
+                   .arg(100.0 + i * 0.5, 0, 'f', 1)
+                   .arg(start.addSecs(i * 3).toString(Qt::ISODate));
+        }
+        out << "</trkseg></trk></gpx>\n";
+    }
+
+    static void sendMouse(QWidget* widget, QEvent::Type type, const QPoint& pos, Qt::MouseButtons buttons) {
+        QMouseEvent event(type, pos, widget->mapToGlobal(pos), Qt::LeftButton, buttons, Qt::NoModifier);
+        QApplication::sendEvent(widget, &event);
+    }
+
+private slots:
+    void initTestCase();
+    void testDragFillsRangeStats();
+};
+
+void MainWindowTest::initTestCase()
+{
+    // Keep recent files and caches out of the user's settings
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("RouteExplorer");
+    QCoreApplication::setApplicationName("GPX Viewer Tests");
+}
+
+void MainWindowTest::testDragFillsRangeStats()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("climb.gpx");
+    writeSampleTrack(path);
+
+    MainWindow window;
+    window.resize(1200, 800);
+    window.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&window));
+    QVERIFY(QMetaObject::invokeMethod(&window, "openFile", Qt::DirectConnection, Q_ARG(QString, path)));
+
+    QPushButton* button = window.findChild<QPushButton*>("rangeSelectButton");
+    QLabel* label = window.findChild<QLabel*>("rangeStatsLabel");
+    QCustomPlot* plot = window.findChild<QCustomPlot*>("elevationPlot");
+    TrackStatsWidget* stats = window.findChild<TrackStatsWidget*>();
+    QVERIFY(button && label && plot && stats);
+    QVERIFY(button->isEnabled());
+
+    // Range tables are built with the other whole-track metrics in the background
+    QTRY_VERIFY(!stats->getRangeStats().empty());
+
+    button->setChecked(true);
+    QCOMPARE(plot->selectionRectMode(), QCP::srmCustom);
+
+    const QRect area = plot->axisRect()->rect();
+    const QPoint from(area.left() + area.width() / 4, area.center().y());
+    const QPoint to(area.left() + area.width() * 3 / 4, area.center().y());
+    sendMouse(plot, QEvent::MouseButtonPress, from, Qt::LeftButton);
+    sendMouse(plot, QEvent::MouseMove, to, Qt::LeftButton);
+    sendMouse(plot, QEvent::MouseButtonRelease, to, Qt::NoButton);
+
+    QVERIFY(!label->text().isEmpty());
+    QVERIFY(label->text().contains("mi"));
+
+    // Leaving selection mode clears the panel again
+    button->setChecked(false);
+    QVERIFY(label->text().isEmpty());
+    QCOMPARE(plot->selectionRectMode(), QCP::srmNone);
+}
+
+QTEST_MAIN(MainWindowTest)
+#include "mainwindow_test.moc"
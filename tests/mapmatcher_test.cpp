@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include "MapMatcher.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <random>
+
+namespace {
+
+const double LAT0 = 45.0;
+const double LON0 = 10.0;
+const double METERS_PER_DEGREE = 111320.0;
+
+// Local meters east/north of the test origin
+QGeoCoordinate at(double east, double north) {
+    return QGeoCoordinate(LAT0 + north / METERS_PER_DEGREE,
+                          LON0 + east / (METERS_PER_DEGREE * std::cos(LAT0 * M_PI / 180.0)));
+}
+
+double northOf(const QGeoCoordinate& coord) {
+    return (coord.latitude() - LAT0) * METERS_PER_DEGREE;
+}
+
+double eastOf(const QGeoCoordinate& coord) {
+    return (coord.longitude() - LON0) * METERS_PER_DEGREE * std::cos(LAT0 * M_PI / 180.0);
+}
+
+// Within a few sigma of a grid junction, where either street is a fair match
+bool nearJunction(const QGeoCoordinate& coord, double spacing) {
+    const double east = eastOf(coord), north = northOf(coord);
+    return std::hypot(east - std::round(east / spacing) * spacing, north - std::round(north / spacing) * spacing) < 20.0;
+}
+
+// Square street grid: size x size nodes, spacing meters apart, every street two-way
+void addGrid(RoadGraph& graph, int size, double spacing) {
+    std::vector<std::vector<qint32>> nodes(size, std::vector<qint32>(size));
+    for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+            const QGeoCoordinate coord = at(column * spacing, row * spacing);
+            nodes[row][column] = graph.addNode(coord.latitude(), coord.longitude());
+        }
+    }
+    for (int i = 0; i < size; ++i) {
+        std::vector<qint32> street, avenue;
+        for (int j = 0; j < size; ++j) {
+            street.push_back(nodes[i][j]);
+            avenue.push_back(nodes[j][i]);
+        }
+        graph.addWay(street);
+        graph.addWay(avenue);
+    }
+}
+
+// Straight road from one local position to another, with a node every 100 m
+void addRoad(RoadGraph& graph, double east0, double north0, double east1, double north1, bool oneway = false) {
+    const int steps = std::max(1, static_cast<int>(std::hypot(east1 - east0, north1 - north0) / 100.0));
+    std::vector<qint32> nodes;
+    for (int k = 0; k <= steps; ++k) {
+        const double t = static_cast<double>(k) / steps;
+        const QGeoCoordinate coord = at(east0 + (east1 - east0) * t, north0 + (north1 - north0) * t);
+        nodes.push_back(graph.addNode(coord.latitude(), coord.longitude()));
+    }
+    graph.addWay(nodes, oneway);
+}
+
+// GPS trace through local waypoints, one point every step meters with Gaussian noise
+std::vector<TrackPoint> makeTrace(const std::vector<std::pair<double, double>>& waypoints, double step,
+                                  double noise, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> error(0.0, noise);
+    std::vector<TrackPoint> points;
+    double distance = 0.0;
+    for (size_t w = 1; w < waypoints.size(); ++w) {
+        const double dx = waypoints[w].first - waypoints[w - 1].first;
+        const double dy = waypoints[w].second - waypoints[w - 1].second;
+        const double length = std::hypot(dx, dy);
+        for (double s = 0.0; s < length; s += step) {
+            const double t = s / length;
+            const QGeoCoordinate coord = at(waypoints[w - 1].first + dx * t + error(rng),
+                                            waypoints[w - 1].second + dy * t + error(rng));
+            points.emplace_back(coord, 100.0, distance + s);
+        }
+        distance += length;
+    }
+    return points;
+}
+
+// Protobuf encoding, just enough for a .osm.pbf fixture
+void putVarint(QByteArray& out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+void putSigned(QByteArray& out, qint64 value) {
+    putVarint(out, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+void putField(QByteArray& out, int field, quint64 value) {
+    putVarint(out, static_cast<quint64>(field) << 3);
+    putVarint(out, value);
+}
+void putBytes(QByteArray& out, int field, const QByteArray& bytes) {
+    putVarint(out, (static_cast<quint64>(field) << 3) | 2);
+    putVarint(out, static_cast<quint64>(bytes.size()));
+    out.append(bytes);
+}
+
+QByteArray blob(const char* type, const QByteArray& block) {
+    QByteArray compressed = qCompress(block);
+    QByteArray body;
+    putField(body, 2, static_cast<quint64>(block.size()));
+    putBytes(body, 3, compressed.mid(4));   // zlib stream without Qt's size prefix
+    QByteArray header;
+    putBytes(header, 1, QByteArray(type));
+    putField(header, 3, static_cast<quint64>(body.size()));
+    QByteArray out;
+    const quint32 size = static_cast<quint32>(header.size());
+    out.append(static_cast<char>(size >> 24)).append(static_cast<char>(size >> 16))
+       .append(static_cast<char>(size >> 8)).append(static_cast<char>(size));
+    return out + header + body;
+}
+
+QByteArray way(qint64 id, const std::vector<std::pair<int, int>>& tags, const std::vector<qint64>& refs) {
+    QByteArray keys, values, packedRefs, out;
+    for (const auto& tag : tags) {
+        putVarint(keys, static_cast<quint64>(tag.first));
+        putVarint(values, static_cast<quint64>(tag.second));
+    }
+    qint64 previous = 0;
+    for (qint64 ref : refs) {
+        putSigned(packedRefs, ref - previous);
+        previous = ref;
+    }
+    putField(out, 1, static_cast<quint64>(id));
+    putBytes(out, 2, keys);
+    putBytes(out, 3, values);
+    putBytes(out, 8, packedRefs);
+    return out;
+}
+
+} // namespace
+
+TEST(MapMatcherTest, NoisyTraceSnapsToTheStreet) {
+    RoadGraph graph;
+    addGrid(graph, 6, 200.0);
+    graph.build();
+
+    std::vector<TrackPoint> trace = makeTrace({{0.0, 400.0}, {1000.0, 400.0}}, 5.0, 5.0, 3);
+    MapMatchResult result = MapMatcher(graph).match(trace);
+    ASSERT_EQ(result.points.size(), trace.size());
+    EXPECT_EQ(result.breaks, 0);
+    EXPECT_LT(result.usedPoints, trace.size());
+    for (const MatchedPoint& point : result.points) {
+        ASSERT_TRUE(point.matched);
+        if (!nearJunction(point.coord, 200.0)) {
+            EXPECT_NEAR(northOf(point.coord), 400.0, 0.5);
+        }
+    }
+    ASSERT_GE(result.path.size(), 2u);
+    EXPECT_NEAR(northOf(result.path.back()), 400.0, 0.5);
+}
+
+TEST(MapMatcherTest, TurnsFollowTheStreets) {
+    RoadGraph graph;
+    addGrid(graph, 6, 200.0);
+    graph.build();
+
+    // East along one street, north up an avenue, east again
+    std::vector<TrackPoint> trace = makeTrace({{0.0, 200.0}, {600.0, 200.0}, {600.0, 800.0}, {1000.0, 800.0}},
+                                              4.0, 6.0, 8);
+    MapMatchResult result = MapMatcher(graph).match(trace);
+    EXPECT_EQ(result.breaks, 0);
+    EXPECT_EQ(result.matchedCount(), trace.size());
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const double distance = trace[i].distance;
+        const QGeoCoordinate& coord = result.points[i].coord;
+        if (nearJunction(coord, 200.0)) {
+            continue;
+        }
+        if (distance < 600.0) {
+            EXPECT_NEAR(northOf(coord), 200.0, 0.5) << "point " << i;
+        } else if (distance < 1200.0) {
+            EXPECT_NEAR(eastOf(coord), 600.0, 0.5) << "point " << i;
+        } else {
+            EXPECT_NEAR(northOf(coord), 800.0, 0.5) << "point " << i;
+        }
+    }
+}
+
+TEST(MapMatcherTest, OneWayStreetIsNotRiddenAgainstTraffic) {
+    // The trace runs east between two roads; the closer one is one-way westbound
+    RoadGraph graph;
+    addRoad(graph, 1000.0, 12.0, 0.0, 12.0, true);
+    addRoad(graph, 0.0, -20.0, 1000.0, -20.0);
+    graph.build();
+
+    std::vector<TrackPoint> trace = makeTrace({{50.0, 0.0}, {950.0, 0.0}}, 5.0, 1.0, 4);
+    MapMatchResult result = MapMatcher(graph).match(trace);
+    EXPECT_EQ(result.breaks, 0);
+    for (const MatchedPoint& point : result.points) {
+        ASSERT_TRUE(point.matched);
+        EXPECT_NEAR(northOf(point.coord), -20.0, 0.5);
+    }
+}
+
+TEST(MapMatcherTest, DisconnectedRoadsBreakTheChain) {
+    RoadGraph graph;
+    addRoad(graph, 0.0, 0.0, 500.0, 0.0);
+    addRoad(graph, 600.0, 300.0, 1100.0, 300.0);
+    graph.build();
+
+    std::vector<TrackPoint> first = makeTrace({{0.0, 0.0}, {500.0, 0.0}}, 5.0, 3.0, 5);
+    std::vector<TrackPoint> second = makeTrace({{600.0, 300.0}, {1100.0, 300.0}}, 5.0, 3.0, 6);
+    std::vector<TrackPoint> trace = first;
+    trace.insert(trace.end(), second.begin(), second.end());
+    trace.emplace_back(at(2000.0, 2000.0), 100.0, 0.0);     // Far from every road
+
+    MapMatchResult result = MapMatcher(graph).match(trace);
+    EXPECT_EQ(result.breaks, 1);
+    EXPECT_EQ(result.matchedCount(), trace.size() - 1);
+    EXPECT_FALSE(result.points.back().matched);
+    EXPECT_NEAR(northOf(result.points[first.size() - 1].coord), 0.0, 0.5);
+    EXPECT_NEAR(northOf(result.points[first.size()].coord), 300.0, 0.5);
+}
+
+TEST(MapMatcherTest, ReadsRoadsFromPbf) {
+    // Nodes and ways in separate compressed blocks after a header block
+    const QStringList strings = {"", "highway", "residential", "oneway", "yes", "building"};
+    QByteArray table;
+    for (const QString& text : strings) {
+        putBytes(table, 1, text.toUtf8());
+    }
+
+    QByteArray ids, lats, lons;
+    const std::vector<std::pair<double, double>> positions = {{0.0, 0.0}, {100.0, 0.0}, {200.0, 0.0}, {200.0, 100.0}};
+    qint64 previousLat = 0, previousLon = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const QGeoCoordinate coord = at(positions[i].first, positions[i].second);
+        const qint64 lat = std::llround(coord.latitude() * 1e7), lon = std::llround(coord.longitude() * 1e7);
+        putSigned(ids, 1);
+        putSigned(lats, lat - previousLat);
+        putSigned(lons, lon - previousLon);
+        previousLat = lat;
+        previousLon = lon;
+    }
+    QByteArray dense, nodeGroup, nodeBlock;
+    putBytes(dense, 1, ids);
+    putBytes(dense, 8, lats);
+    putBytes(dense, 9, lons);
+    putBytes(nodeGroup, 2, dense);
+    putBytes(nodeBlock, 1, table);
+    putBytes(nodeBlock, 2, nodeGroup);
+
+    QByteArray wayGroup, wayBlock;
+    putBytes(wayGroup, 3, way(10, {{1, 2}}, {1, 2, 3}));
+    putBytes(wayGroup, 3, way(11, {{5, 4}}, {1, 4}));                  // Not a road
+    putBytes(wayGroup, 3, way(12, {{1, 2}, {3, 4}}, {3, 4, 99}));       // One-way, node 99 outside the extract
+    putBytes(wayBlock, 1, table);
+    putBytes(wayBlock, 2, wayGroup);
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("roads.osm.pbf");
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(blob("OSMHeader", QByteArray("ignored")) + blob("OSMData", nodeBlock) + blob("OSMData", wayBlock));
+    file.close();
+
+    RoadGraph graph;
+    ASSERT_TRUE(graph.loadPbf(path)) << graph.errorString().toStdString();
+    EXPECT_EQ(graph.nodeCount(), 4u);
+    ASSERT_EQ(graph.segmentCount(), 3u);
+    int oneway = 0;
+    for (qint32 s = 0; s < static_cast<qint32>(graph.segmentCount()); ++s) {
+        const RoadSegment& segment = graph.segment(s);
+        EXPECT_NEAR(segment.length, 100.0, 0.5);
+        if (!segment.backward) {
+            ++oneway;
+            EXPECT_NEAR(northOf(graph.nodeCoordinate(segment.to)), 100.0, 0.01);
+        }
+    }
+    EXPECT_EQ(oneway, 1);
+
+    EXPECT_FALSE(RoadGraph().loadPbf(dir.filePath("missing.osm.pbf")));
+}
+
+TEST(MapMatcherTest, LongTrack) {
+    // 100k points at 1 Hz wandering over a city grid
+    RoadGraph graph;
+    addGrid(graph, 41, 100.0);
+    graph.build();
+
+    std::vector<std::pair<double, double>> waypoints;
+    for (int lap = 0; lap < 4; ++lap) {
+        for (int row = 0; row < 40; row += 2) {
+            waypoints.emplace_back(0.0, row * 100.0);
+            waypoints.emplace_back(4000.0, row * 100.0);
+            waypoints.emplace_back(4000.0, row * 100.0 + 100.0);
+            waypoints.emplace_back(0.0, row * 100.0 + 100.0);
+        }
+    }
+    std::vector<TrackPoint> trace = makeTrace(waypoints, 5.0, 4.0, 9);
+    trace.resize(std::min<size_t>(trace.size(), 100000));
+    ASSERT_EQ(trace.size(), 100000u);
+
+    MapMatchResult result = MapMatcher(graph).match(trace);
+    EXPECT_GT(result.matchedCount(), trace.size() * 99 / 100);
+    EXPECT_LT(result.breaks, 5);
+    size_t offRoad = 0;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const double north = northOf(result.points[i].coord);
+        const double east = eastOf(result.points[i].coord);
+        if (std::abs(north - std::round(north / 100.0) * 100.0) > 0.5 && std::abs(east - std::round(east / 100.0) * 100.0) > 0.5) {
+            ++offRoad;
+        }
+    }
+    EXPECT_EQ(offRoad, 0u);
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "MotionAnalyzer.h"
+#include <cmath>
+
+namespace {
+
+// Points one second apart; each entry is the speed in m/s for that second
+std::vector<TrackPoint> makeTimedTrack(const std::vector<double>& speeds) {
+    QDateTime start = QDateTime::fromSecsSinceEpoch(1700000000);
+    std::vector<TrackPoint> points;
+    double distance = 0.0;
+    points.emplace_back(QGeoCoordinate(45.0, 10.0), 100.0, distance, start);
+    for (size_t i = 0; i < speeds.size(); ++i) {
+        distance += speeds[i];
+        points.emplace_back(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), 100.0, distance,
+                            start.addSecs(static_cast<qint64>(i) + 1));
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(MotionAnalyzerTest, ConstantSpeed) {
+    std::vector<TrackPoint> points = makeTimedTrack(std::vector<double>(600, 5.0));
+    MotionProfile profile = MotionAnalyzer().analyze(TrackColumns::fromPoints(points));
+
+    ASSERT_TRUE(profile.hasTime());
+    EXPECT_DOUBLE_EQ(profile.elapsedTime, 600.0);
+    EXPECT_DOUBLE_EQ(profile.movingTime, 600.0);
+    EXPECT_NEAR(profile.averageMovingSpeed(), 5.0, 1e-9);
+    EXPECT_NEAR(profile.maxSpeed, 5.0, 1e-9);
+    EXPECT_TRUE(std::isnan(profile.speed[0]));
+    EXPECT_NEAR(profile.speed[300], 5.0, 1e-9);
+    EXPECT_NEAR(profile.pace[300], 200.0, 1e-9);
+}
+
+TEST(MotionAnalyzerTest, StopsAreExcludedFromMovingTime) {
+    std::vector<double> speeds(300, 4.0);
+    speeds.insert(speeds.end(), 120, 0.1);   // Two minute stop with GPS drift
+    speeds.insert(speeds.end(), 300, 4.0);
+    std::vector<TrackPoint> points = makeTimedTrack(speeds);
+    MotionProfile profile = MotionAnalyzer().analyze(TrackColumns::fromPoints(points));
+
+    EXPECT_DOUBLE_EQ(profile.elapsedTime, 720.0);
+    EXPECT_DOUBLE_EQ(profile.movingTime, 600.0);
+    EXPECT_DOUBLE_EQ(profile.stoppedTime(), 120.0);
+    EXPECT_NEAR(profile.averageMovingSpeed(), 4.0, 1e-9);
+    EXPECT_EQ(profile.moving[350], 0);
+    EXPECT_TRUE(std::isnan(profile.pace[350]));
+    // The smoothed speed trails the restart by up to one window
+    EXPECT_LT(profile.smoothedSpeed[430], 4.0);
+    EXPECT_NEAR(profile.smoothedSpeed[460], 4.0, 1e-9);
+}
+
+TEST(MotionAnalyzerTest, RecordingGapsArePaused) {
+    std::vector<TrackPoint> points = makeTimedTrack(std::vector<double>(200, 5.0));
+    // Shift the second half ten minutes later, as an auto-paused device would
+    for (size_t i = 101; i < points.size(); ++i) {
+        points[i].timestamp = points[i].timestamp.addSecs(600);
+    }
+    MotionProfile profile = MotionAnalyzer().analyze(TrackColumns::fromPoints(points));
+
+    EXPECT_DOUBLE_EQ(profile.elapsedTime, 800.0);
+    EXPECT_DOUBLE_EQ(profile.movingTime, 199.0);
+    EXPECT_EQ(profile.moving[101], 0);
+}
+
+TEST(MotionAnalyzerTest, MissingTimestamps) {
+    std::vector<TrackPoint> points = makeTimedTrack(std::vector<double>(100, 5.0));
+    points[50].timestamp = QDateTime();
+    MotionProfile profile = MotionAnalyzer().analyze(TrackColumns::fromPoints(points));
+    EXPECT_DOUBLE_EQ(profile.movingTime, 100.0);
+    EXPECT_TRUE(std::isnan(profile.speed[50]));
+    EXPECT_NEAR(profile.speed[51], 5.0, 1e-9);
+
+    for (auto& point : points) {
+        point.timestamp = QDateTime();
+    }
+    MotionProfile untimed = MotionAnalyzer().analyze(TrackColumns::fromPoints(points));
+    EXPECT_FALSE(untimed.hasTime());
+    EXPECT_EQ(untimed.speed.size(), points.size());
+    EXPECT_DOUBLE_EQ(untimed.movingTime, 0.0);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "PacingModel.h"
+#include "synthetic_track.h"
+#include <cmath>
+
+namespace {
+
+// Bisection on the power balance, as an independent reference
+double referenceSpeed(const RiderParams& params, double gradient) {
+    double angle = std::atan(gradient / 100.0);
+    auto power = [&](double v) {
+        return v * params.mass * 9.80665 * (std::sin(angle) + params.rollingResistance * std::cos(angle)) +
+               0.5 * params.airDensity * params.dragArea * v * v * v;
+    };
+    // Power needed is negative below the root on descents, so search from the local minimum upwards
+    double low = 0.0, high = 100.0;
+    for (int i = 0; i < 200; ++i) {
+        double mid = 0.5 * (low + high);
+        if (power(mid) < params.power) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return std::min(params.maxSpeed, std::max(params.minSpeed, low));
+}
+
+} // namespace
+
+TEST(PacingModelTest, CyclingSpeedMatchesPowerBalance) {
+    RiderParams params;
+    params.maxSpeed = 100.0;
+    params.minSpeed = 0.0;
+    PacingModel model(params);
+    for (double gradient = -8.0; gradient <= 25.0; gradient += 0.5) {
+        EXPECT_NEAR(model.speedAt(gradient), referenceSpeed(params, gradient), 1e-6) << gradient;
+    }
+}
+
+TEST(PacingModelTest, SpeedLimits) {
+    PacingModel model;
+    EXPECT_DOUBLE_EQ(model.speedAt(-15.0), model.params().maxSpeed);
+    EXPECT_DOUBLE_EQ(model.speedAt(40.0), model.params().minSpeed);
+    EXPECT_GT(model.speedAt(0.0), model.speedAt(5.0));
+}
+
+TEST(PacingModelTest, HikingFollowsTobler) {
+    RiderParams params;
+    params.mode = RiderParams::HIKING;
+    PacingModel model(params);
+    EXPECT_NEAR(model.speedAt(-5.0) * 3.6, 6.0, 1e-9);     // Fastest on a gentle descent
+    EXPECT_NEAR(model.speedAt(0.0) * 3.6, 6.0 * std::exp(-0.175), 1e-9);
+    EXPECT_LT(model.speedAt(20.0), model.speedAt(0.0));
+}
+
+TEST(PacingModelTest, EstimateAccumulatesIntervals) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(2000, 8);
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    PacingModel model;
+    PacingEstimate estimate = model.estimate(columns);
+
+    ASSERT_EQ(estimate.elapsed.size(), points.size());
+    double expected = 0.0;
+    for (size_t i = 1; i < points.size(); ++i) {
+        expected += (points[i].distance - points[i - 1].distance) / model.speedAt(points[i].gradient);
+    }
+    EXPECT_NEAR(estimate.totalTime(), expected, 1e-6);
+    EXPECT_DOUBLE_EQ(estimate.elapsed[0], 0.0);
+}
+
+TEST(PacingModelTest, SweepMatchesSingleRuns) {
+    TrackColumns columns = TrackColumns::fromPoints(makeSyntheticTrack(3000, 9));
+    std::vector<RiderParams> grid;
+    for (double power : {150.0, 200.0, 250.0, 300.0}) {
+        RiderParams params;
+        params.power = power;
+        grid.push_back(params);
+    }
+    std::vector<double> times = PacingModel::sweep(columns, grid);
+
+    ASSERT_EQ(times.size(), grid.size());
+    for (size_t i = 0; i < grid.size(); ++i) {
+        EXPECT_DOUBLE_EQ(times[i], PacingModel(grid[i]).estimate(columns).totalTime());
+        if (i > 0) {
+            EXPECT_LT(times[i], times[i - 1]);
+        }
+    }
+}
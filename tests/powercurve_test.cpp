@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include "PowerCurve.h"
+#include <random>
+
+namespace {
+
+double bruteForce(const std::vector<double>& watts, int duration) {
+    double best = 0.0;
+    for (size_t start = 0; start + duration <= watts.size(); ++start) {
+        double sum = 0.0;
+        for (int i = 0; i < duration; ++i) {
+            sum += watts[start + i];
+        }
+        best = std::max(best, sum / duration);
+    }
+    return best;
+}
+
+} // namespace
+
+TEST(PowerCurveTest, MatchesBruteForce) {
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<double> power(0.0, 600.0);
+    std::vector<double> watts(3000);
+    for (double& w : watts) {
+        w = power(rng);
+    }
+    PowerCurve curve = PowerCurve::fromSeries(watts);
+
+    ASSERT_FALSE(curve.isEmpty());
+    EXPECT_EQ(curve.points().back().duration, 3000);
+    for (const PowerCurvePoint& point : curve.points()) {
+        ASSERT_NEAR(point.power, bruteForce(watts, point.duration), 1e-6) << point.duration;
+    }
+}
+
+TEST(PowerCurveTest, SampledDurations) {
+    std::vector<int> durations = PowerCurve::sampleDurations(36000);
+    EXPECT_EQ(durations.front(), 1);
+    EXPECT_EQ(durations[119], 120);
+    EXPECT_EQ(durations.back(), 36000);
+    EXPECT_LT(durations.size(), 250u);
+    EXPECT_TRUE(std::is_sorted(durations.begin(), durations.end()));
+}
+
+TEST(PowerCurveTest, IntervalInSteadyRide) {
+    // One hour at 200 W with a minute at 400 W after ten minutes
+    std::vector<double> watts(3600, 200.0);
+    std::fill(watts.begin() + 600, watts.begin() + 660, 400.0);
+    PowerCurve curve = PowerCurve::fromSeries(watts);
+
+    EXPECT_DOUBLE_EQ(curve.powerAt(1), 400.0);
+    EXPECT_DOUBLE_EQ(curve.powerAt(60), 400.0);
+    EXPECT_DOUBLE_EQ(curve.powerAt(120), 300.0);
+    EXPECT_EQ(curve.points()[59].startSecond, 600);
+    EXPECT_NEAR(curve.powerAt(3600), 200.0 + 200.0 * 60 / 3600, 1e-9);
+}
+
+TEST(PowerCurveTest, CriticalPowerFromHyperbola) {
+    // Each window holds its own W'/t + CP effort at the start, then easy riding
+    const double cp = 250.0, wPrime = 20000.0;
+    std::vector<double> watts(1200, 0.0);
+    for (size_t i = 0; i < watts.size(); ++i) {
+        double t = static_cast<double>(i + 1);
+        // Marginal power so that the first t seconds average exactly W'/t + CP
+        double previousWork = (i == 0) ? 0.0 : wPrime + cp * i;
+        watts[i] = (i == 0) ? wPrime + cp : (wPrime + cp * t) - previousWork;
+    }
+    PowerCurve curve = PowerCurve::fromSeries(watts);
+    EXPECT_NEAR(curve.criticalPower(), cp, 1e-6);
+    EXPECT_NEAR(curve.anaerobicCapacity(), wPrime, 1e-3);
+}
+
+TEST(PowerCurveTest, FromColumns) {
+    // 1 Hz samples recorded every 2 s, with a 2 minute pause
+    std::vector<TrackPoint> points;
+    qint64 ms = 1700000000000LL;
+    for (int i = 0; i < 200; ++i) {
+        TrackPoint point(QGeoCoordinate(45.0, 10.0), 100.0, i * 10.0, QDateTime::fromMSecsSinceEpoch(ms));
+        point.power = 250.0;
+        points.push_back(point);
+        ms += (i == 99) ? 120000 : 2000;
+    }
+    PowerCurve curve = PowerCurve::compute(TrackColumns::fromPoints(points));
+
+    ASSERT_FALSE(curve.isEmpty());
+    EXPECT_EQ(curve.points().back().duration, 99 * 2 * 2 + 120 + 1);
+    EXPECT_DOUBLE_EQ(curve.powerAt(100), 250.0);
+    // The last sample is held for 30 s into the pause, the remaining 89 s count as zero
+    double expected = 250.0 * (curve.points().back().duration - 89) / curve.points().back().duration;
+    EXPECT_NEAR(curve.points().back().power, expected, 1e-9);
+
+    EXPECT_TRUE(PowerCurve::compute(TrackColumns::fromPoints(std::vector<TrackPoint>(10))).isEmpty());
+}
+
+TEST(PowerCurveTest, OutOfOrderTimestamps) {
+    // Same ride as recorded in order, with a block of samples written late
+    std::vector<TrackPoint> points;
+    qint64 ms = 1700000000000LL;
+    for (int i = 0; i < 300; ++i) {
+        TrackPoint point(QGeoCoordinate(45.0, 10.0), 100.0, i * 10.0, QDateTime::fromMSecsSinceEpoch(ms + i * 1000));
+        point.power = 150.0 + (i % 60) * 5.0;
+        points.push_back(point);
+    }
+    std::vector<TrackPoint> shuffled(points.begin() + 200, points.end());
+    shuffled.insert(shuffled.end(), points.begin(), points.begin() + 200);
+    std::swap(shuffled[10], shuffled[250]);
+
+    PowerCurve ordered = PowerCurve::compute(TrackColumns::fromPoints(points));
+    PowerCurve curve = PowerCurve::compute(TrackColumns::fromPoints(shuffled));
+
+    ASSERT_FALSE(curve.isEmpty());
+    ASSERT_EQ(curve.points().size(), ordered.points().size());
+    EXPECT_EQ(curve.points().back().duration, 300);
+    for (size_t i = 0; i < curve.points().size(); ++i) {
+        EXPECT_DOUBLE_EQ(curve.points()[i].power, ordered.points()[i].power) << curve.points()[i].duration;
+    }
+}
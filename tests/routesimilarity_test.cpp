@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "RouteSimilarity.h"
+#include "synthetic_track.h"
+#include <QTemporaryDir>
+
+namespace {
+
+// Synthetic track moved by the given offset in degrees
+std::vector<TrackPoint> makeRoute(size_t count, unsigned seed, double latOffset, double lonOffset) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(count, seed);
+    for (TrackPoint& point : points) {
+        point.coord = QGeoCoordinate(point.coord.latitude() + latOffset, point.coord.longitude() + lonOffset);
+    }
+    return points;
+}
+
+// Every n-th point, keeping cumulative distances
+std::vector<TrackPoint> decimate(const std::vector<TrackPoint>& points, size_t n) {
+    std::vector<TrackPoint> result;
+    for (size_t i = 0; i < points.size(); i += n) {
+        result.push_back(points[i]);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(RouteSimilarityTest, JaccardOfCellSets) {
+    EXPECT_DOUBLE_EQ(RouteSimilarityIndex::jaccard({1, 2, 3, 4}, {3, 4, 5, 6}), 2.0 / 6.0);
+    EXPECT_DOUBLE_EQ(RouteSimilarityIndex::jaccard({1, 2}, {1, 2}), 1.0);
+    EXPECT_DOUBLE_EQ(RouteSimilarityIndex::jaccard({1, 2}, {3}), 0.0);
+    EXPECT_DOUBLE_EQ(RouteSimilarityIndex::jaccard({}, {}), 0.0);
+}
+
+TEST(RouteSimilarityTest, SparseRecordingCoversSameCells) {
+    RouteSimilarityIndex index;
+    std::vector<TrackPoint> dense = makeRoute(4000, 1, 0.0, 0.0);
+    RouteSketch denseSketch = index.sketch(dense);
+    RouteSketch sparseSketch = index.sketch(decimate(dense, 20));
+
+    ASSERT_FALSE(denseSketch.isEmpty());
+    EXPECT_EQ(static_cast<int>(denseSketch.signature.size()), index.params().signatureSize());
+    EXPECT_GT(RouteSimilarityIndex::jaccard(denseSketch.cells, sparseSketch.cells), 0.9);
+}
+
+TEST(RouteSimilarityTest, FindsVariantsAmongManyRoutes) {
+    RouteSimilarityIndex index;
+    std::vector<TrackPoint> original = makeRoute(3000, 7, 0.0, 0.0);
+
+    // Unrelated routes all over a region, plus variants of the original
+    for (int k = 0; k < 300; ++k) {
+        index.add(QString("other%1.gpx").arg(k),
+                  index.sketch(makeRoute(3000, 100 + k, 0.3 * (k % 20 + 1), 0.3 * (k / 20))));
+    }
+    index.add("same.gpx", index.sketch(decimate(original, 3)));
+    std::vector<TrackPoint> partial(original.begin(), original.begin() + 2400);
+    index.add("partial.gpx", index.sketch(partial));
+    ASSERT_EQ(index.size(), 302u);
+
+    RouteSketch query = index.sketch(original);
+    std::vector<RouteMatch> matches = index.query(query, 10, 0.5);
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].file, QString("same.gpx"));
+    EXPECT_EQ(matches[1].file, QString("partial.gpx"));
+    EXPECT_GT(matches[0].similarity, 0.8);
+    EXPECT_NEAR(matches[1].coverage, matches[1].similarity, 0.05); // Partial route lies within the query
+    EXPECT_LT(matches[1].coverage, 0.9);
+
+    // Only a small shortlist is scored exactly
+    EXPECT_LT(index.candidateCount(query), 20u);
+}
+
+TEST(RouteSimilarityTest, SaveAndLoad) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("index.idx");
+
+    RouteSimilarityIndex index;
+    for (int k = 0; k < 20; ++k) {
+        index.add(QString("route%1.gpx").arg(k), index.sketch(makeRoute(1000, k, 0.2 * k, 0.0)), 1000 + k, 5000 + k);
+    }
+    ASSERT_TRUE(index.save(path));
+
+    RouteSimilarityIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_EQ(loaded.size(), index.size());
+    RouteSketch query = index.sketch(makeRoute(1000, 5, 1.0, 0.0));
+    std::vector<RouteMatch> matches = loaded.query(query);
+    ASSERT_FALSE(matches.empty());
+    EXPECT_EQ(matches[0].file, QString("route5.gpx"));
+    EXPECT_DOUBLE_EQ(matches[0].similarity, 1.0);
+
+    // An index built with other parameters is not reused
+    SimilarityParams coarse;
+    coarse.cellSize = 250.0;
+    RouteSimilarityIndex other(coarse);
+    EXPECT_FALSE(other.load(path));
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "SegmentMatcher.h"
+#include <cmath>
+
+namespace {
+
+const double ORIGIN_LAT = 45.0;
+const double ORIGIN_LON = 10.0;
+
+// Track through waypoints given in meters east and north of the origin, one point
+// every 10 m at a constant speed; speed 0 leaves the points untimed
+std::vector<TrackPoint> makeRide(const std::vector<std::pair<double, double>>& waypoints, double speed,
+                                 double offsetEast = 0.0) {
+    std::vector<TrackPoint> points;
+    const double metersPerLon = 111320.0 * std::cos(ORIGIN_LAT * M_PI / 180.0);
+    double distance = 0.0;
+    for (size_t w = 1; w < waypoints.size(); ++w) {
+        const double dx = waypoints[w].first - waypoints[w - 1].first;
+        const double dy = waypoints[w].second - waypoints[w - 1].second;
+        const double leg = std::sqrt(dx * dx + dy * dy);
+        const int steps = std::max(1, static_cast<int>(std::round(leg / 10.0)));
+        for (int k = (w == 1 ? 0 : 1); k <= steps; ++k) {
+            const double t = static_cast<double>(k) / steps;
+            const double x = waypoints[w - 1].first + dx * t + offsetEast;
+            const double y = waypoints[w - 1].second + dy * t;
+            if (!points.empty()) {
+                distance += leg / steps;
+            }
+            TrackPoint point(QGeoCoordinate(ORIGIN_LAT + y / 111320.0, ORIGIN_LON + x / metersPerLon), 100.0, distance);
+            if (speed > 0.0) {
+                point.timestamp = QDateTime::fromMSecsSinceEpoch(1600000000000LL + static_cast<qint64>(distance / speed * 1000.0));
+            }
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+// The segment: 2 km due north from the origin
+SegmentDefinition makeSegment() {
+    std::vector<TrackPoint> reference = makeRide({{0.0, -500.0}, {0.0, 2500.0}}, 10.0);
+    return SegmentDefinition::fromTrack(reference, 50, 250);
+}
+
+} // namespace
+
+TEST(SegmentMatcherTest, DefinitionIsResampled) {
+    SegmentDefinition segment = makeSegment();
+    ASSERT_FALSE(segment.isEmpty());
+    EXPECT_NEAR(segment.length, 2000.0, 1e-6);
+    EXPECT_EQ(segment.path.size(), 201u);
+    EXPECT_TRUE(SegmentDefinition::fromTrack(makeRide({{0.0, 0.0}, {0.0, 100.0}}, 1.0), 5, 5).isEmpty());
+}
+
+TEST(SegmentMatcherTest, FindsEveryTraversalFastestFirst) {
+    SegmentIndex index;
+    index.addTrack("slow.gpx", makeRide({{-800.0, -300.0}, {0.0, -300.0}, {0.0, 2400.0}}, 8.0));
+    index.addTrack("fast.gpx", makeRide({{0.0, -1000.0}, {0.0, 3000.0}}, 12.0));
+    index.addTrack("elsewhere.gpx", makeRide({{5000.0, 0.0}, {5000.0, 2000.0}}, 10.0));
+    index.addTrack("medium.gpx", makeRide({{0.0, -100.0}, {0.0, 2100.0}, {900.0, 2100.0}}, 10.0, 5.0));
+    index.build();
+
+    std::vector<SegmentEffort> efforts = index.find(makeSegment());
+    ASSERT_EQ(efforts.size(), 3u);
+    EXPECT_EQ(efforts[0].file, QString("fast.gpx"));
+    EXPECT_EQ(efforts[1].file, QString("medium.gpx"));
+    EXPECT_EQ(efforts[2].file, QString("slow.gpx"));
+    EXPECT_NEAR(efforts[0].elapsedTime, 2000.0 / 12.0, 2.0);
+    EXPECT_NEAR(efforts[1].elapsedTime, 2000.0 / 10.0, 2.0);
+    EXPECT_NEAR(efforts[2].elapsedTime, 2000.0 / 8.0, 2.0);
+    for (const SegmentEffort& effort : efforts) {
+        EXPECT_NEAR(effort.distance, 2000.0, 20.0);
+        EXPECT_GE(effort.pathFidelity, 0.99);
+        EXPECT_EQ(index.file(effort.track), effort.file);
+    }
+}
+
+TEST(SegmentMatcherTest, ReverseDirectionIsNotMatched) {
+    SegmentIndex index;
+    index.addTrack("reverse.gpx", makeRide({{0.0, 2500.0}, {0.0, -500.0}}, 10.0));
+    index.build();
+    EXPECT_TRUE(index.find(makeSegment()).empty());
+}
+
+TEST(SegmentMatcherTest, OtherRoadBetweenEndpointsIsRejected) {
+    SegmentIndex index;
+    // Same start and end, within the length ratio, but 300 m off the segment in the middle
+    index.addTrack("parallel.gpx", makeRide({{0.0, -200.0}, {0.0, 0.0}, {300.0, 1000.0}, {0.0, 2000.0}, {0.0, 2200.0}}, 10.0));
+    // Too long a detour to count as the segment
+    index.addTrack("detour.gpx", makeRide({{0.0, -200.0}, {0.0, 0.0}, {1200.0, 0.0}, {1200.0, 2000.0},
+                                           {0.0, 2000.0}, {0.0, 2200.0}}, 10.0));
+    // A 100 m excursion off the road still follows most of the path
+    index.addTrack("excursion.gpx", makeRide({{0.0, -200.0}, {0.0, 950.0}, {100.0, 950.0}, {100.0, 1050.0},
+                                              {0.0, 1050.0}, {0.0, 2200.0}}, 10.0));
+    index.build();
+
+    std::vector<SegmentEffort> efforts = index.find(makeSegment());
+    ASSERT_EQ(efforts.size(), 1u);
+    EXPECT_EQ(efforts[0].file, QString("excursion.gpx"));
+    EXPECT_LT(efforts[0].pathFidelity, 1.0);
+}
+
+TEST(SegmentMatcherTest, LapsGiveOneEffortEach) {
+    SegmentIndex index;
+    // Up the segment, back down a road 500 m east, and up the segment again
+    index.addTrack("laps.gpx", makeRide({{0.0, -200.0}, {0.0, 2200.0}, {500.0, 2200.0}, {500.0, -200.0},
+                                         {0.0, -200.0}, {0.0, 2200.0}}, 10.0));
+    index.addTrack("untimed.gpx", makeRide({{0.0, -200.0}, {0.0, 2200.0}}, 0.0));
+    index.build();
+
+    std::vector<SegmentEffort> efforts = index.find(makeSegment());
+    ASSERT_EQ(efforts.size(), 3u);
+    EXPECT_EQ(efforts[0].file, QString("laps.gpx"));
+    EXPECT_EQ(efforts[1].file, QString("laps.gpx"));
+    EXPECT_LT(std::min(efforts[0].endIndex, efforts[1].endIndex), std::max(efforts[0].startIndex, efforts[1].startIndex));
+    EXPECT_EQ(efforts[2].file, QString("untimed.gpx"));
+    EXPECT_TRUE(std::isnan(efforts[2].elapsedTime));
+    EXPECT_FALSE(efforts[2].startTime.isValid());
+}
+
+TEST(SegmentMatcherTest, LargeLibrary) {
+    SegmentIndex index;
+    int expected = 0;
+    for (int k = 0; k < 1000; ++k) {
+        if (k % 25 == 0) {
+            index.addTrack(QString("match%1.gpx").arg(k), makeRide({{0.0, -3000.0}, {0.0, 5000.0}}, 5.0 + k % 7));
+            ++expected;
+        } else {
+            // Same area, other roads: parallel lines and crossings of the segment
+            const double east = 200.0 * (k % 40 - 20) + 50.0;
+            if (k % 2 == 0) {
+                index.addTrack(QString("other%1.gpx").arg(k), makeRide({{east, -3000.0}, {east, 5000.0}}, 8.0));
+            } else {
+                index.addTrack(QString("cross%1.gpx").arg(k), makeRide({{-4000.0, east * 0.5}, {4000.0, east * 0.5}}, 8.0));
+            }
+        }
+    }
+    index.build();
+    EXPECT_EQ(index.trackCount(), 1000u);
+    EXPECT_GT(index.pointCount(), 750000u);
+
+    std::vector<SegmentEffort> efforts = index.find(makeSegment());
+    EXPECT_EQ(static_cast<int>(efforts.size()), expected);
+    for (size_t i = 1; i < efforts.size(); ++i) {
+        EXPECT_LE(efforts[i - 1].elapsedTime, efforts[i].elapsedTime);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GpxParser.h"
+#include <random>
+#include <vector>
+
+/**
+ * @brief Deterministic synthetic track for tests and benchmarks
+ *
+ * Noisy rolling terrain with long false-flat stretches, heading north with
+ * one point every 5-15 m. Gradients are pre-filled like GPXParser does.
+ */
+inline std::vector<TrackPoint> makeSyntheticTrack(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1.2);
+    std::uniform_real_distribution<double> step(5.0, 15.0);
+    std::uniform_real_distribution<double> target(-9.0, 9.0);
+    std::uniform_int_distribution<int> length(20, 400);
+    
+    std::vector<TrackPoint> points;
+    points.reserve(count);
+    double distance = 0.0;
+    double elevation = 500.0;
+    double baseGradient = 0.0;
+    int remaining = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (remaining-- <= 0) {
+            baseGradient = (rng() % 3 == 0) ? 0.5 : target(rng);
+            remaining = length(rng);
+        }
+        double gradient = baseGradient + noise(rng);
+        if (i > 0) {
+            double delta = step(rng);
+            distance += delta;
+            elevation += delta * gradient / 100.0;
+        }
+        TrackPoint point(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), elevation, distance);
+        point.gradient = gradient;
+        points.push_back(point);
+    }
+    return points;
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "TrackAligner.h"
+#include "synthetic_track.h"
+#include <cmath>
+
+namespace {
+
+const qint64 START_MS = 1600000000000LL;
+
+// Same road as makeSyntheticTrack, ridden at a constant speed, with an optional stop
+std::vector<TrackPoint> makeEffort(const std::vector<TrackPoint>& route, double speed,
+                                   double stopAt = -1.0, double stopSeconds = 0.0) {
+    std::vector<TrackPoint> points = route;
+    for (TrackPoint& point : points) {
+        double seconds = point.distance / speed;
+        if (stopAt >= 0.0 && point.distance > stopAt) {
+            seconds += stopSeconds;
+        }
+        point.timestamp = QDateTime::fromMSecsSinceEpoch(START_MS + static_cast<qint64>(seconds * 1000.0));
+    }
+    return points;
+}
+
+// The same road recorded with other sample positions: one point every `spacing` meters
+std::vector<TrackPoint> resampleRoute(const std::vector<TrackPoint>& route, double spacing, double elevationShift) {
+    std::vector<TrackPoint> points;
+    size_t k = 1;
+    for (double d = 0.0; d <= route.back().distance; d += spacing) {
+        while (k + 1 < route.size() && route[k].distance < d) {
+            ++k;
+        }
+        const TrackPoint& p = route[k - 1];
+        const TrackPoint& q = route[k];
+        const double t = std::min(std::max((d - p.distance) / (q.distance - p.distance), 0.0), 1.0);
+        TrackPoint point(QGeoCoordinate(p.coord.latitude() + (q.coord.latitude() - p.coord.latitude()) * t,
+                                        p.coord.longitude()),
+                         p.elevation + (q.elevation - p.elevation) * t + elevationShift, d);
+        points.push_back(point);
+    }
+    return points;
+}
+
+// Unbanded O(n·m) DTW cost with the same local cost, for reference
+double fullDtwCost(const std::vector<TrackPoint>& a, const std::vector<TrackPoint>& b) {
+    const double lonScale = 111320.0 * std::cos(a.front().coord.latitude() * M_PI / 180.0);
+    auto cost = [&](size_t i, size_t j) {
+        const double dx = (b[j].coord.longitude() - a[i].coord.longitude()) * lonScale;
+        const double dy = (b[j].coord.latitude() - a[i].coord.latitude()) * 111320.0;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> previous(b.size(), inf), current(b.size(), inf);
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (size_t j = 0; j < b.size(); ++j) {
+            double best = (i == 0 && j == 0) ? 0.0 : inf;
+            if (i > 0) best = std::min(best, previous[j]);
+            if (j > 0) best = std::min(best, current[j - 1]);
+            if (i > 0 && j > 0) best = std::min(best, previous[j - 1]);
+            current[j] = best + cost(i, j);
+        }
+        std::swap(previous, current);
+    }
+    return previous.back();
+}
+
+} // namespace
+
+TEST(TrackAlignerTest, IdenticalEffortsAlignOnTheDiagonal) {
+    std::vector<TrackPoint> effort = makeEffort(makeSyntheticTrack(2000, 3), 8.0);
+    TrackAlignment alignment = TrackAligner().align(effort, effort);
+
+    ASSERT_EQ(alignment.points.size(), effort.size());
+    EXPECT_EQ(alignment.path.size(), effort.size());
+    EXPECT_NEAR(alignment.cost, 0.0, 1e-9);
+    for (const AlignedPoint& point : alignment.points) {
+        EXPECT_EQ(point.otherIndex, point.index);
+        EXPECT_NEAR(point.timeGap, 0.0, 1e-9);
+        EXPECT_NEAR(point.elevationDelta, 0.0, 1e-9);
+    }
+}
+
+TEST(TrackAlignerTest, TimeGapAndElevationDeltaFollowTheRoad) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(3000, 5);
+    std::vector<TrackPoint> reference = makeEffort(route, 10.0);
+    // Slower rider, recorded every 7 m with a barometer offset and a two-minute stop halfway
+    std::vector<TrackPoint> other = makeEffort(resampleRoute(route, 7.0, 12.0), 8.0, route.back().distance / 2, 120.0);
+
+    TrackAlignment alignment = TrackAligner().align(reference, other);
+    ASSERT_EQ(alignment.points.size(), reference.size());
+    for (size_t i = 10; i + 10 < reference.size(); i += 50) {
+        const AlignedPoint& point = alignment.points[i];
+        const double d = point.distance;
+        double expected = d / 8.0 - d / 10.0;
+        if (d > route.back().distance / 2 + 10.0) {
+            expected += 120.0;
+        }
+        EXPECT_LT(point.offset, 8.0);  // Within one sample spacing
+        EXPECT_NEAR(point.timeGap, expected, 2.0) << "at " << d << " m";
+        EXPECT_NEAR(point.elevationDelta, 12.0, 1.0) << "at " << d << " m";
+    }
+}
+
+TEST(TrackAlignerTest, WideBandMatchesFullDtw) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(400, 9);
+    std::vector<TrackPoint> reference = makeEffort(route, 10.0);
+    std::vector<TrackPoint> other = makeEffort(resampleRoute(route, 13.0, 0.0), 9.0);
+
+    AlignmentParams params;
+    params.bandRadius = 1000;
+    TrackAlignment alignment = TrackAligner(params).align(reference, other);
+    const double full = fullDtwCost(reference, other);
+    EXPECT_NEAR(alignment.cost, full, 1e-6 * full);
+    EXPECT_EQ(alignment.cellCount, reference.size() * other.size());
+
+    // A narrow band finds the same optimum on efforts of the same road, with far fewer cells
+    params.bandRadius = 40;
+    TrackAlignment banded = TrackAligner(params).align(reference, other);
+    EXPECT_NEAR(banded.cost, full, 1e-6 * full);
+    EXPECT_LT(banded.cellCount, alignment.cellCount / 3);
+}
+
+TEST(TrackAlignerTest, VectorizedAndScalarLoopsAgree) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(5000, 11);
+    std::vector<TrackPoint> reference = makeEffort(route, 10.0);
+    std::vector<TrackPoint> other = makeEffort(resampleRoute(route, 9.0, 3.0), 7.0);
+
+    AlignmentParams params;
+    params.useSimd = false;
+    TrackAlignment scalar = TrackAligner(params).align(reference, other);
+    params.useSimd = true;
+    TrackAlignment vectorized = TrackAligner(params).align(reference, other);
+
+    EXPECT_EQ(scalar.path, vectorized.path);
+    EXPECT_DOUBLE_EQ(scalar.cost, vectorized.cost);
+}
+
+TEST(TrackAlignerTest, UntimedAndDegenerateInput) {
+    std::vector<TrackPoint> route = makeSyntheticTrack(500, 13);
+    TrackAlignment alignment = TrackAligner().align(route, makeEffort(route, 5.0));
+    ASSERT_FALSE(alignment.isEmpty());
+    EXPECT_TRUE(std::isnan(alignment.points[100].timeGap));
+
+    EXPECT_TRUE(TrackAligner().align(route, std::vector<TrackPoint>(route.begin(), route.begin() + 1)).isEmpty());
+    EXPECT_TRUE(TrackAligner().align(std::vector<TrackPoint>(), route).isEmpty());
+}
@@ -0,0 +1,86 @@
+#include "TrackAnalyzer.h"
+#include "BestEfforts.h"
+#include "TrackRangeStats.h"
+#include "synthetic_track.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Times the segmentation stages on a large synthetic track.
+// Usage: trackanalyzer_benchmark [points] [repetitions]
+namespace {
+
+template <typename Func>
+double bestOfMs(int repetitions, Func func) {
+    double best = -1.0;
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (best < 0.0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t pointCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    
+    std::vector<TrackPoint> points = makeSyntheticTrack(pointCount, 42);
+    TrackAnalyzer analyzer;
+    TrackAnalyzer sequential;
+    sequential.setChunkSize(0);
+    
+    std::vector<double> smoothed;
+    std::vector<size_t> boundaries;
+    std::vector<TrackSegment> rawSegments;
+    
+    double smoothMs = bestOfMs(repetitions, [&]() { smoothed = analyzer.calculateSmoothedGradients(points); });
+    double boundaryMs = bestOfMs(repetitions, [&]() { boundaries = analyzer.identifySegmentBoundaries(points, smoothed); });
+    double rawMs = bestOfMs(repetitions, [&]() { rawSegments = analyzer.createRawSegments(points, smoothed, boundaries); });
+    double optimizeMs = bestOfMs(repetitions, [&]() { analyzer.optimizeSegments(rawSegments, points); });
+    std::vector<Climb> climbs;
+    double climbMs = bestOfMs(repetitions, [&]() { climbs = ClimbDetector().detect(points); });
+    
+    // Best efforts need timestamps; one point per second
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i].timestamp = QDateTime::fromMSecsSinceEpoch(1700000000000LL + static_cast<qint64>(i) * 1000);
+    }
+    TrackColumns columns = TrackColumns::fromPoints(points);
+    std::vector<BestEffort> efforts;
+    double effortsMs = bestOfMs(repetitions, [&]() { efforts = BestEffortFinder().find(columns); });
+    
+    // Splits reuse the range tables, built once per track
+    TrackRangeStats rangeStats(points);
+    std::vector<RangeStats> splits;
+    double splitsMs = bestOfMs(repetitions, [&]() { splits = rangeStats.splitsByDistance(100.0); });
+    
+    double parallelMs = bestOfMs(repetitions, [&]() { analyzer.analyze(points); });
+    double sequentialMs = bestOfMs(repetitions, [&]() { sequential.analyze(points); });
+
+    // Re-segmenting after a threshold change reuses the prepared profile
+    GradientProfile profile = analyzer.prepare(points);
+    SegmentationParams tuned;
+    tuned.minBoundaryDistance = 500.0;
+    TrackAnalyzer retuned;
+    retuned.setParams(tuned);
+    TrackAnalysisResult resegmented;
+    double resegmentMs = bestOfMs(repetitions, [&]() { resegmented = retuned.segment(points, profile); });
+    
+    std::printf("points:             %zu\n", points.size());
+    std::printf("smoothed gradients: %8.2f ms\n", smoothMs);
+    std::printf("segment boundaries: %8.2f ms (%zu boundaries)\n", boundaryMs, boundaries.size());
+    std::printf("raw segments:       %8.2f ms (%zu segments)\n", rawMs, rawSegments.size());
+    std::printf("optimize segments:  %8.2f ms\n", optimizeMs);
+    std::printf("climb detection:    %8.2f ms (%zu climbs)\n", climbMs, climbs.size());
+    std::printf("best efforts:       %8.2f ms (%zu windows)\n", effortsMs, efforts.size());
+    std::printf("100 m splits:       %8.2f ms (%zu splits)\n", splitsMs, splits.size());
+    std::printf("full analysis:      %8.2f ms (sequential %.2f ms, chunk size %zu)\n",
+                parallelMs, sequentialMs, analyzer.chunkSize());
+    std::printf("re-segmentation:    %8.2f ms (%zu segments)\n", resegmentMs, resegmented.segments().size());
+    return 0;
+}
@@ -0,0 +1,340 @@
+#include "gtest/gtest.h"
+#include "TrackAnalyzer.h"
+#include "synthetic_track.h"
+#include <deque>
+#include <map>
+#include <thread>
+
+namespace {
+
+// Original map/deque based boundary detector, kept as the reference the linear one must match
+std::vector<size_t> referenceBoundaries(
+    const std::vector<TrackPoint>& points, 
+    const std::vector<double>& smoothGradients)
+{
+    const double GRADIENT_THRESHOLD_FLAT = 1.5; // Slightly increased for better sensitivity
+    const double SEGMENT_CHANGE_THRESHOLD = 2.5; // Slightly decreased for more sensitive detection
+    const double MIN_SEGMENT_DISTANCE = 300.0; // Shorter minimum segment length for better detail
+    
+    std::vector<size_t> boundaries;
+    boundaries.push_back(0);
+    
+    enum class GradientType { FLAT, CLIMB, DESCENT };
+    
+    // Determine initial segment type
+    GradientType currentType = GradientType::FLAT;
+    if (points.size() > 1) {
+        if (smoothGradients[1] > GRADIENT_THRESHOLD_FLAT) {
+            currentType = GradientType::CLIMB;
+        } else if (smoothGradients[1] < -GRADIENT_THRESHOLD_FLAT) {
+            currentType = GradientType::DESCENT;
+        }
+    }
+    
+    // Use a more sophisticated approach for detecting changes
+    const int STABILITY_WINDOW = 7; // Smaller window for quicker response
+    std::deque<GradientType> recentTypes(STABILITY_WINDOW, currentType);
+    
+    for (size_t i = 1; i < points.size(); i++) {
+        // Determine point type from smoothed gradient
+        GradientType pointType;
+        if (smoothGradients[i] > GRADIENT_THRESHOLD_FLAT) {
+            pointType = GradientType::CLIMB;
+        } else if (smoothGradients[i] < -GRADIENT_THRESHOLD_FLAT) {
+            pointType = GradientType::DESCENT;
+        } else {
+            pointType = GradientType::FLAT;
+        }
+        
+        // Update recent types
+        recentTypes.pop_front();
+        recentTypes.push_back(pointType);
+        
+        // Check if there's a stable type change
+        std::map<GradientType, int> typeCounts;
+        for (const auto& type : recentTypes) {
+            typeCounts[type]++;
+        }
+        
+        // Find the dominant type in the window
+        GradientType dominantType = currentType;
+        int maxCount = 0;
+        
+        // Use a different approach instead of C++17 structured bindings
+        for (auto typeCountPair : typeCounts) {
+            GradientType type = typeCountPair.first;
+            int count = typeCountPair.second;
+            if (count > maxCount) {
+                maxCount = count;
+                dominantType = type;
+            }
+        }
+        
+        // If the dominant type is different and stable (above threshold), register a change
+        if (dominantType != currentType && 
+            typeCounts[dominantType] >= (STABILITY_WINDOW * 2 / 3) && 
+            (i > 0) && 
+            (points[i].distance - points[boundaries.back()].distance >= MIN_SEGMENT_DISTANCE)) {
+            
+            // Calculate average gradients for current and new segment
+            double avgCurrentGradient = 0.0;
+            double avgNewGradient = 0.0;
+            
+            // Sample current segment
+            for (size_t j = boundaries.back(); j < i; j++) {
+                avgCurrentGradient += smoothGradients[j];
+            }
+            avgCurrentGradient /= (i - boundaries.back());
+            
+            // Sample potential new segment
+            size_t sampleEnd = std::min(i + STABILITY_WINDOW, points.size());
+            for (size_t j = i; j < sampleEnd; j++) {
+                avgNewGradient += smoothGradients[j];
+            }
+            avgNewGradient /= (sampleEnd - i);
+            
+            // Only create a new segment if the gradient change is significant
+            if (std::abs(avgNewGradient - avgCurrentGradient) >= SEGMENT_CHANGE_THRESHOLD) {
+                boundaries.push_back(i);
+                currentType = dominantType;
+            }
+        }
+    }
+    
+    // Always include the last point
+    if (boundaries.back() != points.size() - 1) {
+        boundaries.push_back(points.size() - 1);
+    }
+    
+    return boundaries;
+}
+
+} // namespace
+
+// Test fixture for TrackAnalyzer tests
+class TrackAnalyzerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // 3 km flat, 3 km climbing at 6%, 3 km descending at 6%, one point every 20 m
+        double elevation = 100.0;
+        for (int i = 0; i <= 450; ++i) {
+            double distance = i * 20.0;
+            double gradient = 0.0;
+            if (distance > 3000.0 && distance <= 6000.0) {
+                gradient = 6.0;
+            } else if (distance > 6000.0) {
+                gradient = -6.0;
+            }
+            if (i > 0) {
+                elevation += 20.0 * gradient / 100.0;
+            }
+            TrackPoint point(QGeoCoordinate(45.0 + distance / 111320.0, 10.0), elevation, distance);
+            point.gradient = gradient;
+            points.push_back(point);
+        }
+    }
+
+    std::vector<TrackPoint> points;
+    TrackAnalyzer analyzer;
+};
+
+// Test case for too short tracks
+TEST_F(TrackAnalyzerTest, TooFewPoints) {
+    TrackAnalysisResult result = analyzer.analyze(std::vector<TrackPoint>(points.begin(), points.begin() + 1));
+    EXPECT_TRUE(result.isEmpty());
+    EXPECT_EQ(result.pointCount(), 1);
+    EXPECT_DOUBLE_EQ(result.uphillPercent(), 0.0);
+}
+
+// Test case for detecting the flat, climb and descent parts
+TEST_F(TrackAnalyzerTest, ClimbAndDescent) {
+    TrackAnalysisResult result = analyzer.analyze(points);
+    const std::vector<TrackSegment>& segments = result.segments();
+    ASSERT_EQ(segments.size(), 3);
+    
+    EXPECT_EQ(segments[0].type, TrackSegment::FLAT);
+    EXPECT_EQ(segments[1].type, TrackSegment::CLIMB);
+    EXPECT_EQ(segments[2].type, TrackSegment::DESCENT);
+    EXPECT_NEAR(segments[1].avgGradient, 6.0, 1.0);
+    EXPECT_NEAR(segments[2].avgGradient, -6.0, 1.0);
+    EXPECT_EQ(segments.back().endIndex, points.size() - 1);
+    
+    EXPECT_NEAR(result.uphillPercent() + result.downhillPercent() + result.flatPercent(), 100.0, 1e-9);
+    EXPECT_NEAR(result.steepestUphill(), 6.0, 0.5);
+    EXPECT_NEAR(result.steepestDownhill(), -6.0, 0.5);
+}
+
+// Test case for running the analyzer from several threads at once
+TEST_F(TrackAnalyzerTest, Concurrent) {
+    TrackAnalysisResult expected = analyzer.analyze(points);
+    
+    std::vector<TrackAnalysisResult> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([this, &results, i]() { results[i] = analyzer.analyze(points); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    for (const auto& result : results) {
+        ASSERT_EQ(result.segments().size(), expected.segments().size());
+        for (size_t i = 0; i < result.segments().size(); ++i) {
+            EXPECT_EQ(result.segments()[i].startIndex, expected.segments()[i].startIndex);
+            EXPECT_EQ(result.segments()[i].endIndex, expected.segments()[i].endIndex);
+            EXPECT_EQ(result.segments()[i].type, expected.segments()[i].type);
+        }
+    }
+}
+
+// Test case for the linear-time boundary detector matching the original algorithm
+TEST_F(TrackAnalyzerTest, BoundariesMatchReference) {
+    for (unsigned seed = 1; seed <= 5; ++seed) {
+        std::vector<TrackPoint> track = makeSyntheticTrack(50000, seed);
+        std::vector<double> smoothed = analyzer.calculateSmoothedGradients(track);
+        std::vector<size_t> expected = referenceBoundaries(track, smoothed);
+        ASSERT_GT(expected.size(), 10);
+        EXPECT_EQ(analyzer.identifySegmentBoundaries(track, smoothed), expected) << "seed " << seed;
+    }
+    
+    std::vector<double> smoothed = analyzer.calculateSmoothedGradients(points);
+    EXPECT_EQ(analyzer.identifySegmentBoundaries(points, smoothed), referenceBoundaries(points, smoothed));
+}
+
+// Test case for chunked parallel analysis giving exactly the sequential result
+TEST_F(TrackAnalyzerTest, ParallelMatchesSequential) {
+    TrackAnalyzer sequential;
+    sequential.setChunkSize(0);
+    
+    for (unsigned seed = 1; seed <= 3; ++seed) {
+        std::vector<TrackPoint> track = makeSyntheticTrack(60000, seed);
+        std::vector<double> smoothed = sequential.calculateSmoothedGradients(track);
+        std::vector<size_t> boundaries = sequential.identifySegmentBoundaries(track, smoothed);
+        TrackAnalysisResult expected = sequential.analyze(track);
+        
+        for (size_t chunkSize : {257u, 1000u, 4096u, 20000u}) {
+            TrackAnalyzer parallel;
+            parallel.setChunkSize(chunkSize);
+            EXPECT_EQ(parallel.calculateSmoothedGradients(track), smoothed);
+            EXPECT_EQ(parallel.identifySegmentBoundaries(track, smoothed), boundaries)
+                << "seed " << seed << " chunk " << chunkSize;
+            
+            TrackAnalysisResult result = parallel.analyze(track);
+            ASSERT_EQ(result.segments().size(), expected.segments().size());
+            for (size_t i = 0; i < result.segments().size(); ++i) {
+                EXPECT_EQ(result.segments()[i].startIndex, expected.segments()[i].startIndex);
+                EXPECT_EQ(result.segments()[i].endIndex, expected.segments()[i].endIndex);
+                EXPECT_EQ(result.segments()[i].avgGradient, expected.segments()[i].avgGradient);
+            }
+        }
+    }
+}
+
+// Test case for raw segment averages: summed in order over the segment, so the
+// flat/climb/descent threshold decision matches the original analyzer bit for bit
+TEST_F(TrackAnalyzerTest, RawSegmentAveragesAreDirectSums) {
+    std::vector<TrackPoint> track = makeSyntheticTrack(50000, 11);
+    std::vector<double> smoothed = analyzer.calculateSmoothedGradients(track);
+    std::vector<size_t> boundaries = analyzer.identifySegmentBoundaries(track, smoothed);
+    std::vector<TrackSegment> raw = analyzer.createRawSegments(track, smoothed, boundaries);
+    ASSERT_GT(raw.size(), 10u);
+    for (const TrackSegment& segment : raw) {
+        double sum = 0.0;
+        for (size_t j = segment.startIndex; j <= segment.endIndex; ++j) {
+            sum += smoothed[j];
+        }
+        EXPECT_EQ(segment.avgGradient, sum / (segment.endIndex - segment.startIndex + 1));
+    }
+}
+
+// Test case for the segment hierarchy: coarser levels nest whole runs of finer segments
+TEST_F(TrackAnalyzerTest, SegmentHierarchy) {
+    std::vector<TrackPoint> track = makeSyntheticTrack(100000, 7);
+    TrackAnalysisResult result = analyzer.analyze(track);
+    ASSERT_GT(result.levelCount(), 1);
+    EXPECT_LE(result.levelCount(), TrackAnalyzer::MAX_LEVELS);
+    EXPECT_EQ(result.segmentsAtLevel(0).size(), result.segments().size());
+    EXPECT_TRUE(result.segmentsAtLevel(result.levelCount()).empty());
+    
+    for (int level = 1; level < result.levelCount(); ++level) {
+        const std::vector<TrackSegment>& fine = result.segmentsAtLevel(level - 1);
+        const std::vector<TrackSegment>& coarse = result.segmentsAtLevel(level);
+        EXPECT_LT(coarse.size(), fine.size());
+        EXPECT_GT(result.levelResolution(level), result.levelResolution(level - 1));
+        
+        size_t next = 0;
+        for (const auto& segment : coarse) {
+            ASSERT_LT(next, fine.size());
+            EXPECT_EQ(segment.startIndex, fine[next].startIndex);
+            while (next < fine.size() && fine[next].endIndex < segment.endIndex) {
+                ++next;
+            }
+            ASSERT_LT(next, fine.size());
+            EXPECT_EQ(segment.endIndex, fine[next].endIndex);
+            ++next;
+        }
+        EXPECT_EQ(next, fine.size());
+    }
+    
+    EXPECT_EQ(result.levelForResolution(0.0), 0);
+    EXPECT_EQ(result.levelForResolution(result.levelResolution(1)), 1);
+    EXPECT_EQ(result.levelForResolution(1e9), result.levelCount() - 1);
+}
+
+// Test case for typing merged segments independently of the boundary flat threshold
+TEST_F(TrackAnalyzerTest, MergedTypesIgnoreBoundaryFlatThreshold) {
+    std::vector<TrackPoint> track = makeSyntheticTrack(50000, 11);
+    for (double flatThreshold : {0.5, 1.5, 3.0}) {
+        SegmentationParams params;
+        params.flatThreshold = flatThreshold;
+        TrackAnalyzer tuned;
+        tuned.setParams(params);
+        TrackAnalysisResult result = tuned.analyze(track);
+        for (int level = 0; level < result.levelCount(); ++level) {
+            for (const auto& segment : result.segmentsAtLevel(level)) {
+                TrackSegment::Type expected = TrackSegment::FLAT;
+                if (segment.avgGradient > params.mergedFlatThreshold) {
+                    expected = TrackSegment::CLIMB;
+                } else if (segment.avgGradient < -params.mergedFlatThreshold) {
+                    expected = TrackSegment::DESCENT;
+                }
+                EXPECT_EQ(segment.type, expected) << "flat " << flatThreshold << " level " << level;
+            }
+        }
+    }
+}
+
+// Test case for re-segmenting from a prepared profile when only the thresholds change
+TEST_F(TrackAnalyzerTest, SegmentFromPreparedProfile) {
+    std::vector<TrackPoint> track = makeSyntheticTrack(50000, 9);
+    GradientProfile profile = analyzer.prepare(track);
+    ASSERT_EQ(profile.smoothGradients.size(), track.size());
+    
+    TrackAnalysisResult expected = analyzer.analyze(track);
+    TrackAnalysisResult incremental = analyzer.segment(track, profile);
+    ASSERT_EQ(incremental.segments().size(), expected.segments().size());
+    EXPECT_EQ(incremental.climbs().size(), expected.climbs().size());
+    
+    // Every threshold change must match a full run with the same parameters
+    std::vector<SegmentationParams> variants(4);
+    variants[0].flatThreshold = 0.8;
+    variants[1].changeThreshold = 5.0;
+    variants[2].minBoundaryDistance = 1000.0;
+    variants[3].similarGradientThreshold = 6.0;
+    for (size_t v = 0; v < variants.size(); ++v) {
+        TrackAnalyzer tuned;
+        tuned.setParams(variants[v]);
+        TrackAnalysisResult full = tuned.analyze(track);
+        TrackAnalysisResult fast = tuned.segment(track, profile);
+        EXPECT_NE(fast.segments().size(), expected.segments().size()) << "variant " << v;
+        ASSERT_EQ(fast.segments().size(), full.segments().size()) << "variant " << v;
+        for (size_t i = 0; i < full.segments().size(); ++i) {
+            EXPECT_EQ(fast.segments()[i].startIndex, full.segments()[i].startIndex);
+            EXPECT_EQ(fast.segments()[i].endIndex, full.segments()[i].endIndex);
+            EXPECT_EQ(fast.segments()[i].type, full.segments()[i].type);
+        }
+    }
+    
+    // A profile of another track is rejected instead of read out of bounds
+    EXPECT_TRUE(analyzer.segment(makeSyntheticTrack(100, 1), profile).isEmpty());
+}
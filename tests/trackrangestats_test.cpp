@@ -0,0 +1,176 @@
+#include "gtest/gtest.h"
+#include "TrackRangeStats.h"
+#include "synthetic_track.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Direct O(n) computation of the same figures
+RangeStats bruteForce(const std::vector<TrackPoint>& points, size_t first, size_t last) {
+    RangeStats stats;
+    stats.startIndex = first;
+    stats.endIndex = last;
+    stats.distance = points[last].distance - points[first].distance;
+    stats.minElevation = stats.maxElevation = points[first].elevation;
+    stats.minGradient = stats.maxGradient = points[first].gradient;
+    for (size_t i = first; i <= last; ++i) {
+        if (i > first) {
+            double diff = points[i].elevation - points[i - 1].elevation;
+            if (diff > 0.6) stats.elevationGain += diff;
+            if (diff < -0.6) stats.elevationLoss -= diff;
+        }
+        stats.minElevation = std::min(stats.minElevation, points[i].elevation);
+        stats.maxElevation = std::max(stats.maxElevation, points[i].elevation);
+        stats.minGradient = std::min(stats.minGradient, points[i].gradient);
+        stats.maxGradient = std::max(stats.maxGradient, points[i].gradient);
+    }
+    return stats;
+}
+
+std::vector<TrackPoint> makeTimedTrack(size_t count) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(count, 3);
+    QDateTime start = QDateTime::fromSecsSinceEpoch(1700000000);
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i].timestamp = start.addSecs(static_cast<qint64>(i) * 2);
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(TrackRangeStatsTest, MatchesBruteForce) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 11);
+    TrackRangeStats rangeStats(points);
+    ASSERT_EQ(rangeStats.size(), points.size());
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<size_t> index(0, points.size() - 1);
+    for (int trial = 0; trial < 500; ++trial) {
+        size_t first = index(rng);
+        size_t last = index(rng);
+        if (first > last) {
+            std::swap(first, last);
+        }
+        RangeStats expected = bruteForce(points, first, last);
+        RangeStats actual = rangeStats.stats(first, last);
+        EXPECT_NEAR(actual.distance, expected.distance, 1e-6);
+        EXPECT_NEAR(actual.elevationGain, expected.elevationGain, 1e-6);
+        EXPECT_NEAR(actual.elevationLoss, expected.elevationLoss, 1e-6);
+        EXPECT_DOUBLE_EQ(actual.minElevation, expected.minElevation);
+        EXPECT_DOUBLE_EQ(actual.maxElevation, expected.maxElevation);
+        EXPECT_DOUBLE_EQ(actual.minGradient, expected.minGradient);
+        EXPECT_DOUBLE_EQ(actual.maxGradient, expected.maxGradient);
+    }
+}
+
+TEST(TrackRangeStatsTest, ReversedRangeAndClamping) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(100, 2);
+    TrackRangeStats rangeStats(points);
+
+    RangeStats forward = rangeStats.stats(10, 40);
+    RangeStats backward = rangeStats.stats(40, 10);
+    EXPECT_EQ(backward.startIndex, 10u);
+    EXPECT_EQ(backward.endIndex, 40u);
+    EXPECT_DOUBLE_EQ(backward.elevationGain, forward.elevationGain);
+
+    RangeStats clamped = rangeStats.stats(90, 1000);
+    EXPECT_EQ(clamped.endIndex, 99u);
+}
+
+TEST(TrackRangeStatsTest, DistanceQueries) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(1000, 4);
+    TrackRangeStats rangeStats(points);
+
+    EXPECT_EQ(rangeStats.indexAtDistance(-5.0), 0u);
+    EXPECT_EQ(rangeStats.indexAtDistance(1e9), points.size() - 1);
+    EXPECT_EQ(rangeStats.indexAtDistance(points[500].distance + 0.1), 500u);
+
+    RangeStats stats = rangeStats.statsForDistance(points[100].distance, points[800].distance);
+    EXPECT_EQ(stats.startIndex, 100u);
+    EXPECT_EQ(stats.endIndex, 800u);
+    double netChange = points[800].elevation - points[100].elevation;
+    EXPECT_NEAR(stats.avgGradient, netChange / stats.distance * 100.0, 1e-9);
+}
+
+TEST(TrackRangeStatsTest, TimeAndSpeed) {
+    std::vector<TrackPoint> timed = makeTimedTrack(200);
+    RangeStats stats = TrackRangeStats(timed).stats(50, 150);
+    EXPECT_DOUBLE_EQ(stats.duration, 200.0);
+    EXPECT_NEAR(stats.avgSpeed, stats.distance / 200.0, 1e-9);
+
+    // Only the ends of a range need timestamps, not the start of the track
+    timed[0].timestamp = QDateTime();
+    timed[1].timestamp = QDateTime();
+    RangeStats lateStart = TrackRangeStats(timed).stats(50, 150);
+    EXPECT_DOUBLE_EQ(lateStart.duration, 200.0);
+    EXPECT_NEAR(lateStart.avgSpeed, lateStart.distance / 200.0, 1e-9);
+    EXPECT_TRUE(std::isnan(TrackRangeStats(timed).stats(0, 150).duration));
+
+    RangeStats untimed = TrackRangeStats(makeSyntheticTrack(200, 3)).stats(50, 150);
+    EXPECT_TRUE(std::isnan(untimed.duration));
+    EXPECT_TRUE(std::isnan(untimed.avgSpeed));
+}
+
+TEST(TrackRangeStatsTest, EmptyTrack) {
+    TrackRangeStats rangeStats{std::vector<TrackPoint>()};
+    EXPECT_TRUE(rangeStats.empty());
+    EXPECT_DOUBLE_EQ(rangeStats.stats(0, 10).distance, 0.0);
+}
+
+TEST(TrackRangeStatsTest, DistanceSplits) {
+    std::vector<TrackPoint> points = makeSyntheticTrack(5000, 8);
+    TrackRangeStats rangeStats(points);
+    std::vector<RangeStats> splits = rangeStats.splitsByDistance(1000.0);
+
+    const double total = points.back().distance;
+    ASSERT_EQ(splits.size(), static_cast<size_t>(std::ceil(total / 1000.0)));
+    EXPECT_EQ(splits.front().startIndex, 0u);
+    EXPECT_EQ(splits.back().endIndex, points.size() - 1);
+
+    double gain = 0.0;
+    for (size_t i = 0; i < splits.size(); ++i) {
+        if (i > 0) {
+            EXPECT_EQ(splits[i].startIndex, splits[i - 1].endIndex);
+        }
+        // Boundaries snap to the point nearest each whole kilometer (points are at most 15 m apart)
+        if (i + 1 < splits.size()) {
+            EXPECT_NEAR(points[splits[i].endIndex].distance, (i + 1) * 1000.0, 7.5);
+        }
+        gain += splits[i].elevationGain;
+    }
+    EXPECT_NEAR(gain, rangeStats.stats(0, points.size() - 1).elevationGain, 1e-6);
+}
+
+TEST(TrackRangeStatsTest, SparsePointsSkipEmptySplits) {
+    // Points every 2.5 km, split every km
+    std::vector<TrackPoint> points;
+    for (int i = 0; i < 5; ++i) {
+        points.emplace_back(QGeoCoordinate(45.0 + i * 2500.0 / 111320.0, 10.0), 100.0, i * 2500.0);
+    }
+    std::vector<RangeStats> splits = TrackRangeStats(points).splitsByDistance(1000.0);
+
+    ASSERT_EQ(splits.size(), 4u);
+    for (size_t i = 0; i < splits.size(); ++i) {
+        EXPECT_EQ(splits[i].startIndex, i);
+        EXPECT_EQ(splits[i].endIndex, i + 1);
+    }
+    EXPECT_TRUE(TrackRangeStats(points).splitsByDistance(0.0).empty());
+}
+
+TEST(TrackRangeStatsTest, TimeSplits) {
+    // One point every 2 s, so five minute splits hold 150 intervals each
+    std::vector<TrackPoint> timed = makeTimedTrack(1000);
+    timed[400].timestamp = QDateTime();
+    std::vector<RangeStats> splits = TrackRangeStats(timed).splitsByTime(300.0);
+
+    ASSERT_EQ(splits.size(), 7u);
+    for (size_t i = 0; i + 1 < splits.size(); ++i) {
+        EXPECT_EQ(splits[i].endIndex, (i + 1) * 150) << i;
+        EXPECT_DOUBLE_EQ(splits[i].duration, 300.0) << i;
+    }
+    EXPECT_EQ(splits.back().endIndex, 999u);
+
+    EXPECT_TRUE(TrackRangeStats(makeSyntheticTrack(100, 1)).splitsByTime(60.0).empty());
+}
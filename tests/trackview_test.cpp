@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "TrackView.h"
+#include <cmath>
+
+// Test fixture for TrackView tests
+class TrackViewTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Ten points heading north, 100 m of climb-then-descent elevation
+        std::vector<TrackPoint> points;
+        double distance = 0.0;
+        for (int i = 0; i < 10; ++i) {
+            QGeoCoordinate coord(45.0 + i * 0.001, 10.0);
+            if (i > 0) {
+                distance += points.back().coord.distanceTo(coord);
+            }
+            TrackPoint point(coord, i < 5 ? 100.0 + i * 10.0 : 140.0 - (i - 5) * 10.0, distance);
+            point.gradient = i < 5 ? 9.0 : -9.0;
+            points.push_back(point);
+        }
+        store = std::make_shared<const std::vector<TrackPoint>>(points);
+        track = TrackView(store);
+    }
+
+    std::shared_ptr<const std::vector<TrackPoint>> store;
+    TrackView track;
+};
+
+// Test case for a view over the whole store
+TEST_F(TrackViewTest, WholeStore) {
+    ASSERT_EQ(track.size(), 10);
+    EXPECT_DOUBLE_EQ(track.totalDistance(), store->back().distance);
+    EXPECT_DOUBLE_EQ(track.maxElevation(), 140.0);
+    EXPECT_DOUBLE_EQ(track.minElevation(), 100.0);
+    EXPECT_NEAR(track.totalElevationGain(), 40.0, 1e-9);
+    EXPECT_EQ(&track.sourcePoint(3), &(*store)[3]);
+}
+
+// Test case for trimming: distances restart at zero and no points are copied
+TEST_F(TrackViewTest, Trim) {
+    TrackView trimmed = track.trimmed(2, 6);
+    ASSERT_EQ(trimmed.size(), 5);
+    EXPECT_EQ(&trimmed.sourcePoint(0), &(*store)[2]);
+    EXPECT_DOUBLE_EQ(trimmed.distanceAt(0), 0.0);
+    EXPECT_DOUBLE_EQ(trimmed.totalDistance(), (*store)[6].distance - (*store)[2].distance);
+    EXPECT_TRUE(track.trimmed(5, 2).empty());
+}
+
+// Test case for reversing: order flips, gradients change sign
+TEST_F(TrackViewTest, Reverse) {
+    TrackView reversed = track.reversed();
+    ASSERT_EQ(reversed.size(), 10);
+    EXPECT_EQ(&reversed.sourcePoint(0), &(*store)[9]);
+    EXPECT_DOUBLE_EQ(reversed.distanceAt(0), 0.0);
+    EXPECT_NEAR(reversed.totalDistance(), track.totalDistance(), 1e-9);
+    EXPECT_DOUBLE_EQ(reversed.gradientAt(0), 9.0);
+    EXPECT_DOUBLE_EQ(reversed.gradientAt(9), -9.0);
+    EXPECT_TRUE(reversed.reversed() == track);
+}
+
+// Test case for splitting and re-joining a track
+TEST_F(TrackViewTest, SplitAndConcatenate) {
+    auto halves = track.splitAt(4);
+    EXPECT_EQ(halves.first.size(), 4);
+    EXPECT_EQ(halves.second.size(), 6);
+    EXPECT_DOUBLE_EQ(halves.second.distanceAt(0), 0.0);
+
+    TrackView joined = halves.first.concatenated(halves.second);
+    EXPECT_TRUE(joined == track);
+    for (size_t i = 0; i < track.size(); ++i) {
+        EXPECT_NEAR(joined.distanceAt(i), track.distanceAt(i), 1e-6);
+    }
+}
+
+// Test case for reversed gradients: each one matches the step into the point on a reversed copy
+TEST_F(TrackViewTest, ReversedGradientsMatchReversedCopy) {
+    // Backward-difference gradients like GPXParser's, on uneven steps
+    std::vector<TrackPoint> points;
+    const double elevations[] = {100.0, 104.0, 103.0, 111.0, 111.0, 106.0, 118.0, 115.0};
+    for (int i = 0; i < 8; ++i) {
+        points.push_back(TrackPoint(QGeoCoordinate(45.0, 10.0), elevations[i], i * 100.0 + (i % 3) * 20.0));
+    }
+    auto withGradients = [](std::vector<TrackPoint> track) {
+        for (size_t i = 1; i < track.size(); ++i) {
+            track[i].gradient = (track[i].elevation - track[i - 1].elevation)
+                              / (track[i].distance - track[i - 1].distance) * 100.0;
+        }
+        return track;
+    };
+    points = withGradients(points);
+
+    std::vector<TrackPoint> copy(points.rbegin(), points.rend());
+    const double length = copy.front().distance;
+    for (auto& point : copy) {
+        point.distance = length - point.distance;
+    }
+    copy = withGradients(copy);
+
+    TrackView reversed = TrackView::fromPoints(points).reversed();
+    std::vector<TrackPoint> viewPoints = reversed.toPoints();
+    ASSERT_EQ(viewPoints.size(), copy.size());
+    // The first point has no step into it on either side
+    for (size_t i = 1; i < copy.size(); ++i) {
+        EXPECT_NEAR(reversed.gradientAt(i), copy[i].gradient, 1e-9) << i;
+        EXPECT_NEAR(viewPoints[i].gradient, copy[i].gradient, 1e-9) << i;
+    }
+
+    // A trimmed range still reads the neighbour just outside it
+    TrackView middle = TrackView::fromPoints(points).trimmed(2, 5).reversed();
+    EXPECT_NEAR(middle.gradientAt(0), copy[2].gradient, 1e-9);
+    EXPECT_NEAR(middle.gradientAt(3), copy[5].gradient, 1e-9);
+}
+
+// Test case for concatenating views over different stores
+TEST_F(TrackViewTest, ConcatenateStores) {
+    TrackView other = TrackView::fromPoints(*store);
+    TrackView joined = track.concatenated(other.reversed());
+    ASSERT_EQ(joined.size(), 20);
+    // Last point of the first track and first point of the reversed copy coincide
+    EXPECT_NEAR(joined.distanceAt(10), track.totalDistance(), 1e-6);
+    EXPECT_NEAR(joined.totalDistance(), 2.0 * track.totalDistance(), 1e-6);
+
+    std::vector<TrackPoint> points = joined.toPoints();
+    ASSERT_EQ(points.size(), 20);
+    for (size_t i = 1; i < points.size(); ++i) {
+        EXPECT_GE(points[i].distance, points[i - 1].distance);
+    }
+    EXPECT_DOUBLE_EQ(points[10].gradient, 9.0);
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "ZoneHistogram.h"
+#include <cmath>
+
+namespace {
+
+// Points every second and every 5 m, with heart rate cycling through the given values
+std::vector<TrackPoint> makeTrack(const std::vector<double>& heartRates, size_t count) {
+    std::vector<TrackPoint> points;
+    for (size_t i = 0; i < count; ++i) {
+        TrackPoint point(QGeoCoordinate(45.0 + i * 5.0 / 111320.0, 10.0), 100.0, i * 5.0,
+                         QDateTime::fromMSecsSinceEpoch(1700000000000LL + static_cast<qint64>(i) * 1000));
+        point.heartRate = heartRates[i % heartRates.size()];
+        point.gradient = (i < count / 2) ? 2.0 : -5.0;
+        points.push_back(point);
+    }
+    return points;
+}
+
+} // namespace
+
+TEST(ZoneHistogramTest, DefaultBounds) {
+    ZoneSettings settings(200.0, 300.0);
+    ASSERT_EQ(settings.heartRateBounds.size(), 4u);
+    EXPECT_DOUBLE_EQ(settings.heartRateBounds[0], 120.0);
+    ASSERT_EQ(settings.powerBounds.size(), 6u);
+    EXPECT_DOUBLE_EQ(settings.powerBounds[3], 315.0);
+    EXPECT_EQ(ZoneSettings::parseBounds(" 4, -1,x,1 ,4"), (std::vector<double>{-1.0, 1.0, 4.0}));
+}
+
+TEST(ZoneHistogramTest, TimeAndDistanceInZone) {
+    // 100, 130, 150, 170, 185 bpm fall in zones 0..4 of a 190 bpm max
+    std::vector<TrackPoint> points = makeTrack({100.0, 130.0, 150.0, 170.0, 185.0}, 1001);
+    ZoneReport report = ZoneAnalyzer().analyze(TrackColumns::fromPoints(points));
+
+    ASSERT_EQ(report.heartRate.zoneCount(), 5u);
+    for (size_t zone = 0; zone < 5; ++zone) {
+        EXPECT_DOUBLE_EQ(report.heartRate.time[zone], 200.0) << zone;
+        EXPECT_DOUBLE_EQ(report.heartRate.distance[zone], 1000.0) << zone;
+    }
+    EXPECT_DOUBLE_EQ(report.heartRate.totalTime(), 1000.0);
+    EXPECT_TRUE(report.power.isEmpty());
+
+    // Gradient zones: 2% is zone 4 ([1, 4)), -5% is zone 1 ([-8, -4)); each
+    // interval counts toward the zone of the point that closes it
+    EXPECT_DOUBLE_EQ(report.gradient.distance[4], 499.0 * 5.0);
+    EXPECT_DOUBLE_EQ(report.gradient.distance[1], 501.0 * 5.0);
+}
+
+TEST(ZoneHistogramTest, MissingSamplesAndPauses) {
+    std::vector<TrackPoint> points = makeTrack({150.0}, 101);
+    points[10].heartRate = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i = 50; i < points.size(); ++i) {
+        points[i].timestamp = points[i].timestamp.addSecs(600);
+    }
+    ZoneHistogram histogram = ZoneAnalyzer().analyze(TrackColumns::fromPoints(points)).heartRate;
+
+    // 100 intervals, one without heart rate and one across the ten minute pause
+    EXPECT_DOUBLE_EQ(histogram.time[2], 98.0);
+    EXPECT_DOUBLE_EQ(histogram.distance[2], 99.0 * 5.0);
+}
+
+TEST(ZoneHistogramTest, BatchMatchesSingleTracks) {
+    std::vector<TrackColumns> tracks;
+    for (int i = 0; i < 6; ++i) {
+        tracks.push_back(TrackColumns::fromPoints(makeTrack({110.0 + i * 10, 160.0}, 200 + i * 50)));
+    }
+    ZoneAnalyzer analyzer(ZoneSettings(180.0, 200.0));
+    std::vector<ZoneReport> reports = analyzer.analyzeBatch(tracks);
+
+    ASSERT_EQ(reports.size(), tracks.size());
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        ZoneReport single = analyzer.analyze(tracks[i]);
+        EXPECT_EQ(reports[i].heartRate.time, single.heartRate.time);
+        EXPECT_EQ(reports[i].gradient.distance, single.gradient.distance);
+    }
+}